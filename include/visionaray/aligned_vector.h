@@ -10,6 +10,7 @@
 #include <vector>
 
 #include "detail/aligned_allocator.h"
+#include "detail/huge_page_allocator.h"
 
 namespace visionaray
 {
@@ -21,6 +22,14 @@ namespace visionaray
 template <typename T, size_t A = 16>
 using aligned_vector = std::vector<T, aligned_allocator<T, A>>;
 
+
+//-------------------------------------------------------------------------------------------------
+// An aligned_vector that is backed by huge pages if it is large enough
+//
+
+template <typename T, size_t A = 16>
+using huge_page_vector = std::vector<T, huge_page_allocator<T, A>>;
+
 } // visionaray
 
 #endif // VSNRAY_ALIGNED_VECTOR_H
@@ -0,0 +1,97 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_AOV_BUFFER_RT_H
+#define VSNRAY_AOV_BUFFER_RT_H 1
+
+#include "aligned_vector.h"
+#include "pixel_traits.h"
+#include "render_target.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// AOVs that aov_buffer_rt stores, bitwise or'ed
+//
+
+enum aov_channel
+{
+    AovDepth    = 0x01,     // window space depth
+    AovNormal   = 0x02,     // shading normal, three planes
+    AovAlbedo   = 0x04,     // rgb albedo, three planes
+    AovPrimID   = 0x08,
+    AovGeomID   = 0x10,
+    AovAll      = 0x1F
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Render target with a color buffer and planar AOV buffers
+//
+// Kernels that return aov_result_record (e.g. simple::kernel<Params,
+// aov_result_record>) fill all AOVs in the same pass as the color. Kernels
+// that return a plain result_record only fill color and depth. Each channel
+// is stored as a separate plane of width x height values.
+// Does NOT implement display_color_buffer()
+//
+
+template <pixel_format ColorFormat>
+class aov_buffer_rt : public render_target
+{
+public:
+
+    using color_type    = typename pixel_traits<ColorFormat>::type;
+
+    using ref_type      = aov_render_target_ref<ColorFormat>;
+
+public:
+
+    explicit aov_buffer_rt(unsigned channels = AovAll);
+
+    unsigned channels() const;
+
+    color_type* color();
+    color_type const* color() const;
+
+    // Planes, nullptr if the channel is not stored
+    float* depth();
+    float* normal(int component);
+    float* albedo(int component);
+    int* prim_id();
+    int* geom_id();
+
+    float const* depth() const;
+    float const* normal(int component) const;
+    float const* albedo(int component) const;
+    int const* prim_id() const;
+    int const* geom_id() const;
+
+    ref_type ref();
+
+    void clear_color_buffer(vec4 const& color = vec4(0.0f));
+    void clear_aov_buffers();
+    void begin_frame();
+    void end_frame();
+    void resize(int w, int h);
+
+private:
+
+    unsigned                channels_;
+
+    aligned_vector<color_type> color_buffer;
+    aligned_vector<float>   depth_buffer;
+    aligned_vector<float>   normal_buffers[3];
+    aligned_vector<float>   albedo_buffers[3];
+    aligned_vector<int>     prim_id_buffer;
+    aligned_vector<int>     geom_id_buffer;
+
+};
+
+} // visionaray
+
+#include "detail/aov_buffer_rt.inl"
+
+#endif // VSNRAY_AOV_BUFFER_RT_H
@@ -0,0 +1,130 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_ASYNC_BVH_BUILDER_H
+#define VSNRAY_ASYNC_BVH_BUILDER_H 1
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#include "aligned_vector.h"
+#include "bvh.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Asynchronous BVH construction
+//
+// Builds or refits trees on a background thread, while rendering continues
+// with the current (front) tree. build() and refit() copy the primitives,
+// so the caller may modify its own copy immediately. The finished tree is
+// stored as the back tree and becomes the front tree w/ swap(). Call swap()
+// between frames, when no bvh_ref of the front tree is in use: it is the
+// only function that modifies the front tree. A new request replaces a
+// request that has not started yet. tree() is empty until the first build
+// was swapped in.
+//
+// Usage:
+//
+//   async_bvh_builder<index_bvh<P>> builder;
+//   builder.build(prims.data(), prims.size());
+//
+//   // Between frames
+//   if (builder.swap())
+//       reset_accumulation();
+//
+//   render(builder.tree().ref());
+//
+
+template <typename Tree>
+class async_bvh_builder
+{
+public:
+
+    using tree_type         = Tree;
+    using primitive_type    = typename Tree::primitive_type;
+
+public:
+
+    async_bvh_builder();
+
+    // Waits until the running request has finished, pending requests are dropped
+   ~async_bvh_builder();
+
+    async_bvh_builder(async_bvh_builder const&) = delete;
+    async_bvh_builder& operator=(async_bvh_builder const&) = delete;
+
+    // Build a tree over a copy of primitives w/ the binned SAH builder
+    void build(primitive_type const* primitives, size_t count, bool use_spatial_splits = false);
+
+    // Refit the newest tree after its primitives moved, the number and order
+    // of the primitives must be the same. Replaces a pending build by a build
+    // over the moved primitives
+    void refit(primitive_type const* primitives, size_t count);
+
+    // True while a request is pending or running
+    bool busy() const;
+
+    // Progress of the running request in [0..1], 1 if idle
+    float progress() const;
+
+    // Block until all requests have finished
+    void wait();
+
+    // Make the newest finished tree the front tree, returns true if the front tree changed
+    bool swap();
+
+    // The front tree
+    Tree const& tree() const;
+
+    // Time to build or refit the front tree in seconds
+    double build_time() const;
+
+private:
+
+    struct request
+    {
+        aligned_vector<primitive_type> primitives;
+        bool refit;
+        bool use_spatial_splits;
+    };
+
+    // Rendered, only modified by swap()
+    Tree front_;
+    double front_time_ = 0.0;
+
+    // Finished, not yet swapped in. Guarded by mutex_
+    Tree back_;
+    double back_time_ = 0.0;
+    bool back_ready_ = false;
+
+    // Guarded by mutex_
+    std::unique_ptr<request> pending_;
+    bool running_ = false;
+    bool quit_ = false;
+
+    // Primitives placed in leaves by the running build
+    std::atomic<size_t> num_done_;
+    std::atomic<size_t> num_total_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable cond_;
+    std::thread thread_;
+
+    void submit(std::unique_ptr<request> req);
+    void work();
+
+};
+
+} // visionaray
+
+#include "detail/async_bvh_builder.inl"
+
+#endif // VSNRAY_ASYNC_BVH_BUILDER_H
@@ -11,6 +11,7 @@
 #include <cstring>
 #include <stdexcept>
 #include <type_traits>
+#include <vector>
 
 #ifdef __CUDACC__
 #include <cuda.h>
@@ -29,6 +30,9 @@
 
 namespace visionaray
 {
+
+class thread_pool;
+
 namespace detail
 {
 
@@ -348,6 +352,9 @@ public:
         : primitives_(rhs.primitives())
         , nodes_(rhs.nodes())
         , indices_(rhs.indices())
+        , free_nodes_(rhs.free_nodes())
+        , free_indices_(rhs.free_indices())
+        , free_primitives_(rhs.free_primitives())
     {
     }
 
@@ -360,6 +367,17 @@ public:
     index_vector const&     indices() const     { return indices_; }
     index_vector&           indices()           { return indices_; }
 
+    // Free lists of insert_primitive() and remove_primitive(): first nodes of
+    // unused sibling pairs, unused indices and unused primitive slots
+    std::vector<unsigned> const& free_nodes() const      { return free_nodes_; }
+    std::vector<unsigned>&       free_nodes()            { return free_nodes_; }
+
+    std::vector<unsigned> const& free_indices() const    { return free_indices_; }
+    std::vector<unsigned>&       free_indices()          { return free_indices_; }
+
+    std::vector<unsigned> const& free_primitives() const { return free_primitives_; }
+    std::vector<unsigned>&       free_primitives()       { return free_primitives_; }
+
     size_t num_primitives() const               { return primitives_.size(); }
     size_t num_nodes() const                    { return nodes_.size(); }
 
@@ -394,6 +412,10 @@ public:
 
         indices_.clear();
         indices_.reserve(capacity);
+
+        free_nodes_.clear();
+        free_indices_.clear();
+        free_primitives_.clear();
     }
 
 private:
@@ -402,6 +424,10 @@ private:
     node_vector nodes_;
     index_vector indices_;
 
+    std::vector<unsigned> free_nodes_;
+    std::vector<unsigned> free_indices_;
+    std::vector<unsigned> free_primitives_;
+
 };
 
 
@@ -442,6 +468,12 @@ using bvh               = bvh_t<aligned_vector<P>, aligned_vector<bvh_node, 32>>
 template <typename P>
 using index_bvh         = index_bvh_t<aligned_vector<P>, aligned_vector<bvh_node, 32>, aligned_vector<unsigned>>;
 
+// BVHs with nodes, primitives and indices in huge pages, for large scenes
+template <typename P>
+using huge_page_bvh         = bvh_t<huge_page_vector<P>, huge_page_vector<bvh_node, 32>>;
+template <typename P>
+using huge_page_index_bvh   = index_bvh_t<huge_page_vector<P>, huge_page_vector<bvh_node, 32>, huge_page_vector<unsigned>>;
+
 #ifdef __CUDACC__
 template <typename P>
 using cuda_bvh          = bvh_t<thrust::device_vector<P>, thrust::device_vector<bvh_node>>;
@@ -465,6 +497,103 @@ template <typename Tree, typename P>
 Tree build(P* primitives, size_t num_prims, bool use_spatial_splits = false);
 
 
+//-------------------------------------------------------------------------------------------------
+// Leaf layout
+//
+// Sort the primitives in each leaf by type. Traversal intersects runs of
+// generic_primitives of the same type in tight loops, w/o dispatching on the
+// type of each primitive. Call after build(), no-op for other primitive types
+//
+
+template <typename Tree>
+void sort_leaves_by_type(Tree& tree);
+
+
+//-------------------------------------------------------------------------------------------------
+// Tree quality
+//
+// Restructure treelets of up to 7 nodes to minimize the SAH cost of the tree
+// (Karras, Aila 2013). Treelets are optimized bottom-up, treelets on the same
+// level of the tree in parallel on the threads of pool. Improves trees from
+// fast builders like the LBVH builder. Treelets that would move leaves deeper
+// than 31 levels (the size of the traversal stack) are not rewritten. Stops
+// after max_iterations passes over the tree, or when time_budget (in seconds,
+// 0: unlimited) is exceeded
+//
+
+struct treelet_optimization_stats
+{
+    float       sah_cost_before = 0.0f;
+    float       sah_cost_after  = 0.0f;
+    unsigned    iterations      = 0;    // completed passes over the tree
+    double      seconds         = 0.0;
+};
+
+template <typename Tree>
+treelet_optimization_stats optimize_treelets(
+        Tree&           tree,
+        thread_pool&    pool,
+        unsigned        max_iterations = 3,
+        double          time_budget = 0.0
+        );
+
+
+//-------------------------------------------------------------------------------------------------
+// Node layout
+//
+// The build stores the nodes in the order in which the builder creates them.
+// Reorder the nodes of a tree for cache and page locality: nodes that are
+// likely visited one after another (by surface area) are clustered in
+// contiguous blocks of cluster_size bytes, the clusters are stored in depth-
+// first order. Siblings stay adjacent. Call after build() and after
+// optimize_treelets(), the latter scatters the nodes of its treelets
+//
+
+template <typename Tree>
+void reorder_nodes(Tree& tree, size_t cluster_size = 4096);
+
+
+//-------------------------------------------------------------------------------------------------
+// Dynamic updates
+//
+// Insert and remove primitives w/o rebuilding the tree, for index_bvhs. A new
+// primitive becomes a leaf of its own, its sibling is the node for which the
+// SAH cost of the tree increases the least (branch and bound search, Bittner
+// et al. 2015). Ancestors are refitted and, where this reduces their surface
+// area, rotated (Kopta et al. 2012). remove_primitive() removes all
+// primitives w/ prim_id, empty leaves are collapsed into their parents.
+// Unused nodes, indices and primitive slots are recycled w/ the tree's free
+// lists. Leaves of edited subtrees are at most 31 levels deep, the maximum
+// that the traversal stack supports.
+//
+// Edits invalidate bvh_refs. Edited trees slowly degrade, call
+// reoptimize_if_degraded() periodically, e.g. between frames. It restructures
+// the tree w/ optimize_treelets() once the SAH cost grew by more than
+// max_degradation relative to reference_cost (0: the current cost), and
+// then updates reference_cost. Returns true if the tree was restructured
+//
+
+template <typename Tree, typename P>
+unsigned insert_primitive(Tree& tree, P const& prim);
+
+template <typename Tree>
+size_t remove_primitive(Tree& tree, unsigned prim_id);
+
+// Recompute the bounds of all nodes after the tree's primitives moved, the
+// topology is kept. Leaf bounds clipped by spatial splits are not restored
+template <typename Tree>
+void refit(Tree& tree);
+
+template <typename Tree>
+bool reoptimize_if_degraded(
+        Tree&           tree,
+        thread_pool&    pool,
+        float&          reference_cost,
+        float           max_degradation = 0.1f,
+        double          time_budget = 0.0
+        );
+
+
 //-------------------------------------------------------------------------------------------------
 // Traversal algorithms
 //
@@ -489,8 +618,11 @@ void traverse_parents(B const& b, N const& n, F func);
 #include "detail/bvh/get_tex_coord.h"
 #include "detail/bvh/hit_record.h"
 #include "detail/bvh/intersect.inl"
+#include "detail/bvh/intersect_coherent.inl"
+#include "detail/bvh/optimize.inl"
 #include "detail/bvh/prim_traits.h"
 #include "detail/bvh/statistics.h"
 #include "detail/bvh/traverse.h"
+#include "detail/bvh/update.inl"
 
 #endif // VSNRAY_BVH_H
@@ -0,0 +1,50 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_CPU_FEATURES_H
+#define VSNRAY_CPU_FEATURES_H 1
+
+#include "export.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// SIMD instruction sets that can be detected at runtime
+//
+// Ordered so that a later ISA implies the earlier ones (on x86).
+//
+
+enum simd_isa
+{
+    ISA_Scalar = 0,
+    ISA_SSE2,
+    ISA_SSE4_1,
+    ISA_AVX,
+    ISA_AVX2,
+    ISA_AVX512F
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Runtime CPU feature detection
+//
+// Uses cpuid and also checks that the operating system saves the AVX and AVX-512
+// register state on context switches. Returns false for all x86 ISAs on other
+// architectures.
+//
+
+// Returns true if the CPU (and the OS) support the ISA
+VSNRAY_EXPORT bool cpu_supports(simd_isa isa);
+
+// Returns the most capable ISA the CPU (and the OS) support
+VSNRAY_EXPORT simd_isa best_simd_isa();
+
+// Returns a printable name, e.g. "AVX2"
+VSNRAY_EXPORT char const* simd_isa_name(simd_isa isa);
+
+} // visionaray
+
+#endif // VSNRAY_CPU_FEATURES_H
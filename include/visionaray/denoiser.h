@@ -0,0 +1,84 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DENOISER_H
+#define VSNRAY_DENOISER_H 1
+
+#include "detail/thread_pool.h"
+#include "aligned_vector.h"
+#include "aov_buffer_rt.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Edge-aware spatial denoiser for low sample count path traced images
+//
+// Edge-avoiding a-trous wavelet filter (Dammertz et al. 2010) with the
+// luminance edge-stopping function from SVGF (Schied et al. 2017), but w/o the
+// temporal part. The color is demodulated by the albedo AOV before filtering,
+// so that texture detail is not blurred. Each iteration applies a 3x3 kernel
+// whose taps are spaced 2^iteration pixels apart, taps are weighted by the
+// similarity of their luminance, normal and depth with the center pixel. A 3x3
+// spatial luminance variance estimate steers the luminance weights.
+//
+// Uses the depth, normal and albedo planes of an aov_buffer_rt, whichever
+// are available. Each pass is distributed over the threads of a thread_pool,
+// e.g. the one of the tiled_sched that rendered the frame, and processes
+// rows of pixels with SIMD vectors of type FloatT.
+//
+
+class denoiser
+{
+public:
+
+    denoiser() = default;
+
+    // Number of a-trous iterations, the filter radius is 2^iterations - 1 pixels
+    void set_iterations(unsigned iterations);
+    unsigned iterations() const;
+
+    // Luminance edge-stopping, in standard deviations (default: 4)
+    void set_sigma_luminance(float sigma);
+    float sigma_luminance() const;
+
+    // Normal edge-stopping, distance between unit normals (default: 0.2)
+    void set_sigma_normal(float sigma);
+    float sigma_normal() const;
+
+    // Depth edge-stopping, relative to the local depth gradient (default: 1)
+    void set_sigma_depth(float sigma);
+    float sigma_depth() const;
+
+    // Filter the color buffer of input, write the result to output (w x h pixels)
+    template <typename FloatT = float>
+    void denoise(thread_pool& pool, aov_buffer_rt<PF_RGBA32F> const& input, vec4* output);
+
+private:
+
+    unsigned iterations_    = 5;
+    float sigma_luminance_  = 4.0f;
+    float sigma_normal_     = 0.2f;
+    float sigma_depth_      = 1.0f;
+
+    int width_  = 0;
+    int height_ = 0;
+
+    // Demodulated color and luminance variance, ping-pong
+    aligned_vector<float> color_[2][3];
+    aligned_vector<float> variance_[2];
+
+    // Max. depth difference to the 4-neighborhood
+    aligned_vector<float> depth_gradient_;
+
+    void resize(int w, int h);
+
+};
+
+} // visionaray
+
+#include "detail/denoiser.inl"
+
+#endif // VSNRAY_DENOISER_H
@@ -0,0 +1,203 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+
+#include "color_conversion.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// aov_buffer_rt
+//
+
+template <pixel_format ColorFormat>
+aov_buffer_rt<ColorFormat>::aov_buffer_rt(unsigned channels)
+    : channels_(channels)
+{
+}
+
+template <pixel_format ColorFormat>
+unsigned aov_buffer_rt<ColorFormat>::channels() const
+{
+    return channels_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Accessors
+//
+
+template <pixel_format ColorFormat>
+typename aov_buffer_rt<ColorFormat>::color_type* aov_buffer_rt<ColorFormat>::color()
+{
+    return color_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+typename aov_buffer_rt<ColorFormat>::color_type const* aov_buffer_rt<ColorFormat>::color() const
+{
+    return color_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+float* aov_buffer_rt<ColorFormat>::depth()
+{
+    return depth_buffer.empty() ? nullptr : depth_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+float* aov_buffer_rt<ColorFormat>::normal(int component)
+{
+    return normal_buffers[component].empty() ? nullptr : normal_buffers[component].data();
+}
+
+template <pixel_format ColorFormat>
+float* aov_buffer_rt<ColorFormat>::albedo(int component)
+{
+    return albedo_buffers[component].empty() ? nullptr : albedo_buffers[component].data();
+}
+
+template <pixel_format ColorFormat>
+int* aov_buffer_rt<ColorFormat>::prim_id()
+{
+    return prim_id_buffer.empty() ? nullptr : prim_id_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+int* aov_buffer_rt<ColorFormat>::geom_id()
+{
+    return geom_id_buffer.empty() ? nullptr : geom_id_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+float const* aov_buffer_rt<ColorFormat>::depth() const
+{
+    return depth_buffer.empty() ? nullptr : depth_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+float const* aov_buffer_rt<ColorFormat>::normal(int component) const
+{
+    return normal_buffers[component].empty() ? nullptr : normal_buffers[component].data();
+}
+
+template <pixel_format ColorFormat>
+float const* aov_buffer_rt<ColorFormat>::albedo(int component) const
+{
+    return albedo_buffers[component].empty() ? nullptr : albedo_buffers[component].data();
+}
+
+template <pixel_format ColorFormat>
+int const* aov_buffer_rt<ColorFormat>::prim_id() const
+{
+    return prim_id_buffer.empty() ? nullptr : prim_id_buffer.data();
+}
+
+template <pixel_format ColorFormat>
+int const* aov_buffer_rt<ColorFormat>::geom_id() const
+{
+    return geom_id_buffer.empty() ? nullptr : geom_id_buffer.data();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Interface
+//
+
+template <pixel_format ColorFormat>
+typename aov_buffer_rt<ColorFormat>::ref_type aov_buffer_rt<ColorFormat>::ref()
+{
+    return {
+        color(),
+        depth(),
+        { normal(0), normal(1), normal(2) },
+        { albedo(0), albedo(1), albedo(2) },
+        prim_id(),
+        geom_id(),
+        width(),
+        height()
+        };
+}
+
+template <pixel_format ColorFormat>
+void aov_buffer_rt<ColorFormat>::clear_color_buffer(vec4 const& c)
+{
+    // Convert from RGBA32F to internal color format
+    color_type cc;
+    convert(
+        pixel_format_constant<ColorFormat>{},
+        pixel_format_constant<PF_RGBA32F>{},
+        cc,
+        c
+        );
+
+    std::fill(color_buffer.begin(), color_buffer.end(), cc);
+}
+
+template <pixel_format ColorFormat>
+void aov_buffer_rt<ColorFormat>::clear_aov_buffers()
+{
+    std::fill(depth_buffer.begin(), depth_buffer.end(), 1.0f);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        std::fill(normal_buffers[i].begin(), normal_buffers[i].end(), 0.0f);
+        std::fill(albedo_buffers[i].begin(), albedo_buffers[i].end(), 0.0f);
+    }
+
+    std::fill(prim_id_buffer.begin(), prim_id_buffer.end(), -1);
+    std::fill(geom_id_buffer.begin(), geom_id_buffer.end(), -1);
+}
+
+template <pixel_format ColorFormat>
+void aov_buffer_rt<ColorFormat>::begin_frame()
+{
+}
+
+template <pixel_format ColorFormat>
+void aov_buffer_rt<ColorFormat>::end_frame()
+{
+}
+
+template <pixel_format ColorFormat>
+void aov_buffer_rt<ColorFormat>::resize(int w, int h)
+{
+    render_target::resize(w, h);
+
+
+    color_buffer.resize(w * h);
+
+    if (channels_ & AovDepth)
+    {
+        depth_buffer.resize(w * h);
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        if (channels_ & AovNormal)
+        {
+            normal_buffers[i].resize(w * h);
+        }
+
+        if (channels_ & AovAlbedo)
+        {
+            albedo_buffers[i].resize(w * h);
+        }
+    }
+
+    if (channels_ & AovPrimID)
+    {
+        prim_id_buffer.resize(w * h);
+    }
+
+    if (channels_ & AovGeomID)
+    {
+        geom_id_buffer.resize(w * h);
+    }
+
+    clear_aov_buffers();
+}
+
+} // visionaray
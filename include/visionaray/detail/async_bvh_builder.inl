@@ -0,0 +1,256 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <utility>
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Builder that counts the primitives placed in leaves
+//
+
+template <typename Builder>
+struct progress_builder : Builder
+{
+    std::atomic<size_t>* num_done = nullptr;
+
+    template <typename Indices, typename LeafInfo>
+    int insert_indices(Indices& indices, LeafInfo const& leaf)
+    {
+        int count = Builder::insert_indices(indices, leaf);
+        num_done->fetch_add(static_cast<size_t>(count), std::memory_order_relaxed);
+        return count;
+    }
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// async_bvh_builder members
+//
+
+template <typename Tree>
+inline async_bvh_builder<Tree>::async_bvh_builder()
+    : num_done_(0)
+    , num_total_(0)
+{
+    thread_ = std::thread([this](){ work(); });
+}
+
+template <typename Tree>
+inline async_bvh_builder<Tree>::~async_bvh_builder()
+{
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        quit_ = true;
+        pending_.reset();
+    }
+
+    cond_.notify_all();
+    thread_.join();
+}
+
+template <typename Tree>
+inline void async_bvh_builder<Tree>::build(
+        primitive_type const*   primitives,
+        size_t                  count,
+        bool                    use_spatial_splits
+        )
+{
+    std::unique_ptr<request> req(new request);
+    req->primitives.assign(primitives, primitives + count);
+    req->refit = false;
+    req->use_spatial_splits = use_spatial_splits;
+
+    submit(std::move(req));
+}
+
+template <typename Tree>
+inline void async_bvh_builder<Tree>::refit(primitive_type const* primitives, size_t count)
+{
+    std::unique_ptr<request> req(new request);
+    req->primitives.assign(primitives, primitives + count);
+    req->refit = true;
+    req->use_spatial_splits = false;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        // A pending build uses the moved primitives instead
+        if (pending_ != nullptr && !pending_->refit)
+        {
+            req->refit = false;
+            req->use_spatial_splits = pending_->use_spatial_splits;
+        }
+    }
+
+    submit(std::move(req));
+}
+
+template <typename Tree>
+inline bool async_bvh_builder<Tree>::busy() const
+{
+    std::unique_lock<std::mutex> l(mutex_);
+    return running_ || pending_ != nullptr;
+}
+
+template <typename Tree>
+inline float async_bvh_builder<Tree>::progress() const
+{
+    if (!busy())
+    {
+        return 1.0f;
+    }
+
+    size_t total = num_total_.load(std::memory_order_relaxed);
+
+    if (total == 0)
+    {
+        return 0.0f;
+    }
+
+    // Spatial splits reference primitives more than once
+    float p = static_cast<float>(num_done_.load(std::memory_order_relaxed)) / static_cast<float>(total);
+    return std::min(p, 0.99f);
+}
+
+template <typename Tree>
+inline void async_bvh_builder<Tree>::wait()
+{
+    std::unique_lock<std::mutex> l(mutex_);
+    cond_.wait(l, [this](){ return !running_ && pending_ == nullptr; });
+}
+
+template <typename Tree>
+inline bool async_bvh_builder<Tree>::swap()
+{
+    Tree old;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        if (!back_ready_)
+        {
+            return false;
+        }
+
+        std::swap(front_, back_);
+        std::swap(front_time_, back_time_);
+        back_ready_ = false;
+
+        // Free the previous tree outside the lock
+        std::swap(back_, old);
+    }
+
+    return true;
+}
+
+template <typename Tree>
+inline Tree const& async_bvh_builder<Tree>::tree() const
+{
+    return front_;
+}
+
+template <typename Tree>
+inline double async_bvh_builder<Tree>::build_time() const
+{
+    return front_time_;
+}
+
+template <typename Tree>
+inline void async_bvh_builder<Tree>::submit(std::unique_ptr<request> req)
+{
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        pending_ = std::move(req);
+    }
+
+    cond_.notify_all();
+}
+
+template <typename Tree>
+inline void async_bvh_builder<Tree>::work()
+{
+    using clock = std::chrono::steady_clock;
+
+    for (;;)
+    {
+        std::unique_ptr<request> req;
+        Tree tree;
+
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+            cond_.wait(l, [this](){ return quit_ || pending_ != nullptr; });
+
+            if (quit_)
+            {
+                return;
+            }
+
+            req = std::move(pending_);
+            running_ = true;
+
+            // Refits start from the newest tree, copy it while swap() can't modify it
+            if (req->refit)
+            {
+                tree = back_ready_ ? back_ : front_;
+            }
+        }
+
+        num_done_ = 0;
+        num_total_ = req->primitives.size();
+
+        auto start = clock::now();
+
+        auto first = req->primitives.data();
+        auto last  = req->primitives.data() + req->primitives.size();
+
+        // Refits of trees w/ other primitives are dropped
+        bool valid = !req->refit || tree.num_primitives() == req->primitives.size();
+
+        if (req->refit)
+        {
+            if (valid)
+            {
+                std::copy(first, last, tree.primitives().begin());
+                visionaray::refit(tree);
+            }
+        }
+        else if (first != last)
+        {
+            // Same parameters as build()
+            detail::progress_builder<detail::binned_sah_builder> builder;
+            builder.enable_spatial_splits(req->use_spatial_splits);
+            builder.set_alpha(1.0e-5f);
+            builder.num_done = &num_done_;
+
+            tree = Tree(first, req->primitives.size());
+            detail::build_tree(tree, builder, first, last);
+        }
+
+        double seconds = std::chrono::duration<double>(clock::now() - start).count();
+
+        {
+            std::unique_lock<std::mutex> l(mutex_);
+
+            if (valid)
+            {
+                std::swap(back_, tree);
+                back_time_ = seconds;
+                back_ready_ = true;
+            }
+
+            running_ = false;
+        }
+
+        cond_.notify_all();
+    }
+}
+
+} // visionaray
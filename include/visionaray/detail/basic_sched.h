@@ -9,6 +9,8 @@
 namespace visionaray
 {
 
+class visibility_buffer;
+
 template <typename Backend, typename R>
 class basic_sched
 {
@@ -23,10 +25,31 @@ public:
     template <typename ...Args>
     void reset(Args&&... args);
 
+    // E.g. to run post processing passes on the scheduler's threads
+    Backend& backend();
+
+    // Trace the primary rays of size x size pixel tiles w/ one BVH traversal
+    // (see intersect_coherent()). size is 8 or 16, 0 (default) disables coherent
+    // tiles. Applies to uniform pixel sampling w/ kernels that implement
+    // trace_coherent(), other frames are rendered packet by packet
+    void set_coherent_tiles(unsigned size);
+    unsigned coherent_tiles() const;
+
+    // Shade the primary hits of a visibility buffer w/ the frame's size (e.g.
+    // written by a rasterizer) instead of tracing primary rays. Applies to
+    // uniform pixel sampling w/ kernels that implement shade_visible(), other
+    // frames are ray traced. nullptr (default) disables the visibility buffer
+    void set_visibility_buffer(visibility_buffer const* vbuffer);
+    visibility_buffer const* get_visibility_buffer() const;
+
 private:
 
     Backend backend_;
 
+    unsigned coherent_tile_size_ = 0;
+
+    visibility_buffer const* visibility_buffer_ = nullptr;
+
 };
 
 } // visionaray
@@ -3,6 +3,7 @@
 
 #include <atomic>
 #include <cassert>
+#include <cstddef>
 #include <condition_variable>
 #include <functional>
 #include <memory>
@@ -11,6 +12,12 @@
 #include <type_traits>
 #include <utility>
 
+#include <visionaray/math/array.h>
+#include <visionaray/bvh.h>
+#include <visionaray/intersector.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/visibility_buffer.h>
+
 #include "../make_generator.h"
 #include "range.h"
 #include "sched_common.h"
@@ -84,6 +91,374 @@ void call_sample_pixel(
             );
 }
 
+
+
+//-------------------------------------------------------------------------------------------------
+// Coherent tiles, trace the primary rays of a tile at once and store the results per packet
+//
+
+template <typename R, size_t N, typename K, typename SP>
+auto trace_coherent(std::false_type /* has intersector */, K const& kernel, array<R, N> const& rays, SP& sparams)
+    -> decltype( kernel.trace_coherent(std::declval<default_intersector&>(), rays) )
+{
+    VSNRAY_UNUSED(sparams);
+
+    default_intersector isect;
+    return kernel.trace_coherent(isect, rays);
+}
+
+template <typename R, size_t N, typename K, typename SP>
+auto trace_coherent(std::true_type /* has intersector */, K const& kernel, array<R, N> const& rays, SP& sparams)
+    -> decltype( kernel.trace_coherent(sparams.intersector, rays) )
+{
+    return kernel.trace_coherent(sparams.intersector, rays);
+}
+
+// Uniform pixel sampling and kernel w/ trace_coherent()
+template <typename K, typename SP, typename R, size_t N>
+class supports_coherent_tiles
+{
+private:
+
+    template <typename U>
+    static auto test(U*) -> decltype(
+            trace_coherent(
+                typename detail::sched_params_has_intersector<U>::type(),
+                std::declval<K const&>(),
+                std::declval<array<R, N> const&>(),
+                std::declval<U&>()
+                ),
+            std::is_same<typename U::pixel_sampler_type, pixel_sampler::uniform_type>()
+            );
+
+    template <typename U>
+    static std::false_type test(...);
+
+public:
+
+    using type = decltype( test<SP>(nullptr) );
+
+};
+
+// Returns a result that was computed before, sample_pixel() then only stores it
+template <typename Result>
+struct precomputed_kernel
+{
+    Result const& result;
+
+    template <typename R>
+    Result operator()(R const& /* */) const
+    {
+        return result;
+    }
+};
+
+template <size_t N, typename R, typename K, typename SP>
+void sample_tile_coherent(
+        R               /* */,
+        K const&        kernel,
+        SP              sparams,
+        unsigned        frame_num,
+        int             x,
+        int             y,
+        int             tile_size,
+        int             nx,
+        int             ny
+        )
+{
+    using S = typename R::scalar_type;
+
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    int width  = sparams.rt.width();
+    int height = sparams.rt.height();
+
+    int packets_per_row = tile_size / pw;
+
+    auto gen = make_generator(S{}, pixel_sampler::uniform_type{}, detail::tic(S{}));
+
+    array<R, N> rays;
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        int px = x + static_cast<int>(k) % packets_per_row * pw;
+        int py = y + static_cast<int>(k) / packets_per_row * ph;
+
+        rays[k] = detail::make_primary_rays(R{}, pixel_sampler::uniform_type{}, gen, px, py, width, height, sparams.cam);
+    }
+
+    auto results = trace_coherent(
+            typename detail::sched_params_has_intersector<SP>::type(),
+            kernel,
+            rays,
+            sparams
+            );
+
+    using Result = typename std::decay<decltype(results[0])>::type;
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        int px = x + static_cast<int>(k) % packets_per_row * pw;
+        int py = y + static_cast<int>(k) / packets_per_row * ph;
+
+        // Packets outside the scissor box
+        if (px >= nx || py >= ny)
+        {
+            continue;
+        }
+
+        detail::sample_pixel_impl(
+                precomputed_kernel<Result>{ results[k] },
+                pixel_sampler::uniform_type{},
+                rays[k],
+                gen,
+                frame_num,
+                sparams.rt.ref(),
+                px,
+                py,
+                width,
+                height,
+                sparams.cam
+                );
+    }
+}
+
+template <size_t N, typename Backend, typename R, typename K, typename SP>
+bool frame_coherent(std::false_type /* supported */, Backend&, R, K, SP, unsigned, int)
+{
+    return false;
+}
+
+template <size_t N, typename Backend, typename R, typename K, typename SP>
+bool frame_coherent(
+        std::true_type  /* supported */,
+        Backend&        backend,
+        R               /* */,
+        K               kernel,
+        SP              sparams,
+        unsigned        frame_num,
+        int             tile_size
+        )
+{
+    int x0 = sparams.scissor_box.x;
+    int y0 = sparams.scissor_box.y;
+
+    int nx = x0 + sparams.scissor_box.w;
+    int ny = y0 + sparams.scissor_box.h;
+
+    // One call per tile
+    backend.for_each_packet(
+        tiled_range2d<int>(x0, nx, tile_size, y0, ny, tile_size), tile_size, tile_size,
+        [=](int x, int y)
+        {
+            sample_tile_coherent<N>(R{}, kernel, sparams, frame_num, x, y, tile_size, nx, ny);
+        });
+
+    return true;
+}
+
+// Returns false if the kernel or the pixel sampler doesn't support coherent tiles
+template <int TileSize, typename Backend, typename R, typename K, typename SP>
+bool frame_coherent(Backend& backend, R, K kernel, SP sparams, unsigned frame_num)
+{
+    using S = typename R::scalar_type;
+
+    static const size_t N = (TileSize / packet_size<S>::w) * (TileSize / packet_size<S>::h);
+
+    return frame_coherent<N>(
+            typename supports_coherent_tiles<K, SP, R, N>::type(),
+            backend,
+            R{},
+            kernel,
+            sparams,
+            frame_num,
+            TileSize
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Visibility buffer, shade rasterized primary hits instead of tracing primary rays
+//
+
+template <typename R, typename K, typename SP>
+auto shade_visible(
+        std::false_type                                     /* has intersector */,
+        K const&                                            kernel,
+        R const&                                            r,
+        visibility_sample<typename R::scalar_type> const&   vis,
+        SP&                                                 sparams
+        )
+    -> decltype( kernel.shade_visible(std::declval<default_intersector&>(), r, vis) )
+{
+    VSNRAY_UNUSED(sparams);
+
+    default_intersector isect;
+    return kernel.shade_visible(isect, r, vis);
+}
+
+template <typename R, typename K, typename SP>
+auto shade_visible(
+        std::true_type                                      /* has intersector */,
+        K const&                                            kernel,
+        R const&                                            r,
+        visibility_sample<typename R::scalar_type> const&   vis,
+        SP&                                                 sparams
+        )
+    -> decltype( kernel.shade_visible(sparams.intersector, r, vis) )
+{
+    return kernel.shade_visible(sparams.intersector, r, vis);
+}
+
+// Uniform pixel sampling and kernel w/ shade_visible()
+template <typename K, typename SP, typename R>
+class supports_visibility_buffer
+{
+private:
+
+    template <typename U>
+    static auto test(U*) -> decltype(
+            shade_visible(
+                typename detail::sched_params_has_intersector<U>::type(),
+                std::declval<K const&>(),
+                std::declval<R const&>(),
+                std::declval<visibility_sample<typename R::scalar_type> const&>(),
+                std::declval<U&>()
+                ),
+            std::is_same<typename U::pixel_sampler_type, pixel_sampler::uniform_type>()
+            );
+
+    template <typename U>
+    static std::false_type test(...);
+
+public:
+
+    using type = decltype( test<SP>(nullptr) );
+
+};
+
+// Visibility samples of the pixels of a packet, pixels outside the buffer are misses
+inline visibility_sample<float> gather_visibility(float /* */, visibility_buffer const& vbuffer, int x, int y)
+{
+    if (x < vbuffer.width() && y < vbuffer.height())
+    {
+        return vbuffer(x, y);
+    }
+
+    return visibility_sample<float>();
+}
+
+template <
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline visibility_sample<T> gather_visibility(T /* */, visibility_buffer const& vbuffer, int x, int y)
+{
+    array<visibility_sample<float>, simd::num_elements<T>::value> samples;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        samples[i] = gather_visibility(
+                float{},
+                vbuffer,
+                x + i % packet_size<T>::w,
+                y + i / packet_size<T>::w
+                );
+    }
+
+    return simd::pack(samples);
+}
+
+template <typename R, typename K, typename SP>
+void sample_pixel_visible(
+        R                           /* */,
+        K const&                    kernel,
+        SP                          sparams,
+        visibility_buffer const&    vbuffer,
+        unsigned                    frame_num,
+        int                         x,
+        int                         y
+        )
+{
+    using S = typename R::scalar_type;
+
+    int width  = sparams.rt.width();
+    int height = sparams.rt.height();
+
+    auto gen = make_generator(S{}, pixel_sampler::uniform_type{}, detail::tic(S{}));
+
+    auto r = detail::make_primary_rays(R{}, pixel_sampler::uniform_type{}, gen, x, y, width, height, sparams.cam);
+
+    auto result = shade_visible(
+            typename detail::sched_params_has_intersector<SP>::type(),
+            kernel,
+            r,
+            gather_visibility(S{}, vbuffer, x, y),
+            sparams
+            );
+
+    detail::sample_pixel_impl(
+            precomputed_kernel<decltype(result)>{ result },
+            pixel_sampler::uniform_type{},
+            r,
+            gen,
+            frame_num,
+            sparams.rt.ref(),
+            x,
+            y,
+            width,
+            height,
+            sparams.cam
+            );
+}
+
+template <typename Backend, typename R, typename K, typename SP>
+bool frame_visible(std::false_type /* supported */, Backend&, R, K, SP, unsigned, visibility_buffer const*)
+{
+    return false;
+}
+
+// Returns false if the visibility buffer's size differs from the render target's
+template <typename Backend, typename R, typename K, typename SP>
+bool frame_visible(
+        std::true_type              /* supported */,
+        Backend&                    backend,
+        R                           /* */,
+        K                           kernel,
+        SP                          sparams,
+        unsigned                    frame_num,
+        visibility_buffer const*    vbuffer
+        )
+{
+    if (vbuffer->width() != static_cast<int>(sparams.rt.width())
+     || vbuffer->height() != static_cast<int>(sparams.rt.height()))
+    {
+        return false;
+    }
+
+    int pw = packet_size<typename R::scalar_type>::w;
+    int ph = packet_size<typename R::scalar_type>::h;
+
+    int dx = round_up(16, pw);
+    int dy = round_up(16, ph);
+
+    int x0 = sparams.scissor_box.x;
+    int y0 = sparams.scissor_box.y;
+
+    int nx = x0 + sparams.scissor_box.w;
+    int ny = y0 + sparams.scissor_box.h;
+
+    backend.for_each_packet(
+        tiled_range2d<int>(x0, nx, dx, y0, ny, dy), pw, ph,
+        [=](int x, int y)
+        {
+            sample_pixel_visible(R{}, kernel, sparams, *vbuffer, frame_num, x, y);
+        });
+
+    return true;
+}
+
 } // basic_sched_impl
 
 
@@ -106,43 +481,70 @@ void basic_sched<B, R>::frame(K kernel, SP sched_params, unsigned frame_num)
 
     sched_params.rt.begin_frame();
 
-    int pw = packet_size<typename R::scalar_type>::w;
-    int ph = packet_size<typename R::scalar_type>::h;
+    bool coherent = false;
 
-    // Tile size must be be a multiple of packet size.
-    int dx = round_up(16, pw);
-    int dy = round_up(16, ph);
+    if (visibility_buffer_ != nullptr)
+    {
+        coherent = basic_sched_impl::frame_visible(
+                typename basic_sched_impl::supports_visibility_buffer<K, SP, R>::type(),
+                backend_,
+                R{},
+                kernel,
+                sched_params,
+                frame_num,
+                visibility_buffer_
+                );
+    }
 
-    int x0 = sched_params.scissor_box.x;
-    int y0 = sched_params.scissor_box.y;
+    if (!coherent && coherent_tile_size_ == 8)
+    {
+        coherent = basic_sched_impl::frame_coherent<8>(backend_, R{}, kernel, sched_params, frame_num);
+    }
+    else if (!coherent && coherent_tile_size_ == 16)
+    {
+        coherent = basic_sched_impl::frame_coherent<16>(backend_, R{}, kernel, sched_params, frame_num);
+    }
 
-    int nx = x0 + sched_params.scissor_box.w;
-    int ny = y0 + sched_params.scissor_box.h;
+    if (!coherent)
+    {
+        int pw = packet_size<typename R::scalar_type>::w;
+        int ph = packet_size<typename R::scalar_type>::h;
 
-    backend_.for_each_packet(
-        tiled_range2d<int>(x0, nx, dx, y0, ny, dy), pw, ph,
-        [=](int x, int y)
-        {
-            auto gen = make_generator(
-                    typename R::scalar_type{},
-                    typename SP::pixel_sampler_type{},
-                    detail::tic(typename R::scalar_type{})
-                    );
-
-            basic_sched_impl::call_sample_pixel(
-                    typename detail::sched_params_has_intersector<SP>::type(),
-                    R{},
-                    kernel,
-                    sched_params,
-                    gen,
-                    frame_num,
-                    x,
-                    y,
-                    sched_params.rt.width(),
-                    sched_params.rt.height(),
-                    sched_params.cam
-                    );
-        });
+        // Tile size must be be a multiple of packet size.
+        int dx = round_up(16, pw);
+        int dy = round_up(16, ph);
+
+        int x0 = sched_params.scissor_box.x;
+        int y0 = sched_params.scissor_box.y;
+
+        int nx = x0 + sched_params.scissor_box.w;
+        int ny = y0 + sched_params.scissor_box.h;
+
+        backend_.for_each_packet(
+            tiled_range2d<int>(x0, nx, dx, y0, ny, dy), pw, ph,
+            [=](int x, int y)
+            {
+                auto gen = make_generator(
+                        typename R::scalar_type{},
+                        typename SP::pixel_sampler_type{},
+                        detail::tic(typename R::scalar_type{})
+                        );
+
+                basic_sched_impl::call_sample_pixel(
+                        typename detail::sched_params_has_intersector<SP>::type(),
+                        R{},
+                        kernel,
+                        sched_params,
+                        gen,
+                        frame_num,
+                        x,
+                        y,
+                        sched_params.rt.width(),
+                        sched_params.rt.height(),
+                        sched_params.cam
+                        );
+            });
+    }
 
     sched_params.rt.end_frame();
 
@@ -156,4 +558,36 @@ void basic_sched<B, R>::reset(Args&&... args)
     backend_.reset(std::forward<Args>(args)...);
 }
 
+template <typename B, typename R>
+B& basic_sched<B, R>::backend()
+{
+    return backend_;
+}
+
+template <typename B, typename R>
+void basic_sched<B, R>::set_coherent_tiles(unsigned size)
+{
+    assert(size == 0 || size == 8 || size == 16);
+
+    coherent_tile_size_ = size;
+}
+
+template <typename B, typename R>
+unsigned basic_sched<B, R>::coherent_tiles() const
+{
+    return coherent_tile_size_;
+}
+
+template <typename B, typename R>
+void basic_sched<B, R>::set_visibility_buffer(visibility_buffer const* vbuffer)
+{
+    visibility_buffer_ = vbuffer;
+}
+
+template <typename B, typename R>
+visibility_buffer const* basic_sched<B, R>::get_visibility_buffer() const
+{
+    return visibility_buffer_;
+}
+
 } // visionaray
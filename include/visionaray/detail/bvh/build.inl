@@ -5,6 +5,7 @@
 #include <cstddef>
 #include <algorithm>
 #include <limits>
+#include <type_traits>
 
 #include <visionaray/math/aabb.h>
 
@@ -16,6 +17,9 @@
 namespace visionaray
 {
 
+template <typename ...Ts>
+class generic_primitive;
+
 
 namespace detail
 {
@@ -159,6 +163,63 @@ void build_tree(Tree& tree, Builder& builder, I first, I last, int max_leaf_size
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// sort_leaves_by_type
+//
+
+// Type index of generic primitives, other primitives are all of the same type
+template <typename P>
+unsigned leaf_type_key(P const& /* */)
+{
+    return 0;
+}
+
+template <typename ...Ts>
+unsigned leaf_type_key(generic_primitive<Ts...> const& prim)
+{
+    return prim.which();
+}
+
+template <typename Tree>
+void sort_leaves_by_type_impl(Tree& tree, std::true_type /* is_index_bvh */)
+{
+    auto const& prims = tree.primitives();
+
+    for (auto const& node : tree.nodes())
+    {
+        if (is_leaf(node))
+        {
+            auto first = tree.indices().begin() + node.get_indices().first;
+            auto last  = tree.indices().begin() + node.get_indices().last;
+
+            std::stable_sort(first, last, [&](unsigned a, unsigned b)
+            {
+                return leaf_type_key(prims[a]) < leaf_type_key(prims[b]);
+            });
+        }
+    }
+}
+
+template <typename Tree>
+void sort_leaves_by_type_impl(Tree& tree, std::false_type /* is_index_bvh */)
+{
+    using P = typename Tree::primitive_type;
+
+    for (auto const& node : tree.nodes())
+    {
+        if (is_leaf(node))
+        {
+            auto first = tree.primitives().begin() + node.get_indices().first;
+            auto last  = tree.primitives().begin() + node.get_indices().last;
+
+            std::stable_sort(first, last, [](P const& a, P const& b)
+            {
+                return leaf_type_key(a) < leaf_type_key(b);
+            });
+        }
+    }
+}
+
 } // detail
 
 
@@ -207,4 +268,15 @@ Tree build(P* primitives, size_t num_prims, bool enable_spatial_splits)
 }
 
 
+//--------------------------------------------------------------------------------------------------
+// Leaf layout
+//
+
+template <typename Tree>
+void sort_leaves_by_type(Tree& tree)
+{
+    detail::sort_leaves_by_type_impl(tree, is_index_bvh<Tree>());
+}
+
+
 } // visionaray
@@ -20,6 +20,235 @@
 namespace visionaray
 {
 
+template <typename ...Ts>
+class generic_primitive;
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Update the traversal result with the hit record of a primitive, returns true if
+// traversal may exit early
+//
+
+template <traversal_type Traversal, typename RT, typename HR, typename T, typename Cond>
+VSNRAY_FUNC
+inline bool update_leaf_result(RT& result, HR const& hr, T max_t, Cond& update_cond)
+{
+    auto closer = update_cond(hr, result, max_t);
+
+#ifndef __CUDA_ARCH__
+    if (!any(closer))
+    {
+        return false;
+    }
+#endif
+
+    update_if(result, hr, closer);
+
+    exit_traversal<Traversal> early_exit;
+    return early_exit.check(result);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersect the primitives [first..last) of a leaf, returns true if traversal may exit early
+//
+
+template <
+    traversal_type Traversal,
+    typename HR,
+    typename RT,
+    typename T,
+    typename BVH,
+    typename Intersector,
+    typename Cond,
+    typename P
+    >
+VSNRAY_FUNC
+inline bool intersect_leaf(
+        RT&                 result,
+        basic_ray<T> const& ray,
+        BVH const&          b,
+        unsigned            first,
+        unsigned            last,
+        Intersector&        isect,
+        T                   max_t,
+        Cond&               update_cond,
+        P const*            /* primitive type */
+        )
+{
+    for (auto i = first; i != last; ++i)
+    {
+        auto prim = b.primitive(i);
+
+        auto hr = HR(isect(ray, prim), i);
+        isect.on_primitive_test();
+
+        if (update_leaf_result<Traversal>(result, hr, max_t, update_cond))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+
+// generic_primitive --------------------------------------
+//
+// Dispatches once per run of primitives of the same type (see sort_leaves_by_type()).
+// The intersector is called with the concrete primitive type if it then returns the
+// same hit record type, and with the generic primitive otherwise
+//
+
+template <typename Base, typename Intersector, typename R, typename X, typename P>
+VSNRAY_FUNC
+inline auto intersect_run_primitive(Intersector& isect, R const& ray, X const& x, P const& /* */, int)
+    -> typename std::enable_if<std::is_same<decltype(isect(ray, x)), Base>::value, Base>::type
+{
+    return isect(ray, x);
+}
+
+template <typename Base, typename Intersector, typename R, typename X, typename P>
+VSNRAY_FUNC
+inline Base intersect_run_primitive(Intersector& isect, R const& ray, X const& /* */, P const& prim, long)
+{
+    return isect(ray, prim);
+}
+
+template <
+    traversal_type Traversal,
+    typename HR,
+    typename RT,
+    typename T,
+    typename BVH,
+    typename Intersector,
+    typename Cond
+    >
+class leaf_run_visitor
+{
+public:
+
+    // End of the run
+    using return_type = unsigned;
+
+public:
+
+    VSNRAY_FUNC leaf_run_visitor(
+            RT&                 result,
+            basic_ray<T> const& ray,
+            BVH const&          b,
+            unsigned            first,
+            unsigned            last,
+            Intersector&        isect,
+            T                   max_t,
+            Cond&               update_cond,
+            bool&               exit
+            )
+        : result_(result)
+        , ray_(ray)
+        , b_(b)
+        , first_(first)
+        , last_(last)
+        , isect_(isect)
+        , max_t_(max_t)
+        , update_cond_(update_cond)
+        , exit_(exit)
+    {
+    }
+
+    template <typename X>
+    VSNRAY_FUNC
+    unsigned operator()(X const& /* first primitive of the run */) const
+    {
+        using Base = decltype( isect_(ray_, b_.primitive(first_)) );
+
+        unsigned type = b_.primitive(first_).which();
+
+        unsigned i = first_;
+
+        for (; i != last_ && b_.primitive(i).which() == type; ++i)
+        {
+            auto const& prim = b_.primitive(i);
+
+            auto hr = HR(intersect_run_primitive<Base>(isect_, ray_, *prim.template as<X>(), prim, 0), i);
+            isect_.on_primitive_test();
+
+            if (update_leaf_result<Traversal>(result_, hr, max_t_, update_cond_))
+            {
+                exit_ = true;
+                return i + 1;
+            }
+        }
+
+        return i;
+    }
+
+private:
+
+    RT&                 result_;
+    basic_ray<T> const& ray_;
+    BVH const&          b_;
+    unsigned            first_;
+    unsigned            last_;
+    Intersector&        isect_;
+    T                   max_t_;
+    Cond&               update_cond_;
+    bool&               exit_;
+
+};
+
+template <
+    traversal_type Traversal,
+    typename HR,
+    typename RT,
+    typename T,
+    typename BVH,
+    typename Intersector,
+    typename Cond,
+    typename ...Ts
+    >
+VSNRAY_FUNC
+inline bool intersect_leaf(
+        RT&                                 result,
+        basic_ray<T> const&                 ray,
+        BVH const&                          b,
+        unsigned                            first,
+        unsigned                            last,
+        Intersector&                        isect,
+        T                                   max_t,
+        Cond&                               update_cond,
+        generic_primitive<Ts...> const*     /* primitive type */
+        )
+{
+    bool exit = false;
+
+    for (auto i = first; i != last && !exit; )
+    {
+        leaf_run_visitor<Traversal, HR, RT, T, BVH, Intersector, Cond> visitor(
+                result,
+                ray,
+                b,
+                i,
+                last,
+                isect,
+                max_t,
+                update_cond,
+                exit
+                );
+
+        // Skip primitives w/o valid type
+        unsigned next = apply_visitor(visitor, b.primitive(i));
+        i = next > i ? next : i + 1;
+    }
+
+    return exit;
+}
+
+} // detail
+
+
 //-------------------------------------------------------------------------------------------------
 // Ray / BVH intersection
 //
@@ -67,6 +296,7 @@ next:
     while (!st.empty())
     {
         auto node = b.node(st.pop());
+        isect.on_node();
 
         // while node does not contain primitives
         //     traverse to the next node
@@ -77,6 +307,8 @@ next:
 
             auto hr1 = isect(ray, children[0].get_bounds(), inv_dir);
             auto hr2 = isect(ray, children[1].get_bounds(), inv_dir);
+            isect.on_box_test();
+            isect.on_box_test();
 
             auto b1 = any( is_closer(hr1, result, max_t) );
             auto b2 = any( is_closer(hr2, result, max_t) );
@@ -85,15 +317,19 @@ next:
             {
                 unsigned near_addr = all( hr1.tnear < hr2.tnear ) ? 0 : 1;
                 st.push(node.get_child(!near_addr));
+                isect.on_stack_push(st.size());
                 node = b.node(node.get_child(near_addr));
+                isect.on_node();
             }
             else if (b1)
             {
                 node = b.node(node.get_child(0));
+                isect.on_node();
             }
             else if (b2)
             {
                 node = b.node(node.get_child(1));
+                isect.on_node();
             }
             else
             {
@@ -105,27 +341,19 @@ next:
         // while node contains untested primitives
         //     perform a ray-primitive intersection test
 
-        for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+        if (intersect_leaf<Traversal, HR>(
+                result,
+                ray,
+                b,
+                node.get_indices().first,
+                node.get_indices().last,
+                isect,
+                max_t,
+                update_cond,
+                static_cast<typename BVH::primitive_type const*>(nullptr)
+                ))
         {
-            auto prim = b.primitive(i);
-
-            auto hr = HR(isect(ray, prim), i);
-            auto closer = update_cond(hr, result, max_t);
-
-#ifndef __CUDA_ARCH__
-            if (!any(closer))
-            {
-                continue;
-            }
-#endif
-
-            update_if(result, hr, closer);
-
-            exit_traversal<Traversal> early_exit;
-            if (early_exit.check(result))
-            {
-                return result;
-            }
+            return result;
         }
     }
 
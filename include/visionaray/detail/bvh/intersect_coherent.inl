@@ -0,0 +1,436 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/aabb.h>
+#include <visionaray/math/array.h>
+#include <visionaray/math/limits.h>
+#include <visionaray/math/ray.h>
+#include <visionaray/intersector.h>
+#include <visionaray/update_if.h>
+
+#include "../stack.h"
+#include "../tags.h"
+#include "hit_record.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Min and max over the lanes of a SIMD vector
+//
+
+inline float lane_min(float x)
+{
+    return x;
+}
+
+inline float lane_max(float x)
+{
+    return x;
+}
+
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline float lane_min(T const& x)
+{
+    simd::aligned_array_t<T> arr;
+    store(arr, x);
+
+    float result = arr[0];
+
+    for (int i = 1; i < simd::num_elements<T>::value; ++i)
+    {
+        result = min(result, arr[i]);
+    }
+
+    return result;
+}
+
+template <typename T, typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type>
+inline float lane_max(T const& x)
+{
+    simd::aligned_array_t<T> arr;
+    store(arr, x);
+
+    float result = arr[0];
+
+    for (int i = 1; i < simd::num_elements<T>::value; ++i)
+    {
+        result = max(result, arr[i]);
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Interval arithmetic ray packet (Boulos et al. 2006)
+//
+// Bounds the origins and reciprocal directions of all rays of a set of ray
+// packets. A box is missed by all rays if the intervals of the entry and exit
+// distances are disjoint. Requires that the direction components have the
+// same sign for all rays, otherwise valid() is false and nothing is culled
+//
+
+struct interval_packet
+{
+    vec3 ori_lo;
+    vec3 ori_hi;
+    vec3 inv_dir_lo;
+    vec3 inv_dir_hi;
+    bool valid;
+
+    template <typename T, size_t N>
+    void init(array<basic_ray<T>, N> const& rays, array<vector<3, T>, N> const& inv_dir)
+    {
+        ori_lo      = vec3(numeric_limits<float>::max());
+        ori_hi      = vec3(numeric_limits<float>::lowest());
+        inv_dir_lo  = vec3(numeric_limits<float>::max());
+        inv_dir_hi  = vec3(numeric_limits<float>::lowest());
+
+        bool positive[3] = { true, true, true };
+        bool negative[3] = { true, true, true };
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            for (int a = 0; a < 3; ++a)
+            {
+                ori_lo[a]       = min(ori_lo[a], lane_min(rays[k].ori[a]));
+                ori_hi[a]       = max(ori_hi[a], lane_max(rays[k].ori[a]));
+                inv_dir_lo[a]   = min(inv_dir_lo[a], lane_min(inv_dir[k][a]));
+                inv_dir_hi[a]   = max(inv_dir_hi[a], lane_max(inv_dir[k][a]));
+
+                positive[a] &= all(rays[k].dir[a] > T(0.0));
+                negative[a] &= all(rays[k].dir[a] < T(0.0));
+            }
+        }
+
+        // Mixed signs or parallel to a slab
+        valid = (positive[0] || negative[0]) && (positive[1] || negative[1]) && (positive[2] || negative[2]);
+    }
+
+    // Product of the intervals [a_lo..a_hi] and [b_lo..b_hi]
+    static void mul(float a_lo, float a_hi, float b_lo, float b_hi, float& lo, float& hi)
+    {
+        float p1 = a_lo * b_lo;
+        float p2 = a_lo * b_hi;
+        float p3 = a_hi * b_lo;
+        float p4 = a_hi * b_hi;
+
+        lo = min(min(p1, p2), min(p3, p4));
+        hi = max(max(p1, p2), max(p3, p4));
+    }
+
+    // True if no ray hits box closer than max_t
+    bool miss(aabb const& box, float max_t) const
+    {
+        if (!valid)
+        {
+            return false;
+        }
+
+        float tnear_lo = 0.0f;
+        float tfar_hi  = max_t;
+
+        for (int a = 0; a < 3; ++a)
+        {
+            float lo1;
+            float hi1;
+            float lo2;
+            float hi2;
+
+            mul(box.min[a] - ori_hi[a], box.min[a] - ori_lo[a], inv_dir_lo[a], inv_dir_hi[a], lo1, hi1);
+            mul(box.max[a] - ori_hi[a], box.max[a] - ori_lo[a], inv_dir_lo[a], inv_dir_hi[a], lo2, hi2);
+
+            // Slabs are entered at min for positive and at max for negative directions
+            bool positive = inv_dir_lo[a] > 0.0f;
+
+            tnear_lo = max(tnear_lo, positive ? lo1 : lo2);
+            tfar_hi  = min(tfar_hi,  positive ? hi2 : hi1);
+        }
+
+        return tnear_lo > tfar_hi;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// First packet in [first..N) that hits box closer than its current hit, N if none does
+//
+
+template <typename T, size_t N, typename RT, typename Intersector>
+inline size_t first_active(
+        aabb const&                         box,
+        size_t                              first,
+        array<basic_ray<T>, N> const&       rays,
+        array<vector<3, T>, N> const&       inv_dir,
+        array<RT, N> const&                 results,
+        array<T, N> const&                  max_t,
+        bool const*                         done,
+        interval_packet const&              ip,
+        float                               max_hit_t,
+        Intersector&                        isect
+        )
+{
+    if (ip.miss(box, max_hit_t))
+    {
+        return N;
+    }
+
+    for (size_t k = first; k < N; ++k)
+    {
+        if (done[k])
+        {
+            continue;
+        }
+
+        auto hr = isect(rays[k], box, inv_dir[k]);
+        isect.on_box_test();
+
+        if (any( is_closer(hr, results[k], max_t[k]) ))
+        {
+            return k;
+        }
+    }
+
+    return N;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Coherent ray packets / BVH intersection
+//
+// Traverses N ray packets, e.g. all primary rays of a screen tile, together.
+// Each node is visited once for all packets. Before the packets are tested,
+// an interval arithmetic test culls nodes that none of the rays hit. The index
+// of the first packet that hits a node is stored on the traversal stack,
+// packets before it are not tested in the node's subtree (Wald et al. 2001).
+// Works best for rays w/ similar origins and directions, e.g. primary rays
+// and shadow rays to point lights.
+//
+
+template <
+    detail::traversal_type Traversal,
+    typename T,
+    size_t N,
+    typename BVH,
+    typename = typename std::enable_if<is_any_bvh<BVH>::value>::type,
+    typename Intersector,
+    typename Cond = is_closer_t
+    >
+inline auto intersect_coherent(
+        array<basic_ray<T>, N> const&   rays,
+        BVH const&                      b,
+        Intersector&                    isect,
+        array<T, N> const&              max_t,
+        Cond                            update_cond = Cond()
+        )
+    -> array<hit_record_bvh<
+            basic_ray<T>,
+            decltype( isect(rays[0], std::declval<typename BVH::primitive_type>()) )
+            >, N>
+{
+    static_assert(
+            Traversal == detail::ClosestHit || Traversal == detail::AnyHit,
+            "Coherent traversal supports closest and any hit traversal"
+            );
+
+    using namespace detail;
+    using HR = hit_record_bvh<
+        basic_ray<T>,
+        decltype( isect(rays[0], std::declval<typename BVH::primitive_type>()) )
+        >;
+
+    array<HR, N> results;
+
+    if (b.num_nodes() == 0)
+    {
+        return results;
+    }
+
+    array<vector<3, T>, N> inv_dir;
+
+    // Packets in which all rays are done (any hit)
+    bool done[N];
+
+    vec3 dir_sum(0.0f);
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        inv_dir[k] = T(1.0) / rays[k].dir;
+        done[k] = false;
+
+        dir_sum += vec3(
+                lane_max(rays[k].dir.x) + lane_min(rays[k].dir.x),
+                lane_max(rays[k].dir.y) + lane_min(rays[k].dir.y),
+                lane_max(rays[k].dir.z) + lane_min(rays[k].dir.z)
+                );
+    }
+
+    interval_packet ip;
+    ip.init(rays, inv_dir);
+
+    // Furthest distance at which the rays of a packet may still hit something
+    float hit_t[N];
+
+    auto packet_hit_t = [&](size_t k)
+    {
+        return done[k]
+            ? numeric_limits<float>::lowest()
+            : lane_max(select(results[k].hit, results[k].t, max_t[k]));
+    };
+
+    // Maximum over all packets
+    auto update_max_hit_t = [&]()
+    {
+        float result = numeric_limits<float>::lowest();
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            result = max(result, hit_t[k]);
+        }
+
+        return result;
+    };
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        hit_t[k] = packet_hit_t(k);
+    }
+
+    float max_hit_t = update_max_hit_t();
+
+    // Skip all packets if no ray hits the scene
+    size_t root_first = first_active(b.node(0).get_bounds(), 0, rays, inv_dir, results, max_t, done, ip, max_hit_t, isect);
+
+    if (root_first == N)
+    {
+        return results;
+    }
+
+    stack<32> st;
+    stack<32> first_st;
+
+    st.push(0); // address of root node
+    first_st.push(static_cast<unsigned>(root_first));
+
+    // while there are packets that are not terminated
+next:
+    while (!st.empty())
+    {
+        auto node = b.node(st.pop());
+        size_t first = first_st.pop();
+        isect.on_node();
+
+        // while node does not contain primitives
+        //     traverse to the next node
+
+        while (!is_leaf(node))
+        {
+            auto children = &b.node(node.get_child(0));
+
+            size_t f1 = first_active(children[0].get_bounds(), first, rays, inv_dir, results, max_t, done, ip, max_hit_t, isect);
+            size_t f2 = first_active(children[1].get_bounds(), first, rays, inv_dir, results, max_t, done, ip, max_hit_t, isect);
+
+            bool b1 = f1 < N;
+            bool b2 = f2 < N;
+
+            if (b1 && b2)
+            {
+                // Visit the child first that the rays enter first
+                vec3 d = children[1].get_bounds().center() - children[0].get_bounds().center();
+                unsigned near_addr = dot(d, dir_sum) >= 0.0f ? 0 : 1;
+
+                st.push(node.get_child(!near_addr));
+                first_st.push(static_cast<unsigned>(near_addr ? f1 : f2));
+                isect.on_stack_push(st.size());
+
+                first = near_addr ? f2 : f1;
+                node = b.node(node.get_child(near_addr));
+                isect.on_node();
+            }
+            else if (b1)
+            {
+                first = f1;
+                node = b.node(node.get_child(0));
+                isect.on_node();
+            }
+            else if (b2)
+            {
+                first = f2;
+                node = b.node(node.get_child(1));
+                isect.on_node();
+            }
+            else
+            {
+                goto next;
+            }
+        }
+
+
+        // Intersect the leaf's primitives w/ all packets that are active in this subtree,
+        // packets after the first active one are box tested, that's cheaper than the primitives
+
+        bool all_done = true;
+        bool changed = false;
+
+        for (size_t k = first; k < N; ++k)
+        {
+            if (done[k])
+            {
+                continue;
+            }
+
+            if (k != first)
+            {
+                auto hr = isect(rays[k], node.get_bounds(), inv_dir[k]);
+                isect.on_box_test();
+
+                if (!any( is_closer(hr, results[k], max_t[k]) ))
+                {
+                    all_done = false;
+                    continue;
+                }
+            }
+
+            done[k] = intersect_leaf<Traversal, HR>(
+                    results[k],
+                    rays[k],
+                    b,
+                    node.get_indices().first,
+                    node.get_indices().last,
+                    isect,
+                    max_t[k],
+                    update_cond,
+                    static_cast<typename BVH::primitive_type const*>(nullptr)
+                    );
+
+            all_done &= done[k];
+
+            hit_t[k] = packet_hit_t(k);
+            changed = true;
+        }
+
+        if (all_done && first == root_first)
+        {
+            return results;
+        }
+
+        if (changed)
+        {
+            max_hit_t = update_max_hit_t();
+        }
+    }
+
+    return results;
+}
+
+} // visionaray
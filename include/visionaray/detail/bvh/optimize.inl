@@ -0,0 +1,538 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <visionaray/math/aabb.h>
+
+#include "../parallel_for.h"
+#include "../range.h"
+#include "../thread_pool.h"
+
+
+namespace visionaray
+{
+namespace detail
+{
+
+// Max. depth of leaves (the root has depth 0) of optimized and edited trees,
+// the traversal stack holds 31 entries
+enum { MaxLeafDepth = 31 };
+
+
+//--------------------------------------------------------------------------------------------------
+// Treelet restructuring
+//
+// cf. Karras, Aila (2013): Fast Parallel Construction of High-Quality Bounding Volume Hierarchies
+//
+// Node costs are the (unnormalized) SAH costs of the subtrees, consistent w/ sah_cost().
+// Treelets are only rewritten if their leaves stay within MaxLeafDepth
+//
+
+struct treelet
+{
+    enum { MaxLeaves = 7 };
+    enum { MaxSubsets = 1 << MaxLeaves };
+
+    // SAH cost constants, cf. sah_cost()
+    static constexpr float CI = 1.2f;
+    static constexpr float CP = 1.0f;
+
+    // Treelet leaves, either BVH leaves or roots of subtrees, their costs and heights
+    bvh_node    leaves[MaxLeaves];
+    float       leaf_costs[MaxLeaves];
+    unsigned    leaf_heights[MaxLeaves];
+    int         num_leaves = 0;
+
+    // First children of the treelet's inner nodes (incl. the root), the slots
+    // are reused when the treelet is rewritten
+    unsigned    pairs[MaxLeaves - 1];
+    int         num_pairs = 0;
+
+    // The treelet's inner nodes, parents before their children
+    unsigned    inner[MaxLeaves - 1];
+
+    // Bounds and optimal costs of all subsets of leaves, and the optimal
+    // partition of each subset (the subset of the first child)
+    aabb        bounds[MaxSubsets];
+    float       costs[MaxSubsets];
+    unsigned    partitions[MaxSubsets];
+
+    // Form the treelet below root, expand the leaf w/ the largest surface area
+    void form(bvh_node const* nodes, float const* node_costs, unsigned const* node_heights, unsigned root)
+    {
+        unsigned indices[MaxLeaves];
+
+        indices[0] = nodes[root].get_child(0);
+        indices[1] = nodes[root].get_child(1);
+        num_leaves = 2;
+
+        pairs[0] = nodes[root].get_child(0);
+        num_pairs = 1;
+
+        inner[0] = root;
+
+        while (num_leaves < MaxLeaves)
+        {
+            int best = -1;
+            float best_area = -1.0f;
+
+            for (int i = 0; i < num_leaves; ++i)
+            {
+                auto const& n = nodes[indices[i]];
+
+                if (is_inner(n) && surface_area(n.get_bounds()) > best_area)
+                {
+                    best = i;
+                    best_area = surface_area(n.get_bounds());
+                }
+            }
+
+            if (best < 0)
+            {
+                break;
+            }
+
+            auto const& n = nodes[indices[best]];
+
+            inner[num_pairs] = indices[best];
+            pairs[num_pairs++] = n.get_child(0);
+
+            indices[best] = n.get_child(0);
+            indices[num_leaves++] = n.get_child(1);
+        }
+
+        for (int i = 0; i < num_leaves; ++i)
+        {
+            leaves[i] = nodes[indices[i]];
+            leaf_costs[i] = node_costs[indices[i]];
+            leaf_heights[i] = node_heights[indices[i]];
+        }
+    }
+
+    // Dynamic programming over all subsets of the leaves, returns the cost of the optimal treelet
+    float optimize()
+    {
+        unsigned num_subsets = 1U << num_leaves;
+
+        for (int i = 0; i < num_leaves; ++i)
+        {
+            bounds[1U << i] = leaves[i].get_bounds();
+            costs[1U << i] = leaf_costs[i];
+        }
+
+        // Subsets of a subset s are smaller than s
+        for (unsigned s = 1; s < num_subsets; ++s)
+        {
+            if ((s & (s - 1)) == 0)
+            {
+                continue;
+            }
+
+            // Partitions into p and s \ p, p contains the lowest leaf of s
+            unsigned lowest = s & (~s + 1);
+            unsigned rest = s & ~lowest;
+
+            bounds[s] = combine(bounds[lowest], bounds[rest]);
+
+            float best = std::numeric_limits<float>::max();
+            unsigned best_p = lowest;
+
+            for (unsigned q = (rest - 1) & rest; ; q = (q - 1) & rest)
+            {
+                unsigned p = q | lowest;
+                float c = costs[p] + costs[s & ~p];
+
+                if (c < best)
+                {
+                    best = c;
+                    best_p = p;
+                }
+
+                if (q == 0)
+                {
+                    break;
+                }
+            }
+
+            costs[s] = CI * surface_area(bounds[s]) + best;
+            partitions[s] = best_p;
+        }
+
+        return costs[num_subsets - 1];
+    }
+
+    // Height of the optimal treelet incl. the subtrees below its leaves
+    unsigned height(unsigned s) const
+    {
+        if ((s & (s - 1)) == 0)
+        {
+            return leaf_heights[leaf_index(s)];
+        }
+
+        return std::max(height(partitions[s]), height(s & ~partitions[s])) + 1;
+    }
+
+    unsigned height() const
+    {
+        return height((1U << num_leaves) - 1);
+    }
+
+    static int leaf_index(unsigned s)
+    {
+        int i = 0;
+        while ((1U << i) != s)
+        {
+            ++i;
+        }
+
+        return i;
+    }
+
+    // Update the heights of the inner nodes when the treelet is not rewritten,
+    // subtrees below the leaves may have changed
+    void update_heights(bvh_node const* nodes, unsigned* node_heights) const
+    {
+        for (int i = num_pairs - 1; i >= 0; --i)
+        {
+            auto const& n = nodes[inner[i]];
+            node_heights[inner[i]] = std::max(node_heights[n.get_child(0)], node_heights[n.get_child(1)]) + 1;
+        }
+    }
+
+    // Rewrite the treelet w/ the optimal topology, the root keeps its slot
+    void write(bvh_node* nodes, float* node_costs, unsigned* node_heights, unsigned root)
+    {
+        // Low slots for nodes close to the root
+        std::sort(pairs, pairs + num_pairs);
+
+        int next_pair = 0;
+
+        write(nodes, node_costs, node_heights, root, (1U << num_leaves) - 1, next_pair);
+    }
+
+    void write(bvh_node* nodes, float* node_costs, unsigned* node_heights, unsigned index, unsigned s, int& next_pair)
+    {
+        if ((s & (s - 1)) == 0)
+        {
+            int i = leaf_index(s);
+
+            nodes[index] = leaves[i];
+            node_costs[index] = leaf_costs[i];
+            node_heights[index] = leaf_heights[i];
+            return;
+        }
+
+        unsigned first_child = pairs[next_pair++];
+
+        nodes[index].set_inner(bounds[s], first_child);
+        node_costs[index] = costs[s];
+        node_heights[index] = height(s);
+
+        write(nodes, node_costs, node_heights, first_child, partitions[s], next_pair);
+        write(nodes, node_costs, node_heights, first_child + 1, s & ~partitions[s], next_pair);
+    }
+};
+
+// Costs, heights and depths of all nodes, and inner nodes w/ at least three nodes below
+// them, grouped by height
+inline void treelet_levels(
+        bvh_node const*                     nodes,
+        size_t                              num_nodes,
+        std::vector<float>&                 node_costs,
+        std::vector<unsigned>&              heights,
+        std::vector<unsigned>&              depths,
+        std::vector<std::vector<unsigned>>& levels
+        )
+{
+    // Pre-order, parents before their children
+    std::vector<unsigned> order;
+    order.reserve(num_nodes);
+
+    std::vector<unsigned> stack(1, 0);
+
+    heights.assign(num_nodes, 0);
+    depths.assign(num_nodes, 0);
+
+    while (!stack.empty())
+    {
+        unsigned index = stack.back();
+        stack.pop_back();
+
+        order.push_back(index);
+
+        if (is_inner(nodes[index]))
+        {
+            depths[nodes[index].get_child(0)] = depths[index] + 1;
+            depths[nodes[index].get_child(1)] = depths[index] + 1;
+
+            stack.push_back(nodes[index].get_child(0));
+            stack.push_back(nodes[index].get_child(1));
+        }
+    }
+
+    node_costs.resize(num_nodes);
+
+    for (auto& level : levels)
+    {
+        level.clear();
+    }
+
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        auto const& n = nodes[*it];
+
+        if (is_leaf(n))
+        {
+            heights[*it] = 0;
+            node_costs[*it] = treelet::CP * surface_area(n.get_bounds()) * static_cast<float>(n.get_num_primitives());
+        }
+        else
+        {
+            unsigned c0 = n.get_child(0);
+            unsigned c1 = n.get_child(1);
+
+            heights[*it] = std::max(heights[c0], heights[c1]) + 1;
+            node_costs[*it] = treelet::CI * surface_area(n.get_bounds()) + node_costs[c0] + node_costs[c1];
+
+            if (heights[*it] >= 2)
+            {
+                size_t level = heights[*it] - 2;
+
+                if (levels.size() <= level)
+                {
+                    levels.resize(level + 1);
+                }
+
+                levels[level].push_back(*it);
+            }
+        }
+    }
+}
+
+// Unused node pairs of index bvhs are dropped when the nodes are reordered
+template <typename Tree>
+inline void clear_free_nodes(Tree& tree, std::true_type /* is_index_bvh */)
+{
+    tree.free_nodes().clear();
+}
+
+template <typename Tree>
+inline void clear_free_nodes(Tree& /* tree */, std::false_type /* is_index_bvh */)
+{
+}
+
+} // detail
+
+
+//--------------------------------------------------------------------------------------------------
+// Tree quality
+//
+
+template <typename Tree>
+treelet_optimization_stats optimize_treelets(
+        Tree&           tree,
+        thread_pool&    pool,
+        unsigned        max_iterations,
+        double          time_budget
+        )
+{
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+
+    auto elapsed = [&]()
+    {
+        return std::chrono::duration<double>(clock::now() - start).count();
+    };
+
+    treelet_optimization_stats stats;
+
+    if (tree.num_nodes() == 0)
+    {
+        return stats;
+    }
+
+    stats.sah_cost_before = sah_cost(tree);
+    stats.sah_cost_after = stats.sah_cost_before;
+
+    bvh_node* nodes = tree.nodes().data();
+    size_t num_nodes = tree.num_nodes();
+
+    std::vector<float> node_costs;
+    std::vector<unsigned> heights;
+    std::vector<unsigned> depths;
+    std::vector<std::vector<unsigned>> levels;
+
+    bool out_of_time = false;
+
+    for (unsigned iteration = 0; iteration < max_iterations && !out_of_time; ++iteration)
+    {
+        detail::treelet_levels(nodes, num_nodes, node_costs, heights, depths, levels);
+
+        // Nodes of the same height are not ancestors of each other, their
+        // treelets are disjoint. Levels are processed bottom-up, so that the
+        // subtrees below a treelet are already optimized. Heights are kept up
+        // to date below the current level, the depths of the treelet roots
+        // don't change before they are processed
+        for (auto const& level : levels)
+        {
+            if (time_budget > 0.0 && elapsed() > time_budget)
+            {
+                out_of_time = true;
+                break;
+            }
+
+            if (level.empty())
+            {
+                continue;
+            }
+
+            parallel_for(
+                pool,
+                tiled_range1d<size_t>(0, level.size(), 64),
+                [&](range1d<size_t> const& r)
+                {
+                    detail::treelet t;
+
+                    for (size_t i = r.begin(); i != r.end(); ++i)
+                    {
+                        unsigned root = level[i];
+
+                        t.form(nodes, node_costs.data(), heights.data(), root);
+
+                        // Only rewrite if the treelet noticeably improves and
+                        // its leaves don't get too deep for traversal
+                        if (t.num_leaves >= 3
+                         && t.optimize() < node_costs[root] * 0.9999f
+                         && depths[root] + t.height() <= detail::MaxLeafDepth)
+                        {
+                            t.write(nodes, node_costs.data(), heights.data(), root);
+                        }
+                        else
+                        {
+                            t.update_heights(nodes, heights.data());
+                        }
+                    }
+                });
+        }
+
+        if (!out_of_time)
+        {
+            ++stats.iterations;
+        }
+    }
+
+    stats.sah_cost_after = sah_cost(tree);
+    stats.seconds = elapsed();
+
+    return stats;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Node layout
+//
+// cf. Yoon, Manocha (2006): Cache-Efficient Layouts of Bounding Volume Hierarchies
+//
+
+template <typename Tree>
+void reorder_nodes(Tree& tree, size_t cluster_size)
+{
+    if (tree.num_nodes() <= 1)
+    {
+        return;
+    }
+
+    auto const& nodes = tree.nodes();
+
+    // Sibling pairs are the unit of the layout
+    size_t pairs_per_cluster = std::max(cluster_size / (2 * sizeof(bvh_node)), size_t(1));
+
+    std::vector<unsigned> new_index(nodes.size(), ~0U);
+    new_index[0] = 0;
+
+    unsigned next = 1;
+
+    // First children of the pairs that start new clusters
+    std::vector<unsigned> cluster_roots;
+
+    if (is_inner(nodes[0]))
+    {
+        cluster_roots.push_back(nodes[0].get_child(0));
+    }
+
+    // Candidate pairs of the current cluster, max-heap by the surface area of
+    // their parent, i.e. by the probability that a ray visits them
+    std::vector<std::pair<float, unsigned>> heap;
+
+    while (!cluster_roots.empty())
+    {
+        heap.clear();
+        heap.emplace_back(0.0f, cluster_roots.back());
+        cluster_roots.pop_back();
+
+        for (size_t i = 0; i < pairs_per_cluster && !heap.empty(); ++i)
+        {
+            std::pop_heap(heap.begin(), heap.end());
+            unsigned first = heap.back().second;
+            heap.pop_back();
+
+            for (unsigned j = 0; j < 2; ++j)
+            {
+                auto const& n = nodes[first + j];
+
+                new_index[first + j] = next++;
+
+                if (is_inner(n))
+                {
+                    heap.emplace_back(surface_area(n.get_bounds()), n.get_child(0));
+                    std::push_heap(heap.begin(), heap.end());
+                }
+            }
+        }
+
+        // Pairs that did not fit start new clusters, depth-first, the most
+        // likely pair is on top of the stack
+        std::sort(heap.begin(), heap.end());
+
+        for (auto const& h : heap)
+        {
+            cluster_roots.push_back(h.second);
+        }
+    }
+
+    // Unreachable nodes are dropped
+    typename Tree::node_vector reordered(next);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        if (new_index[i] == ~0U)
+        {
+            continue;
+        }
+
+        bvh_node n = nodes[i];
+
+        if (is_inner(n))
+        {
+            // Copy, get_bounds() returns a reference to n's own storage
+            aabb bounds = n.get_bounds();
+            n.set_inner(bounds, new_index[n.get_child(0)]);
+        }
+
+        reordered[new_index[i]] = n;
+    }
+
+    tree.nodes().swap(reordered);
+
+    detail::clear_free_nodes(tree, is_index_bvh<Tree>());
+}
+
+} // visionaray
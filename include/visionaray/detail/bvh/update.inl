@@ -0,0 +1,546 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include <visionaray/math/aabb.h>
+
+
+namespace visionaray
+{
+namespace detail
+{
+
+//--------------------------------------------------------------------------------------------------
+// Dynamic updates
+//
+
+template <typename Nodes>
+inline unsigned allocate_node_pair(Nodes& nodes, std::vector<unsigned>& free_nodes)
+{
+    if (!free_nodes.empty())
+    {
+        unsigned first = free_nodes.back();
+        free_nodes.pop_back();
+        return first;
+    }
+
+    unsigned first = static_cast<unsigned>(nodes.size());
+
+    nodes.emplace_back();
+    nodes.emplace_back();
+
+    return first;
+}
+
+template <typename Nodes>
+inline void free_node_pair(Nodes& nodes, std::vector<unsigned>& free_nodes, unsigned first)
+{
+    // Unused nodes have no surface area and don't contribute to sah_cost()
+    nodes[first] = bvh_node{};
+    nodes[first + 1] = bvh_node{};
+
+    free_nodes.push_back(first);
+}
+
+// Slot from a free list, or a new slot at the end of the vector
+template <typename Vector, typename T>
+inline unsigned allocate_slot(Vector& vec, std::vector<unsigned>& free_slots, T const& value)
+{
+    if (!free_slots.empty())
+    {
+        unsigned slot = free_slots.back();
+        free_slots.pop_back();
+        vec[slot] = value;
+        return slot;
+    }
+
+    vec.push_back(value);
+    return static_cast<unsigned>(vec.size() - 1);
+}
+
+// True if no leaf of the subtree is more than max_height levels below its root
+template <typename Nodes>
+inline bool subtree_height_less_equal(Nodes const& nodes, unsigned index, unsigned max_height)
+{
+    std::vector<std::pair<unsigned, unsigned>> stack(1, { index, 0U });
+
+    while (!stack.empty())
+    {
+        auto e = stack.back();
+        stack.pop_back();
+
+        if (is_inner(nodes[e.first]))
+        {
+            if (e.second + 1 > max_height)
+            {
+                return false;
+            }
+
+            stack.emplace_back(nodes[e.first].get_child(0), e.second + 1);
+            stack.emplace_back(nodes[e.first].get_child(1), e.second + 1);
+        }
+    }
+
+    return true;
+}
+
+// Branch and bound search for the sibling of a new leaf w/ bounds, the
+// sibling's subtree is moved one level down. Appends the sibling's ancestors
+// to path, root first
+template <typename Nodes>
+inline unsigned find_best_sibling(Nodes const& nodes, aabb const& bounds, std::vector<unsigned>& path)
+{
+    struct candidate
+    {
+        unsigned index;
+        unsigned depth;
+        float    inherited;     // increase of the surface areas of the ancestors
+        int      parent;        // candidate of the parent
+    };
+
+    float leaf_area = surface_area(bounds);
+
+    std::vector<candidate> candidates(1, { 0U, 0U, 0.0f, -1 });
+
+    // Candidates by lower bound of their cost, smallest first
+    using entry = std::pair<float, int>;
+    std::priority_queue<entry, std::vector<entry>, std::greater<entry>> queue;
+    queue.push({ 0.0f, 0 });
+
+    float best_cost = std::numeric_limits<float>::max();
+    int best = 0;
+
+    while (!queue.empty())
+    {
+        auto e = queue.top();
+        queue.pop();
+
+        if (e.first + leaf_area >= best_cost)
+        {
+            break;
+        }
+
+        auto c = candidates[e.second];
+        auto const& n = nodes[c.index];
+
+        float area = surface_area(n.get_bounds());
+        float merged = surface_area(combine(n.get_bounds(), bounds));
+
+        if (merged + c.inherited < best_cost)
+        {
+            best_cost = merged + c.inherited;
+            best = e.second;
+        }
+
+        // The new leaf would be a level below the child
+        if (is_inner(n) && c.depth + 2 <= MaxLeafDepth)
+        {
+            float inherited = c.inherited + merged - area;
+
+            if (inherited + leaf_area < best_cost)
+            {
+                for (unsigned i = 0; i < 2; ++i)
+                {
+                    candidates.push_back({ n.get_child(i), c.depth + 1, inherited, e.second });
+                    queue.push({ inherited, static_cast<int>(candidates.size() - 1) });
+                }
+            }
+        }
+    }
+
+    size_t first = path.size();
+
+    for (int p = candidates[best].parent; p >= 0; p = candidates[p].parent)
+    {
+        path.push_back(candidates[p].index);
+    }
+
+    std::reverse(path.begin() + first, path.end());
+
+    unsigned sibling = candidates[best].index;
+    unsigned depth = candidates[best].depth;
+
+    // Descend if the subtree would become too deep, into the child w/ the
+    // smaller increase of its surface area first
+    while (!subtree_height_less_equal(nodes, sibling, MaxLeafDepth - depth - 1) && is_inner(nodes[sibling]))
+    {
+        unsigned c = nodes[sibling].get_child(0);
+
+        float d0 = surface_area(combine(nodes[c].get_bounds(), bounds)) - surface_area(nodes[c].get_bounds());
+        float d1 = surface_area(combine(nodes[c + 1].get_bounds(), bounds)) - surface_area(nodes[c + 1].get_bounds());
+
+        unsigned next = d0 <= d1 ? c : c + 1;
+
+        if (!subtree_height_less_equal(nodes, next, MaxLeafDepth - depth - 2))
+        {
+            next = next == c ? c + 1 : c;
+        }
+
+        path.push_back(sibling);
+        sibling = next;
+        ++depth;
+    }
+
+    return sibling;
+}
+
+// Swap a leaf child of node index w/ a grandchild if that reduces the surface
+// area of the leaf's sibling. The leaf moves one level down
+template <typename Nodes>
+inline void rotate(Nodes& nodes, unsigned index)
+{
+    unsigned c = nodes[index].get_child(0);
+
+    float best_gain = 0.0f;
+    unsigned best_leaf = 0;
+    unsigned best_grandchild = 0;
+
+    for (unsigned i = 0; i < 2; ++i)
+    {
+        auto const& leaf = nodes[c + i];
+        auto const& sibling = nodes[c + 1 - i];
+
+        if (!is_leaf(leaf) || !is_inner(sibling))
+        {
+            continue;
+        }
+
+        float area = surface_area(sibling.get_bounds());
+
+        for (unsigned j = 0; j < 2; ++j)
+        {
+            auto const& other = nodes[sibling.get_child(1 - j)];
+
+            float gain = area - surface_area(combine(leaf.get_bounds(), other.get_bounds()));
+
+            if (gain > best_gain)
+            {
+                best_gain = gain;
+                best_leaf = c + i;
+                best_grandchild = sibling.get_child(j);
+            }
+        }
+    }
+
+    if (best_gain > 0.0f)
+    {
+        unsigned sibling = best_leaf == c ? c + 1 : c;
+        unsigned g = nodes[sibling].get_child(0);
+
+        std::swap(nodes[best_leaf], nodes[best_grandchild]);
+
+        nodes[sibling].set_inner(combine(nodes[g].get_bounds(), nodes[g + 1].get_bounds()), g);
+    }
+}
+
+// Refit the inner nodes on path (root first, the depth of path[i] is i) bottom-up, and rotate them
+template <typename Nodes>
+inline void refit(Nodes& nodes, std::vector<unsigned> const& path)
+{
+    for (size_t i = path.size(); i-- > 0; )
+    {
+        unsigned index = path[i];
+        unsigned c = nodes[index].get_child(0);
+
+        nodes[index].set_inner(combine(nodes[c].get_bounds(), nodes[c + 1].get_bounds()), c);
+
+        if (i + 2 <= MaxLeafDepth)
+        {
+            rotate(nodes, index);
+        }
+    }
+}
+
+// Remove one reference to primitive prim_index from the leaves that overlap
+// bounds (or from any leaf if exhaustive). Returns false if there is none
+template <typename Tree>
+inline bool remove_reference(Tree& tree, unsigned prim_index, aabb const& bounds, bool exhaustive)
+{
+    auto& nodes = tree.nodes();
+    auto& indices = tree.indices();
+
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    std::vector<unsigned> path;
+    std::vector<std::pair<unsigned, unsigned>> stack(1, { 0U, 0U });
+
+    while (!stack.empty())
+    {
+        auto e = stack.back();
+        stack.pop_back();
+
+        // Ancestors of e.first
+        path.resize(e.second);
+
+        auto const& n = nodes[e.first];
+
+        if (!exhaustive && !intersect(n.get_bounds(), bounds).valid())
+        {
+            continue;
+        }
+
+        if (is_inner(n))
+        {
+            path.push_back(e.first);
+
+            stack.emplace_back(n.get_child(0), e.second + 1);
+            stack.emplace_back(n.get_child(1), e.second + 1);
+            continue;
+        }
+
+        unsigned first = n.get_indices().first;
+        unsigned last  = n.get_indices().last;
+
+        auto it = std::find(indices.begin() + first, indices.begin() + last, prim_index);
+
+        if (it == indices.begin() + last)
+        {
+            continue;
+        }
+
+        if (last - first > 1)
+        {
+            // Keep the leaf's bounds, they may be clipped (spatial splits)
+            *it = indices[last - 1];
+            nodes[e.first].set_leaf(n.get_bounds(), first, last - first - 1);
+            tree.free_indices().push_back(last - 1);
+            return true;
+        }
+
+        tree.free_indices().push_back(first);
+
+        if (path.empty())
+        {
+            // Removed the last leaf
+            nodes.clear();
+            indices.clear();
+            tree.free_nodes().clear();
+            tree.free_indices().clear();
+            return true;
+        }
+
+        // The sibling replaces the parent
+        unsigned parent = path.back();
+        unsigned c = nodes[parent].get_child(0);
+        unsigned sibling = e.first == c ? c + 1 : c;
+
+        nodes[parent] = nodes[sibling];
+        free_node_pair(nodes, tree.free_nodes(), c);
+
+        path.pop_back();
+        refit(nodes, path);
+
+        return true;
+    }
+
+    return false;
+}
+
+// Bounds of the primitives of a leaf
+template <typename Tree>
+inline aabb leaf_bounds(Tree const& tree, bvh_node const& leaf, std::true_type /* is_index_bvh */)
+{
+    aabb bounds;
+    bounds.invalidate();
+
+    for (unsigned i = leaf.get_indices().first; i != leaf.get_indices().last; ++i)
+    {
+        bounds = combine(bounds, get_bounds(tree.primitives()[tree.indices()[i]]));
+    }
+
+    return bounds;
+}
+
+template <typename Tree>
+inline aabb leaf_bounds(Tree const& tree, bvh_node const& leaf, std::false_type /* is_index_bvh */)
+{
+    aabb bounds;
+    bounds.invalidate();
+
+    for (unsigned i = leaf.get_indices().first; i != leaf.get_indices().last; ++i)
+    {
+        bounds = combine(bounds, get_bounds(tree.primitives()[i]));
+    }
+
+    return bounds;
+}
+
+} // detail
+
+
+//--------------------------------------------------------------------------------------------------
+// Dynamic updates
+//
+
+template <typename Tree, typename P>
+unsigned insert_primitive(Tree& tree, P const& prim)
+{
+    static_assert(is_index_bvh<Tree>::value, "insert_primitive() requires an index_bvh");
+
+    auto& nodes = tree.nodes();
+
+    unsigned prim_index = detail::allocate_slot(tree.primitives(), tree.free_primitives(), prim);
+    unsigned index = detail::allocate_slot(tree.indices(), tree.free_indices(), prim_index);
+
+    aabb bounds = get_bounds(prim);
+
+    bvh_node leaf;
+    leaf.set_leaf(bounds, index, 1);
+
+    if (nodes.empty())
+    {
+        nodes.push_back(leaf);
+        return prim_index;
+    }
+
+    std::vector<unsigned> path;
+    unsigned sibling = detail::find_best_sibling(nodes, bounds, path);
+
+    unsigned first = detail::allocate_node_pair(nodes, tree.free_nodes());
+
+    nodes[first] = nodes[sibling];
+    nodes[first + 1] = leaf;
+    nodes[sibling].set_inner(combine(nodes[first].get_bounds(), bounds), first);
+
+    path.push_back(sibling);
+    detail::refit(nodes, path);
+
+    return prim_index;
+}
+
+template <typename Tree>
+size_t remove_primitive(Tree& tree, unsigned prim_id)
+{
+    static_assert(is_index_bvh<Tree>::value, "remove_primitive() requires an index_bvh");
+
+    auto const& prims = tree.primitives();
+    auto const& free_prims = tree.free_primitives();
+
+    size_t num_removed = 0;
+
+    for (size_t i = 0; i < prims.size(); ++i)
+    {
+        if (prims[i].prim_id != prim_id
+         || std::find(free_prims.begin(), free_prims.end(), i) != free_prims.end())
+        {
+            continue;
+        }
+
+        unsigned prim_index = static_cast<unsigned>(i);
+        aabb bounds = get_bounds(prims[i]);
+
+        bool found = false;
+
+        // Primitives may be referenced more than once (spatial splits)
+        while (detail::remove_reference(tree, prim_index, bounds, false))
+        {
+            found = true;
+        }
+
+        // Bounds of clipped references may not overlap due to round-off
+        while (!found && detail::remove_reference(tree, prim_index, bounds, true))
+        {
+            while (detail::remove_reference(tree, prim_index, bounds, true))
+            {
+            }
+
+            found = true;
+        }
+
+        if (found)
+        {
+            tree.free_primitives().push_back(prim_index);
+            ++num_removed;
+        }
+    }
+
+    return num_removed;
+}
+
+template <typename Tree>
+void refit(Tree& tree)
+{
+    auto& nodes = tree.nodes();
+
+    if (nodes.empty())
+    {
+        return;
+    }
+
+    // Pre-order, children are refitted before their parents in reverse
+    std::vector<unsigned> order;
+    std::vector<unsigned> stack(1, 0);
+
+    while (!stack.empty())
+    {
+        unsigned index = stack.back();
+        stack.pop_back();
+
+        order.push_back(index);
+
+        if (is_inner(nodes[index]))
+        {
+            stack.push_back(nodes[index].get_child(0));
+            stack.push_back(nodes[index].get_child(1));
+        }
+    }
+
+    for (auto it = order.rbegin(); it != order.rend(); ++it)
+    {
+        bvh_node n = nodes[*it];
+
+        if (is_leaf(n))
+        {
+            auto bounds = detail::leaf_bounds(tree, n, is_index_bvh<Tree>());
+            nodes[*it].set_leaf(bounds, n.get_first_primitive(), n.get_num_primitives());
+        }
+        else
+        {
+            unsigned c = n.get_child(0);
+            nodes[*it].set_inner(combine(nodes[c].get_bounds(), nodes[c + 1].get_bounds()), c);
+        }
+    }
+}
+
+template <typename Tree>
+bool reoptimize_if_degraded(
+        Tree&           tree,
+        thread_pool&    pool,
+        float&          reference_cost,
+        float           max_degradation,
+        double          time_budget
+        )
+{
+    if (tree.num_nodes() == 0)
+    {
+        return false;
+    }
+
+    float cost = sah_cost(tree);
+
+    if (reference_cost <= 0.0f || cost <= reference_cost * (1.0f + max_degradation))
+    {
+        reference_cost = reference_cost <= 0.0f ? cost : reference_cost;
+        return false;
+    }
+
+    auto stats = optimize_treelets(tree, pool, 3, time_budget);
+
+    reference_cost = stats.sah_cost_after;
+
+    return true;
+}
+
+} // visionaray
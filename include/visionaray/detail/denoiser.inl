@@ -0,0 +1,490 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <type_traits>
+
+#include "../math/simd/type_traits.h"
+#include "../math/math.h"
+#include "parallel_for.h"
+#include "range.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Load FloatT from consecutive pixels of a row, x is clamped to [0..width)
+//
+
+template <typename FloatT>
+inline FloatT denoiser_load(std::false_type /* is simd */, float const* row, int x, int width)
+{
+    return row[std::max(0, std::min(x, width - 1))];
+}
+
+template <typename FloatT>
+inline FloatT denoiser_load(std::true_type /* is simd */, float const* row, int x, int width)
+{
+    static const int N = simd::num_elements<FloatT>::value;
+
+    simd::aligned_array_t<FloatT> v;
+
+    if (x >= 0 && x + N <= width)
+    {
+        std::memcpy(v, row + x, sizeof(v));
+    }
+    else
+    {
+        for (int i = 0; i < N; ++i)
+        {
+            v[i] = row[std::max(0, std::min(x + i, width - 1))];
+        }
+    }
+
+    return FloatT(v);
+}
+
+template <typename FloatT>
+inline FloatT denoiser_load(float const* row, int x, int width)
+{
+    return denoiser_load<FloatT>(
+            std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{},
+            row,
+            x,
+            width
+            );
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Store FloatT to consecutive pixels of a row, lanes beyond width are dropped
+//
+
+template <typename FloatT>
+inline void denoiser_store(std::false_type /* is simd */, float* row, int x, int width, FloatT const& value)
+{
+    VSNRAY_UNUSED(width);
+
+    row[x] = value;
+}
+
+template <typename FloatT>
+inline void denoiser_store(std::true_type /* is simd */, float* row, int x, int width, FloatT const& value)
+{
+    static const int N = simd::num_elements<FloatT>::value;
+
+    simd::aligned_array_t<FloatT> v;
+    store(v, value);
+
+    std::memcpy(row + x, v, std::min(N, width - x) * sizeof(float));
+}
+
+template <typename FloatT>
+inline void denoiser_store(float* row, int x, int width, FloatT const& value)
+{
+    denoiser_store<FloatT>(
+            std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{},
+            row,
+            x,
+            width,
+            value
+            );
+}
+
+template <typename FloatT>
+inline FloatT denoiser_luminance(FloatT const& r, FloatT const& g, FloatT const& b)
+{
+    return FloatT(0.2126f) * r + FloatT(0.7152f) * g + FloatT(0.0722f) * b;
+}
+
+//-------------------------------------------------------------------------------------------------
+// exp(-x), x >= 0, for the edge-stopping weights
+// SIMD: cubic approximation of 2^x, relative error < 2E-4, flushes to 2^-126
+//
+
+template <typename FloatT>
+inline FloatT denoiser_exp_neg(std::false_type /* is simd */, FloatT const& x)
+{
+    return std::exp(-x);
+}
+
+template <typename FloatT>
+inline FloatT denoiser_exp_neg(std::true_type /* is simd */, FloatT const& x)
+{
+    FloatT y = max(x * FloatT(-constants::log2_e<float>()), FloatT(-126.0f));
+    FloatT yi = floor(y);
+    FloatT f = y - yi;
+
+    FloatT p = FloatT(1.0f) + f * (FloatT(0.6960656f) + f * (FloatT(0.2244943f) + f * FloatT(0.0794402f)));
+
+    return reinterpret_as_float(reinterpret_as_int(p) + (convert_to_int(yi) << 23));
+}
+
+template <typename FloatT>
+inline FloatT denoiser_exp_neg(FloatT const& x)
+{
+    return denoiser_exp_neg(std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{}, x);
+}
+
+// Albedo used for (de)modulation, 1 where there is no albedo (background etc.)
+template <typename FloatT>
+inline FloatT denoiser_albedo(float const* plane, int y, int x, int width)
+{
+    if (plane == nullptr)
+    {
+        return FloatT(1.0f);
+    }
+
+    FloatT a = denoiser_load<FloatT>(plane + y * width, x, width);
+    return select(a > FloatT(1E-3f), a, FloatT(1.0f));
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Parameters
+//
+
+inline void denoiser::set_iterations(unsigned iterations)
+{
+    iterations_ = iterations;
+}
+
+inline unsigned denoiser::iterations() const
+{
+    return iterations_;
+}
+
+inline void denoiser::set_sigma_luminance(float sigma)
+{
+    sigma_luminance_ = sigma;
+}
+
+inline float denoiser::sigma_luminance() const
+{
+    return sigma_luminance_;
+}
+
+inline void denoiser::set_sigma_normal(float sigma)
+{
+    sigma_normal_ = sigma;
+}
+
+inline float denoiser::sigma_normal() const
+{
+    return sigma_normal_;
+}
+
+inline void denoiser::set_sigma_depth(float sigma)
+{
+    sigma_depth_ = sigma;
+}
+
+inline float denoiser::sigma_depth() const
+{
+    return sigma_depth_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Denoise
+//
+
+template <typename FloatT>
+inline void denoiser::denoise(thread_pool& pool, aov_buffer_rt<PF_RGBA32F> const& input, vec4* output)
+{
+    using std::sqrt;
+
+    static const int N = simd::num_elements<FloatT>::value;
+
+    int w = input.width();
+    int h = input.height();
+
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    resize(w, h);
+
+    vec4 const*  color  = input.color();
+    float const* depth  = input.depth();
+    float const* nx     = input.normal(0);
+    float const* ny     = input.normal(1);
+    float const* nz     = input.normal(2);
+    float const* albedo[3] = { input.albedo(0), input.albedo(1), input.albedo(2) };
+
+    bool use_normals = nx != nullptr;
+
+    // Narrow tiles, so that the rows the a-trous taps access stay in cache
+    // Tile width is a multiple of the SIMD width
+    tiled_range2d<int> tiles(0, w, 64, 0, h, 16);
+
+
+    // Demodulate color, depth gradients
+
+    parallel_for(pool, tiles, [&](range2d<int> const& r)
+    {
+        for (int y = r.cols().begin(); y != r.cols().end(); ++y)
+        {
+            for (int x = r.rows().begin(); x < r.rows().end(); x += N)
+            {
+                VSNRAY_ALIGN(64) float c[3][N];
+
+                for (int i = 0; i < N; ++i)
+                {
+                    vec4 const& cc = color[y * w + std::min(x + i, w - 1)];
+                    c[0][i] = cc.x;
+                    c[1][i] = cc.y;
+                    c[2][i] = cc.z;
+                }
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    FloatT a = detail::denoiser_albedo<FloatT>(albedo[k], y, x, w);
+                    FloatT v = detail::denoiser_load<FloatT>(c[k], 0, N) / a;
+                    detail::denoiser_store(color_[0][k].data() + y * w, x, w, v);
+                }
+
+                if (depth != nullptr)
+                {
+                    float const* row  = depth + y * w;
+                    float const* up   = depth + std::max(y - 1, 0) * w;
+                    float const* down = depth + std::min(y + 1, h - 1) * w;
+
+                    FloatT z = detail::denoiser_load<FloatT>(row, x, w);
+
+                    FloatT g = max(
+                            max(abs(z - detail::denoiser_load<FloatT>(row, x - 1, w)),
+                                abs(z - detail::denoiser_load<FloatT>(row, x + 1, w))),
+                            max(abs(z - detail::denoiser_load<FloatT>(up, x, w)),
+                                abs(z - detail::denoiser_load<FloatT>(down, x, w)))
+                            );
+
+                    detail::denoiser_store(depth_gradient_.data() + y * w, x, w, g);
+                }
+            }
+        }
+    });
+
+
+    // Spatial luminance variance estimate (3x3)
+
+    parallel_for(pool, tiles, [&](range2d<int> const& r)
+    {
+        for (int y = r.cols().begin(); y != r.cols().end(); ++y)
+        {
+            for (int x = r.rows().begin(); x < r.rows().end(); x += N)
+            {
+                FloatT m1(0.0f);
+                FloatT m2(0.0f);
+
+                for (int j = -1; j <= 1; ++j)
+                {
+                    int yy = std::max(0, std::min(y + j, h - 1));
+
+                    for (int i = -1; i <= 1; ++i)
+                    {
+                        FloatT l = detail::denoiser_luminance(
+                                detail::denoiser_load<FloatT>(color_[0][0].data() + yy * w, x + i, w),
+                                detail::denoiser_load<FloatT>(color_[0][1].data() + yy * w, x + i, w),
+                                detail::denoiser_load<FloatT>(color_[0][2].data() + yy * w, x + i, w)
+                                );
+
+                        m1 += l;
+                        m2 += l * l;
+                    }
+                }
+
+                m1 /= FloatT(9.0f);
+                m2 /= FloatT(9.0f);
+
+                detail::denoiser_store(variance_[0].data() + y * w, x, w, max(m2 - m1 * m1, FloatT(0.0f)));
+            }
+        }
+    });
+
+
+    // A-trous iterations
+
+    // 3x3 a-trous kernel
+    static const float kernel[] = { 1.0f / 2.0f, 1.0f / 4.0f };
+
+    FloatT sigma_l(sigma_luminance_);
+    FloatT inv_sigma_n2(1.0f / (sigma_normal_ * sigma_normal_));
+    FloatT sigma_z(sigma_depth_);
+
+    int src = 0;
+
+    for (unsigned it = 0; it < iterations_; ++it)
+    {
+        int dst = 1 - src;
+        int step = 1 << it;
+
+        parallel_for(pool, tiles, [&](range2d<int> const& r)
+        {
+            for (int y = r.cols().begin(); y != r.cols().end(); ++y)
+            {
+                for (int x = r.rows().begin(); x < r.rows().end(); x += N)
+                {
+                    int o = y * w;
+
+                    FloatT cr = detail::denoiser_load<FloatT>(color_[src][0].data() + o, x, w);
+                    FloatT cg = detail::denoiser_load<FloatT>(color_[src][1].data() + o, x, w);
+                    FloatT cb = detail::denoiser_load<FloatT>(color_[src][2].data() + o, x, w);
+                    FloatT cl = detail::denoiser_luminance(cr, cg, cb);
+                    FloatT cv = detail::denoiser_load<FloatT>(variance_[src].data() + o, x, w);
+
+                    FloatT inv_sigma_l = FloatT(1.0f) / (sigma_l * sqrt(cv) + FloatT(1E-6f));
+
+                    FloatT cnx(0.0f);
+                    FloatT cny(0.0f);
+                    FloatT cnz(0.0f);
+
+                    if (use_normals)
+                    {
+                        cnx = detail::denoiser_load<FloatT>(nx + o, x, w);
+                        cny = detail::denoiser_load<FloatT>(ny + o, x, w);
+                        cnz = detail::denoiser_load<FloatT>(nz + o, x, w);
+                    }
+
+                    // Depth differences are relative to the gradient times the
+                    // Manhattan distance of the tap (0..2 steps)
+                    FloatT cz(0.0f);
+                    FloatT inv_sigma_z[3];
+
+                    if (depth != nullptr)
+                    {
+                        cz = detail::denoiser_load<FloatT>(depth + o, x, w);
+
+                        FloatT g = detail::denoiser_load<FloatT>(depth_gradient_.data() + o, x, w) * sigma_z;
+
+                        for (int d = 0; d < 3; ++d)
+                        {
+                            inv_sigma_z[d] = FloatT(1.0f) / (g * FloatT(static_cast<float>(step * d)) + FloatT(1E-6f));
+                        }
+                    }
+
+                    FloatT sum_w(0.0f);
+                    FloatT sum_w2v(0.0f);
+                    FloatT sum_r(0.0f);
+                    FloatT sum_g(0.0f);
+                    FloatT sum_b(0.0f);
+
+                    for (int j = -1; j <= 1; ++j)
+                    {
+                        int yy = std::max(0, std::min(y + j * step, h - 1));
+                        int oo = yy * w;
+
+                        for (int i = -1; i <= 1; ++i)
+                        {
+                            int xx = x + i * step;
+
+                            FloatT qr = detail::denoiser_load<FloatT>(color_[src][0].data() + oo, xx, w);
+                            FloatT qg = detail::denoiser_load<FloatT>(color_[src][1].data() + oo, xx, w);
+                            FloatT qb = detail::denoiser_load<FloatT>(color_[src][2].data() + oo, xx, w);
+                            FloatT qv = detail::denoiser_load<FloatT>(variance_[src].data() + oo, xx, w);
+
+                            // Sum of the edge-stopping exponents
+                            FloatT e = abs(detail::denoiser_luminance(qr, qg, qb) - cl) * inv_sigma_l;
+
+                            if (use_normals)
+                            {
+                                FloatT dx = detail::denoiser_load<FloatT>(nx + oo, xx, w) - cnx;
+                                FloatT dy = detail::denoiser_load<FloatT>(ny + oo, xx, w) - cny;
+                                FloatT dz = detail::denoiser_load<FloatT>(nz + oo, xx, w) - cnz;
+                                e += (dx * dx + dy * dy + dz * dz) * inv_sigma_n2;
+                            }
+
+                            if (depth != nullptr)
+                            {
+                                FloatT qz = detail::denoiser_load<FloatT>(depth + oo, xx, w);
+                                e += abs(qz - cz) * inv_sigma_z[std::abs(i) + std::abs(j)];
+                            }
+
+                            FloatT wq = FloatT(kernel[std::abs(i)] * kernel[std::abs(j)]) * detail::denoiser_exp_neg(e);
+
+                            sum_w   += wq;
+                            sum_w2v += wq * wq * qv;
+                            sum_r   += wq * qr;
+                            sum_g   += wq * qg;
+                            sum_b   += wq * qb;
+                        }
+                    }
+
+                    // The center tap has weight > 0, so sum_w > 0
+                    FloatT inv_w = FloatT(1.0f) / sum_w;
+
+                    detail::denoiser_store(color_[dst][0].data() + o, x, w, sum_r * inv_w);
+                    detail::denoiser_store(color_[dst][1].data() + o, x, w, sum_g * inv_w);
+                    detail::denoiser_store(color_[dst][2].data() + o, x, w, sum_b * inv_w);
+                    detail::denoiser_store(variance_[dst].data() + o, x, w, sum_w2v * inv_w * inv_w);
+                }
+            }
+        });
+
+        src = dst;
+    }
+
+
+    // Remodulate
+
+    parallel_for(pool, tiles, [&](range2d<int> const& r)
+    {
+        for (int y = r.cols().begin(); y != r.cols().end(); ++y)
+        {
+            for (int x = r.rows().begin(); x < r.rows().end(); x += N)
+            {
+                VSNRAY_ALIGN(64) float c[3][N];
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    FloatT a = detail::denoiser_albedo<FloatT>(albedo[k], y, x, w);
+                    FloatT v = detail::denoiser_load<FloatT>(color_[src][k].data() + y * w, x, w) * a;
+                    detail::denoiser_store(c[k], 0, N, v);
+                }
+
+                for (int i = 0; i < N && x + i < w; ++i)
+                {
+                    int index = y * w + x + i;
+                    output[index] = vec4(c[0][i], c[1][i], c[2][i], color[index].w);
+                }
+            }
+        }
+    });
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//
+
+inline void denoiser::resize(int w, int h)
+{
+    if (w == width_ && h == height_)
+    {
+        return;
+    }
+
+    width_  = w;
+    height_ = h;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        for (int k = 0; k < 3; ++k)
+        {
+            color_[i][k].resize(w * h);
+        }
+
+        variance_[i].resize(w * h);
+    }
+
+    depth_gradient_.resize(w * h);
+}
+
+} // visionaray
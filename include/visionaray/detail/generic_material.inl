@@ -2,6 +2,8 @@
 // See the LICENSE file for details.
 
 #include <cstddef>
+#include <type_traits>
+#include <utility>
 
 #include <visionaray/math/array.h>
 #include <visionaray/material.h>
@@ -34,6 +36,13 @@ inline spectrum<typename T::scalar_type> generic_material<T, Ts...>::ambient() c
     return apply_visitor( ambient_visitor(), *this );
 }
 
+template <typename T, typename ...Ts>
+VSNRAY_FUNC
+inline spectrum<typename T::scalar_type> generic_material<T, Ts...>::albedo() const
+{
+    return apply_visitor( albedo_visitor(), *this );
+}
+
 template <typename T, typename ...Ts>
 template <typename SR>
 VSNRAY_FUNC
@@ -95,6 +104,20 @@ struct generic_material<T, Ts...>::ambient_visitor
     }
 };
 
+template <typename T, typename ...Ts>
+struct generic_material<T, Ts...>::albedo_visitor
+{
+    using Base = generic_material<T, Ts...>;
+    using return_type = spectrum<typename Base::scalar_type>;
+
+    template <typename X>
+    VSNRAY_FUNC
+    return_type operator()(X const& ref) const
+    {
+        return ref.albedo();
+    }
+};
+
 template <typename T, typename ...Ts>
 template <typename SR>
 struct generic_material<T, Ts...>::shade_visitor
@@ -147,10 +170,149 @@ struct generic_material<T, Ts...>::sample_visitor
 
 namespace simd
 {
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Test if N materials of type M can be packed into a single SIMD material
+//
+
+template <typename M, size_t N>
+class has_simd_pack
+{
+    template <typename U>
+    static std::true_type test(decltype(pack(std::declval<array<U, N> const&>()))*);
+
+    template <typename U>
+    static std::false_type test(...);
+
+public:
+
+    using type = decltype( test<M>(nullptr) );
+    static constexpr bool value = type::value;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Coherent dispatch
+//
+// Visits the materials of a packet type by type. If at least MinLanes lanes
+// refer to a material type M that can be packed, these lanes are gathered into
+// a SIMD material and the visitor is called once with the SIMD material and a
+// mask of the lanes of type M. Inactive lanes of the SIMD material hold a copy
+// of an active lane, so that all lanes compute meaningful values. Visited
+// lanes are flagged in covered, the caller handles the remaining lanes.
+//
+
+template <size_t N, typename ...Ts>
+struct coherent_dispatch;
+
+template <size_t N>
+struct coherent_dispatch<N>
+{
+    template <typename Materials, typename Visitor, typename Covered>
+    VSNRAY_FUNC
+    static size_t apply(Materials const&, Visitor&, Covered&, size_t, size_t)
+    {
+        return 0;
+    }
+};
+
+template <size_t N, typename T, typename ...Ts>
+struct coherent_dispatch<N, T, Ts...>
+{
+    template <typename Materials, typename Visitor, typename Covered>
+    VSNRAY_FUNC
+    static size_t apply(Materials const& mats, Visitor& visitor, Covered& covered, size_t min_lanes, size_t visited)
+    {
+        if (visited >= N)
+        {
+            return 0;
+        }
+
+        size_t count = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            count += mats[i].template as<T>() != nullptr ? 1 : 0;
+        }
+
+        size_t num_covered = 0;
+
+        if (count >= min_lanes && count > 0)
+        {
+            num_covered = visit(mats, visitor, covered, typename has_simd_pack<T, N>::type{});
+        }
+
+        return num_covered + coherent_dispatch<N, Ts...>::apply(mats, visitor, covered, min_lanes, visited + count);
+    }
+
+    template <typename Materials, typename Visitor, typename Covered>
+    VSNRAY_FUNC
+    static size_t visit(Materials const& mats, Visitor& visitor, Covered& covered, std::true_type /* has pack */)
+    {
+        using mask_t = typename Visitor::mask_type;
+
+        array<T, N> lanes;
+        aligned_array_t<mask_t> active;
+        T const* first = nullptr;
+        size_t count = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto ptr = mats[i].template as<T>();
+
+            active[i] = ptr != nullptr;
+
+            if (ptr != nullptr)
+            {
+                lanes[i] = *ptr;
+                first = first != nullptr ? first : ptr;
+                covered[i] = true;
+                ++count;
+            }
+        }
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (!active[i])
+            {
+                lanes[i] = *first;
+            }
+        }
+
+        visitor(pack(lanes), mask_t(active), count == N);
+
+        return count;
+    }
+
+    template <typename Materials, typename Visitor, typename Covered>
+    VSNRAY_FUNC
+    static size_t visit(Materials const&, Visitor&, Covered&, std::false_type /* has pack */)
+    {
+        return 0;
+    }
+};
+
+} // detail
+
 
 //-------------------------------------------------------------------------------------------------
 // SIMD type used internally. Contains N generic materials
 //
+// ambient(), albedo(), shade() and sample() dispatch coherently: each material
+// type that is present in at least 3/4 of the non-empty lanes is evaluated only
+// once, as a SIMD material over all lanes, and the results are merged with
+// select(). Packets that hit a single material type thus take the full SIMD
+// code path. The remaining lanes, and material types that cannot be packed,
+// are evaluated per lane with the scalar generic material. Empty lanes (e.g.
+// rays that missed) are not evaluated, their results are zero.
+//
+// Mixed packets are not split into one masked SIMD pass per type: the SIMD
+// material computes all lanes, so types that only cover a few lanes are
+// cheaper per lane (see BM_GenericMaterialShade/Sample).
+//
 
 template <size_t N, typename ...Ts>
 class generic_material
@@ -199,14 +361,43 @@ public:
     VSNRAY_FUNC
     spectrum<scalar_type> ambient() const
     {
+        ambient_visitor visitor;
+        mask_array covered;
+
+        if (dispatch(visitor, covered) == N)
+        {
+            return visitor.result;
+        }
+
         array<spectrum<float>, N> amb;
 
         for (size_t i = 0; i < N; ++i)
         {
-            amb[i] = mats_[i].ambient();
+            amb[i] = covered[i] ? spectrum<float>(0.0f) : mats_[i].ambient();
         }
 
-        return pack(amb);
+        return select(mask_type(covered), visitor.result, pack(amb));
+    }
+
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        albedo_visitor visitor;
+        mask_array covered;
+
+        if (dispatch(visitor, covered) == N)
+        {
+            return visitor.result;
+        }
+
+        array<spectrum<float>, N> alb;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            alb[i] = covered[i] ? spectrum<float>(0.0f) : mats_[i].albedo();
+        }
+
+        return select(mask_type(covered), visitor.result, pack(alb));
     }
 
 
@@ -214,16 +405,24 @@ public:
     VSNRAY_FUNC
     spectrum<scalar_type> shade(SR const& sr) const
     {
+        shade_visitor<SR> visitor(sr);
+        mask_array covered;
+
+        if (dispatch(visitor, covered) == N)
+        {
+            return visitor.result;
+        }
+
         auto srs = unpack(sr);
 
         array<spectrum<float>, N> shaded;
 
         for (size_t i = 0; i < N; ++i)
         {
-            shaded[i] = mats_[i].shade(srs[i]);
+            shaded[i] = covered[i] ? spectrum<float>(0.0f) : mats_[i].shade(srs[i]);
         }
 
-        return pack(shaded);
+        return select(mask_type(covered), visitor.result, pack(shaded));
     }
 
     template <typename SR, typename Generator>
@@ -239,6 +438,17 @@ public:
         using float_array = aligned_array_t<scalar_type>;
         using int_array = aligned_array_t<int_type_t<scalar_type>>;
 
+        sample_visitor<SR, Generator> visitor(sr, gen);
+        mask_array covered;
+
+        if (dispatch(visitor, covered) == N)
+        {
+            refl_dir = visitor.refl_dir;
+            pdf = visitor.pdf;
+            inter = visitor.inter;
+            return visitor.result;
+        }
+
         auto srs = unpack(sr);
 
         array<vector<3, float>, N> rds;
@@ -246,21 +456,183 @@ public:
         int_array                  inters;
         array<spectrum<float>, N>  sampled;
 
+        store(pdfs, visitor.pdf);
+        store(inters, visitor.inter);
+
         for (size_t i = 0; i < N; ++i)
         {
-            sampled[i] = mats_[i].sample(srs[i], rds[i], pdfs[i], inters[i], gen.get_generator(i));
+            if (covered[i])
+            {
+                rds[i] = vector<3, float>(0.0f);
+                sampled[i] = spectrum<float>(0.0f);
+            }
+            else
+            {
+                sampled[i] = mats_[i].sample(srs[i], rds[i], pdfs[i], inters[i], gen.get_generator(i));
+            }
         }
 
-        refl_dir = pack(rds);
+        refl_dir = select(mask_type(covered), visitor.refl_dir, pack(rds));
         pdf = scalar_type(pdfs);
         inter = int_type_t<scalar_type>(inters);
-        return pack(sampled);
+        return select(mask_type(covered), visitor.result, pack(sampled));
     }
 
 private:
 
+    using mask_type  = mask_type_t<scalar_type>;
+    using mask_array = aligned_array_t<mask_type>;
+
     array<single_material, N> mats_;
 
+    // Returns the number of lanes that were evaluated with SIMD materials or
+    // are empty, the visitor's initial result is kept for empty lanes
+    template <typename Visitor>
+    VSNRAY_FUNC
+    size_t dispatch(Visitor& visitor, mask_array& covered) const
+    {
+        size_t num_empty = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            covered[i] = mats_[i].which() == 0;
+            num_empty += covered[i] ? 1 : 0;
+        }
+
+        // SIMD evaluation for material types in at least 3/4 of the non-empty lanes
+        size_t min_lanes = (N - num_empty) * 3 / 4;
+
+        return num_empty + detail::coherent_dispatch<N, Ts...>::apply(mats_, visitor, covered, min_lanes, num_empty);
+    }
+
+    // Coherent dispatch visitors, called with a SIMD material and its lanes
+
+    struct ambient_visitor;
+
+    struct albedo_visitor;
+
+    template <typename SR>
+    struct shade_visitor;
+
+    template <typename SR, typename Generator>
+    struct sample_visitor;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Private coherent dispatch visitors
+//
+
+template <size_t N, typename ...Ts>
+struct generic_material<N, Ts...>::ambient_visitor
+{
+    using mask_type = mask_type_t<scalar_type>;
+
+    VSNRAY_FUNC
+    ambient_visitor()
+        : result(scalar_type(0.0f))
+    {
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    void operator()(M const& mat, mask_type const& m, bool all)
+    {
+        result = all ? mat.ambient() : select(m, mat.ambient(), result);
+    }
+
+    spectrum<scalar_type> result;
+};
+
+template <size_t N, typename ...Ts>
+struct generic_material<N, Ts...>::albedo_visitor
+{
+    using mask_type = mask_type_t<scalar_type>;
+
+    VSNRAY_FUNC
+    albedo_visitor()
+        : result(scalar_type(0.0f))
+    {
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    void operator()(M const& mat, mask_type const& m, bool all)
+    {
+        result = all ? mat.albedo() : select(m, mat.albedo(), result);
+    }
+
+    spectrum<scalar_type> result;
+};
+
+template <size_t N, typename ...Ts>
+template <typename SR>
+struct generic_material<N, Ts...>::shade_visitor
+{
+    using mask_type = mask_type_t<scalar_type>;
+
+    VSNRAY_FUNC
+    shade_visitor(SR const& sr)
+        : sr_(sr)
+        , result(scalar_type(0.0f))
+    {
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    void operator()(M const& mat, mask_type const& m, bool all)
+    {
+        result = all ? mat.shade(sr_) : select(m, mat.shade(sr_), result);
+    }
+
+    SR const& sr_;
+    spectrum<scalar_type> result;
+};
+
+// The SIMD generator draws random numbers for all lanes, also for inactive ones
+template <size_t N, typename ...Ts>
+template <typename SR, typename Generator>
+struct generic_material<N, Ts...>::sample_visitor
+{
+    using mask_type = mask_type_t<scalar_type>;
+    using int_type  = int_type_t<scalar_type>;
+
+    VSNRAY_FUNC
+    sample_visitor(SR const& sr, Generator& gen)
+        : sr_(sr)
+        , gen_(gen)
+        , result(scalar_type(0.0f))
+        , refl_dir(scalar_type(0.0f))
+        , pdf(0.0f)
+        , inter(0)
+    {
+    }
+
+    template <typename M>
+    VSNRAY_FUNC
+    void operator()(M const& mat, mask_type const& m, bool all)
+    {
+        // Not all materials write all outputs (e.g. emissive)
+        vector<3, scalar_type> rd(scalar_type(0.0f));
+        scalar_type p(0.0f);
+        int_type i(0);
+
+        auto s = mat.sample(sr_, rd, p, i, gen_);
+
+        result   = all ? s  : select(m, s,  result);
+        refl_dir = all ? rd : select(m, rd, refl_dir);
+        pdf      = all ? p  : select(m, p,  pdf);
+        inter    = all ? i  : select(m, i,  inter);
+    }
+
+    SR const&               sr_;
+    Generator&              gen_;
+
+    spectrum<scalar_type>   result;
+    vector<3, scalar_type>  refl_dir;
+    scalar_type             pdf;
+    int_type                inter;
 };
 
 
@@ -0,0 +1,143 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_HEATMAP_INL
+#define VSNRAY_DETAIL_HEATMAP_INL 1
+
+#include <visionaray/math/vector.h>
+#include <visionaray/result_record.h>
+#include <visionaray/traversal_counters.h>
+#include <visionaray/traverse.h>
+
+namespace visionaray
+{
+namespace heatmap
+{
+
+//-------------------------------------------------------------------------------------------------
+// Counter that is visualized
+//
+
+enum counter_type
+{
+    Nodes,          // BVH nodes visited
+    Boxes,          // ray / AABB tests
+    Primitives,     // ray / primitive tests
+    StackDepth      // max. traversal stack depth
+};
+
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Map [0..1] to blue - cyan - green - yellow - red
+//
+
+VSNRAY_FUNC
+inline vec3 color_ramp(float t)
+{
+    t = t < 0.0f ? 0.0f : t > 1.0f ? 1.0f : t;
+
+    if (t < 0.25f)
+    {
+        return vec3(0.0f, t * 4.0f, 1.0f);
+    }
+    else if (t < 0.5f)
+    {
+        return vec3(0.0f, 1.0f, 1.0f - (t - 0.25f) * 4.0f);
+    }
+    else if (t < 0.75f)
+    {
+        return vec3((t - 0.5f) * 4.0f, 1.0f, 0.0f);
+    }
+    else
+    {
+        return vec3(1.0f, 1.0f - (t - 0.75f) * 4.0f, 0.0f);
+    }
+}
+
+VSNRAY_FUNC
+inline float get_count(traversal_counters const& c, counter_type counter)
+{
+    switch (counter)
+    {
+    case Nodes:         return static_cast<float>(c.nodes);
+    case Boxes:         return static_cast<float>(c.boxes);
+    case Primitives:    return static_cast<float>(c.prims);
+    case StackDepth:    return static_cast<float>(c.max_stack_depth);
+    }
+
+    return 0.0f;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Debug kernel, traces primary rays and colors each pixel by the traversal
+// cost of its ray (or of its packet, for SIMD rays)
+//
+// Parameters:
+//      params:     kernel params, only primitives are used
+//      counter:    the counter to visualize
+//      max_count:  count that maps to red
+//      stats:      optional, if not null the counters are added to it (host only)
+//
+
+template <typename Params>
+struct kernel
+{
+
+    Params params;
+    counter_type counter;
+    float max_count;
+    traversal_statistics* stats;
+
+    // The intersector must derive from basic_counting_intersector
+    template <typename Intersector, typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(Intersector const& isect, R ray) const
+    {
+        using S = typename R::scalar_type;
+        using C = typename result_record<S>::color_type;
+
+        // Intersectors passed with the scheduler params are shared by all threads
+        Intersector counting = isect;
+        counting.counters = traversal_counters();
+
+        result_record<S> result;
+
+        auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, counting);
+
+        counting.counters.rays = 1;
+
+        vec3 clr = detail::color_ramp( detail::get_count(counting.counters, counter) / max_count );
+
+        result.color     = C(vec4(clr, 1.0f));
+        result.hit       = hit_rec.hit;
+        result.isect_pos = ray.ori + ray.dir * hit_rec.t;
+
+#ifndef __CUDA_ARCH__
+        if (stats != nullptr)
+        {
+            stats->add(counting.counters);
+        }
+#endif
+
+        return result;
+    }
+
+    template <typename R>
+    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    {
+        counting_intersector isect;
+        return (*this)(isect, ray);
+    }
+};
+
+} // heatmap
+} // visionaray
+
+#endif // VSNRAY_DETAIL_HEATMAP_INL
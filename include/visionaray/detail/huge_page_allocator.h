@@ -0,0 +1,222 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_HUGE_PAGE_ALLOCATOR_H
+#define VSNRAY_DETAIL_HUGE_PAGE_ALLOCATOR_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+
+#include "aligned_allocator.h"
+#include "macros.h"
+#include "platform.h"
+
+#if VSNRAY_OS_LINUX
+#include <sys/mman.h>
+#endif
+
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Huge page memory (Linux only)
+//
+// Allocations are rounded up to multiples of the huge page size (2 MB on
+// x86-64). Explicit huge pages (MAP_HUGETLB) are used if the administrator
+// reserved some (vm.nr_hugepages), otherwise the memory is 2 MB aligned and
+// marked eligible for transparent huge pages (madvise(MADV_HUGEPAGE)).
+//
+
+static const size_t HugePageSize = size_t(2) << 20;
+
+inline size_t huge_page_round_up(size_t size)
+{
+    return (size + HugePageSize - 1) & ~(HugePageSize - 1);
+}
+
+inline void* huge_page_alloc(size_t size)
+{
+#if VSNRAY_OS_LINUX
+    size = huge_page_round_up(size);
+
+#ifdef MAP_HUGETLB
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+
+    if (ptr != MAP_FAILED)
+    {
+        return ptr;
+    }
+#endif
+
+    // Over-allocate and trim to obtain a 2 MB aligned range
+    size_t mapped_size = size + HugePageSize;
+    void* mapped = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (mapped == MAP_FAILED)
+    {
+        return nullptr;
+    }
+
+    auto first = reinterpret_cast<uintptr_t>(mapped);
+    auto aligned = (first + HugePageSize - 1) & ~(uintptr_t(HugePageSize) - 1);
+    auto last = first + mapped_size;
+
+    if (aligned > first)
+    {
+        munmap(mapped, aligned - first);
+    }
+
+    if (last > aligned + size)
+    {
+        munmap(reinterpret_cast<void*>(aligned + size), last - (aligned + size));
+    }
+
+#ifdef MADV_HUGEPAGE
+    madvise(reinterpret_cast<void*>(aligned), size, MADV_HUGEPAGE);
+#endif
+
+    return reinterpret_cast<void*>(aligned);
+#else
+    VSNRAY_UNUSED(size);
+    return nullptr;
+#endif
+}
+
+inline void huge_page_free(void* ptr, size_t size)
+{
+#if VSNRAY_OS_LINUX
+    munmap(ptr, huge_page_round_up(size));
+#else
+    VSNRAY_UNUSED(ptr);
+    VSNRAY_UNUSED(size);
+#endif
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Allocator that backs large allocations with huge pages
+//
+// Use for large arrays that are accessed randomly, e.g. BVH nodes and
+// primitives or texture data, to reduce TLB misses. Allocations smaller than
+// a huge page (and all allocations on other platforms than Linux) fall back
+// to aligned_allocator.
+//
+
+template <typename T, size_t A>
+class huge_page_allocator
+{
+public:
+
+    typedef T value_type;
+    typedef T* pointer;
+    typedef const T* const_pointer;
+    typedef T& reference;
+    typedef const T& const_reference;
+    typedef size_t size_type;
+    typedef ptrdiff_t difference_type;
+
+    huge_page_allocator() = default;
+
+    huge_page_allocator(huge_page_allocator const& /* rhs */)
+    {
+    }
+
+    template <typename U>
+    huge_page_allocator(huge_page_allocator<U, A> const& /* rhs */)
+    {
+    }
+
+    template <typename U>
+    struct rebind
+    {
+        typedef huge_page_allocator<U, A> other;
+    };
+
+    pointer address(reference r) const
+    {
+        return &r;
+    }
+
+    const_pointer address(const_reference r) const
+    {
+        return &r;
+    }
+
+    pointer allocate(size_type n, void* /* hint */ = 0)
+    {
+        if (use_huge_pages(n))
+        {
+            void* ptr = detail::huge_page_alloc(n * sizeof(T));
+
+            if (ptr == nullptr)
+            {
+                throw std::bad_alloc();
+            }
+
+            return static_cast<pointer>(ptr);
+        }
+
+        return (pointer)_mm_malloc(n * sizeof(T), A);
+    }
+
+    void deallocate(pointer p, size_type n)
+    {
+        if (use_huge_pages(n))
+        {
+            detail::huge_page_free(p, n * sizeof(T));
+        }
+        else
+        {
+            _mm_free(p);
+        }
+    }
+
+    size_t max_size() const
+    {
+        return static_cast<size_t>(-1) / sizeof(T);
+    }
+
+    void construct(pointer p, const_reference val)
+    {
+        new(static_cast<void*>(p)) T(val);
+    }
+
+    void destroy(pointer p)
+    {
+        p->T::~T();
+    }
+
+    bool operator==(huge_page_allocator const& /* rhs */) const
+    {
+        return true;
+    }
+
+    bool operator!=(huge_page_allocator const& rhs) const
+    {
+        return !(*this == rhs);
+    }
+
+private:
+
+    static bool use_huge_pages(size_type n)
+    {
+#if VSNRAY_OS_LINUX
+        return n * sizeof(T) >= detail::HugePageSize;
+#else
+        VSNRAY_UNUSED(n);
+        return false;
+#endif
+    }
+};
+
+} // visionaray
+
+#endif // VSNRAY_DETAIL_HUGE_PAGE_ALLOCATOR_H
@@ -17,6 +17,13 @@ inline spectrum<T> emissive<T>::ambient() const
     return spectrum<T>();
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> emissive<T>::albedo() const
+{
+    return ce_;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -15,6 +15,13 @@ inline spectrum<T> glass<T>::ambient() const
     return spectrum<T>(0.0); // TODO: no support for  ambient
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> glass<T>::albedo() const
+{
+    return specular_bsdf_.ct * specular_bsdf_.kt;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
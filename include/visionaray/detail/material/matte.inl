@@ -17,6 +17,13 @@ inline spectrum<T> matte<T>::ambient() const
     return ca_ * ka_;
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> matte<T>::albedo() const
+{
+    return diffuse_brdf_.cd * diffuse_brdf_.kd;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
@@ -15,6 +15,13 @@ inline spectrum<T> mirror<T>::ambient() const
     return spectrum<T>(0.0); // TODO: no support for  ambient
 }
 
+template <typename T>
+VSNRAY_FUNC
+inline spectrum<T> mirror<T>::albedo() const
+{
+    return specular_brdf_.cr * specular_brdf_.kr;
+}
+
 template <typename T>
 template <typename SR>
 VSNRAY_FUNC
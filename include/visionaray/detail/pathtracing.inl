@@ -20,14 +20,14 @@ namespace visionaray
 namespace pathtracing
 {
 
-template <typename Params>
+template <typename Params, template <typename> class Result = result_record>
 struct kernel
 {
 
     Params params;
 
     template <typename Intersector, typename R, typename Generator>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(
             Intersector& isect,
             R ray,
             Generator& gen
@@ -42,7 +42,7 @@ struct kernel
 
         C dst(1.0);
 
-        result_record<S> result;
+        Result<S> result;
         result.color = params.bg_color;
 
         for (unsigned bounce = 0; bounce < params.num_bounces; ++bounce)
@@ -79,6 +79,11 @@ struct kernel
 
             auto surf = get_surface(hit_rec, params);
 
+            if (bounce == 0)
+            {
+                set_aovs(result, hit_rec, surf);
+            }
+
             S pdf(0.0);
             I inter = 0;
 
@@ -112,7 +117,7 @@ struct kernel
     }
 
     template <typename R, typename Generator>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(
             R ray,
             Generator& gen
             ) const
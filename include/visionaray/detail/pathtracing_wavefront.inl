@@ -0,0 +1,360 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL
+#define VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL 1
+
+#include <algorithm>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#include <visionaray/math/simd/type_traits.h>
+#include <visionaray/math/array.h>
+#include <visionaray/get_surface.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/result_record.h>
+#include <visionaray/spectrum.h>
+#include <visionaray/traverse.h>
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Conversions between the lanes of a packet and the packet, T is the packet's scalar type.
+// T == float is the degenerate case of a packet with a single lane
+//
+
+template <typename T, typename U>
+inline U wavefront_pack(array<U, 1> const& lanes)
+{
+    return lanes[0];
+}
+
+template <
+    typename T,
+    typename U,
+    size_t N,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline auto wavefront_pack(array<U, N> const& lanes)
+    -> decltype( simd::pack(lanes) )
+{
+    return simd::pack(lanes);
+}
+
+template <
+    typename T,
+    typename U,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type
+    >
+inline array<U, 1> wavefront_unpack(U const& packet)
+{
+    return {{ packet }};
+}
+
+template <
+    typename T,
+    typename U,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline auto wavefront_unpack(U const& packet)
+    -> decltype( simd::unpack(packet) )
+{
+    return simd::unpack(packet);
+}
+
+// Store a mask as 0/1 integers, the mask may also be a plain bool
+template <typename T>
+inline void wavefront_store_mask(int* dst, bool m)
+{
+    std::fill(dst, dst + simd::num_elements<T>::value, m ? 1 : 0);
+}
+
+template <
+    typename T,
+    typename M,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline void wavefront_store_mask(int* dst, M const& m)
+{
+    using I = simd::int_type_t<T>;
+
+    simd::aligned_array_t<I> arr;
+    store(arr, select(m, I(1), I(0)));
+
+    std::copy(arr, arr + simd::num_elements<T>::value, dst);
+}
+
+// Generator of a packet, and access to the generator of a single lane
+template <
+    typename T,
+    typename = typename std::enable_if<!simd::is_simd_vector<T>::value>::type
+    >
+inline random_generator<T> make_wavefront_generator()
+{
+    return random_generator<T>();
+}
+
+template <
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type,
+    typename = void
+    >
+inline random_generator<T> make_wavefront_generator()
+{
+    return random_generator<T>(array<unsigned, simd::num_elements<T>::value>{{}});
+}
+
+inline random_generator<float>& wavefront_lane_generator(random_generator<float>& gen, size_t /* lane */)
+{
+    return gen;
+}
+
+template <
+    typename T,
+    typename = typename std::enable_if<simd::is_simd_vector<T>::value>::type
+    >
+inline random_generator<float>& wavefront_lane_generator(random_generator<T>& gen, size_t lane)
+{
+    return gen.get_generator(lane);
+}
+
+} // detail
+
+
+namespace pathtracing
+{
+
+//-------------------------------------------------------------------------------------------------
+// Path tracing kernel for the wavefront_sched, computes the same image as
+// pathtracing::kernel, but in stages (see wavefront_sched.h). The stages
+// process packets of paths from the scheduler's path queues
+//
+
+template <typename Params>
+struct wavefront_kernel
+{
+    using hit_record_type = decltype( closest_hit(
+            std::declval<basic_ray<float>>(),
+            std::declval<Params>().prims.begin,
+            std::declval<Params>().prims.end
+            ) );
+
+    // Sort key of paths that left the scene
+    static const unsigned Retired = ~0U;
+
+    Params params;
+
+    unsigned num_bounces() const
+    {
+        return params.num_bounces;
+    }
+
+    // Generate stage, the path's primary ray is already set
+    template <typename Paths>
+    void init(Paths& paths, size_t i) const
+    {
+        for (int s = 0; s < spectrum<float>::num_samples; ++s)
+        {
+            paths.throughput[s][i] = 1.0f;
+        }
+
+        paths.first_hit[i] = 0;
+        paths.alive[i] = 1;
+    }
+
+    // Extend stage, closest hits of the paths in queue [first..last)
+    template <typename S, typename Intersector, typename Paths>
+    void extend(
+            Intersector&    isect,
+            Paths&          paths,
+            unsigned const* queue,
+            size_t          first,
+            size_t          last
+            ) const
+    {
+        static const size_t N = simd::num_elements<S>::value;
+
+        for (size_t q = first; q < last; q += N)
+        {
+            size_t n = std::min(N, last - q);
+
+            // Incomplete packets are padded with the last path
+            array<unsigned, N> ids;
+            array<basic_ray<float>, N> rays;
+
+            for (size_t j = 0; j < N; ++j)
+            {
+                ids[j] = queue[q + std::min(j, n - 1)];
+                rays[j] = paths.ray(ids[j]);
+            }
+
+            auto ray = detail::wavefront_pack<S>(rays);
+            auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
+            auto hit_recs = detail::wavefront_unpack<S>(hit_rec);
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                hit_recs[j].isect_pos = rays[j].ori + rays[j].dir * hit_recs[j].t;
+                paths.hit[ids[j]] = hit_recs[j];
+            }
+        }
+    }
+
+    // Returns the sort key of path i, the material index, or Retired if the path left the scene
+    template <typename Paths>
+    unsigned classify(Paths& paths, size_t i, unsigned bounce) const
+    {
+        auto const& hit_rec = paths.hit[i];
+
+        if (bounce == 0)
+        {
+            paths.first_hit[i] = hit_rec.hit ? 1 : 0;
+
+            for (int d = 0; d < 3; ++d)
+            {
+                paths.first_isect_pos[d][i] = hit_rec.isect_pos[d];
+            }
+        }
+
+        if (!hit_rec.hit)
+        {
+            spectrum<float> ambient = from_rgba(params.ambient_color);
+
+            for (int s = 0; s < spectrum<float>::num_samples; ++s)
+            {
+                paths.throughput[s][i] *= ambient[s];
+            }
+
+            paths.alive[i] = 0;
+            return Retired;
+        }
+
+        return static_cast<unsigned>(hit_rec.geom_id);
+    }
+
+    // Shade stage, samples the BRDFs of the paths in queue [first..last)
+    template <typename S, typename Paths>
+    void shade(
+            Paths&          paths,
+            unsigned const* queue,
+            size_t          first,
+            size_t          last,
+            unsigned        /* bounce */
+            ) const
+    {
+        static const size_t N = simd::num_elements<S>::value;
+
+        using I = simd::int_type_t<S>;
+        using V = vector<3, S>;
+        using surface_type = decltype( get_surface(std::declval<hit_record_type>(), params) );
+
+        auto gen = detail::make_wavefront_generator<S>();
+
+        for (size_t q = first; q < last; q += N)
+        {
+            size_t n = std::min(N, last - q);
+
+            array<unsigned, N> ids;
+            array<surface_type, N> surfs;
+            array<vector<3, float>, N> view_dirs;
+
+            for (size_t j = 0; j < N; ++j)
+            {
+                ids[j] = queue[q + std::min(j, n - 1)];
+
+                unsigned p = ids[j];
+
+                surfs[j] = get_surface(paths.hit[p], params);
+                view_dirs[j] = vector<3, float>(-paths.dir[0][p], -paths.dir[1][p], -paths.dir[2][p]);
+                detail::wavefront_lane_generator(gen, j) = paths.gen[p];
+            }
+
+            auto surf = detail::wavefront_pack<S>(surfs);
+            V view_dir = detail::wavefront_pack<S>(view_dirs);
+
+            V refl_dir;
+            S pdf(0.0);
+            I inter = 0;
+
+            auto src = surf.sample(view_dir, refl_dir, pdf, inter, gen);
+
+            auto zero_pdf = pdf <= S(0.0);
+            src = select( zero_pdf, spectrum<S>(0.0), src );
+
+            auto srcs = detail::wavefront_unpack<S>(src.samples());
+            auto refl_dirs = detail::wavefront_unpack<S>(refl_dir);
+
+            int absorbed[N];
+            int emissive[N];
+            detail::wavefront_store_mask<S>(absorbed, zero_pdf);
+            detail::wavefront_store_mask<S>(emissive, has_emissive_material(surf));
+
+            for (size_t j = 0; j < n; ++j)
+            {
+                unsigned p = ids[j];
+
+                paths.gen[p] = detail::wavefront_lane_generator(gen, j);
+
+                for (int s = 0; s < spectrum<float>::num_samples; ++s)
+                {
+                    paths.throughput[s][p] *= srcs[j][s];
+                }
+
+                paths.alive[p] = !absorbed[j] && !emissive[j];
+
+                if (paths.alive[p])
+                {
+                    paths.set_ray(p, basic_ray<float>(
+                            paths.hit[p].isect_pos + refl_dirs[j] * params.epsilon,
+                            refl_dirs[j]
+                            ));
+                }
+            }
+        }
+    }
+
+    // Result of path i, paths that are still alive are terminated
+    template <typename Paths>
+    result_record<float> result(Paths const& paths, size_t i) const
+    {
+        result_record<float> result;
+        result.hit = paths.first_hit[i] != 0;
+        result.color = params.bg_color;
+        result.isect_pos = vector<3, float>(
+                paths.first_isect_pos[0][i],
+                paths.first_isect_pos[1][i],
+                paths.first_isect_pos[2][i]
+                );
+
+        if (result.hit)
+        {
+            spectrum<float> dst(0.0f);
+
+            if (!paths.alive[i])
+            {
+                for (int s = 0; s < spectrum<float>::num_samples; ++s)
+                {
+                    dst[s] = paths.throughput[s][i];
+                }
+            }
+
+            result.color = to_rgba(dst);
+        }
+
+        return result;
+    }
+};
+
+template <typename Params>
+const unsigned wavefront_kernel<Params>::Retired;
+
+} // pathtracing
+} // visionaray
+
+#endif // VSNRAY_DETAIL_PATHTRACING_WAVEFRONT_INL
@@ -6,11 +6,16 @@
 #ifndef VSNRAY_DETAIL_PIXEL_ACCESS_H
 #define VSNRAY_DETAIL_PIXEL_ACCESS_H 1
 
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
 #include <type_traits>
 
 #include <visionaray/math/array.h>
 #include <visionaray/packet_traits.h>
 #include <visionaray/pixel_format.h>
+#include <visionaray/render_target.h>
 #include <visionaray/result_record.h>
 
 #include "color_conversion.h"
@@ -28,6 +33,113 @@ namespace detail
 namespace pixel_access
 {
 
+// SIMD helpers -----------------------------------------------------------
+
+
+//-------------------------------------------------------------------------------------------------
+// Convert SIMD vector to 8-bit unorm, same result as the scalar conversion
+// (truncate saturate(f) * 255, where the product is computed exactly)
+//
+
+template <
+    typename FloatT,
+    typename = typename std::enable_if<simd::is_simd_vector<FloatT>::value>::type
+    >
+inline simd::int_type_t<FloatT> float_to_unorm8(FloatT const& f)
+{
+    using IntT = simd::int_type_t<FloatT>;
+
+    FloatT s = saturate(f);
+
+    // s * 255 = s * 256 - s, the product is exact, the difference is rounded
+    FloatT a = s * FloatT(256.0f);
+    FloatT t = a - s;
+
+    // Rounding error of the difference, also exact (Sterbenz)
+    FloatT err = (a - t) - s;
+
+    // If t was rounded up, truncate the next smaller float instead
+    IntT bits = reinterpret_as_int(t);
+    bits = select(err < FloatT(0.0f), bits - IntT(1), bits);
+
+    return convert_to_int(reinterpret_as_float(bits));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Store a full SIMD packet of 32-bit values, row by row
+//
+
+template <typename FloatT, typename T, typename OutputValue>
+inline void store_packet_rows(
+        int                 x,
+        int                 y,
+        int                 width,
+        T const*            values,
+        OutputValue*        buffer
+        )
+{
+    static_assert(sizeof(T) == sizeof(OutputValue), "Size mismatch");
+
+    const int w = packet_size<FloatT>::w;
+    const int h = packet_size<FloatT>::h;
+
+    for (int row = 0; row < h; ++row)
+    {
+        std::memcpy(&buffer[(y + row) * width + x], values + row * w, w * sizeof(T));
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Store a full SIMD packet of SoA rgba colors to an RGBA32F buffer,
+// transpose four lanes at a time in registers. Uses aligned stores, the
+// buffer must be 16-byte aligned (as vector<4, float> is)
+//
+
+template <typename FloatT>
+inline void store_packet_rgba32f(
+        int                                 x,
+        int                                 y,
+        int                                 width,
+        vector<4, FloatT> const&            color,
+        vector<4, float>*                   buffer
+        )
+{
+    static_assert(alignof(vector<4, float>) >= 16, "Pixels must be 16-byte aligned");
+
+    using float_array = simd::aligned_array_t<FloatT>;
+
+    const int w = packet_size<FloatT>::w;
+
+    float_array r;
+    float_array g;
+    float_array b;
+    float_array a;
+
+    store(r, color.x);
+    store(g, color.y);
+    store(b, color.z);
+    store(a, color.w);
+
+    for (int i = 0; i < simd::num_elements<FloatT>::value; i += 4)
+    {
+        simd::float4 t0 = interleave_lo(simd::float4(&r[i]), simd::float4(&g[i]));
+        simd::float4 t1 = interleave_lo(simd::float4(&b[i]), simd::float4(&a[i]));
+        simd::float4 t2 = interleave_hi(simd::float4(&r[i]), simd::float4(&g[i]));
+        simd::float4 t3 = interleave_hi(simd::float4(&b[i]), simd::float4(&a[i]));
+
+        simd::float4 p[] = { move_lo(t0, t1), move_hi(t1, t0), move_lo(t2, t3), move_hi(t3, t2) };
+
+        for (int j = 0; j < 4; ++j)
+        {
+            int lane = i + j;
+            store(buffer[(y + lane / w) * width + x + lane % w].data(), p[j]);
+        }
+    }
+}
+
+
 // Store ------------------------------------------------------------------
 
 
@@ -248,6 +360,22 @@ inline void store(
         )
 {
     using float_array = simd::aligned_array_t<FloatT>;
+    using int_array = simd::aligned_array_t<simd::int_type_t<FloatT>>;
+
+    // Full packet: convert and pack in registers, then store row by row
+    if (x + packet_size<FloatT>::w <= width && y + packet_size<FloatT>::h <= height)
+    {
+        auto packed = float_to_unorm8(color.x)
+                    | (float_to_unorm8(color.y) << 8)
+                    | (float_to_unorm8(color.z) << 16)
+                    | (float_to_unorm8(color.w) << 24);
+
+        int_array values;
+        store(values, packed);
+
+        store_packet_rows<FloatT>(x, y, width, values, buffer);
+        return;
+    }
 
     float_array r;
     float_array g;
@@ -363,6 +491,16 @@ inline void store(
 {
     using float_array = simd::aligned_array_t<FloatT>;
 
+    // Full packet: transpose in registers.
+    // Aligned stores, buffers that were cast from misaligned memory are not supported
+    if (x + packet_size<FloatT>::w <= width && y + packet_size<FloatT>::h <= height)
+    {
+        assert( reinterpret_cast<uintptr_t>(buffer) % 16 == 0 );
+
+        store_packet_rgba32f(x, y, width, color, buffer);
+        return;
+    }
+
     float_array r;
     float_array g;
     float_array b;
@@ -447,6 +585,13 @@ inline void store(
 
     store(v, value);
 
+    // Full packet: store row by row
+    if (x + packet_size<FloatT>::w <= width && y + packet_size<FloatT>::h <= height)
+    {
+        store_packet_rows<FloatT>(x, y, width, v, buffer);
+        return;
+    }
+
     auto w = packet_size<FloatT>::w;
     auto h = packet_size<FloatT>::h;
 
@@ -536,6 +681,13 @@ inline void store(
 
     store(v, value);
 
+    // Full packet: store row by row
+    if (x + packet_size<FloatT>::w <= width && y + packet_size<FloatT>::h <= height)
+    {
+        store_packet_rows<FloatT>(x, y, width, v, buffer);
+        return;
+    }
+
     auto w = packet_size<FloatT>::w;
     auto h = packet_size<FloatT>::h;
 
@@ -586,6 +738,32 @@ inline void store(
         );
 }
 
+// Result record with AOVs, otherwise the color overload above would be selected
+template <pixel_format DF, pixel_format SF, typename T, typename OutputColor>
+VSNRAY_FUNC
+inline void store(
+        pixel_format_constant<DF>       /* dst format */,
+        pixel_format_constant<SF>       /* src format */,
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        aov_result_record<T> const&     rr,
+        OutputColor*                    buffer
+        )
+{
+    store(
+        pixel_format_constant<DF>{},
+        pixel_format_constant<SF>{},
+        x,
+        y,
+        width,
+        height,
+        static_cast<result_record<T> const&>(rr),
+        buffer
+        );
+}
+
 //-------------------------------------------------------------------------------------------------
 // Store color and depth from result record to output buffers
 //
@@ -1178,6 +1356,36 @@ inline void blend(
         );
 }
 
+// Result record with AOVs, otherwise the color overload above would be selected
+template <pixel_format DF, pixel_format SF, typename S, typename OutputColor, typename T>
+VSNRAY_FUNC
+inline void blend(
+        pixel_format_constant<DF>       /* dst format */,
+        pixel_format_constant<SF>       /* src format */,
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        aov_result_record<S> const&     rr,
+        OutputColor*                    color_buffer,
+        T                               sfactor,
+        T                               dfactor
+        )
+{
+    blend(
+        pixel_format_constant<DF>{},
+        pixel_format_constant<SF>{},
+        x,
+        y,
+        width,
+        height,
+        static_cast<result_record<S> const&>(rr),
+        color_buffer,
+        sfactor,
+        dfactor
+        );
+}
+
 //-------------------------------------------------------------------------------------------------
 // Blend color and depth from result record on top of output buffers
 //
@@ -1238,6 +1446,271 @@ inline void blend(
         );
 }
 
+
+// AOVs -------------------------------------------------------------------
+
+
+//-------------------------------------------------------------------------------------------------
+// Store a single channel to a plane of 32-bit values, no conversion
+//
+
+template <typename FloatT, typename T, typename V>
+VSNRAY_FUNC
+inline void store_plane(
+        std::false_type             /* is simd */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        T const&                    value,
+        V*                          buffer
+        )
+{
+    VSNRAY_UNUSED(height);
+
+    buffer[y * width + x] = static_cast<V>(value);
+}
+
+template <typename FloatT, typename T, typename V>
+inline void store_plane(
+        std::true_type              /* is simd */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        T const&                    value,
+        V*                          buffer
+        )
+{
+    simd::aligned_array_t<T> v;
+
+    store(v, value);
+
+    // Full packet: store row by row
+    if (x + packet_size<FloatT>::w <= width && y + packet_size<FloatT>::h <= height)
+    {
+        store_packet_rows<FloatT>(x, y, width, v, buffer);
+        return;
+    }
+
+    auto w = packet_size<FloatT>::w;
+    auto h = packet_size<FloatT>::h;
+
+    for (auto row = 0; row < h; ++row)
+    {
+        for (auto col = 0; col < w; ++col)
+        {
+            if (x + col < width && y + row < height)
+            {
+                buffer[(y + row) * width + (x + col)] = static_cast<V>(v[row * w + col]);
+            }
+        }
+    }
+}
+
+template <typename FloatT, typename T, typename V>
+VSNRAY_FUNC
+inline void store_plane(int x, int y, int width, int height, T const& value, V* buffer)
+{
+    if (buffer != nullptr)
+    {
+        store_plane<FloatT>(
+                std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{},
+                x,
+                y,
+                width,
+                height,
+                value,
+                buffer
+                );
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Blend a single channel into a plane of 32-bit floats
+// dst := value * sfactor + dst * dfactor
+//
+
+template <typename FloatT>
+VSNRAY_FUNC
+inline void blend_plane(
+        std::false_type             /* is simd */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        FloatT const&               value,
+        float*                      buffer,
+        FloatT const&               sfactor,
+        FloatT const&               dfactor
+        )
+{
+    VSNRAY_UNUSED(height);
+
+    float& dst = buffer[y * width + x];
+    dst = value * sfactor + dst * dfactor;
+}
+
+template <typename FloatT>
+inline void blend_plane(
+        std::true_type              /* is simd */,
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        FloatT const&               value,
+        float*                      buffer,
+        FloatT const&               sfactor,
+        FloatT const&               dfactor
+        )
+{
+    using float_array = simd::aligned_array_t<FloatT>;
+
+    float_array v;
+    float_array s;
+    float_array d;
+
+    store(v, value);
+    store(s, sfactor);
+    store(d, dfactor);
+
+    auto w = packet_size<FloatT>::w;
+    auto h = packet_size<FloatT>::h;
+
+    for (auto row = 0; row < h; ++row)
+    {
+        for (auto col = 0; col < w; ++col)
+        {
+            if (x + col < width && y + row < height)
+            {
+                int i = row * w + col;
+                float& dst = buffer[(y + row) * width + (x + col)];
+                dst = v[i] * s[i] + dst * d[i];
+            }
+        }
+    }
+}
+
+template <typename FloatT>
+VSNRAY_FUNC
+inline void blend_plane(
+        int                         x,
+        int                         y,
+        int                         width,
+        int                         height,
+        FloatT const&               value,
+        float*                      buffer,
+        FloatT const&               sfactor,
+        FloatT const&               dfactor
+        )
+{
+    if (buffer != nullptr)
+    {
+        blend_plane(
+                std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{},
+                x,
+                y,
+                width,
+                height,
+                value,
+                buffer,
+                sfactor,
+                dfactor
+                );
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Store AOVs from result record to the planes of an AOV render target
+// W/o AOVs in the result record, only depth is stored
+//
+
+template <typename T, pixel_format CF>
+VSNRAY_FUNC
+inline void store_aovs(
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        result_record<T> const&         rr,
+        aov_render_target_ref<CF>       rt_ref
+        )
+{
+    store_plane<T>(x, y, width, height, rr.depth, rt_ref.depth_);
+}
+
+template <typename T, pixel_format CF>
+VSNRAY_FUNC
+inline void store_aovs(
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        aov_result_record<T> const&     rr,
+        aov_render_target_ref<CF>       rt_ref
+        )
+{
+    store_plane<T>(x, y, width, height, rr.depth, rt_ref.depth_);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        store_plane<T>(x, y, width, height, rr.normal[i], rt_ref.normal_[i]);
+        store_plane<T>(x, y, width, height, rr.albedo[i], rt_ref.albedo_[i]);
+    }
+
+    store_plane<T>(x, y, width, height, rr.prim_id, rt_ref.prim_id_);
+    store_plane<T>(x, y, width, height, rr.geom_id, rt_ref.geom_id_);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Blend AOVs from result record into the planes of an AOV render target
+// Ids cannot be blended, the ids of the latest sample are stored
+//
+
+template <typename T, pixel_format CF>
+VSNRAY_FUNC
+inline void blend_aovs(
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        result_record<T> const&         rr,
+        aov_render_target_ref<CF>       rt_ref,
+        T                               sfactor,
+        T                               dfactor
+        )
+{
+    blend_plane(x, y, width, height, rr.depth, rt_ref.depth_, sfactor, dfactor);
+}
+
+template <typename T, pixel_format CF>
+VSNRAY_FUNC
+inline void blend_aovs(
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        aov_result_record<T> const&     rr,
+        aov_render_target_ref<CF>       rt_ref,
+        T                               sfactor,
+        T                               dfactor
+        )
+{
+    blend_plane(x, y, width, height, rr.depth, rt_ref.depth_, sfactor, dfactor);
+
+    for (int i = 0; i < 3; ++i)
+    {
+        blend_plane(x, y, width, height, rr.normal[i], rt_ref.normal_[i], sfactor, dfactor);
+        blend_plane(x, y, width, height, rr.albedo[i], rt_ref.albedo_[i], sfactor, dfactor);
+    }
+
+    store_plane<T>(x, y, width, height, rr.prim_id, rt_ref.prim_id_);
+    store_plane<T>(x, y, width, height, rr.geom_id, rt_ref.geom_id_);
+}
+
 } // pixel_access
 
 } // detail
@@ -0,0 +1,719 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../math/simd/type_traits.h"
+#include "../math/math.h"
+#include "../bvh.h"
+#include "macros.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Triangles are clipped against w >= raster_min_w (w is the distance to the eye plane)
+// and against a guard band of -raster_guard_band * w <= x,y <= raster_guard_band * w.
+// The guard band keeps the screen coordinates of clipped vertices small enough for
+// single precision edge functions, it does not change the covered pixels
+//
+
+static const float raster_min_w = 1E-5f;
+static const float raster_guard_band = 2.0f;
+
+
+//-------------------------------------------------------------------------------------------------
+// Load and store FloatT / IntT at aligned addresses
+//
+
+template <typename T, typename P>
+inline T raster_load(std::false_type /* is simd */, P const* ptr)
+{
+    return *ptr;
+}
+
+template <typename T, typename P>
+inline T raster_load(std::true_type /* is simd */, P const* ptr)
+{
+    return T(ptr);
+}
+
+template <typename T, typename P>
+inline T raster_load(P const* ptr)
+{
+    return raster_load<T>(std::integral_constant<bool, simd::is_simd_vector<T>::value>{}, ptr);
+}
+
+template <typename T, typename P>
+inline void raster_store(std::false_type /* is simd */, P* ptr, T const& value)
+{
+    *ptr = value;
+}
+
+template <typename T, typename P>
+inline void raster_store(std::true_type /* is simd */, P* ptr, T const& value)
+{
+    store(ptr, value);
+}
+
+template <typename T, typename P>
+inline void raster_store(P* ptr, T const& value)
+{
+    raster_store(std::integral_constant<bool, simd::is_simd_vector<T>::value>{}, ptr, value);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Pixel center offsets of the lanes of a FloatT row
+//
+
+template <typename FloatT>
+inline FloatT raster_lane_offsets(std::false_type /* is simd */)
+{
+    return FloatT(0.5f);
+}
+
+template <typename FloatT>
+inline FloatT raster_lane_offsets(std::true_type /* is simd */)
+{
+    simd::aligned_array_t<FloatT> offsets;
+
+    for (int i = 0; i < simd::num_elements<FloatT>::value; ++i)
+    {
+        offsets[i] = i + 0.5f;
+    }
+
+    return FloatT(offsets);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Triangle of a primitive range, either triangles or BVHs of triangles
+//
+
+template <typename Primitives>
+inline auto raster_primitive(std::false_type /* is bvh */, Primitives begin, unsigned bvh, unsigned index)
+    -> decltype( *begin )
+{
+    VSNRAY_UNUSED(bvh);
+
+    return begin[index];
+}
+
+template <typename Primitives>
+inline auto raster_primitive(std::true_type /* is bvh */, Primitives begin, unsigned bvh, unsigned index)
+    -> decltype( begin->primitive(index) )
+{
+    return begin[bvh].primitive(index);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test if all corners of box are outside one of the clip planes (-w <= x,y <= w, w >= min w)
+//
+
+inline bool outside_frustum(aabb const& box, mat4 const& view_proj)
+{
+    int outside[5] = { 0, 0, 0, 0, 0 };
+
+    for (int i = 0; i < 8; ++i)
+    {
+        vec4 c = view_proj * vec4(
+                i & 1 ? box.max.x : box.min.x,
+                i & 2 ? box.max.y : box.min.y,
+                i & 4 ? box.max.z : box.min.z,
+                1.0f
+                );
+
+        outside[0] += c.x < -c.w;
+        outside[1] += c.x >  c.w;
+        outside[2] += c.y < -c.w;
+        outside[3] += c.y >  c.w;
+        outside[4] += c.w < raster_min_w;
+    }
+
+    return outside[0] == 8 || outside[1] == 8 || outside[2] == 8 || outside[3] == 8 || outside[4] == 8;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Collect the leaves of BVHs that are not outside the view frustum
+//
+
+template <typename Primitives>
+inline void collect_leaves(
+        std::false_type                 /* is bvh */,
+        Primitives                      begin,
+        Primitives                      end,
+        mat4 const&                     view_proj,
+        std::vector<raster_leaf>&       leaves
+        )
+{
+    VSNRAY_UNUSED(begin, end, view_proj, leaves);
+}
+
+template <typename Primitives>
+inline void collect_leaves(
+        std::true_type                  /* is bvh */,
+        Primitives                      begin,
+        Primitives                      end,
+        mat4 const&                     view_proj,
+        std::vector<raster_leaf>&       leaves
+        )
+{
+    leaves.clear();
+
+    std::vector<unsigned> stack;
+
+    for (Primitives it = begin; it != end; ++it)
+    {
+        if (it->num_nodes() == 0)
+        {
+            continue;
+        }
+
+        stack.push_back(0);
+
+        while (!stack.empty())
+        {
+            auto const& node = it->node(stack.back());
+            stack.pop_back();
+
+            if (outside_frustum(node.get_bounds(), view_proj))
+            {
+                continue;
+            }
+
+            if (is_inner(node))
+            {
+                stack.push_back(node.get_child(0));
+                stack.push_back(node.get_child(1));
+            }
+            else
+            {
+                auto indices = node.get_indices();
+                leaves.push_back({ static_cast<unsigned>(it - begin), indices.first, indices.last });
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Project a clip space triangle, set it up for rasterization if it covers pixel centers
+//
+
+inline void setup_triangle(
+        vec4 const&                         c0,
+        vec4 const&                         c1,
+        vec4 const&                         c2,
+        int                                 width,
+        int                                 height,
+        unsigned                            bvh,
+        unsigned                            index,
+        aligned_vector<raster_triangle>&    triangles
+        )
+{
+    vec4 const* clip[3] = { &c0, &c1, &c2 };
+
+    float x[3];
+    float y[3];
+    float inv_w[3];
+
+    for (int i = 0; i < 3; ++i)
+    {
+        inv_w[i] = 1.0f / clip[i]->w;
+        x[i] = (clip[i]->x * inv_w[i] + 1.0f) * 0.5f * width;
+        y[i] = (clip[i]->y * inv_w[i] + 1.0f) * 0.5f * height;
+    }
+
+    // Pixel centers are at (px + 0.5, py + 0.5)
+    float min_x = std::min(x[0], std::min(x[1], x[2]));
+    float max_x = std::max(x[0], std::max(x[1], x[2]));
+    float min_y = std::min(y[0], std::min(y[1], y[2]));
+    float max_y = std::max(y[0], std::max(y[1], y[2]));
+
+    raster_triangle t;
+
+    t.x0 = static_cast<int>( std::max(std::ceil(min_x - 0.5f), 0.0f) );
+    t.y0 = static_cast<int>( std::max(std::ceil(min_y - 0.5f), 0.0f) );
+    t.x1 = static_cast<int>( std::min(std::floor(max_x - 0.5f), width - 1.0f) );
+    t.y1 = static_cast<int>( std::min(std::floor(max_y - 0.5f), height - 1.0f) );
+
+    if (t.x0 > t.x1 || t.y0 > t.y1)
+    {
+        return;
+    }
+
+    float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+
+    if (area == 0.0f)
+    {
+        return;
+    }
+
+    // Counter-clockwise
+    if (area < 0.0f)
+    {
+        std::swap(x[1], x[2]);
+        std::swap(y[1], y[2]);
+        std::swap(inv_w[1], inv_w[2]);
+        area = -area;
+    }
+
+    for (int i = 0; i < 3; ++i)
+    {
+        // Edge from vertex j to vertex k
+        int j = (i + 1) % 3;
+        int k = (i + 2) % 3;
+
+        t.a[i] = y[j] - y[k];
+        t.b[i] = x[k] - x[j];
+        t.ox[i] = x[j];
+        t.oy[i] = y[j];
+        t.inv_w[i] = inv_w[i];
+        t.top_left[i] = t.a[i] > 0.0f || (t.a[i] == 0.0f && t.b[i] > 0.0f);
+    }
+
+    t.inv_area = 1.0f / area;
+    t.bvh = bvh;
+    t.index = index;
+
+    triangles.push_back(t);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Signed distance of a clip space vertex to clip plane i, inside if >= 0
+//
+
+inline float raster_clip_distance(vec4 const& c, int i)
+{
+    switch (i)
+    {
+    case 0:  return c.w - raster_min_w;
+    case 1:  return raster_guard_band * c.w + c.x;
+    case 2:  return raster_guard_band * c.w - c.x;
+    case 3:  return raster_guard_band * c.w + c.y;
+    default: return raster_guard_band * c.w - c.y;
+    }
+}
+
+enum { RasterNumClipPlanes = 5 };
+
+
+//-------------------------------------------------------------------------------------------------
+// Clip a triangle against the clip planes and set up the remaining triangle fan
+//
+
+template <typename Triangle>
+inline void setup_triangle(
+        Triangle const&                     tri,
+        mat4 const&                         view_proj,
+        int                                 width,
+        int                                 height,
+        unsigned                            bvh,
+        unsigned                            index,
+        aligned_vector<raster_triangle>&    triangles
+        )
+{
+    vec3 v1(tri.v1);
+    vec3 v2 = v1 + vec3(tri.e1);
+    vec3 v3 = v1 + vec3(tri.e2);
+
+    // Each plane adds at most one vertex
+    vec4 poly[2][3 + RasterNumClipPlanes] = {{
+        view_proj * vec4(v1, 1.0f),
+        view_proj * vec4(v2, 1.0f),
+        view_proj * vec4(v3, 1.0f)
+        }};
+    int n = 3;
+
+    int clip_mask = 0;
+
+    for (int i = 0; i < RasterNumClipPlanes; ++i)
+    {
+        int num_outside = (raster_clip_distance(poly[0][0], i) < 0.0f)
+                        + (raster_clip_distance(poly[0][1], i) < 0.0f)
+                        + (raster_clip_distance(poly[0][2], i) < 0.0f);
+
+        if (num_outside == 3)
+        {
+            return;
+        }
+
+        clip_mask |= (num_outside > 0) << i;
+    }
+
+    // Sutherland-Hodgman, only w/ the planes that vertices are outside of
+    int src = 0;
+
+    for (int i = 0; i < RasterNumClipPlanes && n >= 3; ++i)
+    {
+        if (!(clip_mask & (1 << i)))
+        {
+            continue;
+        }
+
+        vec4 const* in = poly[src];
+        vec4* out = poly[1 - src];
+        int m = 0;
+
+        for (int k = 0; k < n; ++k)
+        {
+            vec4 const& a = in[k];
+            vec4 const& b = in[(k + 1) % n];
+
+            float da = raster_clip_distance(a, i);
+            float db = raster_clip_distance(b, i);
+
+            if (da >= 0.0f)
+            {
+                out[m++] = a;
+            }
+
+            if ((da >= 0.0f) != (db >= 0.0f))
+            {
+                out[m++] = a + (b - a) * (da / (da - db));
+            }
+        }
+
+        n = m;
+        src = 1 - src;
+    }
+
+    for (int i = 1; i + 1 < n; ++i)
+    {
+        setup_triangle(poly[src][0], poly[src][i], poly[src][i + 1], width, height, bvh, index, triangles);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Edge test, pixels on the edge are inside if it is a top or left edge
+//
+
+template <typename FloatT>
+inline auto raster_edge_test(FloatT const& e, bool top_left)
+    -> decltype( e > FloatT(0.0f) )
+{
+    return top_left ? e >= FloatT(0.0f) : e > FloatT(0.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Rasterize a triangle into the depth and id buffers of the tile at (tile_x, tile_y)
+//
+
+template <typename FloatT, int TileSize>
+inline void rasterize_triangle(
+        raster_triangle const&  t,
+        int                     id,
+        int                     tile_x,
+        int                     tile_y,
+        float*                  depth,
+        int*                    ids
+        )
+{
+    using I = simd::int_type_t<FloatT>;
+
+    static const int N = simd::num_elements<FloatT>::value;
+
+    int x0 = std::max(t.x0, tile_x);
+    int y0 = std::max(t.y0, tile_y);
+    int x1 = std::min(t.x1, tile_x + TileSize - 1);
+    int y1 = std::min(t.y1, tile_y + TileSize - 1);
+
+    // Rows start at multiples of N in the tile
+    x0 = tile_x + (x0 - tile_x) / N * N;
+
+    FloatT lane = raster_lane_offsets<FloatT>(
+            std::integral_constant<bool, simd::is_simd_vector<FloatT>::value>{}
+            );
+
+    FloatT a0(t.a[0]);
+    FloatT a1(t.a[1]);
+    FloatT a2(t.a[2]);
+
+    FloatT ox0(t.ox[0]);
+    FloatT ox1(t.ox[1]);
+    FloatT ox2(t.ox[2]);
+
+    FloatT iw0(t.inv_w[0] * t.inv_area);
+    FloatT iw1(t.inv_w[1] * t.inv_area);
+    FloatT iw2(t.inv_w[2] * t.inv_area);
+
+    I id_vec(id);
+
+    for (int y = y0; y <= y1; ++y)
+    {
+        float py = y + 0.5f;
+
+        FloatT row0(t.b[0] * (py - t.oy[0]));
+        FloatT row1(t.b[1] * (py - t.oy[1]));
+        FloatT row2(t.b[2] * (py - t.oy[2]));
+
+        float* depth_row = depth + (y - tile_y) * TileSize;
+        int* id_row = ids + (y - tile_y) * TileSize;
+
+        for (int x = x0; x <= x1; x += N)
+        {
+            FloatT px = FloatT(static_cast<float>(x)) + lane;
+
+            FloatT e0 = a0 * (px - ox0) + row0;
+            FloatT e1 = a1 * (px - ox1) + row1;
+            FloatT e2 = a2 * (px - ox2) + row2;
+
+            auto inside = raster_edge_test(e0, t.top_left[0])
+                        & raster_edge_test(e1, t.top_left[1])
+                        & raster_edge_test(e2, t.top_left[2]);
+
+            if (!any(inside))
+            {
+                continue;
+            }
+
+            FloatT z = e0 * iw0 + e1 * iw1 + e2 * iw2;
+            FloatT old_z = raster_load<FloatT>(depth_row + x - tile_x);
+
+            auto closer = inside & (z > old_z);
+
+            if (!any(closer))
+            {
+                continue;
+            }
+
+            raster_store(depth_row + x - tile_x, select(closer, z, old_z));
+            raster_store(id_row + x - tile_x, select(closer, id_vec, raster_load<I>(id_row + x - tile_x)));
+        }
+    }
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// rasterizer implementation
+//
+
+template <typename FloatT, typename Camera, typename Primitives>
+void rasterizer::rasterize(
+        thread_pool&        pool,
+        Camera              cam,
+        Primitives          begin,
+        Primitives          end,
+        visibility_buffer&  vbuffer
+        )
+{
+    using Primitive = typename std::iterator_traits<Primitives>::value_type;
+    using is_bvh = std::integral_constant<bool, is_any_bvh<Primitive>::value>;
+
+    static_assert(TileSize % simd::num_elements<FloatT>::value == 0, "Tile size must be a multiple of the SIMD width");
+
+    int width  = vbuffer.width();
+    int height = vbuffer.height();
+
+    if (width <= 0 || height <= 0)
+    {
+        return;
+    }
+
+    cam.begin_frame();
+
+    mat4 view_proj = cam.get_proj_matrix() * cam.get_view_matrix();
+
+    int tiles_x = div_up(width, static_cast<int>(TileSize));
+    int tiles_y = div_up(height, static_cast<int>(TileSize));
+    int num_tiles = tiles_x * tiles_y;
+
+
+    // Collect the leaves in the view frustum (BVHs only)
+
+    size_t num_items = static_cast<size_t>(std::distance(begin, end));
+
+    if (is_bvh::value)
+    {
+        detail::collect_leaves(is_bvh{}, begin, end, view_proj, leaves_);
+        num_items = leaves_.size();
+    }
+
+
+    // Set up and bin the triangles, one chunk of the input per thread
+
+    size_t num_chunks = std::max(pool.num_threads, 1U);
+
+    triangles_.resize(num_chunks);
+    offsets_.resize(num_chunks + 1);
+    bins_.resize(num_chunks);
+
+    pool.run([&](long chunk)
+        {
+            auto& triangles = triangles_[chunk];
+            auto& bins = bins_[chunk];
+
+            triangles.clear();
+            bins.resize(num_tiles);
+
+            for (auto& bin : bins)
+            {
+                bin.clear();
+            }
+
+            size_t first = num_items * chunk / num_chunks;
+            size_t last  = num_items * (chunk + 1) / num_chunks;
+
+            for (size_t i = first; i != last; ++i)
+            {
+                if (is_bvh::value)
+                {
+                    auto const& l = leaves_[i];
+
+                    for (unsigned j = l.first; j != l.last; ++j)
+                    {
+                        detail::setup_triangle(
+                                detail::raster_primitive(is_bvh{}, begin, l.bvh, j),
+                                view_proj,
+                                width,
+                                height,
+                                l.bvh,
+                                j,
+                                triangles
+                                );
+                    }
+                }
+                else
+                {
+                    detail::setup_triangle(
+                            detail::raster_primitive(is_bvh{}, begin, 0, static_cast<unsigned>(i)),
+                            view_proj,
+                            width,
+                            height,
+                            0,
+                            static_cast<unsigned>(i),
+                            triangles
+                            );
+                }
+            }
+
+            for (size_t i = 0; i < triangles.size(); ++i)
+            {
+                auto const& t = triangles[i];
+
+                for (int ty = t.y0 / TileSize; ty <= t.y1 / TileSize; ++ty)
+                {
+                    for (int tx = t.x0 / TileSize; tx <= t.x1 / TileSize; ++tx)
+                    {
+                        bins[ty * tiles_x + tx].push_back(static_cast<unsigned>(i));
+                    }
+                }
+            }
+        }, static_cast<long>(num_chunks));
+
+    offsets_[0] = 0;
+
+    for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+    {
+        offsets_[chunk + 1] = offsets_[chunk] + triangles_[chunk].size();
+    }
+
+
+    // Rasterize the tiles, then intersect the visible triangles w/ the primary rays
+
+    pool.run([&](long tile)
+        {
+            int tile_x = static_cast<int>(tile % tiles_x) * TileSize;
+            int tile_y = static_cast<int>(tile / tiles_x) * TileSize;
+
+            VSNRAY_ALIGN(64) float depth[TileSize * TileSize];
+            VSNRAY_ALIGN(64) int ids[TileSize * TileSize];
+
+            std::fill(depth, depth + TileSize * TileSize, 0.0f);
+            std::fill(ids, ids + TileSize * TileSize, -1);
+
+            for (size_t chunk = 0; chunk < num_chunks; ++chunk)
+            {
+                for (unsigned i : bins_[chunk][tile])
+                {
+                    detail::rasterize_triangle<FloatT, TileSize>(
+                            triangles_[chunk][i],
+                            static_cast<int>(offsets_[chunk] + i),
+                            tile_x,
+                            tile_y,
+                            depth,
+                            ids
+                            );
+                }
+            }
+
+            int x1 = std::min(tile_x + TileSize, width);
+            int y1 = std::min(tile_y + TileSize, height);
+
+            for (int y = tile_y; y < y1; ++y)
+            {
+                for (int x = tile_x; x < x1; ++x)
+                {
+                    int id = ids[(y - tile_y) * TileSize + (x - tile_x)];
+
+                    visibility_buffer::sample_type& sample = vbuffer(x, y);
+                    sample = visibility_buffer::sample_type();
+
+                    if (id < 0)
+                    {
+                        continue;
+                    }
+
+                    size_t chunk = std::upper_bound(offsets_.begin(), offsets_.end(), static_cast<size_t>(id))
+                                 - offsets_.begin() - 1;
+
+                    auto const& t = triangles_[chunk][id - offsets_[chunk]];
+                    auto const& tri = detail::raster_primitive(is_bvh{}, begin, t.bvh, t.index);
+
+                    // Same as intersect(ray, tri), but w/o rejecting rays that pass
+                    // the triangle's edges by rounding errors
+                    auto r = cam.primary_ray(
+                            ray{},
+                            static_cast<float>(x),
+                            static_cast<float>(y),
+                            static_cast<float>(width),
+                            static_cast<float>(height)
+                            );
+
+                    vec3 v1(tri.v1);
+                    vec3 e1(tri.e1);
+                    vec3 e2(tri.e2);
+
+                    vec3 s1 = cross(r.dir, e2);
+                    float div = dot(s1, e1);
+
+                    if (div == 0.0f)
+                    {
+                        continue;
+                    }
+
+                    float inv_div = 1.0f / div;
+
+                    vec3 d = r.ori - v1;
+                    vec3 s2 = cross(d, e1);
+
+                    sample.hit     = true;
+                    sample.prim_id = tri.prim_id;
+                    sample.geom_id = tri.geom_id;
+                    sample.index   = t.index;
+                    sample.t       = dot(e2, s2) * inv_div;
+                    sample.u       = dot(d, s1) * inv_div;
+                    sample.v       = dot(r.dir, s2) * inv_div;
+                }
+            }
+        }, static_cast<long>(num_tiles));
+
+    cam.end_frame();
+}
+
+} // visionaray
@@ -731,6 +731,188 @@ inline void sample_pixel_impl(
     }
 }
 
+//-------------------------------------------------------------------------------------------------
+// Pixel samplers for AOV render targets, store color and all AOVs of a sample at once
+//
+
+template <
+    typename K,
+    typename R,
+    typename Generator,
+    pixel_format CF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                               kernel,
+        pixel_sampler::uniform_type     /* */,
+        R const&                        r,
+        Generator&                      gen,
+        unsigned                        frame_num,
+        aov_render_target_ref<CF>       rt_ref,
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        Camera const&                   cam
+        )
+{
+    VSNRAY_UNUSED(frame_num);
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+    result.depth = select( result.hit, depth_transform(result.isect_pos, cam), typename R::scalar_type(1.0) );
+
+    pixel_access::store(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color()
+            );
+
+    pixel_access::store_aovs(x, y, width, height, result, rt_ref);
+}
+
+template <
+    typename K,
+    typename R,
+    typename Generator,
+    pixel_format CF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                               kernel,
+        pixel_sampler::jittered_type    /* */,
+        R const&                        r,
+        Generator&                      gen,
+        unsigned                        frame_num,
+        aov_render_target_ref<CF>       rt_ref,
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        Camera const&                   cam
+        )
+{
+    sample_pixel_impl(
+            kernel,
+            pixel_sampler::uniform_type{},
+            r,
+            gen,
+            frame_num,
+            rt_ref,
+            x,
+            y,
+            width,
+            height,
+            cam
+            );
+}
+
+template <
+    typename K,
+    typename R,
+    typename Generator,
+    pixel_format CF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                                   kernel,
+        pixel_sampler::jittered_blend_type  /* */,
+        R const&                            r,
+        Generator&                          gen,
+        unsigned                            frame_num,
+        aov_render_target_ref<CF>           rt_ref,
+        int                                 x,
+        int                                 y,
+        int                                 width,
+        int                                 height,
+        Camera const&                       cam
+        )
+{
+    using S = typename R::scalar_type;
+
+    auto result = invoke_kernel(kernel, r, gen, x, y);
+    auto alpha  = S(1.0) / S(frame_num);
+
+    result.depth = select( result.hit, depth_transform(result.isect_pos, cam), S(1.0) );
+
+    pixel_access::blend(
+            pixel_format_constant<CF>{},
+            pixel_format_constant<PF_RGBA32F>{},
+            x,
+            y,
+            width,
+            height,
+            result,
+            rt_ref.color(),
+            alpha, S(1.0) - alpha
+            );
+
+    pixel_access::blend_aovs(x, y, width, height, result, rt_ref, alpha, S(1.0) - alpha);
+}
+
+template <
+    typename K,
+    typename R,
+    size_t Num,
+    typename Generator,
+    pixel_format CF,
+    typename Camera
+    >
+VSNRAY_FUNC
+inline void sample_pixel_impl(
+        K                               kernel,
+        pixel_sampler::ssaa_type<Num>   /* */,
+        array<R, Num> const&            rays,
+        Generator&                      gen,
+        unsigned                        frame_num,
+        aov_render_target_ref<CF>       rt_ref,
+        int                             x,
+        int                             y,
+        int                             width,
+        int                             height,
+        Camera const&                   cam
+        )
+{
+    VSNRAY_UNUSED(frame_num);
+
+    using S = typename R::scalar_type;
+
+    auto ray_ptr = rays.data();
+
+    for (size_t frame = 0; frame < Num; ++frame)
+    {
+        auto result = invoke_kernel(kernel, *ray_ptr++, gen, x, y);
+        result.depth = select( result.hit, depth_transform(result.isect_pos, cam), S(1.0) );
+
+        // The first sample overwrites the previous frame
+        auto alpha = S(1.0) / S(Num);
+        auto beta  = frame == 0 ? S(0.0) : S(1.0);
+
+        pixel_access::blend(
+                pixel_format_constant<CF>{},
+                pixel_format_constant<PF_RGBA32F>{},
+                x,
+                y,
+                width,
+                height,
+                result,
+                rt_ref.color(),
+                alpha,
+                beta
+                );
+
+        pixel_access::blend_aovs(x, y, width, height, result, rt_ref, alpha, beta);
+    }
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // w/o intersector
 //
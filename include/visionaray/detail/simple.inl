@@ -6,9 +6,14 @@
 #ifndef VSNRAY_DETAIL_SIMPLE_INL
 #define VSNRAY_DETAIL_SIMPLE_INL 1
 
+#include <cstddef>
+#include <utility>
+
+#include <visionaray/math/array.h>
 #include <visionaray/get_surface.h>
 #include <visionaray/result_record.h>
 #include <visionaray/traverse.h>
+#include <visionaray/visibility_buffer.h>
 
 
 namespace visionaray
@@ -16,28 +21,37 @@ namespace visionaray
 namespace simple
 {
 
-template <typename Params>
+template <typename Params, template <typename> class Result = result_record>
 struct kernel
 {
 
     Params params;
 
     template <typename Intersector, typename R>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(Intersector& isect, R ray) const
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(Intersector& isect, R ray) const
+    {
+        return shade(isect, ray, closest_hit(ray, params.prims.begin, params.prims.end, isect));
+    }
+
+    // Shade the closest hit of ray
+    template <typename Intersector, typename R, typename HR>
+    VSNRAY_FUNC Result<typename R::scalar_type> shade(Intersector& isect, R ray, HR hit_rec) const
     {
+        VSNRAY_UNUSED(isect);
+
         using S = typename R::scalar_type;
         using V = typename result_record<S>::vec_type;
         using C = spectrum<S>;
 
-        result_record<S> result;
-
-        auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
+        Result<S> result;
 
         if (any(hit_rec.hit))
         {
             hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
 
             auto surf = get_surface(hit_rec, params);
+            set_aovs(result, hit_rec, surf);
+
             auto ambient = surf.material.ambient() * C(from_rgba(params.ambient_color));
             auto shaded_clr = select( hit_rec.hit, ambient, C(from_rgba(params.bg_color)) );
             auto view_dir = -ray.dir;
@@ -64,11 +78,51 @@ struct kernel
     }
 
     template <typename R>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(R ray) const
     {
         default_intersector ignore;
         return (*this)(ignore, ray);
     }
+
+    // Shade rasterized primary hits (see basic_sched::set_visibility_buffer())
+    template <typename Intersector, typename R>
+    VSNRAY_FUNC Result<typename R::scalar_type> shade_visible(
+            Intersector&                                        isect,
+            R                                                   ray,
+            visibility_sample<typename R::scalar_type> const&   vis
+            ) const
+    {
+        using HR = decltype( closest_hit(ray, params.prims.begin, params.prims.end, isect) );
+
+        return shade(isect, ray, make_hit_record<HR>(vis));
+    }
+
+    // Trace N coherent ray packets w/ one BVH traversal, e.g. the primary rays of a
+    // screen tile (see basic_sched::set_coherent_tiles())
+    template <
+        typename Intersector,
+        typename R,
+        size_t N,
+        typename = decltype( closest_hit_coherent(
+                std::declval<array<R, N> const&>(),
+                std::declval<Params const&>().prims.begin,
+                std::declval<Params const&>().prims.end,
+                std::declval<Intersector&>()
+                ) )
+        >
+    array<Result<typename R::scalar_type>, N> trace_coherent(Intersector& isect, array<R, N> const& rays) const
+    {
+        auto hit_recs = closest_hit_coherent(rays, params.prims.begin, params.prims.end, isect);
+
+        array<Result<typename R::scalar_type>, N> result;
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            result[k] = shade(isect, rays[k], hit_recs[k]);
+        }
+
+        return result;
+    }
 };
 
 } // simple
@@ -0,0 +1,289 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cmath>
+
+#include "parallel_for.h"
+#include "range.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Parameters
+//
+
+inline void temporal_accumulator::set_max_history(unsigned max_history)
+{
+    max_history_ = max_history;
+}
+
+inline unsigned temporal_accumulator::max_history() const
+{
+    return max_history_;
+}
+
+inline void temporal_accumulator::set_depth_tolerance(float tolerance)
+{
+    depth_tolerance_ = tolerance;
+}
+
+inline float temporal_accumulator::depth_tolerance() const
+{
+    return depth_tolerance_;
+}
+
+inline void temporal_accumulator::set_normal_tolerance(float tolerance)
+{
+    normal_tolerance_ = tolerance;
+}
+
+inline float temporal_accumulator::normal_tolerance() const
+{
+    return normal_tolerance_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Interface
+//
+
+inline void temporal_accumulator::reset()
+{
+    valid_ = false;
+}
+
+inline void temporal_accumulator::accumulate(
+        thread_pool&                pool,
+        aov_buffer_rt<PF_RGBA32F>&  frame,
+        pinhole_camera const&       cam
+        )
+{
+    int w = frame.width();
+    int h = frame.height();
+
+    if (w <= 0 || h <= 0)
+    {
+        return;
+    }
+
+    if (w != width_ || h != height_)
+    {
+        resize(w, h);
+        valid_ = false;
+    }
+
+    vec4*  color     = frame.color();
+    float* depth     = frame.depth();
+    float* normal[3] = { frame.normal(0), frame.normal(1), frame.normal(2) };
+    float* albedo[3] = { frame.albedo(0), frame.albedo(1), frame.albedo(2) };
+
+    bool use_normals = normal[0] != nullptr;
+    bool use_albedo  = albedo[0] != nullptr;
+
+    // W/o depth, there is nothing to reproject
+    bool use_history = valid_ && depth != nullptr;
+
+    mat4 view_proj = cam.get_proj_matrix() * cam.get_view_matrix();
+    mat4 inv_view_proj = inverse(view_proj);
+    vec3 eye = cam.eye();
+
+    int prev = curr_;
+    int next = 1 - curr_;
+
+    float max_len = static_cast<float>(std::max(max_history_, 1U));
+
+    parallel_for(pool, tiled_range2d<int>(0, w, 64, 0, h, 16), [&](range2d<int> const& r)
+    {
+        for (int y = r.cols().begin(); y != r.cols().end(); ++y)
+        {
+            for (int x = r.rows().begin(); x != r.rows().end(); ++x)
+            {
+                int i = y * w + x;
+
+                bool hit = depth != nullptr && depth[i] < 1.0f;
+
+                vec3 n(0.0f);
+
+                if (use_normals)
+                {
+                    n = vec3(normal[0][i], normal[1][i], normal[2][i]);
+                }
+
+                // World space position of the sample, on the far plane if no surface was hit
+                vec4 ndc(
+                        (x + 0.5f) / w * 2.0f - 1.0f,
+                        (y + 0.5f) / h * 2.0f - 1.0f,
+                        hit ? depth[i] * 2.0f - 1.0f : 1.0f,
+                        1.0f
+                        );
+
+                vec4 wpos = inv_view_proj * ndc;
+                vec3 pos = wpos.xyz() / wpos.w;
+
+                vec4  hist_color(0.0f);
+                vec3  hist_albedo(0.0f);
+                float hist_len = 0.0f;
+
+                vec4 ppos = use_history ? prev_view_proj_ * vec4(pos, 1.0f) : vec4(0.0f);
+
+                if (ppos.w > 0.0f)
+                {
+                    // Pixel coordinates in the previous frame
+                    float px = (ppos.x / ppos.w + 1.0f) * 0.5f * w - 0.5f;
+                    float py = (ppos.y / ppos.w + 1.0f) * 0.5f * h - 0.5f;
+
+                    float fx = px - std::floor(px);
+                    float fy = py - std::floor(py);
+                    int   x0 = static_cast<int>(std::floor(px));
+                    int   y0 = static_cast<int>(std::floor(py));
+
+                    // Snap to the pixel center if (almost) not moved, so that
+                    // a still image is not blurred
+                    if (fx < 1E-3f || fx > 1.0f - 1E-3f)
+                    {
+                        x0 += fx > 0.5f ? 1 : 0;
+                        fx = 0.0f;
+                    }
+
+                    if (fy < 1E-3f || fy > 1.0f - 1E-3f)
+                    {
+                        y0 += fy > 0.5f ? 1 : 0;
+                        fy = 0.0f;
+                    }
+
+                    float expected = hit ? length(pos - prev_eye_) : -1.0f;
+                    float sum_w = 0.0f;
+
+                    for (int t = 0; t < 4; ++t)
+                    {
+                        int tx = x0 + (t & 1);
+                        int ty = y0 + (t >> 1);
+
+                        float tw = ((t & 1) ? fx : 1.0f - fx) * ((t >> 1) ? fy : 1.0f - fy);
+
+                        if (tw <= 0.0f || tx < 0 || tx >= w || ty < 0 || ty >= h)
+                        {
+                            continue;
+                        }
+
+                        int j = ty * w + tx;
+
+                        if (length_[prev][j] <= 0.0f)
+                        {
+                            continue;
+                        }
+
+                        // Disocclusion tests
+                        float d = dist_[prev][j];
+
+                        if (hit)
+                        {
+                            if (d < 0.0f || std::abs(d - expected) > depth_tolerance_ * expected)
+                            {
+                                continue;
+                            }
+
+                            if (use_normals)
+                            {
+                                vec3 pn(normal_[prev][0][j], normal_[prev][1][j], normal_[prev][2][j]);
+
+                                if (dot(pn, n) < normal_tolerance_)
+                                {
+                                    continue;
+                                }
+                            }
+                        }
+                        else if (d >= 0.0f)
+                        {
+                            continue;
+                        }
+
+                        hist_color += tw * color_[prev][j];
+                        hist_len   += tw * length_[prev][j];
+
+                        if (use_albedo)
+                        {
+                            hist_albedo += tw * vec3(albedo_[prev][0][j], albedo_[prev][1][j], albedo_[prev][2][j]);
+                        }
+
+                        sum_w += tw;
+                    }
+
+                    if (sum_w > 1E-3f)
+                    {
+                        hist_color  /= sum_w;
+                        hist_albedo /= sum_w;
+                        hist_len    /= sum_w;
+                    }
+                    else
+                    {
+                        hist_len = 0.0f;
+                    }
+                }
+
+
+                // Blend
+
+                float len = std::min(hist_len + 1.0f, max_len);
+                float alpha = 1.0f / len;
+
+                vec4 c = lerp(hist_color, color[i], alpha);
+
+                color[i] = c;
+                color_[next][i] = c;
+                length_[next][i] = len;
+                dist_[next][i] = hit ? length(pos - eye) : -1.0f;
+
+                for (int k = 0; k < 3; ++k)
+                {
+                    normal_[next][k][i] = n[k];
+
+                    if (use_albedo)
+                    {
+                        float a = lerp(hist_albedo[k], albedo[k][i], alpha);
+                        albedo[k][i] = a;
+                        albedo_[next][k][i] = a;
+                    }
+                }
+            }
+        }
+    });
+
+    curr_ = next;
+    prev_view_proj_ = view_proj;
+    prev_eye_ = eye;
+    valid_ = true;
+}
+
+inline float const* temporal_accumulator::history_length() const
+{
+    return length_[curr_].empty() ? nullptr : length_[curr_].data();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Private functions
+//
+
+inline void temporal_accumulator::resize(int w, int h)
+{
+    width_  = w;
+    height_ = h;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        color_[i].resize(w * h);
+        length_[i].resize(w * h);
+        dist_[i].resize(w * h);
+
+        for (int k = 0; k < 3; ++k)
+        {
+            albedo_[i][k].resize(w * h);
+            normal_[i][k].resize(w * h);
+        }
+    }
+}
+
+} // visionaray
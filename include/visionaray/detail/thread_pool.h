@@ -9,16 +9,45 @@
 #include <atomic>
 #include <cassert>
 #include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
+#include "platform.h"
 #include "semaphore.h"
 
+#if VSNRAY_OS_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
 namespace visionaray
 {
 
+//-------------------------------------------------------------------------------------------------
+// Placement of the threads of a thread pool
+//
+// cpus:    one entry per thread, the logical CPU the thread is pinned to
+//          (-1: not pinned). Pinning is only implemented on Linux.
+// domains: one entry per thread, the domain (e.g. NUMA node) of the thread.
+//          The work items of a run are split into one contiguous range per
+//          domain. Threads process the range of their own domain first and
+//          then help with the other ranges.
+//
+// Default: threads are not pinned and share a single domain.
+// See numa.h for how to generate a placement from the NUMA topology.
+//
+
+struct thread_affinity
+{
+    std::vector<int>      cpus;
+    std::vector<unsigned> domains;
+};
+
+
 //-------------------------------------------------------------------------------------------------
 // Thread pool
 //
@@ -27,11 +56,11 @@ class thread_pool
 {
 public:
 
-    explicit thread_pool(unsigned num_threads)
+    explicit thread_pool(unsigned num_threads, thread_affinity const& affinity = thread_affinity())
     {
         sync_params.start_threads = false;
         sync_params.join_threads = false;
-        reset(num_threads);
+        reset(num_threads, affinity);
     }
 
    ~thread_pool()
@@ -39,16 +68,25 @@ public:
         join_threads();
     }
 
-    void reset(unsigned num_threads)
+    void reset(unsigned num_threads, thread_affinity const& affinity = thread_affinity())
     {
         join_threads();
 
+        this->affinity = affinity;
+
+        num_domains = 1;
+        for (auto d : affinity.domains)
+        {
+            num_domains = d + 1 > num_domains ? d + 1 : num_domains;
+        }
+        queues.reset(new work_queue[num_domains]);
+
         threads.reset(new std::thread[num_threads]);
         this->num_threads = num_threads;
 
         for (unsigned i = 0; i < num_threads; ++i)
         {
-            threads[i] = std::thread([this](){ thread_loop(); });
+            threads[i] = std::thread([this, i](){ thread_loop(i); });
         }
     }
 
@@ -79,13 +117,21 @@ public:
     template <typename Func>
     void run(Func f, long queue_length)
     {
+        assert(queue_length >= 0 && queue_length <= MaxQueueLength);
+
         // Set worker function
         func = f;
 
-        // Set counters
-        sync_params.num_work_items = queue_length;
-        sync_params.work_item_counter = 0;
-        sync_params.work_items_finished_counter = 0;
+        // Set counter, one contiguous range of work items per domain
+        sync_params.work_items_remaining = queue_length;
+
+        for (unsigned d = 0; d < num_domains; ++d)
+        {
+            queues[d].range = make_range(
+                    queue_length * d / num_domains,
+                    queue_length * (d + 1) / num_domains
+                    );
+        }
 
         // Activate persistent threads
         sync_params.start_threads = true;
@@ -106,6 +152,29 @@ private:
     using func_t = std::function<void(unsigned)>;
     func_t func;
 
+    thread_affinity affinity;
+
+    // Work items of one domain, padded to avoid false sharing. The next work item
+    // (low 32 bits) and the end of the range (high 32 bits) share one atomic: threads
+    // that still steal from the last run's queues must never combine the next item
+    // of a new run w/ the end of the old one.
+    struct work_queue
+    {
+        std::atomic<uint64_t>   range;
+        char                    pad[64 - sizeof(std::atomic<uint64_t>)];
+    };
+
+    // Leaves headroom for the fetch_add()s past the end of a range
+    enum { MaxQueueLength = 0x7FFFFFFF };
+
+    static uint64_t make_range(long next, long end)
+    {
+        return (static_cast<uint64_t>(end) << 32) | static_cast<uint64_t>(next);
+    }
+
+    std::unique_ptr<work_queue[]> queues;
+    unsigned num_domains = 1;
+
 
     struct
     {
@@ -116,13 +185,30 @@ private:
         std::atomic<bool>       start_threads;
         std::atomic<bool>       join_threads;
 
-        std::atomic<long>       num_work_items;
-        std::atomic<long>       work_item_counter;
-        std::atomic<long>       work_items_finished_counter;
+        std::atomic<long>       work_items_remaining;
     } sync_params;
 
-    void thread_loop()
+    void pin_thread(unsigned thread_index)
     {
+#if VSNRAY_OS_LINUX
+        if (thread_index < affinity.cpus.size() && affinity.cpus[thread_index] >= 0)
+        {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(affinity.cpus[thread_index], &set);
+            pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+        }
+#else
+        static_cast<void>(thread_index);
+#endif
+    }
+
+    void thread_loop(unsigned thread_index)
+    {
+        pin_thread(thread_index);
+
+        unsigned home = thread_index < affinity.domains.size() ? affinity.domains[thread_index] : 0;
+
         for (;;)
         {
             // Wait until activated
@@ -145,25 +231,36 @@ private:
             }
 
 
-            // Perform work in queue
-            for (;;)
-            {
-                auto work_item = sync_params.work_item_counter.fetch_add(1);
+            // Perform work in queues, own domain first
+            bool done = false;
 
-                if (work_item >= sync_params.num_work_items)
-                {
-                    break;
-                }
-
-                func(work_item);
-
-                auto finished = sync_params.work_items_finished_counter.fetch_add(1);
+            for (unsigned i = 0; i < num_domains && !done; ++i)
+            {
+                work_queue& queue = queues[(home + i) % num_domains];
 
-                if (finished >= sync_params.num_work_items - 1)
+                for (;;)
                 {
-                    assert(finished == sync_params.num_work_items - 1);
-                    sync_params.threads_ready.notify();
-                    break;
+                    uint64_t range = queue.range.fetch_add(1);
+
+                    long work_item = static_cast<long>(range & 0xFFFFFFFF);
+                    long end       = static_cast<long>(range >> 32);
+
+                    if (work_item >= end)
+                    {
+                        break;
+                    }
+
+                    func(work_item);
+
+                    // Only decide on the value returned by fetch_sub(): a thread that
+                    // is preempted after finishing an item may only resume once run()
+                    // already returned and set up the next run
+                    if (sync_params.work_items_remaining.fetch_sub(1) == 1)
+                    {
+                        sync_params.threads_ready.notify();
+                        done = true;
+                        break;
+                    }
                 }
             }
         }
@@ -16,14 +16,19 @@ namespace visionaray
 
 struct tiled_sched_backend
 {
-    explicit tiled_sched_backend(unsigned num_threads)
-        : pool_(num_threads)
+    explicit tiled_sched_backend(unsigned num_threads, thread_affinity const& affinity = thread_affinity())
+        : pool_(num_threads, affinity)
     {
     }
 
-    void reset(unsigned num_threads)
+    void reset(unsigned num_threads, thread_affinity const& affinity = thread_affinity())
     {
-        pool_.reset(num_threads);
+        pool_.reset(num_threads, affinity);
+    }
+
+    thread_pool& pool()
+    {
+        return pool_;
     }
 
     template <typename Func>
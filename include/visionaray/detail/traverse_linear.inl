@@ -6,6 +6,8 @@
 #include <type_traits>
 #include <utility>
 
+#include <visionaray/math/array.h>
+#include <visionaray/math/limits.h>
 #include <visionaray/bvh.h>
 #include <visionaray/intersector.h>
 #include <visionaray/update_if.h>
@@ -51,6 +53,7 @@ inline auto traverse(
     for (P it = begin; it != end; ++it)
     {
         auto hr = isect(r, *it);
+        isect.on_primitive_test();
         update_if(result, hr, update_cond(hr, result, max_t));
 
         exit_traversal<Traversal> early_exit;
@@ -169,6 +172,45 @@ inline auto traverse(
             );
 }
 
+
+
+//-------------------------------------------------------------------------------------------------
+// Traverse BVHs w/ sets of coherent ray packets
+//
+
+template <
+    traversal_type Traversal,
+    typename R,
+    size_t N,
+    typename P,
+    typename Intersector
+    >
+inline auto traverse_coherent(
+        array<R, N> const&                          rays,
+        P                                           begin,
+        P                                           end,
+        array<typename R::scalar_type, N> const&    max_t,
+        Intersector&                                isect
+        )
+    -> decltype( intersect_coherent<Traversal>(rays, *begin, isect, max_t) )
+{
+    using RT = decltype( intersect_coherent<Traversal>(rays, *begin, isect, max_t) );
+
+    RT result;
+
+    for (P it = begin; it != end; ++it)
+    {
+        auto hr = intersect_coherent<Traversal>(rays, *it, isect, max_t);
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            update_if(result[k], hr[k], is_closer(hr[k], result[k], max_t[k]));
+        }
+    }
+
+    return result;
+}
+
 } // detail
 
 
@@ -319,6 +361,81 @@ inline auto closest_hit(R const& r, Primitives begin, Primitives end)
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// Coherent any hit and closest hit
+//
+// Traverse BVHs w/ N ray packets at once, e.g. all primary rays of a screen tile.
+// Returns one hit record per packet
+//
+
+template <
+    typename R,
+    size_t N,
+    typename Primitives,
+    typename Intersector
+    >
+inline auto any_hit_coherent(
+        array<R, N> const&                          rays,
+        Primitives                                  begin,
+        Primitives                                  end,
+        array<typename R::scalar_type, N> const&    max_t,
+        Intersector&                                isect
+        )
+    -> decltype( detail::traverse_coherent<detail::AnyHit>(rays, begin, end, max_t, isect) )
+{
+    return detail::traverse_coherent<detail::AnyHit>(rays, begin, end, max_t, isect);
+}
+
+template <typename R, size_t N, typename Primitives>
+inline auto any_hit_coherent(
+        array<R, N> const&                          rays,
+        Primitives                                  begin,
+        Primitives                                  end,
+        array<typename R::scalar_type, N> const&    max_t
+        )
+    -> decltype( any_hit_coherent(rays, begin, end, max_t, std::declval<default_intersector&>()) )
+{
+    default_intersector ignore;
+    return any_hit_coherent(rays, begin, end, max_t, ignore);
+}
+
+template <
+    typename R,
+    size_t N,
+    typename Primitives,
+    typename Intersector
+    >
+inline auto closest_hit_coherent(
+        array<R, N> const&  rays,
+        Primitives          begin,
+        Primitives          end,
+        Intersector&        isect
+        )
+    -> decltype( detail::traverse_coherent<detail::ClosestHit>(
+            rays,
+            begin,
+            end,
+            std::declval<array<typename R::scalar_type, N> const&>(),
+            isect
+            ) )
+{
+    using S = typename R::scalar_type;
+
+    array<S, N> max_t;
+    max_t.fill(numeric_limits<S>::max());
+
+    return detail::traverse_coherent<detail::ClosestHit>(rays, begin, end, max_t, isect);
+}
+
+template <typename R, size_t N, typename Primitives>
+inline auto closest_hit_coherent(array<R, N> const& rays, Primitives begin, Primitives end)
+    -> decltype( closest_hit_coherent(rays, begin, end, std::declval<default_intersector&>()) )
+{
+    default_intersector ignore;
+    return closest_hit_coherent(rays, begin, end, ignore);
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // multi hit
 //
@@ -0,0 +1,138 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_DETAIL_WAVEFRONT_SCHED_H
+#define VSNRAY_DETAIL_WAVEFRONT_SCHED_H 1
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+#include "../math/ray.h"
+#include "../math/vector.h"
+#include "../aligned_vector.h"
+#include "../random_generator.h"
+#include "../spectrum.h"
+#include "thread_pool.h"
+
+namespace visionaray
+{
+namespace detail
+{
+struct wavefront_paths_storage_base;
+} // detail
+
+//-------------------------------------------------------------------------------------------------
+// State of a batch of paths, structure of arrays
+//
+// HR: scalar hit record type of the kernel
+//
+
+template <typename HR>
+struct wavefront_paths
+{
+    // Current ray
+    aligned_vector<float>                   ori[3];
+    aligned_vector<float>                   dir[3];
+
+    // Path throughput, one plane per spectral sample
+    aligned_vector<float>                   throughput[spectrum<float>::num_samples];
+
+    // Result of the last extension ray
+    aligned_vector<HR>                      hit;
+
+    // Result of the first bounce
+    aligned_vector<int>                     first_hit;
+    aligned_vector<float>                   first_isect_pos[3];
+
+    // Path is extended after shading
+    aligned_vector<int>                     alive;
+
+    // Sort key (e.g. the material) after extension
+    aligned_vector<unsigned>                key;
+
+    // Pixel coordinates and number generator of the path
+    aligned_vector<int>                     x;
+    aligned_vector<int>                     y;
+    std::vector<random_generator<float>>    gen;
+
+    size_t size() const;
+    void resize(size_t size);
+
+    // Ray of path i
+    basic_ray<float> ray(size_t i) const;
+    void set_ray(size_t i, basic_ray<float> const& r);
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Wavefront scheduler
+//
+// Instead of tracing each path from start to end in a single kernel call, the
+// paths of large batches of pixels are advanced bounce by bounce in stages.
+// Each stage runs over a whole batch in parallel on the scheduler's thread pool:
+//
+//  - generate: primary rays for all pixels of the batch
+//  - extend:   find the closest hits of all active paths
+//  - classify: retire paths that left the scene, compute sort keys (materials)
+//  - sort:     sort the active paths by key (counting sort)
+//  - shade:    sample the BRDFs of the sorted paths
+//  - compact:  remove paths that were absorbed
+//
+// and finally stores (or blends) the path results into the render target.
+// Extend and shade process the path queues in packets of R::scalar_type, thanks
+// to the sort, the packets in the shading stage mostly refer to the same
+// material.
+//
+// The kernel implements the stages, e.g. pathtracing::wavefront_kernel. Only
+// the jittered_type and jittered_blend_type pixel samplers are supported.
+//
+// Not included by scheduler.h, include <visionaray/detail/wavefront_sched.h>.
+//
+
+template <typename R>
+class wavefront_sched
+{
+public:
+
+    explicit wavefront_sched(unsigned num_threads, thread_affinity const& affinity = thread_affinity());
+
+    template <typename K, typename SP>
+    void frame(K kernel, SP sched_params, unsigned frame_num = 0);
+
+    void reset(unsigned num_threads, thread_affinity const& affinity = thread_affinity());
+
+    // Max. number of paths in flight (default: 256K)
+    void set_batch_size(size_t batch_size);
+    size_t batch_size() const;
+
+    // E.g. to run post processing passes on the scheduler's threads
+    thread_pool& pool();
+
+private:
+
+    thread_pool pool_;
+
+    size_t batch_size_ = 1 << 18;
+
+    // Path queues, ping-pong
+    std::vector<unsigned> queue_[2];
+
+    // Per chunk histograms of the sort stage
+    std::vector<size_t> counts_;
+
+    // Path state, reused between frames
+    std::unique_ptr<detail::wavefront_paths_storage_base> paths_storage_;
+
+    template <typename Key>
+    size_t sort(std::vector<unsigned> const& in, size_t n, std::vector<unsigned>& out, unsigned num_keys, Key key);
+
+};
+
+} // visionaray
+
+#include "wavefront_sched.inl"
+
+#endif // VSNRAY_DETAIL_WAVEFRONT_SCHED_H
@@ -0,0 +1,474 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+#include "../bvh.h"
+#include "../intersector.h"
+#include "../random_generator.h"
+#include "../scheduler.h"
+#include "parallel_for.h"
+#include "range.h"
+#include "sched_common.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// wavefront_paths members
+//
+
+template <typename HR>
+inline size_t wavefront_paths<HR>::size() const
+{
+    return hit.size();
+}
+
+template <typename HR>
+inline void wavefront_paths<HR>::resize(size_t size)
+{
+    for (int d = 0; d < 3; ++d)
+    {
+        ori[d].resize(size);
+        dir[d].resize(size);
+        first_isect_pos[d].resize(size);
+    }
+
+    for (int s = 0; s < spectrum<float>::num_samples; ++s)
+    {
+        throughput[s].resize(size);
+    }
+
+    hit.resize(size);
+    first_hit.resize(size);
+    alive.resize(size);
+    key.resize(size);
+    x.resize(size);
+    y.resize(size);
+    gen.resize(size);
+}
+
+template <typename HR>
+inline basic_ray<float> wavefront_paths<HR>::ray(size_t i) const
+{
+    return basic_ray<float>(
+            vector<3, float>(ori[0][i], ori[1][i], ori[2][i]),
+            vector<3, float>(dir[0][i], dir[1][i], dir[2][i])
+            );
+}
+
+template <typename HR>
+inline void wavefront_paths<HR>::set_ray(size_t i, basic_ray<float> const& r)
+{
+    for (int d = 0; d < 3; ++d)
+    {
+        ori[d][i] = r.ori[d];
+        dir[d][i] = r.dir[d];
+    }
+}
+
+
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Type erased storage for the path state, whose type depends on the kernel
+//
+
+struct wavefront_paths_storage_base
+{
+    virtual ~wavefront_paths_storage_base() = default;
+};
+
+template <typename Paths>
+struct wavefront_paths_storage : wavefront_paths_storage_base
+{
+    Paths paths;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersector from sched params, or the default one
+//
+
+template <typename SP, typename Default>
+inline auto wavefront_intersector(SP& sparams, Default& /* */, std::true_type /* has intersector */)
+    -> decltype((sparams.intersector))
+{
+    return sparams.intersector;
+}
+
+template <typename SP, typename Default>
+inline Default& wavefront_intersector(SP& /* */, Default& def, std::false_type /* has intersector */)
+{
+    return def;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Kernel that returns a precomputed result, used to store path results with sample_pixel()
+//
+
+template <typename Result>
+struct wavefront_result_kernel
+{
+    Result result;
+
+    template <typename R, typename Generator>
+    Result operator()(R const& /* */, Generator& /* */) const
+    {
+        return result;
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Seed for the path of pixel p
+//
+
+inline unsigned wavefront_seed(unsigned frame_seed, size_t p)
+{
+    unsigned h = frame_seed ^ static_cast<unsigned>(p * 0x9E3779B1u);
+    h ^= h >> 16;
+    h *= 0x85EBCA6Bu;
+    h ^= h >> 13;
+    return h;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// wavefront_sched implementation
+//
+
+template <typename R>
+wavefront_sched<R>::wavefront_sched(unsigned num_threads, thread_affinity const& affinity)
+    : pool_(num_threads, affinity)
+{
+}
+
+template <typename R>
+template <typename K, typename SP>
+void wavefront_sched<R>::frame(K kernel, SP sched_params, unsigned frame_num)
+{
+    using S = typename R::scalar_type;
+    using pixel_sampler_type = typename SP::pixel_sampler_type;
+    using paths_type = wavefront_paths<typename K::hit_record_type>;
+
+    static_assert(
+            std::is_same<pixel_sampler_type, pixel_sampler::jittered_type>::value ||
+            std::is_same<pixel_sampler_type, pixel_sampler::jittered_blend_type>::value,
+            "wavefront_sched supports jittered_type and jittered_blend_type pixel samplers only"
+            );
+
+    // Stages process chunks of paths, multiple of the packet size
+    static const size_t ChunkSize = 1024;
+
+    sched_params.cam.begin_frame();
+
+    sched_params.rt.begin_frame();
+
+    auto storage = dynamic_cast<detail::wavefront_paths_storage<paths_type>*>(paths_storage_.get());
+
+    if (storage == nullptr)
+    {
+        storage = new detail::wavefront_paths_storage<paths_type>;
+        paths_storage_.reset(storage);
+    }
+
+    paths_type& paths = storage->paths;
+
+    default_intersector ignore;
+    auto& isect = detail::wavefront_intersector(
+            sched_params,
+            ignore,
+            typename detail::sched_params_has_intersector<SP>::type()
+            );
+
+    auto scissor_box = sched_params.scissor_box;
+    int width  = sched_params.rt.width();
+    int height = sched_params.rt.height();
+
+    size_t num_pixels = static_cast<size_t>(scissor_box.w) * scissor_box.h;
+
+    unsigned frame_seed = detail::tic(float{}) ^ frame_num;
+
+    std::vector<unsigned> max_keys;
+
+    for (size_t batch_first = 0; batch_first < num_pixels; batch_first += batch_size_)
+    {
+        size_t batch_size = std::min(batch_size_, num_pixels - batch_first);
+
+        paths.resize(batch_size);
+        queue_[0].resize(batch_size);
+        queue_[1].resize(batch_size);
+
+
+        // Generate
+
+        parallel_for(
+            pool_,
+            tiled_range1d<size_t>(0, batch_size, ChunkSize),
+            [&](range1d<size_t> const& r)
+            {
+                for (size_t i = r.begin(); i != r.end(); ++i)
+                {
+                    size_t p = batch_first + i;
+
+                    int x = scissor_box.x + static_cast<int>(p % scissor_box.w);
+                    int y = scissor_box.y + static_cast<int>(p / scissor_box.w);
+
+                    paths.x[i] = x;
+                    paths.y[i] = y;
+                    paths.gen[i] = random_generator<float>(detail::wavefront_seed(frame_seed, p));
+
+                    paths.set_ray(i, detail::make_primary_rays(
+                            basic_ray<float>{},
+                            pixel_sampler::jittered_type{},
+                            paths.gen[i],
+                            x,
+                            y,
+                            width,
+                            height,
+                            sched_params.cam
+                            ));
+
+                    kernel.init(paths, i);
+
+                    queue_[0][i] = static_cast<unsigned>(i);
+                }
+            });
+
+        size_t queue_size = batch_size;
+
+        for (unsigned bounce = 0; bounce < kernel.num_bounces() && queue_size > 0; ++bounce)
+        {
+            tiled_range1d<size_t> chunks(0, queue_size, ChunkSize);
+
+            // Extend
+
+            parallel_for(
+                pool_,
+                chunks,
+                [&](range1d<size_t> const& r)
+                {
+                    kernel.template extend<S>(isect, paths, queue_[0].data(), r.begin(), r.end());
+                });
+
+
+            // Classify
+
+            max_keys.assign(div_up(queue_size, ChunkSize), 0);
+
+            parallel_for(
+                pool_,
+                chunks,
+                [&](range1d<size_t> const& r)
+                {
+                    unsigned max_key = 0;
+
+                    for (size_t q = r.begin(); q != r.end(); ++q)
+                    {
+                        unsigned p = queue_[0][q];
+                        unsigned key = kernel.classify(paths, p, bounce);
+
+                        paths.key[p] = key;
+
+                        if (key != K::Retired)
+                        {
+                            max_key = std::max(max_key, key + 1);
+                        }
+                    }
+
+                    max_keys[r.begin() / ChunkSize] = max_key;
+                });
+
+
+            // Sort by key, retired paths are dropped
+
+            unsigned num_keys = *std::max_element(max_keys.begin(), max_keys.end());
+
+            queue_size = sort(
+                    queue_[0],
+                    queue_size,
+                    queue_[1],
+                    num_keys,
+                    [&](unsigned p) { return paths.key[p]; }
+                    );
+
+
+            if (queue_size == 0)
+            {
+                break;
+            }
+
+
+            // Shade
+
+            parallel_for(
+                pool_,
+                tiled_range1d<size_t>(0, queue_size, ChunkSize),
+                [&](range1d<size_t> const& r)
+                {
+                    kernel.template shade<S>(paths, queue_[1].data(), r.begin(), r.end(), bounce);
+                });
+
+
+            // Compact, keeps the order
+
+            queue_size = sort(
+                    queue_[1],
+                    queue_size,
+                    queue_[0],
+                    1,
+                    [&](unsigned p) { return paths.alive[p] ? 0U : 1U; }
+                    );
+        }
+
+
+        // Store results
+
+        parallel_for(
+            pool_,
+            tiled_range1d<size_t>(0, batch_size, ChunkSize),
+            [&](range1d<size_t> const& r)
+            {
+                for (size_t i = r.begin(); i != r.end(); ++i)
+                {
+                    using result_type = decltype(kernel.result(paths, i));
+
+                    detail::wavefront_result_kernel<result_type> result_kernel{ kernel.result(paths, i) };
+
+                    sample_pixel(
+                            result_kernel,
+                            pixel_sampler_type{},
+                            basic_ray<float>{},
+                            paths.gen[i],
+                            frame_num,
+                            sched_params.rt.ref(),
+                            paths.x[i],
+                            paths.y[i],
+                            width,
+                            height,
+                            sched_params.cam
+                            );
+                }
+            });
+    }
+
+    sched_params.rt.end_frame();
+
+    sched_params.cam.end_frame();
+}
+
+template <typename R>
+void wavefront_sched<R>::reset(unsigned num_threads, thread_affinity const& affinity)
+{
+    pool_.reset(num_threads, affinity);
+}
+
+template <typename R>
+void wavefront_sched<R>::set_batch_size(size_t batch_size)
+{
+    batch_size_ = std::max(batch_size, size_t(1));
+}
+
+template <typename R>
+size_t wavefront_sched<R>::batch_size() const
+{
+    return batch_size_;
+}
+
+template <typename R>
+thread_pool& wavefront_sched<R>::pool()
+{
+    return pool_;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Parallel, stable counting sort of the first n path indices in, keys >= num_keys
+// are dropped. Returns the number of paths in out
+//
+
+template <typename R>
+template <typename Key>
+size_t wavefront_sched<R>::sort(
+        std::vector<unsigned> const&    in,
+        size_t                          n,
+        std::vector<unsigned>&          out,
+        unsigned                        num_keys,
+        Key                             key
+        )
+{
+    static const size_t ChunkSize = 4096;
+
+    if (n == 0)
+    {
+        return 0;
+    }
+
+    // One more bucket for dropped paths
+    size_t num_buckets = num_keys + 1;
+    size_t num_chunks = div_up(n, ChunkSize);
+
+    counts_.assign(num_chunks * num_buckets, 0);
+
+    auto bucket = [&](unsigned p)
+    {
+        return std::min(static_cast<size_t>(key(p)), num_buckets - 1);
+    };
+
+    parallel_for(
+        pool_,
+        tiled_range1d<size_t>(0, n, ChunkSize),
+        [&](range1d<size_t> const& r)
+        {
+            size_t* counts = counts_.data() + (r.begin() / ChunkSize) * num_buckets;
+
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                ++counts[bucket(in[i])];
+            }
+        });
+
+    // Exclusive prefix sum, bucket major so that the sort is stable
+    size_t sum = 0;
+    size_t num_kept = 0;
+
+    for (size_t b = 0; b < num_buckets; ++b)
+    {
+        if (b == num_buckets - 1)
+        {
+            num_kept = sum;
+        }
+
+        for (size_t c = 0; c < num_chunks; ++c)
+        {
+            size_t count = counts_[c * num_buckets + b];
+            counts_[c * num_buckets + b] = sum;
+            sum += count;
+        }
+    }
+
+    parallel_for(
+        pool_,
+        tiled_range1d<size_t>(0, n, ChunkSize),
+        [&](range1d<size_t> const& r)
+        {
+            size_t* offsets = counts_.data() + (r.begin() / ChunkSize) * num_buckets;
+
+            for (size_t i = r.begin(); i != r.end(); ++i)
+            {
+                out[offsets[bucket(in[i])]++] = in[i];
+            }
+        });
+
+    return num_kept;
+}
+
+} // visionaray
@@ -8,11 +8,14 @@
 
 #include <cstddef>
 #include <type_traits>
+#include <utility>
 
 #include <visionaray/math/array.h>
 #include <visionaray/get_surface.h>
+#include <visionaray/occluder_cache.h>
 #include <visionaray/result_record.h>
 #include <visionaray/traverse.h>
+#include <visionaray/visibility_buffer.h>
 
 namespace visionaray
 {
@@ -210,6 +213,29 @@ inline auto specular_bounce(
         );
 }
 
+
+//-------------------------------------------------------------------------------------------------
+// Shadow rays w/o occluder cache, single rays and packets that are shaded on their own
+// gain nothing from caching
+//
+
+struct no_occluder_cache
+{
+    template <typename R, typename Primitives, typename Intersector>
+    VSNRAY_FUNC auto any_hit(
+            size_t                          /* light */,
+            R const&                        r,
+            Primitives                      begin,
+            Primitives                      end,
+            typename R::scalar_type const&  max_t,
+            Intersector&                    isect
+            ) const
+        -> decltype( visionaray::any_hit(r, begin, end, max_t, isect) )
+    {
+        return visionaray::any_hit(r, begin, end, max_t, isect);
+    }
+};
+
 } // detail
 
 
@@ -217,23 +243,36 @@ inline auto specular_bounce(
 // Whitted kernel
 //
 
-template <typename Params>
+template <typename Params, template <typename> class Result = result_record>
 struct kernel
 {
 
     Params params;
 
     template <typename Intersector, typename R>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(Intersector& isect, R ray) const
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(Intersector& isect, R ray) const
+    {
+        return shade(isect, ray, closest_hit(ray, params.prims.begin, params.prims.end, isect));
+    }
+
+    // Shade the closest hit of ray, trace secondary rays
+    template <typename Intersector, typename R, typename HR>
+    VSNRAY_FUNC Result<typename R::scalar_type> shade(Intersector& isect, R ray, HR hit_rec) const
+    {
+        detail::no_occluder_cache cache;
+        return shade(isect, ray, hit_rec, cache);
+    }
+
+    // Same as above, shadow rays test the occluders in cache (see occluder_cache) first
+    template <typename Intersector, typename R, typename HR, typename Cache>
+    VSNRAY_FUNC Result<typename R::scalar_type> shade(Intersector& isect, R ray, HR hit_rec, Cache& cache) const
     {
 
         using S = typename R::scalar_type;
         using V = typename result_record<S>::vec_type;
         using C = spectrum<S>;
 
-        result_record<S> result;
-
-        auto hit_rec = closest_hit(ray, params.prims.begin, params.prims.end, isect);
+        Result<S> result;
 
         if (any(hit_rec.hit))
         {
@@ -257,6 +296,12 @@ struct kernel
             hit_rec.isect_pos = ray.ori + ray.dir * hit_rec.t;
 
             auto surf = get_surface(hit_rec, params);
+
+            if (depth == 1)
+            {
+                set_aovs(result, hit_rec, surf);
+            }
+
             auto ambient = surf.material.ambient() * C(from_rgba(params.ambient_color));
             auto shaded_clr = select( hit_rec.hit, ambient, C(from_rgba(params.bg_color)) );
             auto view_dir = -ray.dir;
@@ -273,7 +318,8 @@ struct kernel
                         );
 
                 // only cast a shadow if occluder between light source and hit pos
-                auto shadow_rec = any_hit(
+                auto shadow_rec = cache.any_hit(
+                        static_cast<size_t>(it - params.lights.begin),
                         shadow_ray,
                         params.prims.begin,
                         params.prims.end,
@@ -312,11 +358,55 @@ struct kernel
     }
 
     template <typename R>
-    VSNRAY_FUNC result_record<typename R::scalar_type> operator()(R ray) const
+    VSNRAY_FUNC Result<typename R::scalar_type> operator()(R ray) const
     {
         default_intersector ignore;
         return (*this)(ignore, ray);
     }
+
+    // Shade rasterized primary hits (see basic_sched::set_visibility_buffer()),
+    // secondary and shadow rays are traced
+    template <typename Intersector, typename R>
+    VSNRAY_FUNC Result<typename R::scalar_type> shade_visible(
+            Intersector&                                        isect,
+            R                                                   ray,
+            visibility_sample<typename R::scalar_type> const&   vis
+            ) const
+    {
+        using HR = decltype( closest_hit(ray, params.prims.begin, params.prims.end, isect) );
+
+        return shade(isect, ray, make_hit_record<HR>(vis));
+    }
+
+    // Trace N coherent ray packets w/ one BVH traversal, e.g. the primary rays of a
+    // screen tile (see basic_sched::set_coherent_tiles())
+    template <
+        typename Intersector,
+        typename R,
+        size_t N,
+        typename = decltype( closest_hit_coherent(
+                std::declval<array<R, N> const&>(),
+                std::declval<Params const&>().prims.begin,
+                std::declval<Params const&>().prims.end,
+                std::declval<Intersector&>()
+                ) )
+        >
+    array<Result<typename R::scalar_type>, N> trace_coherent(Intersector& isect, array<R, N> const& rays) const
+    {
+        auto hit_recs = closest_hit_coherent(rays, params.prims.begin, params.prims.end, isect);
+
+        array<Result<typename R::scalar_type>, N> result;
+
+        // Neighboring packets' shadow rays are often blocked by the same primitive
+        occluder_cache<> cache;
+
+        for (size_t k = 0; k < N; ++k)
+        {
+            result[k] = shade(isect, rays[k], hit_recs[k], cache);
+        }
+
+        return result;
+    }
 };
 
 } // whitted
@@ -40,6 +40,8 @@ public:
 
     VSNRAY_FUNC spectrum<scalar_type> ambient() const;
 
+    VSNRAY_FUNC spectrum<scalar_type> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC spectrum<typename SR::scalar_type> shade(SR const& sr) const;
 
@@ -60,6 +62,8 @@ private:
 
     struct ambient_visitor;
 
+    struct albedo_visitor;
+
     template <typename SR>
     struct shade_visitor;
 
@@ -27,6 +27,18 @@ struct basic_intersector
     using multi_hit_max = std::integral_constant<size_t, N>;
 
 
+    // Traversal hooks ------------------------------------
+    //
+    // Called by the traversal routines, no-ops by default.
+    // See traversal_counters.h for an intersector that implements them.
+    //
+
+    VSNRAY_FUNC void on_node() {}
+    VSNRAY_FUNC void on_box_test() {}
+    VSNRAY_FUNC void on_primitive_test() {}
+    VSNRAY_FUNC void on_stack_push(unsigned /* depth */) {}
+
+
     template <typename R, typename P, typename ...Args>
     VSNRAY_FUNC
     auto operator()(R const& ray, P const& prim, Args&&... args)
@@ -500,7 +500,9 @@ auto make_kernel_params(
 
 } // visionaray
 
+#include "detail/heatmap.inl"
 #include "detail/pathtracing.inl"
+#include "detail/pathtracing_wavefront.inl"
 #include "detail/simple.inl"
 #include "detail/whitted.inl"
 
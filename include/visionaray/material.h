@@ -22,6 +22,13 @@ namespace visionaray
 //
 // Built-in and user-defined materials (must) support the following interface:
 //
+//  - ambient():
+//      return type:                    spectrum, reflected ambient light
+//
+//  - albedo():
+//      return type:                    spectrum, color of the surface w/o lighting, e.g. for
+//                                      AOVs (optional, only required by AOV kernels)
+//
 //  - shade():
 //      const parameter shade_record:   shading info (normal, texture color, ...)
 //      return type:                    spectrum
@@ -93,6 +100,8 @@ public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
 
+    VSNRAY_FUNC spectrum<T> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC spectrum<typename SR::scalar_type> shade(SR const& sr) const;
 
@@ -146,6 +155,8 @@ public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
 
+    VSNRAY_FUNC spectrum<T> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC
     spectrum<typename SR::scalar_type> shade(SR const& sr) const;
@@ -216,6 +227,8 @@ public:
     // TODO: no support for  ambient (function returns 0.0)
     VSNRAY_FUNC spectrum<T> ambient() const;
 
+    VSNRAY_FUNC spectrum<T> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC
     spectrum<typename SR::scalar_type> shade(SR const& sr) const;
@@ -283,6 +296,8 @@ public:
     // TODO: no support for  ambient (function returns 0.0)
     VSNRAY_FUNC spectrum<T> ambient() const;
 
+    VSNRAY_FUNC spectrum<T> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC
     spectrum<typename SR::scalar_type> shade(SR const& sr) const;
@@ -341,6 +356,8 @@ public:
 
     VSNRAY_FUNC spectrum<T> ambient() const;
 
+    VSNRAY_FUNC spectrum<T> albedo() const;
+
     template <typename SR>
     VSNRAY_FUNC
     spectrum<typename SR::scalar_type> shade(SR const& sr) const;
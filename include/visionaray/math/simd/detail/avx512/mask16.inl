@@ -1,6 +1,7 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <stdexcept>
 #include <type_traits>
 
 namespace MATH_NAMESPACE
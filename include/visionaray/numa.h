@@ -0,0 +1,169 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_NUMA_H
+#define VSNRAY_NUMA_H 1
+
+#include <cstddef>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "detail/thread_pool.h"
+#include "export.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// NUMA topology
+//
+// Only implemented on Linux (using sysfs and the mbind system call, no libnuma
+// required). Elsewhere, or if the kernel has no NUMA support, the system
+// appears as a single node with all CPUs and the memory functions return
+// false.
+//
+
+struct numa_node
+{
+    unsigned              id;       // OS node id
+    std::vector<unsigned> cpus;     // logical CPUs of the node
+};
+
+// NUMA nodes that have CPUs, ordered by node id
+VSNRAY_EXPORT std::vector<numa_node> numa_topology();
+
+// Node of the CPU the calling thread currently runs on, 0 if unknown
+VSNRAY_EXPORT unsigned current_numa_node();
+
+// Pin the calling thread to the CPUs of a node
+VSNRAY_EXPORT bool run_on_numa_node(numa_node const& node);
+
+
+//-------------------------------------------------------------------------------------------------
+// Thread placement for thread_pool / tiled_sched
+//
+// PinCompact:  fill the CPUs of the first node, then of the next, ...
+// PinScatter:  assign threads to nodes round robin
+//
+// Threads are pinned to single CPUs, the domain of a thread is the index of
+// its node in the nodes list. With more threads than CPUs, CPUs are reused.
+//
+
+enum thread_pinning
+{
+    PinNone,
+    PinCompact,
+    PinScatter
+};
+
+VSNRAY_EXPORT thread_affinity make_thread_affinity(
+        unsigned                        num_threads,
+        thread_pinning                  pinning,
+        std::vector<numa_node> const&   nodes
+        );
+
+
+//-------------------------------------------------------------------------------------------------
+// Memory placement
+//
+// Sets the NUMA policy of the pages that lie completely inside [addr..addr+len)
+// and migrates pages that were already touched. Partially covered pages at the
+// ends are left alone, they may hold unrelated data; use page-aligned storage
+// (e.g. huge_page_allocator) to place a whole buffer. Returns false if not
+// supported.
+//
+// numa_bind:       all pages on one node
+// numa_interleave: pages round robin on the nodes, for read-only data that
+//                  all threads access (BVH, primitives, textures)
+// numa_distribute: one contiguous band per node, band i on nodes[i]; matches
+//                  the per domain work ranges of thread_pool, so that with a
+//                  row major framebuffer each node renders into local memory
+//
+
+VSNRAY_EXPORT bool numa_bind(void const* addr, size_t len, numa_node const& node);
+
+VSNRAY_EXPORT bool numa_interleave(void const* addr, size_t len, std::vector<numa_node> const& nodes);
+
+VSNRAY_EXPORT bool numa_distribute(void const* addr, size_t len, std::vector<numa_node> const& nodes);
+
+
+//-------------------------------------------------------------------------------------------------
+// One copy of (read-only) data per NUMA node
+//
+// Each copy is constructed by a thread that runs on the respective node, so
+// that memory allocated by the copy constructor is local to that node (first
+// touch). local() returns the copy of the node the calling thread runs on.
+// Use with pinned threads, e.g. to pass node local BVHs to the kernel:
+//
+//      numa_replicated<index_bvh<triangle_type>> bvhs(bvh, numa_topology());
+//      ...
+//      auto ref = bvhs.local().ref(); // in the render thread
+//
+
+template <typename T>
+class numa_replicated
+{
+public:
+
+    numa_replicated(T const& value, std::vector<numa_node> const& nodes)
+        : nodes_(nodes)
+    {
+        if (nodes_.empty())
+        {
+            copies_.emplace_back(new T(value));
+            return;
+        }
+
+        copies_.resize(nodes_.size());
+
+        for (size_t i = 0; i < nodes_.size(); ++i)
+        {
+            std::thread t([&, i]()
+            {
+                run_on_numa_node(nodes_[i]);
+                copies_[i].reset(new T(value));
+            });
+            t.join();
+        }
+    }
+
+    // Copy on the node the calling thread runs on
+    T const& local() const
+    {
+        unsigned id = current_numa_node();
+
+        for (size_t i = 0; i < nodes_.size(); ++i)
+        {
+            if (nodes_[i].id == id)
+            {
+                return *copies_[i];
+            }
+        }
+
+        return *copies_[0];
+    }
+
+    // Copy on nodes[index]
+    T const& operator[](size_t index) const
+    {
+        return *copies_[index];
+    }
+
+    size_t size() const
+    {
+        return copies_.size();
+    }
+
+private:
+
+    std::vector<numa_node>          nodes_;
+    std::vector<std::unique_ptr<T>> copies_;
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_NUMA_H
@@ -0,0 +1,229 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_OCCLUDER_CACHE_H
+#define VSNRAY_OCCLUDER_CACHE_H 1
+
+#include <cstddef>
+#include <iterator>
+#include <type_traits>
+
+#include "math/simd/type_traits.h"
+#include "detail/macros.h"
+#include "bvh.h"
+#include "intersector.h"
+#include "traverse.h"
+#include "update_if.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Primitive list index of the first ray in a packet that hit something, -1 if none did
+//
+
+template <typename HR>
+VSNRAY_FUNC
+inline int first_hit_index(HR const& hr, std::false_type /* is simd */)
+{
+    return hr.hit ? static_cast<int>(hr.primitive_list_index) : -1;
+}
+
+template <typename HR>
+inline int first_hit_index(HR const& hr, std::true_type /* is simd */)
+{
+    using I = decltype(hr.primitive_list_index);
+
+    simd::aligned_array_t<I> indices;
+    store(indices, select(hr.hit, hr.primitive_list_index, I(-1)));
+
+    for (int i = 0; i < simd::num_elements<I>::value; ++i)
+    {
+        if (indices[i] >= 0)
+        {
+            return indices[i];
+        }
+    }
+
+    return -1;
+}
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Occluder cache for shadow rays
+//
+// Remembers per light source the primitive that last occluded a shadow ray.
+// Neighboring shadow rays to the same light are often blocked by the same
+// primitive, so any_hit() tests that primitive first and only traverses the
+// BVHs if it does not occlude all rays of the packet.
+//
+// Use one cache per thread and per tile of coherent rays (e.g. in a kernel's
+// trace_coherent()), the cache is not thread safe. Entries refer to primitives
+// by index, call invalidate() after the BVHs changed. Lights with an index >=
+// MaxLights are not cached.
+//
+// Usage:
+//
+//   occluder_cache<> cache;
+//
+//   for (auto it = lights.begin; it != lights.end; ++it)
+//   {
+//       auto hr = cache.any_hit(it - lights.begin, shadow_ray, prims.begin, prims.end, dist, isect);
+//   }
+//
+
+template <unsigned MaxLights = 8>
+class occluder_cache
+{
+public:
+
+    VSNRAY_FUNC occluder_cache()
+    {
+        invalidate();
+    }
+
+    // Drop all cached occluders
+    VSNRAY_FUNC void invalidate()
+    {
+        for (unsigned i = 0; i < MaxLights; ++i)
+        {
+            entries_[i].bvh_index = -1;
+            entries_[i].prim_index = -1;
+        }
+    }
+
+    // Any hit query for a shadow ray to light, hits the same rays as visionaray::any_hit()
+    template <
+        typename R,
+        typename Primitives,
+        typename Intersector,
+        typename Primitive = typename std::iterator_traits<Primitives>::value_type
+        >
+    VSNRAY_FUNC auto any_hit(
+            size_t                          light,
+            R const&                        r,
+            Primitives                      begin,
+            Primitives                      end,
+            typename R::scalar_type const&  max_t,
+            Intersector&                    isect
+            )
+        -> decltype( visionaray::any_hit(r, begin, end, max_t, isect) )
+    {
+        return any_hit_impl(is_any_bvh<Primitive>{}, light, r, begin, end, max_t, isect);
+    }
+
+    // Queries that were answered by the cached occluder / that traversed the BVHs
+    VSNRAY_FUNC unsigned num_hits() const { return num_hits_; }
+    VSNRAY_FUNC unsigned num_misses() const { return num_misses_; }
+
+private:
+
+    struct entry
+    {
+        int bvh_index;
+        int prim_index;
+    };
+
+    entry entries_[MaxLights];
+
+    unsigned num_hits_ = 0;
+    unsigned num_misses_ = 0;
+
+    // No BVHs, nothing to cache
+    template <typename R, typename Primitives, typename Intersector>
+    VSNRAY_FUNC auto any_hit_impl(
+            std::false_type                 /* is any bvh */,
+            size_t                          light,
+            R const&                        r,
+            Primitives                      begin,
+            Primitives                      end,
+            typename R::scalar_type const&  max_t,
+            Intersector&                    isect
+            )
+        -> decltype( visionaray::any_hit(r, begin, end, max_t, isect) )
+    {
+        VSNRAY_UNUSED(light);
+
+        return visionaray::any_hit(r, begin, end, max_t, isect);
+    }
+
+    template <typename R, typename Primitives, typename Intersector>
+    VSNRAY_FUNC auto any_hit_impl(
+            std::true_type                  /* is any bvh */,
+            size_t                          light,
+            R const&                        r,
+            Primitives                      begin,
+            Primitives                      end,
+            typename R::scalar_type const&  max_t,
+            Intersector&                    isect
+            )
+        -> decltype( visionaray::any_hit(r, begin, end, max_t, isect) )
+    {
+        using HR = decltype( visionaray::any_hit(r, begin, end, max_t, isect) );
+
+        if (light >= MaxLights)
+        {
+            return visionaray::any_hit(r, begin, end, max_t, isect);
+        }
+
+        HR result;
+
+        entry& e = entries_[light];
+
+        // Test the cached occluder first
+        if (e.prim_index >= 0)
+        {
+            auto const& b = begin[e.bvh_index];
+
+            auto hr = HR(isect(r, b.primitive(e.prim_index)), typename HR::int_type(e.prim_index));
+            isect.on_primitive_test();
+
+            update_if(result, hr, is_closer(hr, result, max_t));
+
+            if (all(result.hit))
+            {
+                ++num_hits_;
+                return result;
+            }
+        }
+
+        ++num_misses_;
+
+        // Traverse the BVHs one by one to know which one the occluder is in
+        for (Primitives it = begin; it != end; ++it)
+        {
+            auto hr = visionaray::any_hit(r, it, it + 1, max_t, isect);
+
+            int prim_index = detail::first_hit_index(
+                    hr,
+                    std::integral_constant<bool, simd::is_simd_vector<typename R::scalar_type>::value>{}
+                    );
+
+            if (prim_index >= 0)
+            {
+                e.bvh_index = static_cast<int>(it - begin);
+                e.prim_index = prim_index;
+            }
+
+            update_if(result, hr, is_closer(hr, result, max_t));
+
+            if (all(result.hit))
+            {
+                break;
+            }
+        }
+
+        return result;
+    }
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_OCCLUDER_CACHE_H
@@ -0,0 +1,135 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_RASTERIZER_H
+#define VSNRAY_RASTERIZER_H 1
+
+#include <cstddef>
+#include <vector>
+
+#include "detail/thread_pool.h"
+#include "aligned_vector.h"
+#include "visibility_buffer.h"
+
+namespace visionaray
+{
+namespace detail
+{
+
+//-------------------------------------------------------------------------------------------------
+// Screen space triangle after near plane clipping
+//
+// Edge function i is zero on the edge opposite of vertex i and positive inside:
+// e_i(x,y) = a_i * (x - ox_i) + b_i * (y - oy_i). inv_w is 1/w at the vertices,
+// linear in screen space, larger is closer.
+//
+
+struct raster_triangle
+{
+    float a[3];
+    float b[3];
+    float ox[3];
+    float oy[3];
+    float inv_w[3];
+    float inv_area;
+
+    // Pixels on the edge are inside if the edge is a top or left edge
+    bool top_left[3];
+
+    // Covered pixels are in [x0..x1] x [y0..y1]
+    int x0;
+    int y0;
+    int x1;
+    int y1;
+
+    // Triangle that was rasterized, BVH index (0 w/o BVHs) and primitive list index
+    unsigned bvh;
+    unsigned index;
+};
+
+// Contiguous primitives of a BVH leaf
+struct raster_leaf
+{
+    unsigned bvh;
+    unsigned first;
+    unsigned last;
+};
+
+} // detail
+
+
+//-------------------------------------------------------------------------------------------------
+// Tiled CPU rasterizer that resolves primary visibility into a visibility buffer
+//
+// Renders the same view as the primary rays of a scheduler w/ uniform pixel
+// sampling: the pixel centers of cam's image plane are sampled. There is no
+// near or far plane and no backface culling. Triangles are clipped against
+// the plane through the eye and a guard band around the viewport, then set
+// up and binned to 32x32 pixel tiles by the threads of a thread_pool (e.g.
+// the one of the tiled_sched that shades the frame). The tiles are
+// rasterized in parallel w/ a tile local depth buffer (1/w), rows of pixels
+// are tested w/ SIMD vectors of type FloatT.
+// Triangles are processed in input order, so that results do not depend on
+// the number of threads.
+//
+// The visible triangle of each pixel is then intersected w/ the pixel's
+// primary ray, t, u and v are the same as closest_hit() would return (up to
+// pixels on triangle edges, where rasterization and ray tracing may pick
+// different triangles).
+//
+// Primitives are either triangles (e.g. model::primitives), or BVHs of
+// triangles (e.g. kernel params prims). Samples then store the primitive list
+// index of the BVH, so that kernels can use them in place of closest_hit()
+// (see basic_sched::set_visibility_buffer()). BVH nodes outside the view
+// frustum are culled.
+//
+// Usage:
+//
+//   rasterizer rast;
+//   visibility_buffer vbuffer;
+//   vbuffer.resize(width, height);
+//
+//   rast.rasterize<simd::float4>(sched.backend().pool(), cam, bvhs.begin, bvhs.end, vbuffer);
+//
+
+class rasterizer
+{
+public:
+
+    enum { TileSize = 32 };
+
+public:
+
+    // Rasterize [begin..end) into vbuffer, using vbuffer's size as the viewport
+    template <typename FloatT = float, typename Camera, typename Primitives>
+    void rasterize(
+            thread_pool&        pool,
+            Camera              cam,
+            Primitives          begin,
+            Primitives          end,
+            visibility_buffer&  vbuffer
+            );
+
+private:
+
+    // Leaves in the view frustum (BVH input only)
+    std::vector<detail::raster_leaf> leaves_;
+
+    // Triangles that were set up, per chunk of the input
+    std::vector<aligned_vector<detail::raster_triangle>> triangles_;
+
+    // Index of the first triangle of each chunk, w/ all chunks concatenated
+    std::vector<size_t> offsets_;
+
+    // Per chunk and tile, triangles (indices into triangles_[chunk]) that overlap the tile
+    std::vector<std::vector<std::vector<unsigned>>> bins_;
+
+};
+
+} // visionaray
+
+#include "detail/rasterizer.inl"
+
+#endif // VSNRAY_RASTERIZER_H
@@ -86,6 +86,53 @@ struct render_target_ref
 
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// AOV render target ref
+//
+// Color buffer and planar buffers for the AOVs (arbitrary output variables)
+// of the primary hit, one plane of width x height values per channel. Planes
+// that are nullptr are not written.
+//
+
+template <pixel_format ColorFormat>
+struct aov_render_target_ref
+{
+    using color_type = typename pixel_traits<ColorFormat>::type;
+
+    VSNRAY_FUNC color_type* color()
+    {
+        return color_;
+    }
+
+    VSNRAY_FUNC color_type const* color() const
+    {
+        return color_;
+    }
+
+    VSNRAY_FUNC int width() const
+    {
+        return width_;
+    }
+
+    VSNRAY_FUNC int height() const
+    {
+        return height_;
+    }
+
+    // Public, to allow for aggregate initialization!
+    color_type* color_;
+    float*      depth_;         // window space depth, 1.0 w/o hit
+    float*      normal_[3];     // x, y, z
+    float*      albedo_[3];     // r, g, b
+    int*        prim_id_;
+    int*        geom_id_;
+
+    int width_;
+    int height_;
+
+};
+
 } // visionaray
 
 #endif // VSNRAY_RENDER_TARGET_H
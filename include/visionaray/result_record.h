@@ -8,6 +8,7 @@
 
 #include "math/simd/type_traits.h"
 #include "math/vector.h"
+#include "spectrum.h"
 
 namespace visionaray
 {
@@ -43,6 +44,64 @@ public:
 
 };
 
+
+//-------------------------------------------------------------------------------------------------
+// Result record with AOVs (arbitrary output variables) of the primary hit
+//
+// Returned by the builtin kernels when instantiated with aov_result_record,
+// e.g. simple::kernel<Params, aov_result_record>. Pixels w/o hit have normal
+// and albedo 0 and ids -1.
+//
+
+template <typename T>
+class aov_result_record : public result_record<T>
+{
+public:
+
+    using int_type    = simd::int_type_t<T>;
+    using vec_type    = typename result_record<T>::vec_type;
+
+public:
+
+    VSNRAY_FUNC aov_result_record()
+        : normal(0.0)
+        , albedo(0.0)
+        , prim_id(-1)
+        , geom_id(-1)
+    {
+    }
+
+    vec_type    normal;     // shading normal
+    vec_type    albedo;     // material albedo (rgb), multiplied by texture color
+    int_type    prim_id;
+    int_type    geom_id;    // material index with the builtin kernels
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Set the AOVs of a result record from the primary hit, no-op w/o AOVs
+//
+
+template <typename T, typename HR, typename Surface>
+VSNRAY_FUNC
+inline void set_aovs(result_record<T>& /* result */, HR const& /* hit_rec */, Surface const& /* surf */)
+{
+}
+
+template <typename T, typename HR, typename Surface>
+VSNRAY_FUNC
+inline void set_aovs(aov_result_record<T>& result, HR const& hit_rec, Surface const& surf)
+{
+    using I = typename aov_result_record<T>::int_type;
+    using V = typename aov_result_record<T>::vec_type;
+
+    result.normal  = select( hit_rec.hit, surf.shading_normal, V(0.0) );
+    result.albedo  = select( hit_rec.hit, to_rgb(surf.albedo()), V(0.0) );
+    result.prim_id = select( hit_rec.hit, I(hit_rec.prim_id), I(-1) );
+    result.geom_id = select( hit_rec.hit, I(hit_rec.geom_id), I(-1) );
+}
+
 } // visionaray
 
 #endif // VSNRAY_RESULT_RECORD_H
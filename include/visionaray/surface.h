@@ -27,6 +27,12 @@ struct surface<N, M>
     N shading_normal;
     M material;
 
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        return material.albedo();
+    }
+
     template <typename U>
     VSNRAY_FUNC
     spectrum<scalar_type> shade(vector<3, U> const& view_dir, vector<3, U> const& light_dir, vector<3, U> const& light_intensity)
@@ -72,6 +78,12 @@ struct surface<N, C, M>
     C tex_color;
     M material;
 
+    VSNRAY_FUNC
+    spectrum<scalar_type> albedo() const
+    {
+        return material.albedo() * from_rgb(tex_color);
+    }
+
     template <typename U>
     VSNRAY_FUNC
     spectrum<scalar_type> shade(vector<3, U> const& view_dir, vector<3, U> const& light_dir, vector<3, U> const& light_intensity)
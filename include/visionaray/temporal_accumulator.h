@@ -0,0 +1,96 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEMPORAL_ACCUMULATOR_H
+#define VSNRAY_TEMPORAL_ACCUMULATOR_H 1
+
+#include "detail/thread_pool.h"
+#include "math/math.h"
+#include "aligned_vector.h"
+#include "aov_buffer_rt.h"
+#include "pinhole_camera.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Temporal accumulation of progressively rendered frames with reprojection
+//
+// Keeps the accumulated color (and albedo) of the previous frames. When the
+// camera moves, each pixel of a new frame is reprojected into the previous
+// frame using its depth and the view and projection matrices of the previous
+// and the current camera. The history is fetched with a bilinear filter, taps
+// whose distance to the eye or normal don't match the reprojected surface
+// (disocclusions) are discarded. The new samples are then blended with the
+// history, the blend weight is 1 / (number of accumulated samples), so that a
+// still image converges like with jittered_blend. Pixels w/o valid history
+// start over with one sample.
+//
+// Input is an aov_buffer_rt with one new sample per pixel (e.g. rendered with
+// pixel_sampler::jittered_type) and at least the depth AOV. Normals are used
+// for disocclusion tests if present. Color and albedo planes of the input
+// are replaced by the accumulated values.
+//
+
+class temporal_accumulator
+{
+public:
+
+    temporal_accumulator() = default;
+
+    // Max. number of accumulated samples, older samples fade out (default: 256)
+    void set_max_history(unsigned max_history);
+    unsigned max_history() const;
+
+    // Max. difference of the distances to the eye, relative (default: 0.05)
+    void set_depth_tolerance(float tolerance);
+    float depth_tolerance() const;
+
+    // Min. cosine between the normals (default: 0.9)
+    void set_normal_tolerance(float tolerance);
+    float normal_tolerance() const;
+
+    // Discard the history, e.g. when the scene changes
+    void reset();
+
+    // Blend the new samples in frame with the reprojected history
+    void accumulate(thread_pool& pool, aov_buffer_rt<PF_RGBA32F>& frame, pinhole_camera const& cam);
+
+    // Number of accumulated samples per pixel after the last call to accumulate()
+    float const* history_length() const;
+
+private:
+
+    unsigned max_history_   = 256;
+    float depth_tolerance_  = 0.05f;
+    float normal_tolerance_ = 0.9f;
+
+    int width_  = 0;
+    int height_ = 0;
+    bool valid_ = false;
+
+    mat4 prev_view_proj_;
+    vec3 prev_eye_;
+
+    // History, ping-pong
+    int curr_ = 0;
+
+    aligned_vector<vec4>  color_[2];
+    aligned_vector<float> albedo_[2][3];
+    aligned_vector<float> length_[2];
+
+    // Distance to the eye (< 0: no surface), normal
+    aligned_vector<float> dist_[2];
+    aligned_vector<float> normal_[2][3];
+
+    void resize(int w, int h);
+
+};
+
+} // visionaray
+
+#include "detail/temporal_accumulator.inl"
+
+#endif // VSNRAY_TEMPORAL_ACCUMULATOR_H
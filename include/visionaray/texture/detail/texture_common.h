@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <array>
+#include <vector>
 
 #include <visionaray/math/norm.h>
 #include <visionaray/math/vector.h>
@@ -85,7 +86,7 @@ protected:
 };
 
 
-template <typename T, size_t Dim>
+template <typename T, size_t Dim, typename Allocator>
 class texture_base : public texture_params_base<Dim>
 {
 public:
@@ -98,7 +99,7 @@ public:
     texture_base() = default;
 
     explicit texture_base(size_t size)
-        : data_(aligned_vector<T>(size))
+        : data_(size)
     {
     }
 
@@ -161,7 +162,7 @@ public:
 
 protected:
 
-    aligned_vector<T> data_;
+    std::vector<T, Allocator> data_;
 
 };
 
@@ -183,7 +184,8 @@ public:
         VSNRAY_UNUSED(size);
     }
 
-    texture_ref_base(texture_base<T, Dim> const& tex)
+    template <typename Allocator>
+    texture_ref_base(texture_base<T, Dim, Allocator> const& tex)
         : base_type(tex)
         , data_(tex.data())
     {
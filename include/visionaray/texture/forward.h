@@ -11,6 +11,13 @@
 namespace visionaray
 {
 
+template <typename T, size_t A>
+class aligned_allocator;
+
+template <typename T, size_t A>
+class huge_page_allocator;
+
+
 //--------------------------------------------------------------------------------------------------
 // Declarations
 //
@@ -34,7 +41,7 @@ enum tex_filter_mode
 };
 
 
-template <typename T, size_t Dim>
+template <typename T, size_t Dim, typename Allocator = aligned_allocator<T, 16>>
 class texture_base;
 
 template <typename T, size_t Dim>
@@ -49,6 +56,10 @@ using texture = texture_iface<texture_base<T, Dim>, T, Dim>;
 template <typename T, size_t Dim>
 using texture_ref = texture_iface<texture_ref_base<T, Dim>, T, Dim>;
 
+// Texture with texel data in huge pages, for large (volume) textures
+template <typename T, size_t Dim>
+using huge_page_texture = texture_iface<texture_base<T, Dim, huge_page_allocator<T, 16>>, T, Dim>;
+
 } // visionaray
 
 #endif // VSNRAY_TEXTURE_FORWARD_H
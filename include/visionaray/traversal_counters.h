@@ -0,0 +1,200 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TRAVERSAL_COUNTERS_H
+#define VSNRAY_TRAVERSAL_COUNTERS_H 1
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "detail/macros.h"
+#include "bvh.h"
+#include "intersector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Counters for one or more ray traversals
+//
+// For SIMD rays the counters apply to the whole packet, as the packet is
+// traversed as a unit.
+//
+
+struct traversal_counters
+{
+    VSNRAY_FUNC traversal_counters()
+        : rays(0)
+        , nodes(0)
+        , boxes(0)
+        , prims(0)
+        , max_stack_depth(0)
+    {
+    }
+
+    VSNRAY_FUNC traversal_counters& operator+=(traversal_counters const& rhs)
+    {
+        rays  += rhs.rays;
+        nodes += rhs.nodes;
+        boxes += rhs.boxes;
+        prims += rhs.prims;
+        max_stack_depth = max_stack_depth > rhs.max_stack_depth ? max_stack_depth : rhs.max_stack_depth;
+        return *this;
+    }
+
+    uint64_t rays;              // number of traversals (rays or packets)
+    uint64_t nodes;             // BVH nodes visited
+    uint64_t boxes;             // ray / AABB tests
+    uint64_t prims;             // ray / primitive tests
+    unsigned max_stack_depth;   // max. number of entries on the traversal stack
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Intersector that counts what the traversal routines do
+//
+// The traversal routines report to the no-op hooks of basic_intersector, so
+// that the counting code is only compiled in if an intersector derived from
+// basic_counting_intersector is passed to them. Use one intersector per thread
+// and per ray (or reset the counters in between)!
+//
+
+template <typename Derived>
+struct basic_counting_intersector : basic_intersector<Derived>
+{
+    VSNRAY_FUNC void on_node()
+    {
+        ++counters.nodes;
+    }
+
+    VSNRAY_FUNC void on_box_test()
+    {
+        ++counters.boxes;
+    }
+
+    VSNRAY_FUNC void on_primitive_test()
+    {
+        ++counters.prims;
+    }
+
+    VSNRAY_FUNC void on_stack_push(unsigned depth)
+    {
+        counters.max_stack_depth = counters.max_stack_depth > depth ? counters.max_stack_depth : depth;
+    }
+
+    traversal_counters counters;
+};
+
+struct counting_intersector : basic_counting_intersector<counting_intersector>
+{
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Aggregate traversal counters from many threads
+//
+// Each thread adds to its own, cache line sized slot, so that render threads
+// do not contend for the counters. Threads are assigned to slots round robin,
+// slots are updated atomically in case that two threads share a slot.
+//
+// Call reset() before and accumulate() after a frame to obtain per frame
+// statistics.
+//
+// Host only.
+//
+
+class traversal_statistics
+{
+public:
+
+    enum { MaxSlots = 64 };
+
+    traversal_statistics()
+    {
+        reset();
+    }
+
+    // Add counters to the calling thread's slot
+    void add(traversal_counters const& c)
+    {
+        slot& s = slots_[thread_index() % MaxSlots];
+
+        s.rays.fetch_add(c.rays, std::memory_order_relaxed);
+        s.nodes.fetch_add(c.nodes, std::memory_order_relaxed);
+        s.boxes.fetch_add(c.boxes, std::memory_order_relaxed);
+        s.prims.fetch_add(c.prims, std::memory_order_relaxed);
+
+        unsigned depth = s.max_stack_depth.load(std::memory_order_relaxed);
+        while (depth < c.max_stack_depth
+            && !s.max_stack_depth.compare_exchange_weak(depth, c.max_stack_depth, std::memory_order_relaxed))
+        {
+        }
+    }
+
+    // Sum over all slots, call when no thread is adding
+    traversal_counters accumulate() const
+    {
+        traversal_counters result;
+
+        for (auto const& s : slots_)
+        {
+            traversal_counters c;
+            c.rays  = s.rays.load(std::memory_order_relaxed);
+            c.nodes = s.nodes.load(std::memory_order_relaxed);
+            c.boxes = s.boxes.load(std::memory_order_relaxed);
+            c.prims = s.prims.load(std::memory_order_relaxed);
+            c.max_stack_depth = s.max_stack_depth.load(std::memory_order_relaxed);
+            result += c;
+        }
+
+        return result;
+    }
+
+    // Zero all slots, call when no thread is adding
+    void reset()
+    {
+        for (auto& s : slots_)
+        {
+            s.rays.store(0, std::memory_order_relaxed);
+            s.nodes.store(0, std::memory_order_relaxed);
+            s.boxes.store(0, std::memory_order_relaxed);
+            s.prims.store(0, std::memory_order_relaxed);
+            s.max_stack_depth.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+
+    struct slot
+    {
+        std::atomic<uint64_t> rays;
+        std::atomic<uint64_t> nodes;
+        std::atomic<uint64_t> boxes;
+        std::atomic<uint64_t> prims;
+        std::atomic<unsigned> max_stack_depth;
+        char pad[64 - 4 * sizeof(uint64_t) - sizeof(unsigned)];
+    };
+
+    slot slots_[MaxSlots];
+
+    static unsigned thread_index()
+    {
+        static std::atomic<unsigned> next_index(0);
+        static VSNRAY_THREAD_LOCAL unsigned index = 0; // 0: not yet assigned
+
+        if (index == 0)
+        {
+            index = ++next_index;
+        }
+
+        return index - 1;
+    }
+
+};
+
+} // visionaray
+
+#endif // VSNRAY_TRAVERSAL_COUNTERS_H
@@ -160,54 +160,133 @@ public:
             : nullptr;
     }
 
+    // Index of the active type, starting at 1
+    VSNRAY_FUNC unsigned which() const
+    {
+        return type_index_;
+    }
+
+    // Unchecked access to the I-th type, starting at 1
+    template <unsigned I>
+    VSNRAY_FUNC detail::type_at<I, Ts...>& get()
+    {
+        return storage_.get(detail::type_index<I>());
+    }
+
+    template <unsigned I>
+    VSNRAY_FUNC detail::type_at<I, Ts...> const& get() const
+    {
+        return storage_.get(detail::type_index<I>());
+    }
+
 private:
 
     detail::variant_storage<Ts...>  storage_;
-    unsigned                        type_index_;
+    unsigned                        type_index_ = 0; // Empty, visitors return a default value
 
 };
 
 
-template <unsigned I, typename ...Ts>
-struct apply_visitor_impl;
+namespace detail
+{
 
-template <unsigned I, typename T, typename ...Ts>
-struct apply_visitor_impl<I, T, Ts...>
+//-------------------------------------------------------------------------------------------------
+// apply_visitor() dispatches with switch statements over the type index, which compile
+// to jump tables on the host and on the device. Each switch statement covers
+// VisitorSwitchSize types, variants with more types chain several switches
+//
+
+enum { VisitorSwitchSize = 16 };
+
+template <unsigned I, typename Visitor, typename Variant>
+VSNRAY_FUNC
+inline typename Visitor::return_type visit_case(
+        Visitor const&  visitor,
+        Variant const&  var,
+        std::true_type  /* valid index */
+        )
+{
+    return visitor(var.template get<I>());
+}
+
+template <unsigned I, typename Visitor, typename Variant>
+VSNRAY_FUNC
+inline typename Visitor::return_type visit_case(
+        Visitor const&  /* */,
+        Variant const&  /* */,
+        std::false_type /* valid index */
+        )
+{
+    // Empty variant (e.g. SIMD lanes that missed)
+    return typename Visitor::return_type();
+}
+
+template <unsigned Offset, bool Done>
+struct visitor_switch
 {
-    template <typename Visitor, typename Variant>
+    template <typename Visitor, typename ...Ts>
     VSNRAY_FUNC
-    typename Visitor::return_type operator()(Visitor const& visitor, Variant const& var) const
+    static typename Visitor::return_type apply(Visitor const& /* */, variant<Ts...> const& /* */)
     {
-        auto ptr = var.template as<T>();
-
-        if (ptr)
-        {
-            return visitor(*ptr);
-        }
-        else
-        {
-            return apply_visitor_impl<I - 1, Ts...>()(visitor, var);
-        }
+        return typename Visitor::return_type();
     }
 };
 
-template <>
-struct apply_visitor_impl<0>
+template <unsigned Offset>
+struct visitor_switch<Offset, false>
 {
-    template <typename Visitor, typename Variant>
+    template <unsigned I, typename Visitor, typename ...Ts>
     VSNRAY_FUNC
-    typename Visitor::return_type operator()(Visitor const&, Variant const&)
+    static typename Visitor::return_type visit(Visitor const& visitor, variant<Ts...> const& var)
     {
-        // TODO
-        return typename Visitor::return_type();
+        return visit_case<Offset + I>(
+                visitor,
+                var,
+                std::integral_constant<bool, Offset + I <= sizeof...(Ts)>{}
+                );
+    }
+
+    template <typename Visitor, typename ...Ts>
+    VSNRAY_FUNC
+    static typename Visitor::return_type apply(Visitor const& visitor, variant<Ts...> const& var)
+    {
+        static_assert(VisitorSwitchSize == 16, "Size mismatch");
+
+        switch (var.which() - Offset)
+        {
+        case  1: return visit< 1>(visitor, var);
+        case  2: return visit< 2>(visitor, var);
+        case  3: return visit< 3>(visitor, var);
+        case  4: return visit< 4>(visitor, var);
+        case  5: return visit< 5>(visitor, var);
+        case  6: return visit< 6>(visitor, var);
+        case  7: return visit< 7>(visitor, var);
+        case  8: return visit< 8>(visitor, var);
+        case  9: return visit< 9>(visitor, var);
+        case 10: return visit<10>(visitor, var);
+        case 11: return visit<11>(visitor, var);
+        case 12: return visit<12>(visitor, var);
+        case 13: return visit<13>(visitor, var);
+        case 14: return visit<14>(visitor, var);
+        case 15: return visit<15>(visitor, var);
+        case 16: return visit<16>(visitor, var);
+        default:
+            return visitor_switch<
+                    Offset + VisitorSwitchSize,
+                    Offset + VisitorSwitchSize >= sizeof...(Ts)
+                    >::apply(visitor, var);
+        }
     }
 };
 
+} // detail
+
+
 template <typename Visitor, typename ...Ts>
 VSNRAY_FUNC
 typename Visitor::return_type apply_visitor(Visitor const& visitor, variant<Ts...> const& var)
 {
-    return apply_visitor_impl<sizeof...(Ts), Ts...>()(visitor, var);
+    return detail::visitor_switch<0, sizeof...(Ts) == 0>::apply(visitor, var);
 }
 
 } // visionaray
@@ -0,0 +1,190 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_VISIBILITY_BUFFER_H
+#define VSNRAY_VISIBILITY_BUFFER_H 1
+
+#include <cassert>
+#include <cstddef>
+
+#include "detail/bvh/hit_record.h"
+#include "detail/macros.h"
+#include "math/simd/type_traits.h"
+#include "math/array.h"
+#include "math/intersect.h"
+#include "math/limits.h"
+#include "aligned_vector.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Primary visibility of a pixel, or of a packet of pixels
+//
+// prim_id and geom_id of the visible triangle, its primitive list index (see
+// hit_record_bvh, position in the triangle list w/o BVH), the ray parameter t
+// and the barycentric coordinates u, v of the primary ray's intersection.
+// Members of pixels w/o a visible triangle have the same values as a
+// hit_record of a missed ray.
+//
+
+template <typename T>
+struct visibility_sample
+{
+    using scalar_type = T;
+    using int_type = simd::int_type_t<T>;
+    using mask_type = simd::mask_type_t<T>;
+
+    VSNRAY_FUNC visibility_sample()
+        : hit(false)
+        , prim_id(0)
+        , geom_id(0)
+        , index(0)
+        , t(numeric_limits<float>::max())
+        , u(0.0)
+        , v(0.0)
+    {
+    }
+
+    mask_type hit;
+    int_type prim_id;
+    int_type geom_id;
+    int_type index;
+
+    T t;
+    T u;
+    T v;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Visibility buffer, width x height visibility samples, e.g. written by a rasterizer
+//
+
+class visibility_buffer
+{
+public:
+
+    using sample_type = visibility_sample<float>;
+
+public:
+
+    void resize(int width, int height)
+    {
+        assert(width >= 0 && height >= 0);
+
+        samples_.resize(static_cast<size_t>(width) * height);
+        width_ = width;
+        height_ = height;
+    }
+
+    int width() const { return width_; }
+    int height() const { return height_; }
+
+    sample_type* data() { return samples_.data(); }
+    sample_type const* data() const { return samples_.data(); }
+
+    sample_type& operator()(int x, int y) { return samples_[static_cast<size_t>(y) * width_ + x]; }
+    sample_type const& operator()(int x, int y) const { return samples_[static_cast<size_t>(y) * width_ + x]; }
+
+private:
+
+    aligned_vector<sample_type> samples_;
+
+    int width_ = 0;
+    int height_ = 0;
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Hit records for visibility samples, as closest_hit() would have returned them
+//
+// Usage:
+//
+//   using HR = decltype( closest_hit(ray, prims.begin, prims.end) );
+//   auto hit_rec = make_hit_record<HR>(vis);
+//
+
+namespace detail
+{
+
+template <typename T>
+VSNRAY_FUNC
+inline void assign_visibility(
+        hit_record<basic_ray<T>, primitive<unsigned>>&  hr,
+        visibility_sample<T> const&                     vis
+        )
+{
+    hr.hit     = vis.hit;
+    hr.prim_id = vis.prim_id;
+    hr.geom_id = vis.geom_id;
+    hr.t       = vis.t;
+    hr.u       = vis.u;
+    hr.v       = vis.v;
+}
+
+template <typename R, typename Base, typename T>
+VSNRAY_FUNC
+inline void assign_visibility(hit_record_bvh<R, Base>& hr, visibility_sample<T> const& vis)
+{
+    assign_visibility(static_cast<Base&>(hr), vis);
+
+    hr.primitive_list_index = vis.index;
+}
+
+} // detail
+
+template <typename HR, typename T>
+VSNRAY_FUNC
+inline HR make_hit_record(visibility_sample<T> const& vis)
+{
+    HR result;
+    detail::assign_visibility(result, vis);
+    return result;
+}
+
+
+namespace simd
+{
+
+//-------------------------------------------------------------------------------------------------
+// simd::pack()
+//
+
+template <
+    size_t N,
+    typename T = float_from_simd_width_t<N>
+    >
+inline visibility_sample<T> pack(array<visibility_sample<float>, N> const& samples)
+{
+    visibility_sample<T> result;
+
+    int* hit = reinterpret_cast<int*>(&result.hit);
+    int* prim_id = reinterpret_cast<int*>(&result.prim_id);
+    int* geom_id = reinterpret_cast<int*>(&result.geom_id);
+    int* index = reinterpret_cast<int*>(&result.index);
+    float* t = reinterpret_cast<float*>(&result.t);
+    float* u = reinterpret_cast<float*>(&result.u);
+    float* v = reinterpret_cast<float*>(&result.v);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        hit[i]     = samples[i].hit ? 0xFFFFFFFF : 0x00000000;
+        prim_id[i] = samples[i].prim_id;
+        geom_id[i] = samples[i].geom_id;
+        index[i]   = samples[i].index;
+        t[i]       = samples[i].t;
+        u[i]       = samples[i].u;
+        v[i]       = samples[i].v;
+    }
+
+    return result;
+}
+
+} // simd
+} // visionaray
+
+#endif // VSNRAY_VISIBILITY_BUFFER_H
@@ -0,0 +1,1344 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/detail/platform.h>
+
+#if VSNRAY_OS_LINUX || VSNRAY_OS_DARWIN
+#include <sys/resource.h>
+#endif
+
+#if VSNRAY_OS_LINUX
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include <visionaray/math/simd/intrinsics.h>
+#include <visionaray/bvh.h>
+#include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/cpu_features.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/numa.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/rasterizer.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/version.h>
+
+#include <common/call_kernel.h>
+#include <common/image.h>
+#include <common/make_materials.h>
+#include <common/model.h>
+#include <common/obj_loader.h>
+#include <common/timer.h>
+
+using namespace visionaray;
+
+using bvh_type              = index_bvh<model::triangle_type>;
+using huge_page_bvh_type    = huge_page_index_bvh<model::triangle_type>;
+using material_type         = plastic<float>;
+using light_type            = point_light<float>;
+using render_target_type    = cpu_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Benchmark settings
+//
+
+struct bench_settings
+{
+    std::string filename;
+    std::string scene       = "spheres";
+    unsigned    triangles   = 100000;
+    std::string bvh         = "binned";
+    unsigned    treelets    = 0;            // treelet restructuring passes after the build
+    bool        reorder     = false;        // cache friendly node layout after the build
+    int         width       = 512;
+    int         height      = 512;
+    unsigned    views       = 4;
+    unsigned    warmup      = 1;
+    unsigned    frames      = 10;
+    std::string algorithms  = "simple,whitted,pathtracing";
+    std::string schedulers  = "tiled";
+    std::string packets     = "float4";
+    unsigned    coherent_tiles = 0;         // 0: off, else tile size for coherent primary rays
+    bool        raster      = false;        // rasterize primary visibility
+    unsigned    num_threads = 0;            // 0: all CPUs (of the used NUMA nodes)
+    std::string pin         = "none";
+    unsigned    numa_nodes  = 0;            // 0: all
+    std::string numa_data   = "default";
+    bool        huge_pages  = false;
+    std::string output;
+    std::string images;
+    std::string image_ext   = ".ppm";
+
+    // Derived from the settings above
+    std::vector<numa_node> nodes;
+    thread_pinning         pinning      = PinNone;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Scene and per-configuration results
+//
+
+struct bench_scene
+{
+    std::string                                 name;
+    model                                       mod;
+    bvh_type                                    bvh;
+    huge_page_bvh_type                          huge_page_bvh;  // used with -huge-pages
+    aligned_vector<bvh_type::bvh_ref>           primitives;
+    aligned_vector<material_type>               materials;
+    double                                      bvh_build_time = 0.0;
+    double                                      bvh_optimize_time = 0.0;
+    size_t                                      bvh_nodes = 0;
+    uint64_t                                    bvh_bytes = 0;
+    float                                       bvh_sah_cost = 0.0f;
+    float                                       bvh_sah_cost_built = 0.0f;  // before restructuring
+};
+
+struct bench_result
+{
+    std::string         algorithm;
+    std::string         scheduler;
+    std::string         packet;
+    std::vector<double> frame_times;
+    int64_t             dtlb_load_misses = -1;  // all frames incl. warmup, -1 if unknown
+    int64_t             llc_load_misses = -1;   // last level cache, same as above
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static std::vector<std::string> split(std::string const& str, char delim = ',')
+{
+    std::vector<std::string> result;
+    std::stringstream ss(str);
+    std::string item;
+
+    while (std::getline(ss, item, delim))
+    {
+        if (!item.empty())
+        {
+            result.push_back(item);
+        }
+    }
+
+    return result;
+}
+
+static std::string json_string(std::string const& str)
+{
+    std::string result = "\"";
+
+    for (char c : str)
+    {
+        switch (c)
+        {
+        case '"':   result += "\\\""; break;
+        case '\\':  result += "\\\\"; break;
+        case '\n':  result += "\\n";  break;
+        case '\t':  result += "\\t";  break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20)
+            {
+                std::ostringstream hex;
+                hex << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c);
+                result += hex.str();
+            }
+            else
+            {
+                result += c;
+            }
+        }
+    }
+
+    return result + "\"";
+}
+
+// Nearest-rank percentile, p in [0..100], times must be sorted
+static double percentile(std::vector<double> const& times, double p)
+{
+    if (times.empty())
+    {
+        return 0.0;
+    }
+
+    size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * times.size()));
+    return times[std::max(rank, size_t(1)) - 1];
+}
+
+// Peak resident set size of the process in bytes, 0 if unknown
+static uint64_t peak_rss()
+{
+#if VSNRAY_OS_LINUX || VSNRAY_OS_DARWIN
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#if VSNRAY_OS_DARWIN
+        return static_cast<uint64_t>(usage.ru_maxrss);          // bytes
+#else
+        return static_cast<uint64_t>(usage.ru_maxrss) * 1024;   // kilobytes
+#endif
+    }
+#endif
+
+    return 0;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Load miss counter of the dTLB or the last level cache (Linux perf events)
+//
+// Counts the calling thread and all threads that are created after the
+// counter was opened. Counts of child threads are only added when the threads
+// exit, so read the counter after the scheduler was destroyed. Unavailable if
+// the CPU or the VM has no such event, or if perf_event_paranoid forbids
+// user space measurements.
+//
+
+class cache_miss_counter
+{
+public:
+
+    enum cache_type { DTLB, LLC };
+
+    explicit cache_miss_counter(cache_type cache)
+    {
+#if VSNRAY_OS_LINUX
+        perf_event_attr attr = {};
+        attr.type           = PERF_TYPE_HW_CACHE;
+        attr.size           = sizeof(attr);
+        attr.config         = (cache == DTLB ? PERF_COUNT_HW_CACHE_DTLB : PERF_COUNT_HW_CACHE_LL)
+                            | (PERF_COUNT_HW_CACHE_OP_READ << 8)
+                            | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.inherit        = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv     = 1;
+
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+    }
+
+   ~cache_miss_counter()
+    {
+#if VSNRAY_OS_LINUX
+        if (fd_ >= 0)
+        {
+            close(fd_);
+        }
+#endif
+    }
+
+    cache_miss_counter(cache_miss_counter const&) = delete;
+    cache_miss_counter& operator=(cache_miss_counter const&) = delete;
+
+    bool available() const
+    {
+        return fd_ >= 0;
+    }
+
+    // Current count, -1 if unavailable
+    int64_t read() const
+    {
+#if VSNRAY_OS_LINUX
+        uint64_t count = 0;
+
+        if (fd_ >= 0 && ::read(fd_, &count, sizeof(count)) == sizeof(count))
+        {
+            return static_cast<int64_t>(count);
+        }
+#endif
+
+        return -1;
+    }
+
+private:
+
+    int fd_ = -1;
+
+};
+
+static char const* compiled_simd_isa()
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    return "AVX-512F";
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
+    return "AVX2";
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    return "AVX";
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE4_1)
+    return "SSE4.1";
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE2)
+    return "SSE2";
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_NEON_FP)
+    return "NEON";
+#else
+    return "Scalar";
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Procedural scenes, deterministic so that results are comparable between runs
+//
+
+static void add_triangle(model& mod, vec3 const& v1, vec3 const& v2, vec3 const& v3)
+{
+    model::triangle_type t;
+    t.v1 = v1;
+    t.e1 = v2 - v1;
+    t.e2 = v3 - v1;
+
+    vec3 n = cross(t.e1, t.e2);
+
+    // Skip degenerate triangles, e.g. at the poles of spheres
+    if (length(n) == 0.0f)
+    {
+        return;
+    }
+
+    t.prim_id = static_cast<unsigned>(mod.primitives.size());
+    t.geom_id = 0;
+
+    mod.primitives.push_back(t);
+    mod.geometric_normals.push_back(normalize(n));
+}
+
+// 8x8 grid of tessellated spheres, about as many triangles as requested
+static void make_spheres(model& mod, unsigned num_triangles)
+{
+    static const int Grid = 8;
+
+    // Each sphere has about 4 * n * n triangles
+    int n = std::max(2, static_cast<int>(std::sqrt(num_triangles / (4.0 * Grid * Grid))));
+
+    for (int gx = 0; gx < Grid; ++gx)
+    {
+        for (int gy = 0; gy < Grid; ++gy)
+        {
+            vec3 center(gx * 2.5f, gy * 2.5f, 0.0f);
+
+            auto pos = [&](int i, int j)
+            {
+                float theta = constants::pi<float>() * i / n;
+                float phi   = constants::pi<float>() * j / n;
+                return center + vec3(sin(theta) * cos(phi), sin(theta) * sin(phi), cos(theta));
+            };
+
+            for (int i = 0; i < n; ++i)
+            {
+                for (int j = 0; j < 2 * n; ++j)
+                {
+                    add_triangle(mod, pos(i, j), pos(i + 1, j), pos(i + 1, j + 1));
+                    add_triangle(mod, pos(i, j), pos(i + 1, j + 1), pos(i, j + 1));
+                }
+            }
+        }
+    }
+}
+
+// Random, small triangles in the unit cube (incoherent)
+static void make_random(model& mod, unsigned num_triangles)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    float size = 2.0f / std::cbrt(static_cast<float>(std::max(num_triangles, 1U)));
+
+    for (unsigned i = 0; i < num_triangles; ++i)
+    {
+        vec3 v1(dist(rng), dist(rng), dist(rng));
+        vec3 v2 = v1 + (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+        vec3 v3 = v1 + (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+        add_triangle(mod, v1, v2, v3);
+    }
+}
+
+// Build the BVH into either scene.bvh or scene.huge_page_bvh, both have the
+// same ref type
+template <typename BVH>
+static void build_bvh(bench_settings const& settings, bench_scene& scene, BVH& bvh)
+{
+    auto const& mod = scene.mod;
+
+    timer t;
+
+    if (settings.bvh == "lbvh")
+    {
+        bvh = build<BVH>(
+                detail::lbvh_builder{},
+                mod.primitives.data(),
+                mod.primitives.size()
+                );
+    }
+    else
+    {
+        bvh = build<BVH>(
+                mod.primitives.data(),
+                mod.primitives.size(),
+                settings.bvh == "split"
+                );
+    }
+
+    scene.bvh_build_time = t.elapsed();
+    scene.bvh_sah_cost_built = sah_cost(bvh);
+
+    if (settings.treelets > 0)
+    {
+        thread_pool pool(settings.num_threads);
+
+        auto stats = optimize_treelets(bvh, pool, settings.treelets);
+
+        scene.bvh_optimize_time = stats.seconds;
+    }
+
+    if (settings.reorder)
+    {
+        timer tr;
+
+        reorder_nodes(bvh);
+
+        scene.bvh_optimize_time += tr.elapsed();
+    }
+
+    scene.bvh_nodes = bvh.nodes().size();
+    scene.bvh_bytes = bvh.nodes().size() * sizeof(bvh_node)
+                    + bvh.indices().size() * sizeof(unsigned)
+                    + bvh.primitives().size() * sizeof(model::triangle_type);
+    scene.bvh_sah_cost = sah_cost(bvh);
+
+    scene.primitives.push_back(bvh.ref());
+}
+
+// Interleave BVH and normals across NUMA nodes
+template <typename BVH>
+static bool interleave_scene(bench_settings const& settings, bench_scene const& scene, BVH const& bvh)
+{
+    auto const& mod = scene.mod;
+
+    return numa_interleave(bvh.nodes().data(), bvh.nodes().size() * sizeof(bvh_node), settings.nodes)
+        && numa_interleave(bvh.indices().data(), bvh.indices().size() * sizeof(unsigned), settings.nodes)
+        && numa_interleave(bvh.primitives().data(), bvh.primitives().size() * sizeof(model::triangle_type), settings.nodes)
+        && numa_interleave(mod.geometric_normals.data(), mod.geometric_normals.size() * sizeof(model::normal_type), settings.nodes);
+}
+
+static bool load_scene(bench_settings const& settings, bench_scene& scene)
+{
+    model& mod = scene.mod;
+
+    if (!settings.filename.empty())
+    {
+        scene.name = settings.filename;
+
+        try
+        {
+            visionaray::load_obj(settings.filename, mod);
+        }
+        catch (std::exception const& e)
+        {
+            std::cerr << "Failed loading obj model: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    else
+    {
+        scene.name = settings.scene;
+
+        if (settings.scene == "spheres")
+        {
+            make_spheres(mod, settings.triangles);
+        }
+        else if (settings.scene == "random")
+        {
+            make_random(mod, settings.triangles);
+        }
+        else
+        {
+            std::cerr << "Unknown scene: " << settings.scene << '\n';
+            return false;
+        }
+
+        mod.materials.emplace_back();
+
+        mod.bbox.invalidate();
+        for (auto const& t : mod.primitives)
+        {
+            mod.bbox.insert(t.v1);
+            mod.bbox.insert(t.v1 + t.e1);
+            mod.bbox.insert(t.v1 + t.e2);
+        }
+    }
+
+    if (mod.primitives.empty())
+    {
+        std::cerr << "Scene contains no triangles\n";
+        return false;
+    }
+
+    scene.materials = make_materials(material_type{}, mod.materials);
+
+    if (settings.huge_pages)
+    {
+        build_bvh(settings, scene, scene.huge_page_bvh);
+    }
+    else
+    {
+        build_bvh(settings, scene, scene.bvh);
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Camera path: orbit around the scene
+//
+
+static pinhole_camera make_camera(bench_settings const& settings, aabb const& bbox, unsigned view)
+{
+    pinhole_camera cam;
+
+    float aspect = settings.width / static_cast<float>(settings.height);
+    cam.set_viewport(0, 0, settings.width, settings.height);
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), aspect, 0.001f, 1000.0f);
+    cam.view_all(bbox);
+
+    vec3 center = bbox.center();
+    vec3 offset = cam.eye() - center;
+
+    float angle = 2.0f * constants::pi<float>() * view / std::max(settings.views, 1U);
+    vec3 eye(
+            offset.x * cos(angle) + offset.z * sin(angle),
+            offset.y,
+           -offset.x * sin(angle) + offset.z * cos(angle)
+            );
+
+    cam.look_at(center + eye, center, cam.up());
+
+    return cam;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Write the color buffer of the render target to an 8-bit RGB image
+//
+
+static void save_image(render_target_type const& rt, std::string const& filename)
+{
+    int w = rt.width();
+    int h = rt.height();
+
+    std::vector<uint8_t> rgb(w * h * 3);
+
+    for (int y = 0; y < h; ++y)
+    {
+        for (int x = 0; x < w; ++x)
+        {
+            // Render target origin is bottom left
+            vec4 c = clamp(rt.color()[(h - 1 - y) * w + x], vec4(0.0f), vec4(1.0f));
+
+            for (int i = 0; i < 3; ++i)
+            {
+                rgb[(y * w + x) * 3 + i] = static_cast<uint8_t>(c[i] * 255.0f + 0.5f);
+            }
+        }
+    }
+
+    image img(w, h, PF_RGB8, rgb.data());
+
+    image::save_options options;
+    options.emplace_back("binary", true);
+
+    if (!img.save(filename, options))
+    {
+        std::cerr << "Failed writing image: " << filename << '\n';
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Render all views of one configuration
+//
+
+// If vbuffer is not null, primary visibility is rasterized w/ the threads of
+// raster_pool each frame and shaded by the scheduler
+template <typename S, typename Sched>
+static void run(
+        Sched&                  sched,
+        bench_settings const&   settings,
+        bench_scene const&      scene,
+        algorithm               algo,
+        bench_result&           result,
+        thread_pool*            raster_pool = nullptr,
+        visibility_buffer*      vbuffer = nullptr
+        )
+{
+    auto diagonal = scene.mod.bbox.max - scene.mod.bbox.min;
+    auto bounces  = algo == Pathtracing ? 10U : 4U;
+    auto epsilon  = std::max( 1E-3f, length(diagonal) * 1E-5f );
+    auto ambient  = algo == Pathtracing ? vec4(1.0f) : vec4(0.0f);
+
+    render_target_type rt;
+    rt.resize(settings.width, settings.height);
+
+    rasterizer rast;
+
+    if (vbuffer != nullptr)
+    {
+        vbuffer->resize(settings.width, settings.height);
+    }
+
+    // Pinned threads render contiguous bands of tiles per node, place the
+    // framebuffer rows accordingly
+    if (settings.pinning != PinNone)
+    {
+        numa_distribute(
+                rt.color(),
+                settings.width * settings.height * sizeof(render_target_type::color_type),
+                settings.nodes
+                );
+    }
+
+    for (unsigned view = 0; view < settings.views; ++view)
+    {
+        auto cam = make_camera(settings, scene.mod.bbox, view);
+
+        aligned_vector<light_type> lights(1);
+        lights[0].set_cl( vec3(1.0f, 1.0f, 1.0f) );
+        lights[0].set_kl(1.0f);
+        lights[0].set_position( cam.eye() );
+
+        auto kparams = make_kernel_params(
+                normals_per_face_binding{},
+                scene.primitives.data(),
+                scene.primitives.data() + scene.primitives.size(),
+                scene.mod.geometric_normals.data(),
+                scene.materials.data(),
+                lights.data(),
+                lights.data() + lights.size(),
+                bounces,
+                epsilon,
+                vec4(0.0f, 0.0f, 0.0f, 1.0f),
+                ambient
+                );
+
+        // Path tracing accumulates frames, restart for each view
+        unsigned frame_num = 0;
+        rt.clear_color_buffer();
+
+        for (unsigned i = 0; i < settings.warmup + settings.frames; ++i)
+        {
+            timer t;
+
+            if (vbuffer != nullptr)
+            {
+                rast.rasterize<S>(
+                        *raster_pool,
+                        cam,
+                        scene.primitives.data(),
+                        scene.primitives.data() + scene.primitives.size(),
+                        *vbuffer
+                        );
+            }
+
+            call_kernel( algo, sched, kparams, frame_num, cam, rt );
+            double elapsed = t.elapsed();
+
+            if (i >= settings.warmup)
+            {
+                result.frame_times.push_back(elapsed);
+            }
+        }
+
+        if (!settings.images.empty())
+        {
+            save_image(
+                    rt,
+                    settings.images + result.algorithm + '-' + result.scheduler + '-'
+                        + result.packet + "-view" + std::to_string(view) + settings.image_ext
+                    );
+        }
+    }
+}
+
+template <typename S>
+static bool run(
+        bench_settings const&   settings,
+        bench_scene const&      scene,
+        algorithm               algo,
+        bench_result&           result
+        )
+{
+    using R = basic_ray<S>;
+
+    // The pathtracing kernel samples the pixels w/ jittered primary rays
+    bool raster = settings.raster && algo != Pathtracing;
+
+    visibility_buffer vbuffer;
+
+    if (result.scheduler == "simple")
+    {
+        simple_sched<R> sched;
+        run<S>(sched, settings, scene, algo, result);
+    }
+#if !defined(__MINGW32__) && !defined(__MINGW64__)
+    else if (result.scheduler == "tiled")
+    {
+        tiled_sched<R> sched(
+                settings.num_threads,
+                make_thread_affinity(settings.num_threads, settings.pinning, settings.nodes)
+                );
+        sched.set_coherent_tiles(settings.coherent_tiles);
+        sched.set_visibility_buffer(raster ? &vbuffer : nullptr);
+        run<S>(sched, settings, scene, algo, result, &sched.backend().pool(), raster ? &vbuffer : nullptr);
+    }
+#endif
+#if VSNRAY_HAVE_TBB
+    else if (result.scheduler == "tbb")
+    {
+        tbb_sched<R> sched(settings.num_threads);
+        sched.set_coherent_tiles(settings.coherent_tiles);
+        sched.set_visibility_buffer(raster ? &vbuffer : nullptr);
+
+        thread_pool pool(settings.num_threads);
+        run<S>(sched, settings, scene, algo, result, &pool, raster ? &vbuffer : nullptr);
+    }
+#endif
+    else
+    {
+        std::cerr << "Scheduler not available: " << result.scheduler << '\n';
+        return false;
+    }
+
+    return true;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Report
+//
+
+static void write_json(
+        std::ostream&                       out,
+        bench_settings const&               settings,
+        bench_scene const&                  scene,
+        std::vector<bench_result> const&    results
+        )
+{
+    auto const& mod = scene.mod;
+
+    uint64_t model_bytes = mod.primitives.size() * sizeof(model::triangle_type)
+                         + mod.geometric_normals.size() * sizeof(model::normal_type)
+                         + mod.shading_normals.size() * sizeof(model::normal_type)
+                         + mod.tex_coords.size() * sizeof(model::tex_coord_type);
+
+    uint64_t rt_bytes = static_cast<uint64_t>(settings.width) * settings.height
+                      * (sizeof(render_target_type::color_type));
+
+    out << std::setprecision(6);
+
+    out << "{\n";
+    out << "  \"version\": \""
+        << VSNRAY_VERSION_MAJOR << '.' << VSNRAY_VERSION_MINOR << '.' << VSNRAY_VERSION_PATCH << "\",\n";
+
+    out << "  \"host\": {\n";
+    out << "    \"threads\": " << settings.num_threads << ",\n";
+    out << "    \"hardware_concurrency\": " << std::thread::hardware_concurrency() << ",\n";
+    out << "    \"numa_nodes\": " << numa_topology().size() << ",\n";
+    out << "    \"cpu_simd_isa\": " << json_string(simd_isa_name(best_simd_isa())) << ",\n";
+    out << "    \"compiled_simd_isa\": " << json_string(compiled_simd_isa()) << '\n';
+    out << "  },\n";
+
+    out << "  \"settings\": {\n";
+    out << "    \"width\": " << settings.width << ",\n";
+    out << "    \"height\": " << settings.height << ",\n";
+    out << "    \"views\": " << settings.views << ",\n";
+    out << "    \"warmup_frames\": " << settings.warmup << ",\n";
+    out << "    \"frames_per_view\": " << settings.frames << ",\n";
+    out << "    \"coherent_tiles\": " << settings.coherent_tiles << ",\n";
+    out << "    \"raster\": " << (settings.raster ? "true" : "false") << ",\n";
+    out << "    \"pin\": " << json_string(settings.pin) << ",\n";
+    out << "    \"numa_nodes_used\": " << settings.nodes.size() << ",\n";
+    out << "    \"numa_data\": " << json_string(settings.numa_data) << ",\n";
+    out << "    \"huge_pages\": " << (settings.huge_pages ? "true" : "false") << '\n';
+    out << "  },\n";
+
+    out << "  \"scene\": {\n";
+    out << "    \"name\": " << json_string(scene.name) << ",\n";
+    out << "    \"triangles\": " << mod.primitives.size() << ",\n";
+    out << "    \"bvh\": " << json_string(settings.bvh) << ",\n";
+    out << "    \"bvh_build_s\": " << scene.bvh_build_time << ",\n";
+    out << "    \"bvh_treelet_passes\": " << settings.treelets << ",\n";
+    out << "    \"bvh_reordered\": " << (settings.reorder ? "true" : "false") << ",\n";
+    out << "    \"bvh_optimize_s\": " << scene.bvh_optimize_time << ",\n";
+    out << "    \"bvh_sah_cost_built\": " << scene.bvh_sah_cost_built << ",\n";
+    out << "    \"bvh_nodes\": " << scene.bvh_nodes << ",\n";
+    out << "    \"bvh_sah_cost\": " << scene.bvh_sah_cost << '\n';
+    out << "  },\n";
+
+    out << "  \"memory\": {\n";
+    out << "    \"model_bytes\": " << model_bytes << ",\n";
+    out << "    \"bvh_bytes\": " << scene.bvh_bytes << ",\n";
+    out << "    \"render_target_bytes\": " << rt_bytes << ",\n";
+    out << "    \"peak_rss_bytes\": " << peak_rss() << '\n';
+    out << "  },\n";
+
+    out << "  \"results\": [";
+
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        auto const& r = results[i];
+
+        auto times = r.frame_times;
+        std::sort(times.begin(), times.end());
+
+        double sum = 0.0;
+        for (double t : times)
+        {
+            sum += t;
+        }
+
+        double mean = times.empty() ? 0.0 : sum / times.size();
+        double rays = static_cast<double>(settings.width) * settings.height;
+        double all_rays = rays * settings.views * (settings.warmup + settings.frames);
+
+        out << (i == 0 ? "\n" : ",\n");
+        out << "    {\n";
+        out << "      \"algorithm\": " << json_string(r.algorithm) << ",\n";
+        out << "      \"scheduler\": " << json_string(r.scheduler) << ",\n";
+        out << "      \"packet\": " << json_string(r.packet) << ",\n";
+        out << "      \"frames\": " << times.size() << ",\n";
+        out << "      \"frame_ms\": {\n";
+        out << "        \"min\": " << (times.empty() ? 0.0 : times.front() * 1000.0) << ",\n";
+        out << "        \"mean\": " << mean * 1000.0 << ",\n";
+        out << "        \"p50\": " << percentile(times, 50.0) * 1000.0 << ",\n";
+        out << "        \"p90\": " << percentile(times, 90.0) * 1000.0 << ",\n";
+        out << "        \"p99\": " << percentile(times, 99.0) * 1000.0 << ",\n";
+        out << "        \"max\": " << (times.empty() ? 0.0 : times.back() * 1000.0) << '\n';
+        out << "      },\n";
+        out << "      \"primary_mrays_per_s\": " << (mean > 0.0 ? rays / mean / 1E6 : 0.0) << ",\n";
+
+        if (r.dtlb_load_misses >= 0)
+        {
+            out << "      \"dtlb_load_misses\": " << r.dtlb_load_misses << ",\n";
+            out << "      \"dtlb_load_misses_per_primary_ray\": " << r.dtlb_load_misses / all_rays << ",\n";
+        }
+        else
+        {
+            out << "      \"dtlb_load_misses\": null,\n";
+            out << "      \"dtlb_load_misses_per_primary_ray\": null,\n";
+        }
+
+        if (r.llc_load_misses >= 0)
+        {
+            out << "      \"llc_load_misses\": " << r.llc_load_misses << ",\n";
+            out << "      \"llc_load_misses_per_primary_ray\": " << r.llc_load_misses / all_rays << '\n';
+        }
+        else
+        {
+            out << "      \"llc_load_misses\": null,\n";
+            out << "      \"llc_load_misses_per_primary_ray\": null\n";
+        }
+
+        out << "    }";
+    }
+
+    out << "\n  ]\n";
+    out << "}\n";
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Main function, renders all configurations and writes a JSON report
+//
+
+int main(int argc, char** argv)
+{
+    using namespace support;
+
+    bench_settings settings;
+
+    cl::CmdLine cmd;
+
+    auto filename_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "filename",
+            cl::Desc("Input file in wavefront obj format (optional, default: procedural scene)"),
+            cl::Positional,
+            cl::Optional,
+            cl::init(settings.filename)
+            );
+
+    auto scene_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "scene",
+            cl::Desc("Procedural scene if no file is given: spheres|random"),
+            cl::ArgRequired,
+            cl::init(settings.scene)
+            );
+
+    auto triangles_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "triangles",
+            cl::Desc("Approximate number of triangles of the procedural scene"),
+            cl::ArgRequired,
+            cl::init(settings.triangles)
+            );
+
+    auto bvh_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "bvh",
+            cl::Desc("BVH construction: binned|split|lbvh"),
+            cl::ArgRequired,
+            cl::init(settings.bvh)
+            );
+
+    auto treelets_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "treelets",
+            cl::Desc("Treelet restructuring passes to improve the BVH after the build (default: 0)"),
+            cl::ArgRequired,
+            cl::init(settings.treelets)
+            );
+
+    auto reorder_opt = cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "reorder-nodes",
+            cl::Desc("Reorder the BVH nodes for cache locality after the build"),
+            cl::ArgDisallowed,
+            cl::init(settings.reorder)
+            );
+
+    auto width_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "width",
+            cl::Desc("Image width"),
+            cl::ArgRequired,
+            cl::init(settings.width)
+            );
+
+    auto height_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "height",
+            cl::Desc("Image height"),
+            cl::ArgRequired,
+            cl::init(settings.height)
+            );
+
+    auto views_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "views",
+            cl::Desc("Number of camera positions on an orbit around the scene"),
+            cl::ArgRequired,
+            cl::init(settings.views)
+            );
+
+    auto warmup_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "warmup",
+            cl::Desc("Untimed frames per view"),
+            cl::ArgRequired,
+            cl::init(settings.warmup)
+            );
+
+    auto frames_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "frames",
+            cl::Desc("Timed frames per view"),
+            cl::ArgRequired,
+            cl::init(settings.frames)
+            );
+
+    auto algorithms_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "algorithms",
+            cl::Desc("Comma separated list of: simple,whitted,pathtracing"),
+            cl::ArgRequired,
+            cl::init(settings.algorithms)
+            );
+
+    auto schedulers_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "schedulers",
+            cl::Desc("Comma separated list of: simple,tiled,tbb"),
+            cl::ArgRequired,
+            cl::init(settings.schedulers)
+            );
+
+    auto packets_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "packets",
+            cl::Desc("Comma separated list of: float,float4,float8,float16"),
+            cl::ArgRequired,
+            cl::init(settings.packets)
+            );
+
+    auto coherent_tiles_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "coherent-tiles",
+            cl::Desc("Trace primary rays of 8x8 or 16x16 pixel tiles coherently (simple and whitted, tiled and tbb scheduler, default: 0, off)"),
+            cl::ArgRequired,
+            cl::init(settings.coherent_tiles)
+            );
+
+    auto raster_opt = cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "raster",
+            cl::Desc("Resolve primary visibility w/ the CPU rasterizer (simple and whitted, tiled and tbb scheduler)"),
+            cl::ArgDisallowed,
+            cl::init(settings.raster)
+            );
+
+    auto threads_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "threads",
+            cl::Desc("Number of render threads (tiled and tbb scheduler, default: all CPUs of the used NUMA nodes)"),
+            cl::ArgRequired,
+            cl::init(settings.num_threads)
+            );
+
+    auto pin_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "pin",
+            cl::Desc("Pin render threads of the tiled scheduler: none, compact, scatter"),
+            cl::ArgRequired,
+            cl::init(settings.pin)
+            );
+
+    auto numa_nodes_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "numa-nodes",
+            cl::Desc("Number of NUMA nodes to render on when pinning threads (default: all)"),
+            cl::ArgRequired,
+            cl::init(settings.numa_nodes)
+            );
+
+    auto numa_data_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "numa-data",
+            cl::Desc("Placement of BVH and model data: default (first touch), interleave"),
+            cl::ArgRequired,
+            cl::init(settings.numa_data)
+            );
+
+    auto huge_pages_opt = cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "huge-pages",
+            cl::Desc("Store the BVH in huge pages (Linux only)"),
+            cl::ArgDisallowed,
+            cl::init(settings.huge_pages)
+            );
+
+    auto output_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "o",
+            cl::Desc("JSON output file (default: stdout)"),
+            cl::ArgRequired,
+            cl::init(settings.output)
+            );
+
+    auto images_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "images",
+            cl::Desc("If set, write the last frame of each view to <images><config>-view<n><ext>"),
+            cl::ArgRequired,
+            cl::init(settings.images)
+            );
+
+    auto image_ext_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "image-ext",
+            cl::Desc("Image file extension, determines the format (e.g. .ppm)"),
+            cl::ArgRequired,
+            cl::init(settings.image_ext)
+            );
+
+    cmd.add(*filename_opt);
+    cmd.add(*scene_opt);
+    cmd.add(*triangles_opt);
+    cmd.add(*bvh_opt);
+    cmd.add(*treelets_opt);
+    cmd.add(*reorder_opt);
+    cmd.add(*width_opt);
+    cmd.add(*height_opt);
+    cmd.add(*views_opt);
+    cmd.add(*warmup_opt);
+    cmd.add(*frames_opt);
+    cmd.add(*algorithms_opt);
+    cmd.add(*schedulers_opt);
+    cmd.add(*packets_opt);
+    cmd.add(*coherent_tiles_opt);
+    cmd.add(*raster_opt);
+    cmd.add(*threads_opt);
+    cmd.add(*pin_opt);
+    cmd.add(*numa_nodes_opt);
+    cmd.add(*numa_data_opt);
+    cmd.add(*huge_pages_opt);
+    cmd.add(*output_opt);
+    cmd.add(*images_opt);
+    cmd.add(*image_ext_opt);
+
+    try
+    {
+        auto args = std::vector<std::string>(argv + 1, argv + argc);
+        cl::expandWildcards(args);
+        cl::expandResponseFiles(args, cl::TokenizeUnix());
+
+        cmd.parse(args);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        std::cout << cmd.help(argv[0]) << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (settings.width <= 0 || settings.height <= 0)
+    {
+        std::cerr << "Invalid image size\n";
+        return EXIT_FAILURE;
+    }
+
+    if (settings.coherent_tiles != 0 && settings.coherent_tiles != 8 && settings.coherent_tiles != 16)
+    {
+        std::cerr << "Invalid coherent tile size: " << settings.coherent_tiles << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (settings.pin == "none")
+    {
+        settings.pinning = PinNone;
+    }
+    else if (settings.pin == "compact")
+    {
+        settings.pinning = PinCompact;
+    }
+    else if (settings.pin == "scatter")
+    {
+        settings.pinning = PinScatter;
+    }
+    else
+    {
+        std::cerr << "Unknown pinning: " << settings.pin << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (settings.bvh != "binned" && settings.bvh != "split" && settings.bvh != "lbvh")
+    {
+        std::cerr << "Unknown BVH construction: " << settings.bvh << '\n';
+        return EXIT_FAILURE;
+    }
+
+    if (settings.numa_data != "default" && settings.numa_data != "interleave")
+    {
+        std::cerr << "Unknown NUMA data placement: " << settings.numa_data << '\n';
+        return EXIT_FAILURE;
+    }
+
+    settings.nodes = numa_topology();
+
+    if (settings.numa_nodes > 0 && settings.numa_nodes < settings.nodes.size())
+    {
+        settings.nodes.resize(settings.numa_nodes);
+    }
+
+    if (settings.num_threads == 0)
+    {
+        if (settings.pinning != PinNone)
+        {
+            for (auto const& n : settings.nodes)
+            {
+                settings.num_threads += static_cast<unsigned>(n.cpus.size());
+            }
+        }
+        else
+        {
+            settings.num_threads = std::thread::hardware_concurrency();
+        }
+    }
+
+    settings.num_threads = std::max(settings.num_threads, 1U);
+
+
+    // Open before any render thread is created so that all threads are counted
+    cache_miss_counter dtlb(cache_miss_counter::DTLB);
+    cache_miss_counter llc(cache_miss_counter::LLC);
+
+    if (!dtlb.available())
+    {
+        std::cerr << "Warning: dTLB miss counter not available\n";
+    }
+
+    if (!llc.available())
+    {
+        std::cerr << "Warning: LLC miss counter not available\n";
+    }
+
+
+    // Scene
+
+    std::cerr << "Loading scene...\n";
+
+    bench_scene scene;
+
+    if (!load_scene(settings, scene))
+    {
+        return EXIT_FAILURE;
+    }
+
+    std::cerr << scene.mod.primitives.size() << " triangles, BVH built in "
+              << scene.bvh_build_time << " s\n";
+
+    if (settings.treelets > 0)
+    {
+        std::cerr << "BVH SAH cost " << scene.bvh_sah_cost_built << " -> " << scene.bvh_sah_cost
+                  << " after treelet restructuring (" << scene.bvh_optimize_time << " s)\n";
+    }
+
+    if (settings.numa_data == "interleave")
+    {
+        bool ok = settings.huge_pages
+                ? interleave_scene(settings, scene, scene.huge_page_bvh)
+                : interleave_scene(settings, scene, scene.bvh);
+
+        if (!ok)
+        {
+            std::cerr << "Warning: cannot interleave scene data across NUMA nodes\n";
+        }
+    }
+
+
+    // Configurations
+
+    std::vector<bench_result> results;
+
+    for (auto const& algo_name : split(settings.algorithms))
+    {
+        algorithm algo = Simple;
+
+        if (algo_name == "simple")
+        {
+            algo = Simple;
+        }
+        else if (algo_name == "whitted")
+        {
+            algo = Whitted;
+        }
+        else if (algo_name == "pathtracing")
+        {
+            algo = Pathtracing;
+        }
+        else
+        {
+            std::cerr << "Unknown algorithm: " << algo_name << '\n';
+            return EXIT_FAILURE;
+        }
+
+        for (auto const& sched_name : split(settings.schedulers))
+        {
+            for (auto const& packet_name : split(settings.packets))
+            {
+                bench_result result;
+                result.algorithm = algo_name;
+                result.scheduler = sched_name;
+                result.packet    = packet_name;
+
+                std::cerr << "Rendering " << algo_name << ", " << sched_name << " scheduler, "
+                          << packet_name << " packets...\n";
+
+                bool ok = false;
+
+                // Render threads exit at the end of run(), their counts are included
+                int64_t misses_before = dtlb.read();
+                int64_t llc_misses_before = llc.read();
+
+                if (packet_name == "float")
+                {
+                    ok = run<float>(settings, scene, algo, result);
+                }
+                else if (packet_name == "float4")
+                {
+                    ok = run<simd::float4>(settings, scene, algo, result);
+                }
+                else if (packet_name == "float8")
+                {
+                    ok = run<simd::float8>(settings, scene, algo, result);
+                }
+                else if (packet_name == "float16")
+                {
+                    ok = run<simd::float16>(settings, scene, algo, result);
+                }
+                else
+                {
+                    std::cerr << "Unknown packet type: " << packet_name << '\n';
+                }
+
+                if (!ok)
+                {
+                    return EXIT_FAILURE;
+                }
+
+                int64_t misses_after = dtlb.read();
+                int64_t llc_misses_after = llc.read();
+
+                if (misses_before >= 0 && misses_after >= 0)
+                {
+                    result.dtlb_load_misses = misses_after - misses_before;
+                }
+
+                if (llc_misses_before >= 0 && llc_misses_after >= 0)
+                {
+                    result.llc_load_misses = llc_misses_after - llc_misses_before;
+                }
+
+                results.push_back(result);
+            }
+        }
+    }
+
+
+    // Report
+
+    if (settings.output.empty())
+    {
+        write_json(std::cout, settings, scene, results);
+    }
+    else
+    {
+        std::ofstream file(settings.output);
+
+        if (!file.good())
+        {
+            std::cerr << "Cannot open output file: " << settings.output << '\n';
+            return EXIT_FAILURE;
+        }
+
+        write_json(file, settings, scene, results);
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -27,6 +27,7 @@ using boost::asio::ip::tcp;
 connection::connection(connection_manager& manager)
     : manager_(manager)
     , socket_(manager.io_service_)
+    , next_id_(1)
 {
 #ifndef NDEBUG
     std::cout << "connection::connection [" << (void*)this << "]\n";
@@ -13,7 +13,10 @@
 #endif
 #endif
 
+#include <cstdint>
+#include <deque>
 #include <memory>
+#include <vector>
 
 #include <boost/asio/io_service.hpp>
 #include <boost/asio/ip/tcp.hpp>
@@ -98,6 +101,19 @@ private:
     signal_type signal_;
     // Slot
     boost::signals2::connection slot_;
+    // Messages waiting to be written.
+    // Only accessed from within the manager's strand.
+    std::deque<message_pointer> write_queue_;
+    // Messages currently being written in a single gather operation.
+    // Only accessed from within the manager's strand.
+    std::vector<message_pointer> write_batch_;
+    // The headers sent for the messages of the current batch. Messages may
+    // be written to several connections, so IDs are assigned to these copies.
+    // Only accessed from within the manager's strand.
+    std::vector<message::header> write_headers_;
+    // Next sequence number (used with connection_manager::Sequential IDs).
+    // Only accessed from within the manager's strand.
+    uint64_t next_id_;
 };
 
 } // async
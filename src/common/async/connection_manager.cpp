@@ -45,7 +45,8 @@ connection_manager::connection_manager()
     , strand_(io_service_)
     , work_(std::make_shared<boost::asio::io_service::work>(std::ref(io_service_)))
     , connections_()
-    , write_queue_()
+    , pool_(make_message_pool())
+    , id_scheme_(RandomUUID)
 {
 }
 
@@ -55,7 +56,8 @@ connection_manager::connection_manager(unsigned short port)
     , strand_(io_service_)
     , work_(std::make_shared<boost::asio::io_service::work>(std::ref(io_service_)))
     , connections_()
-    , write_queue_()
+    , pool_(make_message_pool())
+    , id_scheme_(RandomUUID)
 {
 }
 
@@ -87,6 +89,10 @@ void connection_manager::run()
 #else
     io_service_.run();
 #endif
+
+    // Allow to run again. Not in stop(): that would clear the stop request
+    // before run() has seen it, run() then never returns
+    io_service_.reset();
 }
 
 void connection_manager::run_in_thread()
@@ -104,7 +110,6 @@ void connection_manager::stop()
     work_.reset();
 
     io_service_.stop();
-    io_service_.reset();
 }
 
 void connection_manager::accept(handler h)
@@ -185,7 +190,10 @@ void connection_manager::close(connection_pointer conn)
 
 void connection_manager::close_all()
 {
-    std::for_each(connections_.begin(), connections_.end(), [&](connection_pointer conn) { close(conn); });
+    // close() erases from the list, iterate over a copy
+    connections conns = connections_;
+
+    std::for_each(conns.begin(), conns.end(), [&](connection_pointer conn) { close(conn); });
 
     connections_.clear();
 }
@@ -214,6 +222,21 @@ connection_pointer connection_manager::find(std::string const& host, unsigned sh
     return connection_pointer();
 }
 
+void connection_manager::set_id_scheme(id_scheme scheme)
+{
+    id_scheme_ = scheme;
+}
+
+connection_manager::id_scheme connection_manager::get_id_scheme() const
+{
+    return id_scheme_;
+}
+
+message_pool_pointer connection_manager::pool() const
+{
+    return pool_;
+}
+
 //--------------------------------------------------------------------------------------------------
 // Implementation
 //--------------------------------------------------------------------------------------------------
@@ -288,7 +311,8 @@ void connection_manager::handle_connect(boost::system::error_code const& e, conn
 
 void connection_manager::do_read(connection_pointer conn)
 {
-    message_pointer message = make_message();
+    // Reuse a message (and the capacity of its data buffer) from the pool
+    message_pointer message = pool_->acquire();
 
     // Issue a read operation to read exactly the number of bytes in a header.
     boost::asio::async_read(
@@ -307,7 +331,8 @@ void connection_manager::handle_read_header(boost::system::error_code const& e,
         // Need to deserialize the message-header!
         //
 
-        // Allocate memory for the message data
+        // Allocate memory for the message data.
+        // Does not allocate if a recycled buffer is large enough.
         message->data_.resize(message->header_.size_);
 
         assert( message->header_.size_ != 0 );
@@ -362,56 +387,90 @@ void connection_manager::write(message_pointer msg, connection_pointer conn)
 
 void connection_manager::do_write(message_pointer msg, connection_pointer conn)
 {
-    write_queue_.push_back(std::make_pair(conn, msg));
+    conn->write_queue_.push_back(msg);
 
-    if (write_queue_.size() == 1)
+    // Only start a new write operation if there is none in flight
+    // for this connection. Other connections are not affected.
+    if (conn->write_batch_.empty())
     {
-        do_write_0();
+        do_write_0(conn);
     }
 }
 
-void connection_manager::do_write_0()
+void connection_manager::do_write_0(connection_pointer conn)
 {
-    // Get the next message from the queue
-    std::pair<connection_pointer, message_pointer> msg = write_queue_.front();
+    assert( conn->write_batch_.empty() );
+    assert( !conn->write_queue_.empty() );
+
+    // Move as many pending messages as possible into the next batch
+    while (!conn->write_queue_.empty() && conn->write_batch_.size() < max_write_batch_size)
+    {
+        conn->write_batch_.push_back(conn->write_queue_.front());
+        conn->write_queue_.pop_front();
+    }
+
+    // Send copies of the headers, assign IDs to them if the messages have none
+    conn->write_headers_.clear();
+
+    for (auto const& msg : conn->write_batch_)
+    {
+        message::header h = msg->header_;
+
+        if (h.id_.is_nil())
+        {
+            h.id_ = id_scheme_ == Sequential
+                  ? message::make_sequential_id(conn->next_id_++)
+                  : message::generate_id();
+        }
+
+        conn->write_headers_.push_back(h);
+    }
 
     //
     // TODO:
     // Need to serialize the message-header!
     //
 
-    assert( msg.second->header_.size_ != 0 );
-    assert( msg.second->header_.size_ == msg.second->data_.size() );
-
-    // Send the header and the data in a single write operation.
+    // Send the headers and the data of all messages in a single write operation.
     std::vector<boost::asio::const_buffer> buffers;
+    buffers.reserve(conn->write_batch_.size() * 2);
+
+    for (size_t i = 0; i < conn->write_batch_.size(); ++i)
+    {
+        // External buffers are read-only
+        message const& m = *conn->write_batch_[i];
+
+        assert( m.size() != 0 );
 
-    buffers.push_back(boost::asio::const_buffer(&msg.second->header_, sizeof(msg.second->header_)));
-    buffers.push_back(boost::asio::const_buffer(&msg.second->data_[0], msg.second->data_.size()));
+        buffers.push_back(boost::asio::const_buffer(&conn->write_headers_[i], sizeof(message::header)));
+        buffers.push_back(boost::asio::const_buffer(m.data(), m.size()));
+    }
 
     // Start the write operation.
     boost::asio::async_write(
-            msg.first->socket_,
+            conn->socket_,
             buffers,
-            boost::bind(&connection_manager::handle_write, this, boost::asio::placeholders::error, msg.second, msg.first)
+            strand_.wrap(boost::bind(&connection_manager::handle_write, this, boost::asio::placeholders::error, conn))
             );
 }
 
-void connection_manager::handle_write(boost::system::error_code const& e, message_pointer message, connection_pointer conn)
+void connection_manager::handle_write(boost::system::error_code const& e, connection_pointer conn)
 {
-    // Call the connection's slot
-    conn->signal_(connection::Write, message, e);
+    // Call the connection's slot for every message in the batch
+    for (auto const& msg : conn->write_batch_)
+    {
+        conn->signal_(connection::Write, msg, e);
+    }
 
-    // Remove the message from the queue
-    write_queue_.pop_front();
+    conn->write_batch_.clear();
 
     if (!e)
     {
-        // Message successfully sent.
-        // Send the next one -- if any.
-        if (!write_queue_.empty())
+        // Messages successfully sent.
+        // Send the next ones -- if any.
+        if (!conn->write_queue_.empty())
         {
-            do_write_0();
+            do_write_0(conn);
         }
     }
     else
@@ -420,6 +479,14 @@ void connection_manager::handle_write(boost::system::error_code const& e, messag
         printf("connection_manager::handle_write: %s", e.message().c_str());
 #endif
 
+        // The pending messages are dropped, report the error for each of them
+        for (auto const& msg : conn->write_queue_)
+        {
+            conn->signal_(connection::Write, msg, e);
+        }
+
+        conn->write_queue_.clear();
+
         remove_connection(conn);
     }
 }
@@ -6,13 +6,14 @@
 #ifndef VSNRAY_COMMON_ASYNC_CONNECTION_MANAGER_H
 #define VSNRAY_COMMON_ASYNC_CONNECTION_MANAGER_H 1
 
-#include <deque>
+#include <atomic>
 #include <set>
 #include <vector>
 
 #include <boost/thread.hpp>
 
 #include "connection.h"
+#include "message_pool.h"
 
 
 namespace visionaray
@@ -37,6 +38,13 @@ class connection_manager : public std::enable_shared_from_this<connection_manage
 public:
     using handler = std::function<bool(connection_pointer conn, boost::system::error_code const& e)>;
 
+    // How IDs are assigned to outgoing messages
+    enum id_scheme
+    {
+        RandomUUID, // Globally unique, but expensive to generate
+        Sequential  // Monotonic counter, only unique per connection
+    };
+
 public:
     connection_manager();
     explicit connection_manager(unsigned short port);
@@ -52,7 +60,8 @@ public:
     // Wait for the thread to finish
     void wait();
 
-    // Stops the message loop
+    // Stops the message loop. Call run() or run_in_thread() to restart it,
+    // pending operations of open connections continue then
     void stop();
 
     // Starts a new accept operation.
@@ -77,6 +86,18 @@ public:
     // Search for an existing connection
     connection_pointer find(std::string const& host, unsigned short port);
 
+    // Set how IDs are assigned to outgoing messages.
+    // Should be called before any message is written.
+    // Thread-safe.
+    void set_id_scheme(id_scheme scheme);
+
+    // Returns how IDs are assigned to outgoing messages
+    id_scheme get_id_scheme() const;
+
+    // Returns the pool incoming messages are allocated from.
+    // May also be used to allocate outgoing messages.
+    message_pool_pointer pool() const;
+
 private:
     // Start an accept operation
     void do_accept(handler h);
@@ -105,11 +126,11 @@ private:
     // Starts a new write operation.
     void do_write(message_pointer msg, connection_pointer conn);
 
-    // Write the next message
-    void do_write_0();
+    // Write the next batch of messages queued for the given connection
+    void do_write_0(connection_pointer conn);
 
-    // Called when a complete message is written.
-    void handle_write(boost::system::error_code const& e, message_pointer message, connection_pointer conn);
+    // Called when a complete batch of messages is written.
+    void handle_write(boost::system::error_code const& e, connection_pointer conn);
 
     // Add a new connection
     void add_connection(connection_pointer conn);
@@ -119,7 +140,9 @@ private:
 
 private:
     using connections = std::set<connection_pointer>;
-    using messages = std::deque<std::pair<connection_pointer, message_pointer> >;
+
+    // Max. number of messages sent with a single gather write
+    static const size_t max_write_batch_size = 32;
 
     // The IO service
     boost::asio::io_service io_service_;
@@ -131,8 +154,10 @@ private:
     std::shared_ptr<boost::asio::io_service::work> work_;
     // The list of active connections
     connections connections_;
-    // List of messages to be written
-    messages write_queue_;
+    // Recycles incoming messages
+    message_pool_pointer pool_;
+    // How IDs are assigned to outgoing messages
+    std::atomic<id_scheme> id_scheme_;
     // A thread to process the message queue
     boost::thread runner_;
 };
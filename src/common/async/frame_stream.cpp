@@ -0,0 +1,624 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+
+#include <visionaray/detail/thread_pool.h>
+
+#include "frame_stream.h"
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//--------------------------------------------------------------------------------------------------
+// Wire format
+//
+// frame_header
+// { tile_header, tile data } x num_tiles
+//
+// Key frames contain all tiles, delta frames only those that changed since
+// the previous frame. Delta frames apply to the last key frame's layout.
+//
+
+namespace
+{
+
+struct frame_header
+{
+    uint32_t frame_id;
+    uint32_t width;
+    uint32_t height;
+    uint32_t bytes_per_pixel;
+    uint32_t tile_size;
+    uint32_t num_tiles;
+    uint32_t flags;
+};
+
+enum frame_flags
+{
+    KeyFrame = 0x1  // Contains all tiles, decodable w/o previous frames
+};
+
+enum tile_codec
+{
+    Raw,        // Uncompressed pixels
+    DeltaRLE    // Byte planes, delta encoded, run-length encoded
+};
+
+struct tile_header
+{
+    uint32_t index;
+    uint32_t codec;
+    uint32_t size;
+};
+
+// Limits for incoming headers
+const uint32_t MaxFrameSize     = 16384;
+const uint32_t MaxBytesPerPixel = 64;
+const uint64_t MaxFrameBytes    = uint64_t(1) << 30;
+
+
+//--------------------------------------------------------------------------------------------------
+// Tile layout
+//
+
+struct tile_rect
+{
+    int x0;
+    int y0;
+    int w;
+    int h;
+};
+
+tile_rect get_tile_rect(int index, int width, int height, int tile_size)
+{
+    int num_tiles_x = (width + tile_size - 1) / tile_size;
+
+    tile_rect r;
+    r.x0 = (index % num_tiles_x) * tile_size;
+    r.y0 = (index / num_tiles_x) * tile_size;
+    r.w  = std::min(tile_size, width - r.x0);
+    r.h  = std::min(tile_size, height - r.y0);
+    return r;
+}
+
+int get_num_tiles(int width, int height, int tile_size)
+{
+    return ((width + tile_size - 1) / tile_size) * ((height + tile_size - 1) / tile_size);
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Run-length encoding
+//
+// Control byte c < 128: c + 1 literal bytes follow
+// Control byte c >= 128: the next byte is repeated c - 125 times
+//
+
+void rle_encode(uint8_t const* in, size_t len, std::vector<uint8_t>& out)
+{
+    size_t i = 0;
+
+    while (i < len)
+    {
+        // Length of the run starting at i
+        size_t run = 1;
+        while (i + run < len && run < 130 && in[i + run] == in[i])
+        {
+            ++run;
+        }
+
+        if (run >= 3)
+        {
+            out.push_back(static_cast<uint8_t>(run + 125));
+            out.push_back(in[i]);
+            i += run;
+            continue;
+        }
+
+        // Literals up to the next run of three equal bytes
+        size_t first = i;
+        while (i < len && i - first < 128)
+        {
+            if (i + 2 < len && in[i] == in[i + 1] && in[i] == in[i + 2])
+            {
+                break;
+            }
+
+            ++i;
+        }
+
+        out.push_back(static_cast<uint8_t>(i - first - 1));
+        out.insert(out.end(), in + first, in + i);
+    }
+}
+
+bool rle_decode(uint8_t const* in, size_t len, uint8_t* out, size_t out_len)
+{
+    size_t i = 0;
+    size_t o = 0;
+
+    while (i < len)
+    {
+        uint8_t c = in[i++];
+
+        if (c < 128)
+        {
+            size_t n = size_t(c) + 1;
+
+            if (i + n > len || o + n > out_len)
+            {
+                return false;
+            }
+
+            std::memcpy(out + o, in + i, n);
+            i += n;
+            o += n;
+        }
+        else
+        {
+            size_t n = size_t(c) - 125;
+
+            if (i >= len || o + n > out_len)
+            {
+                return false;
+            }
+
+            std::memset(out + o, in[i++], n);
+            o += n;
+        }
+    }
+
+    return o == out_len;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Tile codecs
+//
+
+// Returns true if the tile differs from the previous frame, updates prev
+bool tile_changed(uint8_t const* frame, uint8_t* prev, int width, int bpp, tile_rect r)
+{
+    bool changed = false;
+    size_t row_size = size_t(r.w) * bpp;
+
+    for (int y = r.y0; y < r.y0 + r.h; ++y)
+    {
+        size_t offset = (size_t(y) * width + r.x0) * bpp;
+
+        if (std::memcmp(frame + offset, prev + offset, row_size) != 0)
+        {
+            std::memcpy(prev + offset, frame + offset, row_size);
+            changed = true;
+        }
+    }
+
+    return changed;
+}
+
+void encode_tile(
+        uint8_t const*          frame,
+        int                     width,
+        int                     bpp,
+        int                     index,
+        tile_rect               r,
+        std::vector<uint8_t>&   out
+        )
+{
+    size_t num_pixels = size_t(r.w) * r.h;
+    size_t raw_size = num_pixels * bpp;
+
+    // Split into byte planes and delta encode within each plane.
+    // Neighboring pixels mostly differ in the low-order bytes only,
+    // so the high-order planes become long runs of zeros.
+    std::vector<uint8_t> planes(raw_size);
+
+    for (int b = 0; b < bpp; ++b)
+    {
+        uint8_t* plane = planes.data() + b * num_pixels;
+        uint8_t last = 0;
+
+        for (int y = 0; y < r.h; ++y)
+        {
+            uint8_t const* row = frame + (size_t(r.y0 + y) * width + r.x0) * bpp + b;
+
+            for (int x = 0; x < r.w; ++x)
+            {
+                uint8_t value = row[x * bpp];
+                *plane++ = static_cast<uint8_t>(value - last);
+                last = value;
+            }
+        }
+    }
+
+    out.clear();
+    out.resize(sizeof(tile_header));
+
+    rle_encode(planes.data(), raw_size, out);
+
+    tile_header th;
+    th.index = static_cast<uint32_t>(index);
+    th.codec = DeltaRLE;
+    th.size = static_cast<uint32_t>(out.size() - sizeof(tile_header));
+
+    // Fall back to raw pixels if compression doesn't pay off
+    if (th.size >= raw_size)
+    {
+        out.resize(sizeof(tile_header) + raw_size);
+
+        uint8_t* dst = out.data() + sizeof(tile_header);
+
+        for (int y = 0; y < r.h; ++y)
+        {
+            std::memcpy(
+                    dst + size_t(y) * r.w * bpp,
+                    frame + (size_t(r.y0 + y) * width + r.x0) * bpp,
+                    size_t(r.w) * bpp
+                    );
+        }
+
+        th.codec = Raw;
+        th.size = static_cast<uint32_t>(raw_size);
+    }
+
+    std::memcpy(out.data(), &th, sizeof(th));
+}
+
+bool decode_tile(
+        uint8_t const*  in,
+        tile_header     th,
+        uint8_t*        frame,
+        int             width,
+        int             bpp,
+        tile_rect       r
+        )
+{
+    size_t num_pixels = size_t(r.w) * r.h;
+    size_t raw_size = num_pixels * bpp;
+
+    if (th.codec == Raw)
+    {
+        if (th.size != raw_size)
+        {
+            return false;
+        }
+
+        for (int y = 0; y < r.h; ++y)
+        {
+            std::memcpy(
+                    frame + (size_t(r.y0 + y) * width + r.x0) * bpp,
+                    in + size_t(y) * r.w * bpp,
+                    size_t(r.w) * bpp
+                    );
+        }
+
+        return true;
+    }
+
+    if (th.codec != DeltaRLE)
+    {
+        return false;
+    }
+
+    std::vector<uint8_t> planes(raw_size);
+
+    if (!rle_decode(in, th.size, planes.data(), raw_size))
+    {
+        return false;
+    }
+
+    for (int b = 0; b < bpp; ++b)
+    {
+        uint8_t const* plane = planes.data() + b * num_pixels;
+        uint8_t last = 0;
+
+        for (int y = 0; y < r.h; ++y)
+        {
+            uint8_t* row = frame + (size_t(r.y0 + y) * width + r.x0) * bpp + b;
+
+            for (int x = 0; x < r.w; ++x)
+            {
+                last = static_cast<uint8_t>(last + *plane++);
+                row[x * bpp] = last;
+            }
+        }
+    }
+
+    return true;
+}
+
+template <typename Func>
+void run(thread_pool* pool, int n, Func func)
+{
+    if (pool != nullptr)
+    {
+        pool->run([&](long i) { func(static_cast<int>(i)); }, n);
+    }
+    else
+    {
+        for (int i = 0; i < n; ++i)
+        {
+            func(i);
+        }
+    }
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// frame_encoder
+//
+
+frame_encoder::frame_encoder(int tile_size, message_pool_pointer pool)
+    : tile_size_(tile_size)
+    , pool_(pool)
+    , prev_()
+    , width_(0)
+    , height_(0)
+    , bytes_per_pixel_(0)
+    , frame_id_(0)
+    , key_frame_requested_(true)
+    , tiles_()
+    , num_tiles_sent_(0)
+{
+    assert( tile_size_ > 0 );
+}
+
+message_pointer frame_encoder::encode(
+        unsigned        type,
+        void const*     pixels,
+        int             width,
+        int             height,
+        int             bytes_per_pixel,
+        thread_pool*    pool
+        )
+{
+    auto frame = static_cast<uint8_t const*>(pixels);
+
+    bool key_frame = key_frame_requested_
+        || width != width_ || height != height_ || bytes_per_pixel != bytes_per_pixel_;
+
+    if (key_frame)
+    {
+        key_frame_requested_ = false;
+
+        width_ = width;
+        height_ = height;
+        bytes_per_pixel_ = bytes_per_pixel;
+
+        prev_.assign(frame, frame + size_t(width) * height * bytes_per_pixel);
+    }
+
+    int num_tiles = get_num_tiles(width, height, tile_size_);
+    tiles_.resize(num_tiles);
+
+    // Detect changed tiles and encode them
+    run(pool, num_tiles, [&](int i)
+    {
+        tile_rect r = get_tile_rect(i, width, height, tile_size_);
+
+        if (key_frame || tile_changed(frame, prev_.data(), width, bytes_per_pixel, r))
+        {
+            encode_tile(frame, width, bytes_per_pixel, i, r, tiles_[i]);
+        }
+        else
+        {
+            tiles_[i].clear();
+        }
+    });
+
+    // Assemble the message
+    size_t size = sizeof(frame_header);
+    num_tiles_sent_ = 0;
+
+    for (auto const& t : tiles_)
+    {
+        size += t.size();
+        num_tiles_sent_ += t.empty() ? 0 : 1;
+    }
+
+    frame_header fh;
+    fh.frame_id = frame_id_++;
+    fh.width = static_cast<uint32_t>(width);
+    fh.height = static_cast<uint32_t>(height);
+    fh.bytes_per_pixel = static_cast<uint32_t>(bytes_per_pixel);
+    fh.tile_size = static_cast<uint32_t>(tile_size_);
+    fh.num_tiles = static_cast<uint32_t>(num_tiles_sent_);
+    fh.flags = key_frame ? KeyFrame : 0;
+
+    message_pointer msg = pool_->acquire(type, size);
+
+    char* dst = msg->data();
+    std::memcpy(dst, &fh, sizeof(fh));
+    dst += sizeof(fh);
+
+    for (auto const& t : tiles_)
+    {
+        if (!t.empty())
+        {
+            std::memcpy(dst, t.data(), t.size());
+            dst += t.size();
+        }
+    }
+
+    return msg;
+}
+
+void frame_encoder::reset()
+{
+    width_ = 0;
+    height_ = 0;
+    bytes_per_pixel_ = 0;
+
+    prev_.clear();
+
+    key_frame_requested_ = true;
+}
+
+void frame_encoder::request_key_frame()
+{
+    key_frame_requested_ = true;
+}
+
+size_t frame_encoder::num_tiles_sent() const
+{
+    return num_tiles_sent_;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// frame_decoder
+//
+
+bool frame_decoder::decode(message const& msg, thread_pool* pool)
+{
+    auto first = reinterpret_cast<uint8_t const*>(msg.data());
+    auto last = first + msg.size();
+
+    // A lost frame leaves stale tiles, wait for the next key frame after errors
+    bool had_key_frame = has_key_frame_;
+    has_key_frame_ = false;
+
+    if (msg.size() < sizeof(frame_header))
+    {
+        return false;
+    }
+
+    frame_header fh;
+    std::memcpy(&fh, first, sizeof(fh));
+
+    // Don't trust the header, check it before allocating anything
+    if (fh.width > MaxFrameSize || fh.height > MaxFrameSize
+     || fh.bytes_per_pixel == 0 || fh.bytes_per_pixel > MaxBytesPerPixel
+     || uint64_t(fh.width) * fh.height * fh.bytes_per_pixel > MaxFrameBytes
+     || fh.tile_size == 0 || fh.tile_size > MaxFrameSize
+     || (fh.flags & ~uint32_t(KeyFrame)) != 0)
+    {
+        return false;
+    }
+
+    bool key_frame = (fh.flags & KeyFrame) != 0;
+
+    int width = static_cast<int>(fh.width);
+    int height = static_cast<int>(fh.height);
+    int bpp = static_cast<int>(fh.bytes_per_pixel);
+    int tile_size = static_cast<int>(fh.tile_size);
+
+    int num_tiles = get_num_tiles(width, height, tile_size);
+
+    // Each tile is sent at most once and needs at least a tile header
+    size_t payload_size = msg.size() - sizeof(frame_header);
+
+    if (fh.num_tiles > uint32_t(num_tiles) || fh.num_tiles > payload_size / sizeof(tile_header))
+    {
+        return false;
+    }
+
+    if (key_frame && fh.num_tiles != uint32_t(num_tiles))
+    {
+        return false;
+    }
+
+    // Deltas only apply on top of a key frame w/ the same layout
+    if (!key_frame && (!had_key_frame || width != width_ || height != height_ || bpp != bytes_per_pixel_))
+    {
+        return false;
+    }
+
+    // Locate the tiles
+    std::vector<std::pair<tile_header, uint8_t const*>> tiles(fh.num_tiles);
+    std::vector<char> seen(num_tiles, 0);
+
+    uint8_t const* ptr = first + sizeof(frame_header);
+
+    for (auto& t : tiles)
+    {
+        if (last - ptr < static_cast<ptrdiff_t>(sizeof(tile_header)))
+        {
+            return false;
+        }
+
+        std::memcpy(&t.first, ptr, sizeof(tile_header));
+        ptr += sizeof(tile_header);
+
+        if (last - ptr < static_cast<ptrdiff_t>(t.first.size) || t.first.index >= uint32_t(num_tiles))
+        {
+            return false;
+        }
+
+        // Duplicates would be decoded concurrently into the same pixels
+        if (seen[t.first.index])
+        {
+            return false;
+        }
+
+        seen[t.first.index] = 1;
+
+        t.second = ptr;
+        ptr += t.first.size;
+    }
+
+    if (width != width_ || height != height_ || bpp != bytes_per_pixel_)
+    {
+        width_ = width;
+        height_ = height;
+        bytes_per_pixel_ = bpp;
+        frame_.assign(size_t(width) * height * bpp, 0);
+    }
+
+    // Decode them
+    std::vector<char> ok(tiles.size(), 1);
+
+    run(pool, static_cast<int>(tiles.size()), [&](int i)
+    {
+        tile_header th = tiles[i].first;
+        tile_rect r = get_tile_rect(static_cast<int>(th.index), width, height, tile_size);
+        ok[i] = decode_tile(tiles[i].second, th, frame_.data(), width, bpp, r);
+    });
+
+    frame_id_ = fh.frame_id;
+
+    if (!std::all_of(ok.begin(), ok.end(), [](char b) { return b != 0; }))
+    {
+        return false;
+    }
+
+    has_key_frame_ = true;
+
+    return true;
+}
+
+bool frame_decoder::needs_key_frame() const
+{
+    return !has_key_frame_;
+}
+
+uint8_t const* frame_decoder::data() const
+{
+    return frame_.data();
+}
+
+int frame_decoder::width() const
+{
+    return width_;
+}
+
+int frame_decoder::height() const
+{
+    return height_;
+}
+
+int frame_decoder::bytes_per_pixel() const
+{
+    return bytes_per_pixel_;
+}
+
+uint32_t frame_decoder::frame_id() const
+{
+    return frame_id_;
+}
@@ -0,0 +1,150 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_ASYNC_FRAME_STREAM_H
+#define VSNRAY_COMMON_ASYNC_FRAME_STREAM_H 1
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <visionaray/cpu_buffer_rt.h>
+
+#include "message.h"
+#include "message_pool.h"
+
+namespace visionaray
+{
+
+class thread_pool;
+
+namespace async
+{
+
+//--------------------------------------------------------------------------------------------------
+// frame_encoder
+//
+// Splits frames into tiles and encodes only those tiles that changed since
+// the last frame. Changed tiles are compressed with a lossless byte-plane
+// delta + run-length scheme. The result is a single message that can be sent
+// over an async::connection and reassembled with a frame_decoder.
+//
+// The first frame, frames after reset() or request_key_frame() and frames
+// w/ a new size or pixel format are key frames that contain all tiles.
+//
+
+class frame_encoder
+{
+public:
+    // Constructor.
+    // tile_size: tile width and height in pixels
+    explicit frame_encoder(int tile_size = 64, message_pool_pointer pool = make_message_pool());
+
+    // Encodes a frame with tightly packed pixels.
+    // If pool is not null, tiles are encoded in parallel.
+    message_pointer encode(
+            unsigned        type,
+            void const*     pixels,
+            int             width,
+            int             height,
+            int             bytes_per_pixel,
+            thread_pool*    pool = nullptr
+            );
+
+    // Encodes the color buffer of a render target
+    template <pixel_format CF, pixel_format DF>
+    message_pointer encode(unsigned type, cpu_buffer_rt<CF, DF> const& rt, thread_pool* pool = nullptr)
+    {
+        using color_type = typename cpu_buffer_rt<CF, DF>::color_type;
+
+        return encode(
+                type,
+                rt.color(),
+                rt.width(),
+                rt.height(),
+                static_cast<int>(sizeof(color_type)),
+                pool
+                );
+    }
+
+    // Drops the last frame, the next frame is a key frame
+    void reset();
+
+    // Sends the next frame as a key frame, e.g. when a decoder lost frames
+    // (see frame_decoder::needs_key_frame())
+    void request_key_frame();
+
+    // Returns the number of tiles sent with the last frame
+    size_t num_tiles_sent() const;
+
+private:
+    // Tile size in pixels
+    int tile_size_;
+    // Pool to allocate messages from
+    message_pool_pointer pool_;
+    // The last frame, to detect changes
+    std::vector<uint8_t> prev_;
+    // Layout of the last frame
+    int width_;
+    int height_;
+    int bytes_per_pixel_;
+    // Counts encoded frames
+    uint32_t frame_id_;
+    // Send the next frame as a key frame
+    bool key_frame_requested_;
+    // Encoded tiles, empty if unchanged
+    std::vector<std::vector<uint8_t>> tiles_;
+    // Number of tiles sent with the last frame
+    size_t num_tiles_sent_;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// frame_decoder
+//
+// Reassembles frames encoded with a frame_encoder. Delta frames are only
+// decoded on top of a key frame.
+//
+
+class frame_decoder
+{
+public:
+    // Applies the changed tiles from the given message to the current frame.
+    // If pool is not null, tiles are decoded in parallel.
+    // Returns false if the message is malformed, if the frame is larger
+    // than 16384 x 16384 pixels or 1 GiB, or if it is a delta frame and
+    // there is no key frame to apply it to.
+    bool decode(message const& msg, thread_pool* pool = nullptr);
+
+    // Returns true until a key frame was decoded and after decode() failed,
+    // delta frames are rejected then
+    bool needs_key_frame() const;
+
+    // Returns the reassembled frame
+    uint8_t const* data() const;
+
+    int width() const;
+    int height() const;
+    int bytes_per_pixel() const;
+
+    // Returns the ID of the last decoded frame
+    uint32_t frame_id() const;
+
+private:
+    std::vector<uint8_t> frame_;
+
+    int width_ = 0;
+    int height_ = 0;
+    int bytes_per_pixel_ = 0;
+
+    uint32_t frame_id_ = 0;
+
+    bool has_key_frame_ = false;
+};
+
+} // async
+} // visionaray
+
+#endif // VSNRAY_COMMON_ASYNC_FRAME_STREAM_H
@@ -36,15 +36,25 @@ message::header::~header()
 //
 
 message::message()
+    : data_()
+    , external_data_(nullptr)
 {
 }
 
 message::message(unsigned type)
     : data_()
+    , external_data_(nullptr)
     , header_(boost::uuids::nil_uuid(), type, 0)
 {
 }
 
+message::message(unsigned type, void const* data, size_t size, external_buffer_tag)
+    : data_()
+    , external_data_(static_cast<char const*>(data))
+    , header_(boost::uuids::nil_uuid(), type, static_cast<unsigned>(size))
+{
+}
+
 message::~message()
 {
 }
@@ -54,3 +64,16 @@ boost::uuids::uuid message::generate_id()
     static boost::uuids::random_generator gen;
     return gen();
 }
+
+boost::uuids::uuid message::make_sequential_id(uint64_t n)
+{
+    boost::uuids::uuid id = boost::uuids::nil_uuid();
+
+    // Store the sequence number in the last 8 bytes, big-endian
+    for (int i = 0; i < 8; ++i)
+    {
+        id.data[15 - i] = static_cast<uint8_t>(n >> (i * 8));
+    }
+
+    return id;
+}
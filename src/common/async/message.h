@@ -7,10 +7,13 @@
 #define VSNRAY_COMMON_ASYNC_MESSAGE_H 1
 
 #include <cassert>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <stdexcept>
 #include <vector>
 
+#include <boost/uuid/nil_generator.hpp>
 #include <boost/uuid/uuid.hpp>
 
 namespace visionaray
@@ -31,6 +34,7 @@ class message
 {
     friend class connection;
     friend class connection_manager;
+    friend class message_pool;
 
     struct header
     {
@@ -50,9 +54,14 @@ class message
 public:
     using data_type = std::vector<char>;
 
+    // Tag type to create messages that reference external buffers
+    struct external_buffer_tag {};
+
 private:
     // The message data
     data_type data_;
+    // Externally owned message data, or nullptr if the message owns its data
+    char const* external_data_;
     // The message header
     header header_;
 
@@ -61,17 +70,28 @@ public:
 
     explicit message(unsigned type);
 
+    // Creates a message which references an externally owned buffer.
+    // No copy is made, the buffer must stay alive until the message was written.
+    // The buffer is only read from.
+    explicit message(unsigned type, void const* data, size_t size, external_buffer_tag);
+
     // Creates a message from the given buffer.
+    // The message ID is nil (see id()).
     template <typename It>
     explicit message(unsigned type, It first, It last)
         : data_(first, last)
-        , header_(generate_id(), type, static_cast<unsigned>(data_.size()))
+        , external_data_(nullptr)
+        , header_(boost::uuids::nil_uuid(), type, static_cast<unsigned>(data_.size()))
     {
     }
 
    ~message();
 
-    // Returns the unique ID of this message
+    // Returns the unique ID of this message.
+    // Messages are written with a copy of their header. If the ID is nil, the
+    // ID of the copy is assigned when the message is written to a connection
+    // (see connection_manager::set_id_scheme()), while this ID stays nil.
+    // Received messages have the ID they were sent with.
     boost::uuids::uuid const& id() const
     {
         return header_.id_;
@@ -86,56 +106,71 @@ public:
     // Returns the size of the message
     unsigned size() const
     {
-        assert( header_.size_ == data_.size() );
-        return static_cast<unsigned>(data_.size());
+        assert( external_data_ != nullptr || header_.size_ == data_.size() );
+        return header_.size_;
     }
 
-    // Returns an iterator to the first element of the data
-    data_type::iterator begin()
+    // Returns true if the message references an externally owned buffer
+    bool is_external() const
     {
-        return data_.begin();
+        return external_data_ != nullptr;
     }
 
-    // Returns an iterator to the element following the last element of the data
-    data_type::iterator end()
+    // Returns an iterator to the first element of the data.
+    // Messages that reference an external buffer are read-only, use the const overload.
+    char* begin()
+    {
+        return data();
+    }
+
+    // Returns an iterator to the element following the last element of the data.
+    // Messages that reference an external buffer are read-only, use the const overload.
+    char* end()
     {
-        return data_.end();
+        return data() + size();
     }
 
     // Returns an iterator to the first element of the data
-    data_type::const_iterator begin() const
+    char const* begin() const
     {
-        return data_.begin();
+        return data();
     }
 
     // Returns an iterator to the element following the last element of the data
-    data_type::const_iterator end() const
+    char const* end() const
     {
-        return data_.end();
+        return data() + size();
     }
 
     // Swaps the data buffer with the given buffer and resets the header.
     void swap_data(data_type& buffer)
     {
         data_.swap(buffer);
+        external_data_ = nullptr;
         header_ = {};
     }
 
-    // Returns a pointer to the data
+    // Returns a pointer to the data.
+    // Messages that reference an external buffer are read-only, use the const overload.
     char* data()
     {
+        assert( external_data_ == nullptr );
         return data_.data();
     }
 
     // Returns a pointer to the data
     char const* data() const
     {
-        return data_.data();
+        return external_data_ ? external_data_ : data_.data();
     }
 
 private:
-    // Creates a new unique ID for this message
+    // Creates a new random unique ID for this message
     static boost::uuids::uuid generate_id();
+
+    // Creates an ID from a sequence number.
+    // Much cheaper than generate_id(), but only unique per connection.
+    static boost::uuids::uuid make_sequential_id(uint64_t n);
 };
 
 inline message_pointer make_message(unsigned type = 0)
@@ -149,6 +184,13 @@ inline message_pointer make_message(unsigned type, It first, It last)
     return std::make_shared<message>(type, first, last);
 }
 
+// Creates a message which references the given buffer instead of copying it.
+// The buffer must stay alive until the message was written.
+inline message_pointer make_message_ref(unsigned type, void const* data, size_t size)
+{
+    return std::make_shared<message>(type, data, size, message::external_buffer_tag{});
+}
+
 } // async
 } // visionaray
 
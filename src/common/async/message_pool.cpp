@@ -0,0 +1,134 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#include "message_pool.h"
+
+using namespace visionaray::async;
+
+
+//--------------------------------------------------------------------------------------------------
+// message_pool::deleter
+//
+
+struct message_pool::deleter
+{
+    std::weak_ptr<message_pool> pool;
+
+    void operator()(message* msg) const
+    {
+        if (auto p = pool.lock())
+        {
+            p->release(msg);
+        }
+        else
+        {
+            delete msg;
+        }
+    }
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// message_pool
+//
+
+message_pool::message_pool(size_t max_pooled, size_t max_capacity)
+    : free_()
+    , max_pooled_(max_pooled)
+    , max_capacity_(max_capacity)
+    , num_allocated_(0)
+    , num_reused_(0)
+{
+}
+
+message_pool::~message_pool()
+{
+}
+
+message_pointer message_pool::acquire(unsigned type)
+{
+    std::unique_ptr<message> msg;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        if (free_.empty())
+        {
+            ++num_allocated_;
+        }
+        else
+        {
+            msg = std::move(free_.back());
+            free_.pop_back();
+            ++num_reused_;
+        }
+    }
+
+    if (!msg)
+    {
+        msg.reset(new message);
+    }
+
+    msg->header_ = message::header(boost::uuids::nil_uuid(), type, 0);
+
+    return message_pointer(msg.release(), deleter{ shared_from_this() });
+}
+
+message_pointer message_pool::acquire(unsigned type, size_t size)
+{
+    message_pointer msg = acquire(type);
+
+    msg->data_.resize(size);
+    msg->header_.size_ = static_cast<unsigned>(size);
+
+    return msg;
+}
+
+size_t message_pool::num_allocated() const
+{
+    std::unique_lock<std::mutex> l(mutex_);
+    return num_allocated_;
+}
+
+size_t message_pool::num_reused() const
+{
+    std::unique_lock<std::mutex> l(mutex_);
+    return num_reused_;
+}
+
+void message_pool::release(message* msg)
+{
+    std::unique_ptr<message> m(msg);
+
+    if (m->data_.capacity() > max_capacity_)
+    {
+        return;
+    }
+
+    // Keep the capacity, but drop references to external buffers
+    m->data_.clear();
+    m->external_data_ = nullptr;
+
+    std::unique_lock<std::mutex> l(mutex_);
+
+    if (free_.size() < max_pooled_)
+    {
+        free_.push_back(std::move(m));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// Factory functions
+//
+
+message_pool_pointer visionaray::async::make_message_pool()
+{
+    return make_message_pool(64, size_t(64) << 20);
+}
+
+message_pool_pointer visionaray::async::make_message_pool(size_t max_pooled, size_t max_capacity)
+{
+    // The constructor is private, no std::make_shared()
+    return message_pool_pointer(new message_pool(max_pooled, max_capacity));
+}
@@ -0,0 +1,109 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_ASYNC_MESSAGE_POOL_H
+#define VSNRAY_COMMON_ASYNC_MESSAGE_POOL_H 1
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "message.h"
+
+namespace visionaray
+{
+namespace async
+{
+
+class message_pool;
+
+using message_pool_pointer = std::shared_ptr<message_pool>;
+
+
+//--------------------------------------------------------------------------------------------------
+// message_pool
+//
+// Recycles message objects together with the capacity of their data buffers.
+// Messages obtained from the pool are returned to it when the last reference
+// is released. Messages may outlive the pool, they are then simply deleted.
+//
+// Messages hold a weak reference to the pool, so pools are only created with
+// make_message_pool().
+//
+
+class message_pool : public std::enable_shared_from_this<message_pool>
+{
+    friend message_pool_pointer make_message_pool();
+    friend message_pool_pointer make_message_pool(size_t max_pooled, size_t max_capacity);
+
+public:
+    // Destructor.
+   ~message_pool();
+
+    // Returns an empty message.
+    // Thread-safe.
+    message_pointer acquire(unsigned type = 0);
+
+    // Returns a message with an uninitialized data buffer of the given size.
+    // Thread-safe.
+    message_pointer acquire(unsigned type, size_t size);
+
+    // Returns a message with a copy of the given range.
+    // Thread-safe.
+    template <typename It>
+    message_pointer acquire(unsigned type, It first, It last)
+    {
+        message_pointer msg = acquire(type);
+
+        msg->data_.assign(first, last);
+        msg->header_.size_ = static_cast<unsigned>(msg->data_.size());
+
+        return msg;
+    }
+
+    // Returns the number of messages that had to be allocated
+    size_t num_allocated() const;
+
+    // Returns the number of requests that were served from the pool
+    size_t num_reused() const;
+
+private:
+    struct deleter;
+
+    // Constructor.
+    // max_pooled: max. number of idle messages kept in the pool
+    // max_capacity: messages with larger data buffers are not recycled
+    message_pool(size_t max_pooled, size_t max_capacity);
+
+    // Returns a message to the pool
+    void release(message* msg);
+
+private:
+    // Idle messages
+    std::vector<std::unique_ptr<message>> free_;
+    // Max. number of idle messages
+    size_t max_pooled_;
+    // Max. capacity of a recycled data buffer
+    size_t max_capacity_;
+    // Statistics
+    size_t num_allocated_;
+    size_t num_reused_;
+    // To protect the list of idle messages
+    mutable std::mutex mutex_;
+};
+
+// Creates a pool that keeps up to 64 idle messages w/ buffers of up to 64 MB
+message_pool_pointer make_message_pool();
+
+// Creates a pool.
+// max_pooled: max. number of idle messages kept in the pool
+// max_capacity: messages with larger data buffers are not recycled
+message_pool_pointer make_message_pool(size_t max_pooled, size_t max_capacity);
+
+} // async
+} // visionaray
+
+#endif // VSNRAY_COMMON_ASYNC_MESSAGE_POOL_H
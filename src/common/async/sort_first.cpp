@@ -0,0 +1,390 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <numeric>
+
+#include "../timer.h"
+#include "sort_first.h"
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//--------------------------------------------------------------------------------------------------
+// Wire format of a reply: reply_header followed by the region's pixels
+//
+
+namespace
+{
+
+struct reply_header
+{
+    uint32_t frame_id;
+    int32_t y;
+    int32_t h;
+    int32_t bytes_per_pixel;
+    double render_time;
+};
+
+// Max. viewport width and height accepted by workers
+const int32_t MaxViewportSize = 16384;
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_balancer
+//
+
+sort_first_balancer::sort_first_balancer(int granularity)
+    : granularity_(granularity)
+{
+    assert( granularity_ > 0 );
+}
+
+void sort_first_balancer::reset(size_t num_workers)
+{
+    shares_.assign(num_workers, 1.0 / std::max(num_workers, size_t(1)));
+    speeds_.assign(num_workers, 1.0);
+}
+
+std::vector<recti> sort_first_balancer::regions(int width, int height) const
+{
+    std::vector<recti> result(shares_.size());
+
+    int y = 0;
+
+    for (size_t i = 0; i < shares_.size(); ++i)
+    {
+        int h = 0;
+
+        if (i == shares_.size() - 1)
+        {
+            // Last region gets the remainder
+            h = height - y;
+        }
+        else
+        {
+            // At least one band, and leave one band for each remaining
+            // worker, as far as the viewport allows
+            int remaining = static_cast<int>(shares_.size() - i - 1) * granularity_;
+            int reserved = std::min(remaining, std::max(height - y - granularity_, 0));
+
+            h = static_cast<int>(shares_[i] * height / granularity_ + 0.5) * granularity_;
+            h = std::max(h, granularity_);
+            h = std::min(h, height - y - reserved);
+        }
+
+        result[i] = recti(0, y, width, h);
+        y += h;
+    }
+
+    return result;
+}
+
+void sort_first_balancer::update(std::vector<recti> const& regions, std::vector<double> const& times)
+{
+    assert( regions.size() == shares_.size() );
+    assert( times.size() == shares_.size() );
+
+    int height = 0;
+
+    for (auto const& r : regions)
+    {
+        height += r.h;
+    }
+
+    if (height == 0)
+    {
+        return;
+    }
+
+    // Estimate each worker's speed (share of the viewport per second)
+    // from the regions that were actually rendered. Workers that rendered
+    // no rows keep their last speed, a zero speed would also give them no
+    // rows in the next frame.
+    for (size_t i = 0; i < times.size(); ++i)
+    {
+        if (regions[i].h > 0)
+        {
+            double share = regions[i].h / static_cast<double>(height);
+            speeds_[i] = share / std::max(times[i], 1E-6);
+        }
+    }
+
+    double sum = std::accumulate(speeds_.begin(), speeds_.end(), 0.0);
+
+    // Move halfway towards the new balance to damp oscillation
+    for (size_t i = 0; i < shares_.size(); ++i)
+    {
+        shares_[i] = 0.5 * shares_[i] + 0.5 * speeds_[i] / sum;
+    }
+}
+
+std::vector<double> const& sort_first_balancer::shares() const
+{
+    return shares_;
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_master
+//
+
+sort_first_master::sort_first_master()
+    : pool_(make_message_pool())
+    , frame_id_(0)
+    , color_buffer_(nullptr)
+    , width_(0)
+    , bytes_per_pixel_(0)
+    , pending_(0)
+    , failed_(false)
+{
+}
+
+sort_first_master::~sort_first_master()
+{
+    for (auto& conn : workers_)
+    {
+        conn->remove_handler();
+    }
+}
+
+void sort_first_master::add_worker(connection_pointer conn)
+{
+    std::unique_lock<std::mutex> l(mutex_);
+
+    size_t index = workers_.size();
+
+    workers_.push_back(conn);
+    frame_times_.resize(workers_.size());
+    balancer_.reset(workers_.size());
+
+    conn->set_handler([this, index](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+    {
+        handle_message(index, r, msg, e);
+    });
+}
+
+bool sort_first_master::render_frame(
+        mat4 const& view,
+        mat4 const& proj,
+        unsigned    frame_num,
+        void*       color_buffer,
+        int         width,
+        int         height,
+        int         bytes_per_pixel
+        )
+{
+    std::unique_lock<std::mutex> l(mutex_);
+
+    if (workers_.empty())
+    {
+        return false;
+    }
+
+    ++frame_id_;
+    color_buffer_ = static_cast<char*>(color_buffer);
+    width_ = width;
+    bytes_per_pixel_ = bytes_per_pixel;
+    pending_ = workers_.size();
+    failed_ = false;
+
+    regions_ = balancer_.regions(width, height);
+
+    for (size_t i = 0; i < workers_.size(); ++i)
+    {
+        sort_first_request req;
+        req.frame_id = frame_id_;
+        req.frame_num = frame_num;
+        req.width = width;
+        req.height = height;
+        req.region = regions_[i];
+        req.view = view;
+        req.proj = proj;
+
+        auto ptr = reinterpret_cast<char const*>(&req);
+        workers_[i]->write(pool_->acquire(SortFirstRequest, ptr, ptr + sizeof(req)));
+    }
+
+    region_ready_.wait(l, [this]() { return pending_ == 0 || failed_; });
+
+    color_buffer_ = nullptr;
+
+    if (failed_)
+    {
+        return false;
+    }
+
+    balancer_.update(regions_, frame_times_);
+
+    return true;
+}
+
+size_t sort_first_master::num_workers() const
+{
+    return workers_.size();
+}
+
+std::vector<double> const& sort_first_master::frame_times() const
+{
+    return frame_times_;
+}
+
+sort_first_balancer& sort_first_master::balancer()
+{
+    return balancer_;
+}
+
+void sort_first_master::handle_message(
+        size_t                              index,
+        connection::reason                  r,
+        message_pointer                     msg,
+        boost::system::error_code const&    e
+        )
+{
+    if (r != connection::Read)
+    {
+        return;
+    }
+
+    std::unique_lock<std::mutex> l(mutex_);
+
+    if (e)
+    {
+        failed_ = true;
+        region_ready_.notify_all();
+        return;
+    }
+
+    if (msg->type() != SortFirstReply || msg->size() < sizeof(reply_header))
+    {
+        return;
+    }
+
+    reply_header rh;
+    std::memcpy(&rh, msg->data(), sizeof(rh));
+
+    // Ignore replies to outdated frames
+    if (rh.frame_id != frame_id_ || color_buffer_ == nullptr)
+    {
+        return;
+    }
+
+    recti region = regions_[index];
+    size_t size = size_t(width_) * region.h * bytes_per_pixel_;
+
+    if (rh.y != region.y || rh.h != region.h || rh.bytes_per_pixel != bytes_per_pixel_
+     || msg->size() != sizeof(reply_header) + size)
+    {
+        failed_ = true;
+        region_ready_.notify_all();
+        return;
+    }
+
+    // Regions are full-width strips, so a single copy suffices
+    std::memcpy(
+            color_buffer_ + size_t(width_) * region.y * bytes_per_pixel_,
+            msg->data() + sizeof(reply_header),
+            size
+            );
+
+    frame_times_[index] = rh.render_time;
+
+    if (--pending_ == 0)
+    {
+        region_ready_.notify_all();
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_worker
+//
+
+sort_first_worker::sort_first_worker(int bytes_per_pixel, render_func func)
+    : bytes_per_pixel_(bytes_per_pixel)
+    , func_(func)
+    , pool_(make_message_pool())
+{
+}
+
+void sort_first_worker::serve(connection_pointer conn)
+{
+    // Store a weak reference only, the connection owns the handler
+    std::weak_ptr<connection> weak_conn(conn);
+
+    conn->set_handler([this, weak_conn](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+    {
+        if (auto conn = weak_conn.lock())
+        {
+            handle_message(conn, r, msg, e);
+        }
+    });
+}
+
+void sort_first_worker::handle_message(
+        connection_pointer                  conn,
+        connection::reason                  r,
+        message_pointer                     msg,
+        boost::system::error_code const&    e
+        )
+{
+    if (r != connection::Read || e || msg->type() != SortFirstRequest || msg->size() != sizeof(sort_first_request))
+    {
+        return;
+    }
+
+    sort_first_request req;
+    std::memcpy(&req, msg->data(), sizeof(req));
+
+    // Don't trust the request. Clamp the region to a full-width strip inside
+    // the viewport, the master rejects replies for other regions than the
+    // requested one.
+    if (req.width <= 0 || req.height <= 0 || req.width > MaxViewportSize || req.height > MaxViewportSize)
+    {
+        req.width = 0;
+        req.height = 0;
+    }
+
+    req.region.x = 0;
+    req.region.w = req.width;
+    req.region.y = std::min(std::max(req.region.y, 0), req.height);
+    req.region.h = std::min(std::max(req.region.h, 0), req.height - req.region.y);
+
+    timer t;
+
+    char const* pixels = nullptr;
+
+    if (req.region.h > 0)
+    {
+        pixels = static_cast<char const*>(func_(req));
+    }
+
+    reply_header rh;
+    rh.frame_id = req.frame_id;
+    rh.y = req.region.y;
+    rh.h = req.region.h;
+    rh.bytes_per_pixel = bytes_per_pixel_;
+    rh.render_time = t.elapsed();
+
+    size_t size = pixels != nullptr ? size_t(req.width) * req.region.h * bytes_per_pixel_ : 0;
+
+    auto reply = pool_->acquire(SortFirstReply, sizeof(reply_header) + size);
+
+    std::memcpy(reply->data(), &rh, sizeof(rh));
+
+    if (size > 0)
+    {
+        std::memcpy(
+                reply->data() + sizeof(reply_header),
+                pixels + size_t(req.width) * req.region.y * bytes_per_pixel_,
+                size
+                );
+    }
+
+    conn->write(reply);
+}
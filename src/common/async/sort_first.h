@@ -0,0 +1,207 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_ASYNC_SORT_FIRST_H
+#define VSNRAY_COMMON_ASYNC_SORT_FIRST_H 1
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include <visionaray/math/forward.h>
+#include <visionaray/math/matrix.h>
+#include <visionaray/math/rectangle.h>
+
+#include "connection.h"
+#include "message_pool.h"
+
+namespace visionaray
+{
+namespace async
+{
+
+//--------------------------------------------------------------------------------------------------
+// Message types used by sort-first rendering
+//
+
+enum sort_first_message_type
+{
+    SortFirstRequest = 0x5F00,  // master -> worker: render a region
+    SortFirstReply              // worker -> master: pixels of a region
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_request
+//
+// Sent by the master to request rendering a region of the viewport
+//
+
+struct sort_first_request
+{
+    // ID of the frame the region belongs to
+    uint32_t frame_id;
+    // Frame number, e.g. for progressive rendering
+    uint32_t frame_num;
+    // Viewport size
+    int32_t width;
+    int32_t height;
+    // The region to render, use as scissor box
+    recti region;
+    // Camera matrices
+    mat4 view;
+    mat4 proj;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_balancer
+//
+// Splits the viewport into horizontal strips, one per worker. The height
+// of each strip is adjusted based on the time the worker took to render
+// its last strip, so that all workers finish at about the same time.
+// Every worker gets at least one band of granularity rows (if the viewport
+// is large enough), so its speed can always be measured.
+//
+
+class sort_first_balancer
+{
+public:
+    // Constructor.
+    // granularity: strip heights are multiples of this (e.g. the packet height)
+    explicit sort_first_balancer(int granularity = 16);
+
+    // Set the number of workers, resets the balancing
+    void reset(size_t num_workers);
+
+    // Returns the regions for the next frame
+    std::vector<recti> regions(int width, int height) const;
+
+    // Update the balancing with the regions of the last frame
+    // and the measured render time per worker
+    void update(std::vector<recti> const& regions, std::vector<double> const& times);
+
+    // Returns the share of the viewport rendered by each worker
+    std::vector<double> const& shares() const;
+
+private:
+    int granularity_;
+    std::vector<double> shares_;
+    // Last measured speed per worker (share of the viewport per second).
+    // Kept if a worker rendered no rows in the last frame.
+    std::vector<double> speeds_;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_master
+//
+// Distributes rendering of a frame over several worker processes and
+// assembles the returned regions into a single color buffer.
+//
+
+class sort_first_master
+{
+public:
+    sort_first_master();
+   ~sort_first_master();
+
+    // Adds a worker.
+    // The connection's handler is replaced.
+    void add_worker(connection_pointer conn);
+
+    // Renders a frame with the given camera into the given color buffer.
+    // Blocks until all workers have returned their regions.
+    // Returns false if a worker failed.
+    bool render_frame(
+            mat4 const& view,
+            mat4 const& proj,
+            unsigned    frame_num,
+            void*       color_buffer,
+            int         width,
+            int         height,
+            int         bytes_per_pixel
+            );
+
+    // Returns the number of workers
+    size_t num_workers() const;
+
+    // Returns the render times per worker of the last frame (in seconds)
+    std::vector<double> const& frame_times() const;
+
+    // Returns the load balancer
+    sort_first_balancer& balancer();
+
+private:
+    // Called when a message arrives from a worker
+    void handle_message(size_t index, connection::reason r, message_pointer msg, boost::system::error_code const& e);
+
+private:
+    // Worker connections
+    std::vector<connection_pointer> workers_;
+    // To allocate requests from
+    message_pool_pointer pool_;
+    // Load balancer
+    sort_first_balancer balancer_;
+    // Render time per worker of the last frame
+    std::vector<double> frame_times_;
+    // Regions of the frame in flight
+    std::vector<recti> regions_;
+
+    // The frame in flight
+    uint32_t frame_id_;
+    char* color_buffer_;
+    int width_;
+    int bytes_per_pixel_;
+    size_t pending_;
+    bool failed_;
+
+    // Protects the frame in flight
+    std::mutex mutex_;
+    // Signaled when a region has arrived
+    std::condition_variable region_ready_;
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_first_worker
+//
+// Renders regions on request of a master. Rendering happens on the
+// connection manager's thread.
+//
+
+class sort_first_worker
+{
+public:
+    // Renders the request's region and returns a pointer to a color buffer
+    // of the size of the whole viewport. Requests are checked before, the
+    // region is a full-width strip inside a viewport of at most
+    // 16384 x 16384 pixels.
+    using render_func = std::function<void const*(sort_first_request const& req)>;
+
+public:
+    sort_first_worker(int bytes_per_pixel, render_func func);
+
+    // Serve requests received on the given connection.
+    // The connection's handler is replaced.
+    void serve(connection_pointer conn);
+
+private:
+    // Called when a message arrives from the master
+    void handle_message(connection_pointer conn, connection::reason r, message_pointer msg, boost::system::error_code const& e);
+
+private:
+    int bytes_per_pixel_;
+    render_func func_;
+    message_pool_pointer pool_;
+};
+
+} // async
+} // visionaray
+
+#endif // VSNRAY_COMMON_ASYNC_SORT_FIRST_H
@@ -0,0 +1,571 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+
+#include <visionaray/math/simd/simd.h>
+
+#include "../timer.h"
+#include "sort_last.h"
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//--------------------------------------------------------------------------------------------------
+// Wire format of exchange and gather messages:
+// stage_header, followed by count colors and count depths
+//
+
+namespace
+{
+
+struct stage_header
+{
+    uint32_t frame_id;
+    int32_t stage;
+    uint64_t first;
+    uint64_t count;
+    float key;
+    int32_t rank;
+};
+
+// Keeps the colors that follow 16-byte aligned
+static_assert(sizeof(stage_header) % 16 == 0, "Size of stage_header must be a multiple of 16");
+
+struct hello
+{
+    int32_t rank;
+};
+
+// Largest power of two <= n
+int floor_pow2(int n)
+{
+    int p = 1;
+
+    while (p * 2 <= n)
+    {
+        p *= 2;
+    }
+
+    return p;
+}
+
+} // namespace
+
+
+//--------------------------------------------------------------------------------------------------
+// Per-pixel merge kernels
+//
+
+void visionaray::async::composite_depth(
+        vec4*           dst_color,
+        float*          dst_depth,
+        vec4 const*     src_color,
+        float const*    src_depth,
+        size_t          count,
+        bool            src_wins_ties
+        )
+{
+    using simd::float4;
+
+    auto dc = reinterpret_cast<float*>(dst_color);
+    auto sc = reinterpret_cast<float const*>(src_color);
+
+    float4 zero(0.0f);
+    float4 one(1.0f);
+
+    size_t i = 0;
+
+    // Depth test for four pixels at once, then select the colors pixel by pixel
+    for (; i + 4 <= count; i += 4)
+    {
+        float4 dd(dst_depth + i);
+        float4 sd(src_depth + i);
+
+        auto closer = src_wins_ties ? sd <= dd : sd < dd;
+
+        store(dst_depth + i, select(closer, sd, dd));
+
+        float4 sel = select(closer, one, zero);
+
+        float4 s0 = simd::shuffle<0, 0, 0, 0>(sel);
+        float4 s1 = simd::shuffle<1, 1, 1, 1>(sel);
+        float4 s2 = simd::shuffle<2, 2, 2, 2>(sel);
+        float4 s3 = simd::shuffle<3, 3, 3, 3>(sel);
+
+        store(dc + i * 4,      select(s0 != zero, float4(sc + i * 4),      float4(dc + i * 4)));
+        store(dc + i * 4 + 4,  select(s1 != zero, float4(sc + i * 4 + 4),  float4(dc + i * 4 + 4)));
+        store(dc + i * 4 + 8,  select(s2 != zero, float4(sc + i * 4 + 8),  float4(dc + i * 4 + 8)));
+        store(dc + i * 4 + 12, select(s3 != zero, float4(sc + i * 4 + 12), float4(dc + i * 4 + 12)));
+    }
+
+    for (; i < count; ++i)
+    {
+        if (src_wins_ties ? src_depth[i] <= dst_depth[i] : src_depth[i] < dst_depth[i])
+        {
+            dst_color[i] = src_color[i];
+            dst_depth[i] = src_depth[i];
+        }
+    }
+}
+
+void visionaray::async::composite_over(
+        vec4*           dst_color,
+        float*          dst_depth,
+        vec4 const*     src_color,
+        float const*    src_depth,
+        size_t          count,
+        bool            src_in_front
+        )
+{
+    using simd::float4;
+
+    auto dc = reinterpret_cast<float*>(dst_color);
+    auto sc = reinterpret_cast<float const*>(src_color);
+
+    // front may alias dst, every pixel is read before it is written
+    auto front = src_in_front ? sc : dc;
+    auto back  = src_in_front ? dc : sc;
+
+    float4 one(1.0f);
+
+    size_t i = 0;
+
+    // Four pixels per iteration, the RGBA channels of a pixel in one float4.
+    // Premultiplied alpha: front + (1 - front.alpha) * back
+    for (; i + 4 <= count; i += 4)
+    {
+        store(dst_depth + i, min(float4(dst_depth + i), float4(src_depth + i)));
+
+        float4 f0(front + i * 4);
+        float4 f1(front + i * 4 + 4);
+        float4 f2(front + i * 4 + 8);
+        float4 f3(front + i * 4 + 12);
+
+        float4 b0(back + i * 4);
+        float4 b1(back + i * 4 + 4);
+        float4 b2(back + i * 4 + 8);
+        float4 b3(back + i * 4 + 12);
+
+        store(dc + i * 4,      f0 + b0 * (one - simd::shuffle<3, 3, 3, 3>(f0)));
+        store(dc + i * 4 + 4,  f1 + b1 * (one - simd::shuffle<3, 3, 3, 3>(f1)));
+        store(dc + i * 4 + 8,  f2 + b2 * (one - simd::shuffle<3, 3, 3, 3>(f2)));
+        store(dc + i * 4 + 12, f3 + b3 * (one - simd::shuffle<3, 3, 3, 3>(f3)));
+    }
+
+    for (; i < count; ++i)
+    {
+        dst_depth[i] = std::min(dst_depth[i], src_depth[i]);
+
+        float4 f(front + i * 4);
+        float4 b(back + i * 4);
+
+        store(dc + i * 4, f + b * (one - simd::shuffle<3, 3, 3, 3>(f)));
+    }
+}
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_last_compositor
+//
+
+sort_last_compositor::sort_last_compositor(int rank, int num_nodes, mode m)
+    : rank_(rank)
+    , num_nodes_(num_nodes)
+    , mode_(m)
+    , peers_(num_nodes)
+    , disconnected_(num_nodes, false)
+    , num_peers_(0)
+    , pool_(make_message_pool())
+    , frame_id_(0)
+    , color_(nullptr)
+    , depth_(nullptr)
+    , num_pixels_(0)
+    , failed_(false)
+    , pending_writes_(0)
+    , composite_time_(0.0)
+    , pixels_sent_(0)
+{
+    assert( num_nodes_ > 0 );
+    assert( rank_ >= 0 && rank_ < num_nodes_ );
+}
+
+sort_last_compositor::~sort_last_compositor()
+{
+    for (auto& conn : peers_)
+    {
+        if (conn)
+        {
+            conn->remove_handler();
+        }
+    }
+}
+
+void sort_last_compositor::accept_peer(connection_pointer conn)
+{
+    // The peer's rank is unknown until its hello message arrives
+    auto peer = std::make_shared<int>(-1);
+
+    // Store a weak reference only, the connection owns the handler
+    std::weak_ptr<connection> weak_conn(conn);
+
+    conn->set_handler([this, peer, weak_conn](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+    {
+        if (r == connection::Read && !e && *peer < 0 && msg->type() == SortLastHello && msg->size() == sizeof(hello))
+        {
+            hello h;
+            std::memcpy(&h, msg->data(), sizeof(h));
+
+            auto conn = weak_conn.lock();
+
+            std::unique_lock<std::mutex> l(mutex_);
+
+            if (conn && h.rank >= 0 && h.rank < num_nodes_ && h.rank != rank_ && !peers_[h.rank])
+            {
+                *peer = h.rank;
+                peers_[h.rank] = conn;
+                ++num_peers_;
+                cond_.notify_all();
+            }
+
+            return;
+        }
+
+        handle_message(peer, r, msg, e);
+    });
+}
+
+void sort_last_compositor::connect_peer(int rank, connection_pointer conn)
+{
+    assert( rank >= 0 && rank < num_nodes_ && rank != rank_ );
+
+    auto peer = std::make_shared<int>(rank);
+
+    conn->set_handler([this, peer](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+    {
+        handle_message(peer, r, msg, e);
+    });
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        if (!peers_[rank])
+        {
+            ++num_peers_;
+        }
+
+        peers_[rank] = conn;
+        cond_.notify_all();
+    }
+
+    hello h;
+    h.rank = rank_;
+
+    auto ptr = reinterpret_cast<char const*>(&h);
+    conn->write(SortLastHello, ptr, ptr + sizeof(h));
+}
+
+bool sort_last_compositor::wait_for_peers()
+{
+    std::unique_lock<std::mutex> l(mutex_);
+
+    cond_.wait(l, [this]() { return num_peers_ == size_t(num_nodes_ - 1) || failed_; });
+
+    return !failed_;
+}
+
+bool sort_last_compositor::composite(
+        vec4*   color,
+        float*  depth,
+        int     width,
+        int     height,
+        float   visibility_key
+        )
+{
+    assert( reinterpret_cast<uintptr_t>(color) % 16 == 0 );
+    assert( reinterpret_cast<uintptr_t>(depth) % 16 == 0 );
+
+    timer t;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+
+        if (failed_)
+        {
+            return false;
+        }
+
+        ++frame_id_;
+        color_ = color;
+        depth_ = depth;
+        num_pixels_ = size_t(width) * height;
+        pixels_sent_ = 0;
+    }
+
+    int pow2 = floor_pow2(num_nodes_);
+    int excess = num_nodes_ - pow2;
+    float key = visibility_key;
+
+    // Binary-swap runs on pow2 virtual ranks. Excess nodes are folded into
+    // their left neighbor first, so each virtual rank covers a contiguous
+    // range of ranks and alpha compositing stays in rank order.
+    auto real_rank = [excess](int v) { return v < excess ? 2 * v : v + excess; };
+
+    int vrank = rank_ < 2 * excess ? rank_ / 2 : rank_ - excess;
+    bool active = rank_ >= 2 * excess || rank_ % 2 == 0;
+
+    size_t first = 0;
+    size_t last = num_pixels_;
+
+    bool ok = true;
+
+    if (!active)
+    {
+        send(rank_ - 1, SortLastExchange, 0, 0, num_pixels_, key);
+    }
+    else if (rank_ < 2 * excess)
+    {
+        auto msg = receive(SortLastExchange, 0, rank_ + 1);
+        ok = msg != nullptr;
+
+        if (ok)
+        {
+            merge(msg, key);
+        }
+    }
+
+    // Binary-swap, each round halves the part of the image this node is responsible for
+    for (int stage = 1, bit = 1; ok && active && bit < pow2; ++stage, bit *= 2)
+    {
+        int partner = real_rank(vrank ^ bit);
+
+        // Split on a multiple of four pixels so the merge kernels stay aligned
+        size_t mid = std::min(first + ((last - first) / 2 + 3) / 4 * 4, last);
+
+        if (rank_ < partner)
+        {
+            send(partner, SortLastExchange, stage, mid, last - mid, key);
+            last = mid;
+        }
+        else
+        {
+            send(partner, SortLastExchange, stage, first, mid - first, key);
+            first = mid;
+        }
+
+        auto msg = receive(SortLastExchange, stage, partner);
+        ok = msg != nullptr;
+
+        if (ok)
+        {
+            merge(msg, key);
+        }
+    }
+
+    // Gather the composited parts on rank 0
+    if (ok && active && rank_ != 0)
+    {
+        send(0, SortLastGather, 0, first, last - first, key);
+    }
+    else if (ok && rank_ == 0)
+    {
+        for (int v = 1; ok && v < pow2; ++v)
+        {
+            auto msg = receive(SortLastGather, 0, real_rank(v));
+            ok = msg != nullptr;
+
+            if (ok)
+            {
+                stage_header sh;
+                std::memcpy(&sh, msg->data(), sizeof(sh));
+
+                auto colors = msg->data() + sizeof(stage_header);
+                auto depths = colors + sh.count * sizeof(vec4);
+
+                std::memcpy(color_ + sh.first, colors, sh.count * sizeof(vec4));
+                std::memcpy(depth_ + sh.first, depths, sh.count * sizeof(float));
+            }
+        }
+    }
+
+    std::unique_lock<std::mutex> l(mutex_);
+
+    // Return only after the outgoing messages were sent, so that
+    // nodes may shut down right after the last frame
+    cond_.wait(l, [this]() { return pending_writes_ == 0 || failed_; });
+
+    ok = ok && !failed_;
+
+    color_ = nullptr;
+    depth_ = nullptr;
+    composite_time_ = t.elapsed();
+
+    return ok;
+}
+
+int sort_last_compositor::num_nodes() const
+{
+    return num_nodes_;
+}
+
+int sort_last_compositor::rank() const
+{
+    return rank_;
+}
+
+double sort_last_compositor::composite_time() const
+{
+    return composite_time_;
+}
+
+size_t sort_last_compositor::pixels_sent() const
+{
+    return pixels_sent_;
+}
+
+void sort_last_compositor::handle_message(
+        std::shared_ptr<int>                peer,
+        connection::reason                  r,
+        message_pointer                     msg,
+        boost::system::error_code const&    e
+        )
+{
+    std::unique_lock<std::mutex> l(mutex_);
+
+    if (e && r == connection::Read && *peer >= 0)
+    {
+        // Peers shut down when they are done, which is only
+        // an error if a message from them is still expected
+        disconnected_[*peer] = true;
+        cond_.notify_all();
+        return;
+    }
+
+    if (e)
+    {
+        failed_ = true;
+        cond_.notify_all();
+        return;
+    }
+
+    if (r == connection::Write)
+    {
+        if (msg->type() == SortLastExchange || msg->type() == SortLastGather)
+        {
+            --pending_writes_;
+            cond_.notify_all();
+        }
+
+        return;
+    }
+
+    if (*peer < 0 || (msg->type() != SortLastExchange && msg->type() != SortLastGather))
+    {
+        return;
+    }
+
+    if (msg->size() < sizeof(stage_header))
+    {
+        return;
+    }
+
+    stage_header sh;
+    std::memcpy(&sh, msg->data(), sizeof(sh));
+
+    if (sh.rank != *peer || msg->size() != sizeof(stage_header) + sh.count * (sizeof(vec4) + sizeof(float)))
+    {
+        failed_ = true;
+        cond_.notify_all();
+        return;
+    }
+
+    // Faster peers may already send messages for the next frame, keep those
+    inbox_.push_back(msg);
+    cond_.notify_all();
+}
+
+void sort_last_compositor::send(int rank, unsigned type, int stage, size_t first, size_t count, float key)
+{
+    stage_header sh;
+    sh.frame_id = frame_id_;
+    sh.stage = stage;
+    sh.first = first;
+    sh.count = count;
+    sh.key = key;
+    sh.rank = rank_;
+
+    auto msg = pool_->acquire(type, sizeof(stage_header) + count * (sizeof(vec4) + sizeof(float)));
+
+    auto colors = msg->data() + sizeof(stage_header);
+    auto depths = colors + count * sizeof(vec4);
+
+    std::memcpy(msg->data(), &sh, sizeof(sh));
+    std::memcpy(colors, color_ + first, count * sizeof(vec4));
+    std::memcpy(depths, depth_ + first, count * sizeof(float));
+
+    connection_pointer conn;
+
+    {
+        std::unique_lock<std::mutex> l(mutex_);
+        conn = peers_[rank];
+        pixels_sent_ += count;
+        ++pending_writes_;
+    }
+
+    assert( conn );
+
+    conn->write(msg);
+}
+
+message_pointer sort_last_compositor::receive(unsigned type, int stage, int rank)
+{
+    std::unique_lock<std::mutex> l(mutex_);
+
+    message_pointer result = nullptr;
+
+    cond_.wait(l, [&]()
+    {
+        for (auto it = inbox_.begin(); it != inbox_.end(); ++it)
+        {
+            stage_header sh;
+            std::memcpy(&sh, (*it)->data(), sizeof(sh));
+
+            if ((*it)->type() == type && sh.frame_id == frame_id_ && sh.stage == stage && sh.rank == rank)
+            {
+                result = *it;
+                inbox_.erase(it);
+                return true;
+            }
+        }
+
+        return failed_ || disconnected_[rank];
+    });
+
+    return result;
+}
+
+void sort_last_compositor::merge(message_pointer msg, float& key)
+{
+    stage_header sh;
+    std::memcpy(&sh, msg->data(), sizeof(sh));
+
+    auto colors = reinterpret_cast<vec4 const*>(msg->data() + sizeof(stage_header));
+    auto depths = reinterpret_cast<float const*>(msg->data() + sizeof(stage_header) + sh.count * sizeof(vec4));
+
+    if (mode_ == DepthTest)
+    {
+        // Resolve equal depths in favor of the lower rank, consistently on all nodes
+        composite_depth(color_ + sh.first, depth_ + sh.first, colors, depths, sh.count, sh.rank < rank_);
+    }
+    else
+    {
+        bool src_in_front = sh.key < key || (sh.key == key && sh.rank < rank_);
+
+        composite_over(color_ + sh.first, depth_ + sh.first, colors, depths, sh.count, src_in_front);
+        key = std::min(key, sh.key);
+    }
+}
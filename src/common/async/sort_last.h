@@ -0,0 +1,190 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details
+
+#pragma once
+
+#ifndef VSNRAY_COMMON_ASYNC_SORT_LAST_H
+#define VSNRAY_COMMON_ASYNC_SORT_LAST_H 1
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include <visionaray/math/forward.h>
+#include <visionaray/math/vector.h>
+
+#include "connection.h"
+#include "message_pool.h"
+
+namespace visionaray
+{
+namespace async
+{
+
+//--------------------------------------------------------------------------------------------------
+// Message types used by sort-last compositing
+//
+
+enum sort_last_message_type
+{
+    SortLastHello = 0x5F10,     // peer -> peer: announces the sender's rank
+    SortLastExchange,           // peer -> peer: pixels of a binary-swap round
+    SortLastGather              // peer -> root: the composited part of the image
+};
+
+
+//--------------------------------------------------------------------------------------------------
+// Per-pixel merge kernels
+//
+// Colors are RGBA32F (premultiplied alpha for alpha compositing), depths are
+// DEPTH32F. All pointers must be 16-byte aligned (e.g. from cpu_buffer_rt).
+//
+
+// Z-test: keeps the fragment closer to the viewer.
+// On equal depth, src is kept if src_wins_ties.
+void composite_depth(
+        vec4*           dst_color,
+        float*          dst_depth,
+        vec4 const*     src_color,
+        float const*    src_depth,
+        size_t          count,
+        bool            src_wins_ties = false
+        );
+
+// Front-to-back alpha compositing (e.g. volumes): blends src over dst if
+// src_in_front, dst over src otherwise. The result's depth is the minimum.
+void composite_over(
+        vec4*           dst_color,
+        float*          dst_depth,
+        vec4 const*     src_color,
+        float const*    src_depth,
+        size_t          count,
+        bool            src_in_front
+        );
+
+
+//--------------------------------------------------------------------------------------------------
+// sort_last_compositor
+//
+// Composites the partial images of several processes with binary-swap.
+// In each of the log2(n) rounds, a node exchanges half of its current part
+// of the image with a partner and merges the half it keeps, so that the
+// amount of data per node halves every round. Finally the parts are gathered
+// on rank 0. With a non-power-of-two number of nodes, the excess nodes first
+// fold their image into their left neighbor and then sit out the exchange.
+//
+// For alpha compositing, each node supplies a visibility key for its partial
+// image (e.g. the distance of its brick to the viewer, smaller is in front).
+// Binary-swap merges the images in rank order, so the data decomposition must
+// be consistent with it (e.g. a kd-tree over the ranks).
+//
+
+class sort_last_compositor
+{
+public:
+    enum mode
+    {
+        DepthTest,
+        AlphaFrontToBack
+    };
+
+public:
+    sort_last_compositor(int rank, int num_nodes, mode m = DepthTest);
+   ~sort_last_compositor();
+
+    // Adds the connection to a peer that connected to this node.
+    // The peer's rank is received with its hello message.
+    // The connection's handler is replaced.
+    void accept_peer(connection_pointer conn);
+
+    // Adds the connection to the peer with the given rank and sends it
+    // a hello message.
+    // The connection's handler is replaced.
+    void connect_peer(int rank, connection_pointer conn);
+
+    // Blocks until all peers have been added
+    bool wait_for_peers();
+
+    // Composites the partial image in color and depth with those of the other
+    // nodes. Blocks until this node is done. On rank 0, color and depth contain
+    // the final image afterwards, the contents are unspecified on other nodes.
+    // Returns false if a peer failed.
+    bool composite(
+            vec4*   color,
+            float*  depth,
+            int     width,
+            int     height,
+            float   visibility_key = 0.0f
+            );
+
+    // Returns the number of nodes
+    int num_nodes() const;
+
+    // Returns the rank of this node
+    int rank() const;
+
+    // Returns the time the last call to composite() took (in seconds)
+    double composite_time() const;
+
+    // Returns the number of pixels this node sent during the last call to composite()
+    size_t pixels_sent() const;
+
+private:
+    // Called when a message arrives from a peer
+    void handle_message(
+            std::shared_ptr<int>                peer,
+            connection::reason                  r,
+            message_pointer                     msg,
+            boost::system::error_code const&    e
+            );
+
+    // Sends the pixels [first, first + count) to the peer with the given rank
+    void send(int rank, unsigned type, int stage, size_t first, size_t count, float key);
+
+    // Blocks until a message of the given type and stage has arrived from
+    // the peer with the given rank. Returns nullptr if the peer disconnected.
+    message_pointer receive(unsigned type, int stage, int rank);
+
+    // Merges a received message into the current frame
+    void merge(message_pointer msg, float& key);
+
+private:
+    int rank_;
+    int num_nodes_;
+    mode mode_;
+
+    // Connections to the peers, indexed by rank
+    std::vector<connection_pointer> peers_;
+    std::vector<bool> disconnected_;
+    size_t num_peers_;
+
+    // Pool for outgoing messages
+    message_pool_pointer pool_;
+
+    // The frame in flight
+    uint32_t frame_id_;
+    vec4* color_;
+    float* depth_;
+    size_t num_pixels_;
+    bool failed_;
+    size_t pending_writes_;
+
+    // Messages that arrived and were not processed yet
+    std::vector<message_pointer> inbox_;
+
+    // Statistics of the last frame
+    double composite_time_;
+    size_t pixels_sent_;
+
+    // Protects the peers and the inbox
+    std::mutex mutex_;
+    // Signaled when a peer was added or a message arrived
+    std::condition_variable cond_;
+};
+
+} // async
+} // visionaray
+
+#endif // VSNRAY_COMMON_ASYNC_SORT_LAST_H
@@ -224,7 +224,7 @@ bool image::save(std::string const& filename, image_base::save_options const& op
     {
     case PNM:
     {
-        pnm_image pnm;
+        pnm_image pnm(width_, height_, format_, data_.data());
         return pnm.save(fn, options);
     }
 
@@ -0,0 +1,254 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+#include <GL/glew.h>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/detail/platform.h>
+
+#include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/pinhole_camera.h>
+
+#include <common/async/connection_manager.h>
+#include <common/async/sort_first.h>
+
+#include <common/manip/arcball_manipulator.h>
+#include <common/manip/pan_manipulator.h>
+#include <common/manip/zoom_manipulator.h>
+
+#include <common/model.h>
+#include <common/obj_loader.h>
+#include <common/timer.h>
+#include <common/viewer_glut.h>
+
+using namespace visionaray;
+
+using viewer_type = viewer_glut;
+
+
+//-------------------------------------------------------------------------------------------------
+// struct with state variables
+//
+
+struct renderer : viewer_type
+{
+    renderer()
+        : viewer_type(512, 512, "Visionaray Sort-First Example")
+    {
+        using namespace support;
+
+        add_cmdline_option( cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "filename",
+            cl::Desc("Input file in wavefront obj format (used to set up the camera)"),
+            cl::Positional,
+            cl::Required,
+            cl::init(this->filename)
+            ) );
+
+        add_cmdline_option( cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "workers",
+            cl::Desc("Comma separated list of workers (host:port)"),
+            cl::ArgRequired,
+            cl::init(this->workers)
+            ) );
+    }
+
+    pinhole_camera                              cam;
+    cpu_buffer_rt<PF_RGBA8, PF_UNSPECIFIED>     host_rt;
+
+    std::string                                 filename;
+    std::string                                 workers         = "localhost:31050";
+
+    model mod;
+    unsigned                                    frame_num       = 0;
+
+    async::connection_manager_pointer           manager;
+    async::sort_first_master                    master;
+
+    frame_counter                               counter;
+    double                                      fps             = 0.0;
+
+protected:
+
+    void on_display();
+    void on_key_press(visionaray::key_event const& event);
+    void on_resize(int w, int h);
+
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Display function, distributes the frame over the workers
+//
+
+void renderer::on_display()
+{
+    bool ok = master.render_frame(
+            cam.get_view_matrix(),
+            cam.get_proj_matrix(),
+            ++frame_num,
+            host_rt.color(),
+            host_rt.width(),
+            host_rt.height(),
+            static_cast<int>(sizeof(decltype(host_rt)::color_type))
+            );
+
+    if (!ok)
+    {
+        std::cerr << "Rendering failed, a worker disconnected\n";
+        quit();
+        return;
+    }
+
+    fps = counter.register_frame();
+
+    // display the rendered image
+
+    auto bgcolor = background_color();
+    glClearColor(bgcolor.x, bgcolor.y, bgcolor.z, 1.0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    host_rt.display_color_buffer();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// keyboard handling
+//
+
+void renderer::on_key_press(key_event const& event)
+{
+    switch (event.key())
+    {
+    case 'b':
+        {
+            // Print frame rate and load balancing
+            std::cout << "FPS: " << fps << '\n';
+
+            auto const& times = master.frame_times();
+            auto const& shares = master.balancer().shares();
+
+            for (size_t i = 0; i < master.num_workers(); ++i)
+            {
+                std::cout << "Worker " << i << ": "
+                          << shares[i] * 100.0 << "% of the viewport, "
+                          << times[i] * 1000.0 << " ms\n";
+            }
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    viewer_type::on_key_press(event);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// resize event
+//
+
+void renderer::on_resize(int w, int h)
+{
+    frame_num = 0;
+
+    cam.set_viewport(0, 0, w, h);
+    float aspect = w / static_cast<float>(h);
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), aspect, 0.001f, 1000.0f);
+    host_rt.resize(w, h);
+
+    viewer_type::on_resize(w, h);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Main function, performs initialization
+//
+
+int main(int argc, char** argv)
+{
+    renderer rend;
+
+    try
+    {
+        rend.init(argc, argv);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        visionaray::load_obj(rend.filename, rend.mod);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Failed loading obj model: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+
+    // Connect to the workers
+
+    rend.manager = async::make_connection_manager();
+
+    std::istringstream workers(rend.workers);
+    std::string worker;
+
+    while (std::getline(workers, worker, ','))
+    {
+        auto colon = worker.rfind(':');
+
+        if (colon == std::string::npos)
+        {
+            std::cerr << "Invalid worker: " << worker << '\n';
+            return EXIT_FAILURE;
+        }
+
+        auto host = worker.substr(0, colon);
+        auto port = static_cast<unsigned short>(std::stoi(worker.substr(colon + 1)));
+
+        auto conn = rend.manager->connect(host, port);
+
+        if (!conn)
+        {
+            std::cerr << "Cannot connect to worker: " << worker << '\n';
+            return EXIT_FAILURE;
+        }
+
+        rend.master.add_worker(conn);
+    }
+
+    rend.manager->run_in_thread();
+
+    std::cout << "Connected to " << rend.master.num_workers() << " workers\n";
+
+
+    float aspect = rend.width() / static_cast<float>(rend.height());
+
+    rend.cam.perspective(45.0f * constants::degrees_to_radians<float>(), aspect, 0.001f, 1000.0f);
+    rend.cam.view_all( rend.mod.bbox );
+
+    rend.add_manipulator( std::make_shared<arcball_manipulator>(rend.cam, mouse::Left) );
+    rend.add_manipulator( std::make_shared<pan_manipulator>(rend.cam, mouse::Middle) );
+    // Additional "Alt + LMB" pan manipulator for setups w/o middle mouse button
+    rend.add_manipulator( std::make_shared<pan_manipulator>(rend.cam, mouse::Left, keyboard::Alt) );
+    rend.add_manipulator( std::make_shared<zoom_manipulator>(rend.cam, mouse::Right) );
+
+    rend.event_loop();
+}
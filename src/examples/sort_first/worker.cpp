@@ -0,0 +1,193 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/detail/platform.h>
+
+#include <visionaray/bvh.h>
+#include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/get_normal.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/traverse.h>
+
+#include <common/async/connection_manager.h>
+#include <common/async/sort_first.h>
+
+#include <common/model.h>
+#include <common/obj_loader.h>
+
+using namespace visionaray;
+
+using host_ray_type = basic_ray<simd::float4>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Main function, renders regions on request of a sort-first master
+//
+
+int main(int argc, char** argv)
+{
+    using namespace support;
+
+    std::string filename;
+    int port = 31050;
+    unsigned num_threads = std::thread::hardware_concurrency();
+
+    cl::CmdLine cmd;
+
+    auto filename_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "filename",
+            cl::Desc("Input file in wavefront obj format"),
+            cl::Positional,
+            cl::Required,
+            cl::init(filename)
+            );
+
+    auto port_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "port",
+            cl::Desc("Port to listen on for the master"),
+            cl::ArgRequired,
+            cl::init(port)
+            );
+
+    auto threads_opt = cl::makeOption<unsigned&>(
+            cl::Parser<>(),
+            "threads",
+            cl::Desc("Number of render threads"),
+            cl::ArgRequired,
+            cl::init(num_threads)
+            );
+
+    cmd.add(*filename_opt);
+    cmd.add(*port_opt);
+    cmd.add(*threads_opt);
+
+    try
+    {
+        auto args = std::vector<std::string>(argv + 1, argv + argc);
+        cl::expandWildcards(args);
+        cl::expandResponseFiles(args, cl::TokenizeUnix());
+
+        cmd.parse(args);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        std::cout << cmd.help(argv[0]) << '\n';
+        return EXIT_FAILURE;
+    }
+
+    model mod;
+
+    try
+    {
+        visionaray::load_obj(filename, mod);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << "Failed loading obj model: " << e.what() << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "Creating BVH...\n";
+
+    auto host_bvh = build<index_bvh<model::triangle_type>>(
+            mod.primitives.data(),
+            mod.primitives.size()
+            );
+
+    using bvh_ref = index_bvh<model::triangle_type>::bvh_ref;
+
+    std::vector<bvh_ref> bvhs;
+    bvhs.push_back(host_bvh.ref());
+
+    auto prims_begin = bvhs.data();
+    auto prims_end   = bvhs.data() + bvhs.size();
+
+    cpu_buffer_rt<PF_RGBA8, PF_UNSPECIFIED> host_rt;
+    tiled_sched<host_ray_type> host_sched(num_threads);
+
+    using R = host_ray_type;
+    using S = R::scalar_type;
+    using C = vector<4, S>;
+
+
+    // Renders the requested region with simple headlight shading
+
+    async::sort_first_worker worker(
+            static_cast<int>(sizeof(decltype(host_rt)::color_type)),
+            [&](async::sort_first_request const& req) -> void const*
+            {
+                if (host_rt.width() != req.width || host_rt.height() != req.height)
+                {
+                    host_rt.resize(req.width, req.height);
+                }
+
+                auto sparams = make_sched_params(req.view, req.proj, host_rt);
+                sparams.scissor_box = req.region;
+
+                host_sched.frame([&](R ray) -> result_record<S>
+                {
+                    result_record<S> result;
+
+                    auto hit_rec = closest_hit(ray, prims_begin, prims_end);
+
+                    result.hit = hit_rec.hit;
+
+                    auto n = get_normal(
+                            mod.geometric_normals.data(),
+                            hit_rec,
+                            bvh_ref{},
+                            normals_per_face_binding{}
+                            );
+
+                    S ndotv = abs( dot(normalize(n), normalize(ray.dir)) );
+
+                    result.color = select( hit_rec.hit, C(ndotv, ndotv, ndotv, S(1.0)), C(0.0) );
+
+                    return result;
+                }, sparams, req.frame_num);
+
+                return host_rt.color();
+            });
+
+
+    // Serve masters, one after another
+
+    auto manager = async::make_connection_manager(static_cast<unsigned short>(port));
+
+    std::function<bool(async::connection_pointer, boost::system::error_code const&)> on_accept;
+
+    on_accept = [&](async::connection_pointer conn, boost::system::error_code const& e)
+    {
+        if (e)
+        {
+            return false;
+        }
+
+        std::cout << "Master connected\n";
+        worker.serve(conn);
+
+        manager->accept(on_accept);
+        return true;
+    };
+
+    manager->accept(on_accept);
+
+    std::cout << "Ready, listening on port " << port << '\n';
+
+    manager->run();
+}
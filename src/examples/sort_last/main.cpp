@@ -0,0 +1,275 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <chrono>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <ostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <Support/CmdLine.h>
+#include <Support/CmdLineUtil.h>
+
+#include <visionaray/detail/platform.h>
+
+#include <visionaray/cpu_buffer_rt.h>
+
+#include <common/async/connection_manager.h>
+#include <common/async/sort_last.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Fills the render target with a synthetic partial image.
+// Each node covers the viewport with fragments at random depths, so that
+// the final image is a mix of all nodes' colors.
+//
+
+static void make_partial_image(cpu_buffer_rt<PF_RGBA32F, PF_DEPTH32F>& rt, int rank, bool alpha)
+{
+    std::default_random_engine rng(rank);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    vec4 color(
+            (rank & 1) ? 1.0f : 0.0f,
+            (rank & 2) ? 1.0f : 0.0f,
+            (rank & 4) ? 1.0f : 0.0f,
+            1.0f
+            );
+
+    if (alpha)
+    {
+        // Premultiplied, semi-transparent
+        color *= 0.25f;
+    }
+
+    for (int i = 0; i < rt.width() * rt.height(); ++i)
+    {
+        rt.color()[i] = color;
+        rt.depth()[i] = dist(rng);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Main function, composites synthetic partial images of several processes
+//
+
+int main(int argc, char** argv)
+{
+    using namespace support;
+
+    int rank = 0;
+    std::string nodes = "::1:31060";
+    int width = 1920;
+    int height = 1080;
+    int frames = 20;
+    bool alpha = false;
+
+    cl::CmdLine cmd;
+
+    auto rank_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "rank",
+            cl::Desc("Rank of this node, indexes the list of nodes"),
+            cl::ArgRequired,
+            cl::init(rank)
+            );
+
+    auto nodes_opt = cl::makeOption<std::string&>(
+            cl::Parser<>(),
+            "nodes",
+            cl::Desc("Comma separated list of all nodes (host:port)"),
+            cl::ArgRequired,
+            cl::init(nodes)
+            );
+
+    auto width_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "width",
+            cl::Desc("Image width"),
+            cl::ArgRequired,
+            cl::init(width)
+            );
+
+    auto height_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "height",
+            cl::Desc("Image height"),
+            cl::ArgRequired,
+            cl::init(height)
+            );
+
+    auto frames_opt = cl::makeOption<int&>(
+            cl::Parser<>(),
+            "frames",
+            cl::Desc("Number of frames to composite"),
+            cl::ArgRequired,
+            cl::init(frames)
+            );
+
+    auto alpha_opt = cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "alpha",
+            cl::Desc("Front-to-back alpha compositing instead of z-test"),
+            cl::ArgDisallowed,
+            cl::init(alpha)
+            );
+
+    cmd.add(*rank_opt);
+    cmd.add(*nodes_opt);
+    cmd.add(*width_opt);
+    cmd.add(*height_opt);
+    cmd.add(*frames_opt);
+    cmd.add(*alpha_opt);
+
+    try
+    {
+        auto args = std::vector<std::string>(argv + 1, argv + argc);
+        cl::expandWildcards(args);
+        cl::expandResponseFiles(args, cl::TokenizeUnix());
+
+        cmd.parse(args);
+    }
+    catch (std::exception const& e)
+    {
+        std::cerr << e.what() << '\n';
+        std::cout << cmd.help(argv[0]) << '\n';
+        return EXIT_FAILURE;
+    }
+
+
+    // Parse the list of nodes
+
+    std::vector<std::pair<std::string, unsigned short>> hosts;
+
+    std::istringstream nodes_stream(nodes);
+    std::string node;
+
+    while (std::getline(nodes_stream, node, ','))
+    {
+        auto colon = node.rfind(':');
+
+        if (colon == std::string::npos)
+        {
+            std::cerr << "Invalid node: " << node << '\n';
+            return EXIT_FAILURE;
+        }
+
+        auto host = node.substr(0, colon);
+        auto port = static_cast<unsigned short>(std::stoi(node.substr(colon + 1)));
+
+        hosts.emplace_back(host, port);
+    }
+
+    if (rank < 0 || rank >= static_cast<int>(hosts.size()))
+    {
+        std::cerr << "Invalid rank: " << rank << '\n';
+        return EXIT_FAILURE;
+    }
+
+    int num_nodes = static_cast<int>(hosts.size());
+
+    // Higher ranks connect to lower ranks
+
+    auto manager = async::make_connection_manager(hosts[rank].second);
+
+    async::sort_last_compositor compositor(
+            rank,
+            num_nodes,
+            alpha ? async::sort_last_compositor::AlphaFrontToBack : async::sort_last_compositor::DepthTest
+            );
+
+    std::function<bool(async::connection_pointer, boost::system::error_code const&)> on_accept;
+
+    int pending_accepts = num_nodes - 1 - rank;
+
+    on_accept = [&](async::connection_pointer conn, boost::system::error_code const& e)
+    {
+        if (e)
+        {
+            return false;
+        }
+
+        compositor.accept_peer(conn);
+
+        if (--pending_accepts > 0)
+        {
+            manager->accept(on_accept);
+        }
+
+        return true;
+    };
+
+    if (pending_accepts > 0)
+    {
+        manager->accept(on_accept);
+    }
+
+    manager->run_in_thread();
+
+    for (int i = 0; i < rank; ++i)
+    {
+        async::connection_pointer conn = nullptr;
+
+        // The peer might not be listening yet
+        for (int retry = 0; !conn && retry < 100; ++retry)
+        {
+            conn = manager->connect(hosts[i].first, hosts[i].second);
+
+            if (!conn)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(100));
+            }
+        }
+
+        if (!conn)
+        {
+            std::cerr << "Cannot connect to node: " << hosts[i].first << ':' << hosts[i].second << '\n';
+            return EXIT_FAILURE;
+        }
+
+        compositor.connect_peer(i, conn);
+    }
+
+    if (!compositor.wait_for_peers())
+    {
+        std::cerr << "Connecting to the other nodes failed\n";
+        return EXIT_FAILURE;
+    }
+
+
+    // Composite
+
+    cpu_buffer_rt<PF_RGBA32F, PF_DEPTH32F> rt;
+    rt.resize(width, height);
+
+    double total_time = 0.0;
+
+    for (int frame = 0; frame < frames; ++frame)
+    {
+        make_partial_image(rt, rank, alpha);
+
+        if (!compositor.composite(rt.color(), rt.depth(), width, height, static_cast<float>(rank)))
+        {
+            std::cerr << "Compositing failed, a node disconnected\n";
+            return EXIT_FAILURE;
+        }
+
+        total_time += compositor.composite_time();
+    }
+
+    std::cout << "Rank " << rank << " of " << num_nodes << ": "
+              << total_time / frames * 1000.0 << " ms per frame, "
+              << compositor.pixels_sent() << " pixels sent per frame\n";
+
+    manager->stop();
+}
@@ -0,0 +1,157 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_VIEWER_RENDER_H
+#define VSNRAY_VIEWER_RENDER_H 1
+
+#include <visionaray/detail/compiler.h>
+#include <visionaray/bvh.h>
+#include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/cpu_features.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+#include <visionaray/traversal_counters.h>
+
+#include <common/call_kernel.h>
+#include <common/model.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Switch to use simple but fast plastic material, or a generic material container with
+// support for emissive objects
+//
+
+#define USE_PLASTIC_MATERIAL 1
+
+
+//-------------------------------------------------------------------------------------------------
+// Defined by the build system if the ISA specific CPU render modules are available
+//
+
+#ifndef VSNRAY_VIEWER_ISA_DISPATCH
+#define VSNRAY_VIEWER_ISA_DISPATCH 0
+#endif
+
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Host types shared by the viewer and the CPU render functions
+//
+
+using primitive_type            = model::triangle_type;
+using normal_type               = model::normal_type;
+using tex_coord_type            = model::tex_coord_type;
+#if USE_PLASTIC_MATERIAL
+using material_type             = plastic<float>;
+#else
+using material_type             = generic_material<
+                                        emissive<float>,
+                                        glass<float>,
+                                        matte<float>,
+                                        mirror<float>,
+                                        plastic<float>
+                                        >;
+#endif
+using light_type                = point_light<float>;
+
+using host_render_target_type   = cpu_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+using host_bvh_type             = index_bvh<primitive_type>;
+
+
+//-------------------------------------------------------------------------------------------------
+// Parameters for a CPU frame
+//
+
+struct render_params
+{
+    host_bvh_type::bvh_ref const*   primitives_begin;
+    host_bvh_type::bvh_ref const*   primitives_end;
+    normal_type const*              normals;
+    material_type const*            materials;
+    light_type const*               lights_begin;
+    light_type const*               lights_end;
+    unsigned                        bounces;
+    float                           epsilon;
+    vec4                            background;
+    vec4                            ambient;
+    algorithm                       algo;
+    unsigned                        ssaa_samples;
+    unsigned                        num_threads;
+
+    // Path tracing: accumulate color and AOVs, show the denoised image
+    bool                            denoise;
+
+    // Path tracing: reproject the accumulated samples when the camera moves,
+    // the history is discarded when frame_num is 0
+    bool                            temporal;
+
+    // Render a traversal cost heatmap instead of using algo
+    bool                            heatmap;
+    heatmap::counter_type           heatmap_counter;
+    float                           heatmap_max;
+    traversal_statistics*           stats;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Render a frame on the CPU
+//
+// There is one function per instruction set, each in its own translation unit,
+// compiled with that ISA and using the packet type that matches its vector width.
+// All but the default variant are built as separate shared modules with hidden
+// symbols, so that the inline functions they instantiate (compiled e.g. with
+// AVX-512) are not merged with the baseline instantiations of the executable.
+//
+
+using render_cpu_func = void (*)(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        );
+
+// Built with the compiler flags of the viewer, basic_ray<simd::float4>
+void render_cpu_default(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        );
+
+#if VSNRAY_VIEWER_ISA_DISPATCH
+
+// -msse4.1, basic_ray<simd::float4>
+VSNRAY_DLL_EXPORT void render_cpu_sse4_1(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        );
+
+// -mavx2, basic_ray<simd::float8>
+VSNRAY_DLL_EXPORT void render_cpu_avx2(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        );
+
+// -mavx512f, basic_ray<simd::float16>
+VSNRAY_DLL_EXPORT void render_cpu_avx512f(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        );
+
+#endif // VSNRAY_VIEWER_ISA_DISPATCH
+
+} // visionaray
+
+#endif // VSNRAY_VIEWER_RENDER_H
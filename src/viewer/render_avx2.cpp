@@ -0,0 +1,25 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/simd/intrinsics.h>
+
+#if !VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
+#error "render_avx2.cpp must be compiled with -mavx2"
+#endif
+
+#include "render_impl.h"
+
+namespace visionaray
+{
+
+void render_cpu_avx2(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        )
+{
+    render_cpu_impl<simd::float8>(params, frame_num, cam, rt);
+}
+
+} // visionaray
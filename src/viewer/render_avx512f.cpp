@@ -0,0 +1,25 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/simd/intrinsics.h>
+
+#if !VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+#error "render_avx512f.cpp must be compiled with -mavx512f"
+#endif
+
+#include "render_impl.h"
+
+namespace visionaray
+{
+
+void render_cpu_avx512f(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        )
+{
+    render_cpu_impl<simd::float16>(params, frame_num, cam, rt);
+}
+
+} // visionaray
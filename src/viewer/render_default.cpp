@@ -0,0 +1,19 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include "render_impl.h"
+
+namespace visionaray
+{
+
+void render_cpu_default(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        )
+{
+    render_cpu_impl<simd::float4>(params, frame_num, cam, rt);
+}
+
+} // visionaray
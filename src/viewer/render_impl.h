@@ -0,0 +1,152 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_VIEWER_RENDER_IMPL_H
+#define VSNRAY_VIEWER_RENDER_IMPL_H 1
+
+#include <algorithm>
+
+#include <visionaray/aov_buffer_rt.h>
+#include <visionaray/denoiser.h>
+#include <visionaray/kernels.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/temporal_accumulator.h>
+
+#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
+#include <visionaray/detail/tbb_sched.h>
+#endif
+
+#include "render.h"
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// Render a frame on the CPU with packets of type S
+//
+// Only include this in the translation units that implement the render_cpu_*
+// functions from render.h.
+//
+
+template <typename S>
+void render_cpu_impl(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        )
+{
+    using ray_type = basic_ray<S>;
+
+    // Each variant owns its scheduler, only the selected one starts a thread pool
+#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
+    static tbb_sched<ray_type> sched(params.num_threads);
+#else
+    static tiled_sched<ray_type> sched(params.num_threads);
+#endif
+
+    // The scheduler outlives the call, restart it when the thread count changes
+    static unsigned num_threads = params.num_threads;
+
+    if (num_threads != params.num_threads)
+    {
+        num_threads = params.num_threads;
+        sched.reset(num_threads);
+    }
+
+    // Path tracing with denoiser or reprojection: accumulate here, write the result to rt
+    static aov_buffer_rt<PF_RGBA32F> accum_rt(AovDepth | AovNormal | AovAlbedo);
+    static temporal_accumulator history;
+    static denoiser filter;
+
+    auto kparams = make_kernel_params(
+            normals_per_face_binding{},
+            params.primitives_begin,
+            params.primitives_end,
+            params.normals,
+            params.materials,
+            params.lights_begin,
+            params.lights_end,
+            params.bounces,
+            params.epsilon,
+            params.background,
+            params.ambient
+            );
+
+    if (params.heatmap)
+    {
+        using K = heatmap::kernel<decltype(kparams)>;
+
+        sched.frame(
+            K{ kparams, params.heatmap_counter, params.heatmap_max, params.stats },
+            make_sched_params(pixel_sampler::uniform_type{}, cam, rt),
+            frame_num
+            );
+    }
+    else if (params.algo == Pathtracing && (params.denoise || params.temporal))
+    {
+        if (accum_rt.width() != rt.width() || accum_rt.height() != rt.height())
+        {
+            accum_rt.resize(rt.width(), rt.height());
+        }
+
+        // Post processing passes on the render threads
+#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
+        static thread_pool pool(num_threads);
+
+        if (pool.num_threads != num_threads)
+        {
+            pool.reset(num_threads);
+        }
+#else
+        thread_pool& pool = sched.backend().pool();
+#endif
+
+        using K = pathtracing::kernel<decltype(kparams), aov_result_record>;
+
+        if (params.temporal)
+        {
+            // frame_num is only reset when the history becomes invalid,
+            // not on camera motion
+            if (frame_num == 0)
+            {
+                history.reset();
+            }
+
+            sched.frame(
+                K({ kparams }),
+                make_sched_params(pixel_sampler::jittered_type{}, cam, accum_rt),
+                ++frame_num
+                );
+
+            history.accumulate(pool, accum_rt, cam);
+        }
+        else
+        {
+            sched.frame(
+                K({ kparams }),
+                make_sched_params(pixel_sampler::jittered_blend_type{}, cam, accum_rt),
+                ++frame_num
+                );
+        }
+
+        if (params.denoise)
+        {
+            filter.denoise<S>(pool, accum_rt, rt.color());
+        }
+        else
+        {
+            std::copy(accum_rt.color(), accum_rt.color() + rt.width() * rt.height(), rt.color());
+        }
+    }
+    else
+    {
+        call_kernel( params.algo, sched, kparams, frame_num, params.ssaa_samples, cam, rt );
+    }
+}
+
+} // visionaray
+
+#endif // VSNRAY_VIEWER_RENDER_IMPL_H
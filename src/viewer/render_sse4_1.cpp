@@ -0,0 +1,25 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/simd/intrinsics.h>
+
+#if !VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE4_1)
+#error "render_sse4_1.cpp must be compiled with -msse4.1"
+#endif
+
+#include "render_impl.h"
+
+namespace visionaray
+{
+
+void render_cpu_sse4_1(
+        render_params const&        params,
+        unsigned&                   frame_num,
+        pinhole_camera const&       cam,
+        host_render_target_type&    rt
+        )
+{
+    render_cpu_impl<simd::float4>(params, frame_num, cam, rt);
+}
+
+} // visionaray
@@ -46,8 +46,10 @@
 #include <visionaray/gl/debug_callback.h>
 #include <visionaray/texture/texture.h>
 #include <visionaray/aligned_vector.h>
+#include <visionaray/async_bvh_builder.h>
 #include <visionaray/bvh.h>
 #include <visionaray/cpu_buffer_rt.h>
+#include <visionaray/cpu_features.h>
 #include <visionaray/generic_material.h>
 #include <visionaray/kernels.h>
 #include <visionaray/material.h>
@@ -55,10 +57,6 @@
 #include <visionaray/point_light.h>
 #include <visionaray/scheduler.h>
 
-#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
-#include <visionaray/detail/tbb_sched.h>
-#endif
-
 #ifdef __CUDACC__
 #include <visionaray/gpu_buffer_rt.h>
 #include <visionaray/pixel_unpack_buffer_rt.h>
@@ -78,20 +76,14 @@
 #include <common/cuda.h>
 #endif
 
+#include "render.h"
+
 
 using namespace visionaray;
 
 using viewer_type = viewer_glut;
 
 
-//-------------------------------------------------------------------------------------------------
-// Switch to use simple but fast plastic material, or a generic material container with
-// support for emissive objects
-//
-
-#define USE_PLASTIC_MATERIAL 1
-
-
 //-------------------------------------------------------------------------------------------------
 // Renderer, stores state, geometry, normals, ...
 //
@@ -99,31 +91,17 @@ using viewer_type = viewer_glut;
 struct renderer : viewer_type
 {
 
-//  using scalar_type_cpu           = float;
-    using scalar_type_cpu           = simd::float4;
-//  using scalar_type_cpu           = simd::float8;
-//  using scalar_type_cpu           = simd::float16;
+    // CPU packet types are chosen at runtime, see render.h
     using scalar_type_gpu           = float;
-    using ray_type_cpu              = basic_ray<scalar_type_cpu>;
     using ray_type_gpu              = basic_ray<scalar_type_gpu>;
 
-    using primitive_type            = model::triangle_type;
-    using normal_type               = model::normal_type;
-    using tex_coord_type            = model::tex_coord_type;
-#if USE_PLASTIC_MATERIAL
-    using material_type             = plastic<float>;
-#else
-    using material_type             = generic_material<
-                                            emissive<float>,
-                                            glass<float>,
-                                            matte<float>,
-                                            mirror<float>,
-                                            plastic<float>
-                                            >;
-#endif
+    using primitive_type            = visionaray::primitive_type;
+    using normal_type               = visionaray::normal_type;
+    using tex_coord_type            = visionaray::tex_coord_type;
+    using material_type             = visionaray::material_type;
 
-    using host_render_target_type   = cpu_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
-    using host_bvh_type             = index_bvh<primitive_type>;
+    using host_render_target_type   = visionaray::host_render_target_type;
+    using host_bvh_type             = visionaray::host_bvh_type;
 #ifdef __CUDACC__
     using device_render_target_type = pixel_unpack_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
     using device_bvh_type           = cuda_index_bvh<primitive_type>;
@@ -149,10 +127,18 @@ struct renderer : viewer_type
         SRGB
     };
 
+    enum isa_variant
+    {
+        Auto = 0,   // Best variant the CPU supports
+        Baseline,   // Built with the viewer's compiler flags
+        SSE4_1,
+        AVX2,
+        AVX512F
+    };
+
 
     renderer()
         : viewer_type(800, 800, "Visionaray Viewer")
-        , host_sched(std::thread::hardware_concurrency())
 #ifdef __CUDACC__
         , device_sched(8, 8)
 #endif
@@ -210,6 +196,22 @@ struct renderer : viewer_type
             cl::init(this->ssaa_samples)
             ) );
 
+        add_cmdline_option( cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "denoise",
+            cl::Desc("Denoise path traced images (CPU only)"),
+            cl::ArgDisallowed,
+            cl::init(this->denoise)
+            ) );
+
+        add_cmdline_option( cl::makeOption<bool&>(
+            cl::Parser<>(),
+            "temporal",
+            cl::Desc("Reproject path traced samples when the camera moves (CPU only)"),
+            cl::ArgDisallowed,
+            cl::init(this->temporal)
+            ) );
+
         add_cmdline_option( cl::makeOption<vec3&, cl::ScalarType>(
             [&](StringRef name, StringRef /*arg*/, vec3& value)
             {
@@ -223,6 +225,19 @@ struct renderer : viewer_type
             cl::init(this->ambient)
             ) );
 
+        add_cmdline_option( cl::makeOption<isa_variant&>({
+                { "auto",               Auto,           "Best instruction set the CPU supports" },
+                { "baseline",           Baseline,       "Instruction set the viewer was compiled for, 4-wide packets" },
+                { "sse4_1",             SSE4_1,         "SSE 4.1, 4-wide packets" },
+                { "avx2",               AVX2,           "AVX2, 8-wide packets" },
+                { "avx512f",            AVX512F,        "AVX-512F, 16-wide packets" }
+            },
+            "isa",
+            cl::Desc("Instruction set for CPU rendering"),
+            cl::ArgRequired,
+            cl::init(this->isa)
+            ) );
+
         add_cmdline_option( cl::makeOption<color_space&>({
                 { "rgb",                RGB,            "RGB color space for display" },
                 { "srgb",               SRGB,           "sRGB color space for display" },
@@ -255,9 +270,14 @@ struct renderer : viewer_type
     bvh_build_strategy                          builder         = Binned;
     device_type                                 dev_type        = CPU;
     color_space                                 col_space       = SRGB;
+    isa_variant                                 isa             = Auto;
     bool                                        show_hud        = true;
     bool                                        show_hud_ext    = true;
     bool                                        show_bvh        = false;
+    bool                                        show_heatmap    = false;
+    bool                                        denoise         = false;
+    bool                                        temporal        = false;
+    heatmap::counter_type                       heatmap_counter = heatmap::Nodes;
 
 
     std::string                                 filename;
@@ -266,7 +286,7 @@ struct renderer : viewer_type
     model                                       mod;
     vec3                                        ambient         = vec3(-1.0f);
 
-    host_bvh_type                               host_bvh;
+    async_bvh_builder<host_bvh_type>            host_bvh;
     aligned_vector<material_type>               host_materials;
 #ifdef __CUDACC__
     device_bvh_type                             device_bvh;
@@ -277,11 +297,7 @@ struct renderer : viewer_type
     thrust::device_vector<device_tex_ref_type>  device_textures;
 #endif
 
-#if defined(__INTEL_COMPILER) || defined(__MINGW32__) || defined(__MINGW64__)
-    tbb_sched<ray_type_cpu>                     host_sched;
-#else
-    tiled_sched<ray_type_cpu>                   host_sched;
-#endif
+    render_cpu_func                             render_cpu      = render_cpu_default;
     host_render_target_type                     host_rt;
 #ifdef __CUDACC__
     cuda_sched<ray_type_gpu>                    device_sched;
@@ -292,9 +308,14 @@ struct renderer : viewer_type
     mouse::pos                                  mouse_pos;
 
     visionaray::frame_counter                   counter;
+    traversal_statistics                        trav_stats;
+    traversal_counters                          trav_counters;
     gl::bvh_outline_renderer                    outlines;
     gl::debug_callback                          gl_debug_callback;
 
+    // Selects the CPU render function for isa, falls back to Auto if not available
+    void select_isa(isa_variant variant);
+
 protected:
 
     void on_close();
@@ -378,6 +399,104 @@ std::ostream& operator<<(std::ostream& out, pinhole_camera const& cam)
 }
 
 
+//-------------------------------------------------------------------------------------------------
+// CPU render variants, ordered from least to most capable
+//
+
+struct isa_variant_info
+{
+    renderer::isa_variant   variant;
+    simd_isa                required;
+    char const*             name;
+    char const*             packet;
+    render_cpu_func         func;
+};
+
+static const isa_variant_info isa_variants[] = {
+    { renderer::Baseline,   ISA_Scalar,     "Baseline",     "float4",   render_cpu_default  },
+#if VSNRAY_VIEWER_ISA_DISPATCH
+    { renderer::SSE4_1,     ISA_SSE4_1,     "SSE4.1",       "float4",   render_cpu_sse4_1   },
+    { renderer::AVX2,       ISA_AVX2,       "AVX2",         "float8",   render_cpu_avx2     },
+    { renderer::AVX512F,    ISA_AVX512F,    "AVX-512F",     "float16",  render_cpu_avx512f  },
+#endif
+};
+
+static const size_t num_isa_variants = sizeof(isa_variants) / sizeof(isa_variants[0]);
+
+static isa_variant_info const& get_isa_variant_info(renderer::isa_variant variant)
+{
+    for (auto const& info : isa_variants)
+    {
+        if (info.variant == variant)
+        {
+            return info;
+        }
+    }
+
+    return isa_variants[0];
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Traversal heatmap counters
+//
+
+static char const* get_heatmap_counter_name(heatmap::counter_type counter)
+{
+    switch (counter)
+    {
+    case heatmap::Nodes:        return "nodes";
+    case heatmap::Boxes:        return "box tests";
+    case heatmap::Primitives:   return "primitive tests";
+    case heatmap::StackDepth:   return "stack depth";
+    }
+
+    return "";
+}
+
+// Count that maps to red
+static float get_heatmap_max_count(heatmap::counter_type counter)
+{
+    switch (counter)
+    {
+    case heatmap::Nodes:        return 128.0f;
+    case heatmap::Boxes:        return 256.0f;
+    case heatmap::Primitives:   return 64.0f;
+    case heatmap::StackDepth:   return 32.0f;
+    }
+
+    return 1.0f;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Select the CPU render variant
+//
+
+void renderer::select_isa(isa_variant variant)
+{
+    isa_variant_info const* selected = nullptr;
+
+    for (auto const& info : isa_variants)
+    {
+        if ((variant == Auto || variant == info.variant) && cpu_supports(info.required))
+        {
+            selected = &info;
+        }
+    }
+
+    if (selected == nullptr)
+    {
+        std::cerr << "Instruction set not built or not supported by the CPU, choosing automatically\n";
+        select_isa(Auto);
+        return;
+    }
+
+    isa = selected->variant;
+    render_cpu = selected->func;
+}
+
+
 //-------------------------------------------------------------------------------------------------
 // If path tracing, clear frame buffer and reset frame counter
 //
@@ -415,18 +534,21 @@ void renderer::render_hud()
     int num_nodes = 0;
     int num_leaves = 0;
 
-    traverse_depth_first(
-        host_bvh,
-        [&](renderer::host_bvh_type::node_type const& node)
-        {
-            ++num_nodes;
-
-            if (is_leaf(node))
+    if (host_bvh.tree().num_nodes() > 0)
+    {
+        traverse_depth_first(
+            host_bvh.tree(),
+            [&](renderer::host_bvh_type::node_type const& node)
             {
-                ++num_leaves;
+                ++num_nodes;
+
+                if (is_leaf(node))
+                {
+                    ++num_leaves;
+                }
             }
-        }
-        );
+            );
+    }
 
 
     // render
@@ -482,10 +604,22 @@ void renderer::render_hud()
     hud.clear_buffer();
 
     hud.buffer() << "# BVH Nodes/Leaves: " << num_nodes << '/' << num_leaves;
+    if (host_bvh.busy())
+    {
+        hud.buffer() << " (building: " << static_cast<int>(host_bvh.progress() * 100.0f) << "%)";
+    }
     hud.print_buffer(300, h * 2 - 68);
     hud.clear_buffer();
 
     hud.buffer() << "SPP: " << std::max(1U, frame_num);
+    if (temporal && algo == Pathtracing && dev_type == renderer::CPU)
+    {
+        hud.buffer() << " (reprojected)";
+    }
+    if (denoise && algo == Pathtracing && dev_type == renderer::CPU)
+    {
+        hud.buffer() << " (denoised)";
+    }
     hud.print_buffer(300, h * 2 - 102);
     hud.clear_buffer();
 
@@ -493,6 +627,29 @@ void renderer::render_hud()
     hud.print_buffer(300, h * 2 - 136);
     hud.clear_buffer();
 
+    auto const& isa_info = get_isa_variant_info(isa);
+    hud.buffer() << "CPU ISA: " << isa_info.name << " (" << isa_info.packet << ')';
+    hud.print_buffer(300, h * 2 - 170);
+    hud.clear_buffer();
+
+    if (show_heatmap && dev_type == renderer::CPU && trav_counters.rays > 0)
+    {
+        double rays = static_cast<double>(trav_counters.rays);
+
+        hud.buffer() << "Heatmap: " << get_heatmap_counter_name(heatmap_counter)
+                     << " (red: " << static_cast<int>(get_heatmap_max_count(heatmap_counter)) << ')';
+        hud.print_buffer(300, h * 2 - 204);
+        hud.clear_buffer();
+
+        hud.buffer() << "Per " << isa_info.packet << ": "
+                     << trav_counters.nodes / rays << " nodes, "
+                     << trav_counters.boxes / rays << " boxes, "
+                     << trav_counters.prims / rays << " prims, "
+                     << "max. depth " << trav_counters.max_stack_depth;
+        hud.print_buffer(300, h * 2 - 238);
+        hud.clear_buffer();
+    }
+
 
     glPopMatrix();
     glMatrixMode(GL_PROJECTION);
@@ -507,7 +664,20 @@ void renderer::on_close()
 
 void renderer::on_display()
 {
-    using light_type = point_light<float>;
+    // Swap in a finished BVH between frames
+    if (host_bvh.swap())
+    {
+        std::cout << "BVH ready (" << host_bvh.build_time() << "s)\n";
+
+        if (show_bvh)
+        {
+            outlines.destroy();
+            outlines.init(host_bvh.tree());
+        }
+
+        counter.reset();
+        clear_frame();
+    }
 
     aligned_vector<light_type> host_lights;
 
@@ -560,25 +730,36 @@ void renderer::on_display()
 #ifndef __CUDA_ARCH__
         aligned_vector<renderer::host_bvh_type::bvh_ref> host_primitives;
 
-        host_primitives.push_back(host_bvh.ref());
-
-        auto kparams = make_kernel_params(
-                normals_per_face_binding{},
-                host_primitives.data(),
-                host_primitives.data() + host_primitives.size(),
-                mod.geometric_normals.data(),
-//              mod.tex_coords.data(),
-                host_materials.data(),
-//              mod.textures.data(),
-                host_lights.data(),
-                host_lights.data() + host_lights.size(),
-                bounces,
-                epsilon,
-                vec4(background_color(), 1.0f),
-                amb
-                );
+        // Nothing is rendered until the first BVH is ready
+        if (host_bvh.tree().num_nodes() > 0)
+        {
+            host_primitives.push_back(host_bvh.tree().ref());
+        }
 
-        call_kernel( algo, host_sched, kparams, frame_num, ssaa_samples, cam, host_rt );
+        render_params params;
+        params.primitives_begin = host_primitives.data();
+        params.primitives_end   = host_primitives.data() + host_primitives.size();
+        params.normals          = mod.geometric_normals.data();
+        params.materials        = host_materials.data();
+        params.lights_begin     = host_lights.data();
+        params.lights_end       = host_lights.data() + host_lights.size();
+        params.bounces          = bounces;
+        params.epsilon          = epsilon;
+        params.background       = vec4(background_color(), 1.0f);
+        params.ambient          = amb;
+        params.algo             = algo;
+        params.ssaa_samples     = ssaa_samples;
+        params.num_threads      = std::thread::hardware_concurrency();
+        params.denoise          = denoise;
+        params.temporal         = temporal;
+        params.heatmap          = show_heatmap;
+        params.heatmap_counter  = heatmap_counter;
+        params.heatmap_max      = get_heatmap_max_count(heatmap_counter);
+        params.stats            = &trav_stats;
+
+        trav_stats.reset();
+        render_cpu( params, frame_num, cam, host_rt );
+        trav_counters = trav_stats.accumulate();
 #endif
     }
 
@@ -652,12 +833,40 @@ void renderer::on_key_press(key_event const& event)
         clear_frame();
         break;
 
+    case '4':
+        // Off -> nodes -> boxes -> primitives -> stack depth -> off
+        if (!show_heatmap)
+        {
+            show_heatmap = true;
+            heatmap_counter = heatmap::Nodes;
+        }
+        else if (heatmap_counter == heatmap::StackDepth)
+        {
+            show_heatmap = false;
+        }
+        else
+        {
+            heatmap_counter = static_cast<heatmap::counter_type>(heatmap_counter + 1);
+        }
+
+        if (show_heatmap)
+        {
+            std::cout << "Traversal heatmap: " << get_heatmap_counter_name(heatmap_counter) << '\n';
+        }
+        else
+        {
+            std::cout << "Traversal heatmap: off\n";
+        }
+        counter.reset();
+        clear_frame();
+        break;
+
     case 'b':
         show_bvh = !show_bvh;
 
-        if (show_bvh)
+        if (show_bvh && host_bvh.tree().num_nodes() > 0)
         {
-            outlines.init(host_bvh);
+            outlines.init(host_bvh.tree());
         }
 
         break;
@@ -673,10 +882,39 @@ void renderer::on_key_press(key_event const& event)
         }
         break;
 
+    case 'd':
+        denoise = !denoise;
+        std::cout << "Denoiser: " << (denoise ? "on" : "off") << '\n';
+        counter.reset();
+        clear_frame();
+        break;
+
      case 'h':
         show_hud = !show_hud;
         break;
 
+    case 'i':
+        {
+            // Cycle through the CPU render variants the CPU supports
+            size_t index = 0;
+            while (isa_variants[index].variant != isa)
+            {
+                ++index;
+            }
+
+            do
+            {
+                index = (index + 1) % num_isa_variants;
+            }
+            while (!cpu_supports(isa_variants[index].required));
+
+            select_isa(isa_variants[index].variant);
+            std::cout << "Switching instruction set: " << isa_variants[index].name << '\n';
+            counter.reset();
+            clear_frame();
+        }
+        break;
+
    case 'm':
 #ifdef __CUDACC__
         if (dev_type == renderer::CPU)
@@ -706,6 +944,13 @@ void renderer::on_key_press(key_event const& event)
         }
         break;
 
+    case 't':
+        temporal = !temporal;
+        std::cout << "Temporal reprojection: " << (temporal ? "on" : "off") << '\n';
+        counter.reset();
+        clear_frame();
+        break;
+
     case 'u':
         {
             std::ofstream file( camera_filename );
@@ -739,7 +984,10 @@ void renderer::on_key_press(key_event const& event)
 
 void renderer::on_mouse_move(visionaray::mouse_event const& event)
 {
-    if (event.buttons() != mouse::NoButton)
+    // Temporal reprojection keeps the accumulated samples
+    bool reproject = temporal && algo == Pathtracing && dev_type == renderer::CPU;
+
+    if (event.buttons() != mouse::NoButton && !reproject)
     {
         clear_frame();
     }
@@ -785,6 +1033,9 @@ int main(int argc, char** argv)
 
     rend.gl_debug_callback.activate();
 
+    rend.select_isa(rend.isa);
+    std::cout << "CPU instruction set: " << get_isa_variant_info(rend.isa).name << '\n';
+
     // Load the scene
     std::cout << "Loading model...\n";
 
@@ -864,22 +1115,25 @@ int main(int argc, char** argv)
 
 //  timer t;
 
-    std::cout << "Creating BVH...\n";
+    std::cout << "Creating BVH in the background...\n";
 
-    // Create the BVH on the host
-    rend.host_bvh = build<renderer::host_bvh_type>(
+    // Create the BVH on the host, rendering starts right away and the BVH
+    // is swapped in when it is ready
+    rend.host_bvh.build(
             rend.mod.primitives.data(),
             rend.mod.primitives.size(),
             rend.builder == renderer::Split
             );
 
-    std::cout << "Ready\n";
-
 #ifdef __CUDACC__
+    // The GPU BVH is a copy of the host BVH
+    rend.host_bvh.wait();
+    rend.host_bvh.swap();
+
     // Copy data to GPU
     try
     {
-        rend.device_bvh = renderer::device_bvh_type(rend.host_bvh);
+        rend.device_bvh = renderer::device_bvh_type(rend.host_bvh.tree());
         rend.device_normals = rend.mod.geometric_normals;
         rend.device_tex_coords = rend.mod.tex_coords;
         rend.device_materials = rend.host_materials;
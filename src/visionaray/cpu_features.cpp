@@ -0,0 +1,164 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstdint>
+
+#include <visionaray/detail/compiler.h>
+#include <visionaray/cpu_features.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define VSNRAY_CPU_FEATURES_X86 1
+#if VSNRAY_CXX_MSVC
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+#else
+#define VSNRAY_CPU_FEATURES_X86 0
+#endif
+
+
+namespace visionaray
+{
+
+//-------------------------------------------------------------------------------------------------
+// cpuid / xgetbv wrappers
+//
+
+#if VSNRAY_CPU_FEATURES_X86
+
+namespace
+{
+
+struct cpuid_regs
+{
+    uint32_t eax;
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+};
+
+cpuid_regs cpuid(uint32_t leaf, uint32_t subleaf = 0)
+{
+    cpuid_regs r = { 0, 0, 0, 0 };
+
+#if VSNRAY_CXX_MSVC
+    int regs[4];
+    __cpuidex(regs, static_cast<int>(leaf), static_cast<int>(subleaf));
+    r.eax = static_cast<uint32_t>(regs[0]);
+    r.ebx = static_cast<uint32_t>(regs[1]);
+    r.ecx = static_cast<uint32_t>(regs[2]);
+    r.edx = static_cast<uint32_t>(regs[3]);
+#else
+    if (leaf > __get_cpuid_max(0, nullptr))
+    {
+        return r;
+    }
+
+    __cpuid_count(leaf, subleaf, r.eax, r.ebx, r.ecx, r.edx);
+#endif
+
+    return r;
+}
+
+// Extended control register 0, tells which register states the OS saves.
+// Only call if cpuid reports OSXSAVE.
+uint64_t xgetbv0()
+{
+#if VSNRAY_CXX_MSVC
+    return _xgetbv(0);
+#else
+    // Encoded, so that no -mxsave is needed
+    uint32_t lo = 0;
+    uint32_t hi = 0;
+    __asm__ __volatile__ (".byte 0x0f, 0x01, 0xd0" : "=a"(lo), "=d"(hi) : "c"(0));
+    return (static_cast<uint64_t>(hi) << 32) | lo;
+#endif
+}
+
+simd_isa detect_simd_isa()
+{
+    cpuid_regs r1 = cpuid(1);
+
+    bool sse2   = (r1.edx & (1U << 26)) != 0;
+    bool sse4_1 = (r1.ecx & (1U << 19)) != 0;
+    bool xsave  = (r1.ecx & (1U << 27)) != 0; // OSXSAVE
+    bool avx    = (r1.ecx & (1U << 28)) != 0;
+
+    if (!sse2)
+    {
+        return ISA_Scalar;
+    }
+
+    if (!sse4_1)
+    {
+        return ISA_SSE2;
+    }
+
+    // XMM and YMM state
+    uint64_t xcr0 = xsave ? xgetbv0() : 0;
+
+    if (!avx || (xcr0 & 0x6) != 0x6)
+    {
+        return ISA_SSE4_1;
+    }
+
+    cpuid_regs r7 = cpuid(7);
+
+    bool avx2    = (r7.ebx & (1U << 5)) != 0;
+    bool avx512f = (r7.ebx & (1U << 16)) != 0;
+
+    if (!avx2)
+    {
+        return ISA_AVX;
+    }
+
+    // Additionally opmask and ZMM state
+    if (!avx512f || (xcr0 & 0xE6) != 0xE6)
+    {
+        return ISA_AVX2;
+    }
+
+    return ISA_AVX512F;
+}
+
+} // namespace
+
+#endif // VSNRAY_CPU_FEATURES_X86
+
+
+//-------------------------------------------------------------------------------------------------
+// Public interface
+//
+
+bool cpu_supports(simd_isa isa)
+{
+    return isa <= best_simd_isa();
+}
+
+simd_isa best_simd_isa()
+{
+#if VSNRAY_CPU_FEATURES_X86
+    static const simd_isa isa = detect_simd_isa();
+    return isa;
+#else
+    return ISA_Scalar;
+#endif
+}
+
+char const* simd_isa_name(simd_isa isa)
+{
+    switch (isa)
+    {
+    case ISA_Scalar:    return "Scalar";
+    case ISA_SSE2:      return "SSE2";
+    case ISA_SSE4_1:    return "SSE4.1";
+    case ISA_AVX:       return "AVX";
+    case ISA_AVX2:      return "AVX2";
+    case ISA_AVX512F:   return "AVX-512F";
+    }
+
+    return "Unknown";
+}
+
+} // visionaray
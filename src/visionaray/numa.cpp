@@ -0,0 +1,383 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <visionaray/detail/platform.h>
+#include <visionaray/numa.h>
+
+#if VSNRAY_OS_LINUX
+#include <dirent.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+
+namespace visionaray
+{
+
+namespace
+{
+
+//-------------------------------------------------------------------------------------------------
+// Single node with all CPUs, used when there is no NUMA information
+//
+
+std::vector<numa_node> default_topology()
+{
+    numa_node node;
+    node.id = 0;
+
+    unsigned num_cpus = std::max(std::thread::hardware_concurrency(), 1U);
+
+    for (unsigned i = 0; i < num_cpus; ++i)
+    {
+        node.cpus.push_back(i);
+    }
+
+    return std::vector<numa_node>(1, node);
+}
+
+
+#if VSNRAY_OS_LINUX
+
+//-------------------------------------------------------------------------------------------------
+// Parse a sysfs cpu list, e.g. "0-3,8-11"
+//
+
+std::vector<unsigned> parse_cpu_list(std::string const& str)
+{
+    std::vector<unsigned> result;
+
+    std::stringstream ss(str);
+    std::string item;
+
+    while (std::getline(ss, item, ','))
+    {
+        if (item.empty() || item == "\n")
+        {
+            continue;
+        }
+
+        unsigned first = 0;
+        unsigned last = 0;
+
+        auto dash = item.find('-');
+
+        try
+        {
+            if (dash == std::string::npos)
+            {
+                first = last = static_cast<unsigned>(std::stoul(item));
+            }
+            else
+            {
+                first = static_cast<unsigned>(std::stoul(item.substr(0, dash)));
+                last  = static_cast<unsigned>(std::stoul(item.substr(dash + 1)));
+            }
+        }
+        catch (...)
+        {
+            continue;
+        }
+
+        for (unsigned cpu = first; cpu <= last; ++cpu)
+        {
+            result.push_back(cpu);
+        }
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// mbind() system call, constants from <numaif.h>
+//
+
+enum
+{
+    MpolBind        = 2,
+    MpolInterleave  = 3,
+    MpolMfMove      = 1 << 1
+};
+
+// Supports node ids < 1024
+static const size_t MaxNodes = 1024;
+static const size_t BitsPerLong = sizeof(unsigned long) * 8;
+
+bool mbind_nodes(void const* addr, size_t len, int mode, std::vector<unsigned> const& node_ids)
+{
+    if (len == 0 || node_ids.empty())
+    {
+        return false;
+    }
+
+    unsigned long mask[MaxNodes / BitsPerLong] = {};
+
+    for (auto id : node_ids)
+    {
+        if (id >= MaxNodes)
+        {
+            return false;
+        }
+
+        mask[id / BitsPerLong] |= 1UL << (id % BitsPerLong);
+    }
+
+    // Round inward to page boundaries. Pages that are only partially covered
+    // may hold unrelated data, which MPOL_MF_MOVE would migrate as well
+    auto page_size = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+    auto first = (reinterpret_cast<uintptr_t>(addr) + page_size - 1) & ~(page_size - 1);
+    auto last  = (reinterpret_cast<uintptr_t>(addr) + len) & ~(page_size - 1);
+
+    if (last <= first)
+    {
+        // No complete page, nothing to do
+        return true;
+    }
+
+    long res = syscall(
+            SYS_mbind,
+            reinterpret_cast<void*>(first),
+            static_cast<unsigned long>(last - first),
+            mode,
+            mask,
+            static_cast<unsigned long>(MaxNodes + 1),
+            static_cast<unsigned>(MpolMfMove)
+            );
+
+    return res == 0;
+}
+
+#endif // VSNRAY_OS_LINUX
+
+} // anonymous namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// NUMA topology
+//
+
+std::vector<numa_node> numa_topology()
+{
+#if VSNRAY_OS_LINUX
+    std::vector<numa_node> nodes;
+
+    DIR* dir = opendir("/sys/devices/system/node");
+
+    if (dir == nullptr)
+    {
+        return default_topology();
+    }
+
+    while (dirent* entry = readdir(dir))
+    {
+        std::string name(entry->d_name);
+
+        if (name.size() <= 4 || name.compare(0, 4, "node") != 0
+         || name.find_first_not_of("0123456789", 4) != std::string::npos)
+        {
+            continue;
+        }
+
+        std::ifstream file("/sys/devices/system/node/" + name + "/cpulist");
+        std::string cpulist;
+        std::getline(file, cpulist);
+
+        numa_node node;
+        node.id = static_cast<unsigned>(std::stoul(name.substr(4)));
+        node.cpus = parse_cpu_list(cpulist);
+
+        // Skip memory-only nodes
+        if (!node.cpus.empty())
+        {
+            nodes.push_back(node);
+        }
+    }
+
+    closedir(dir);
+
+    if (nodes.empty())
+    {
+        return default_topology();
+    }
+
+    std::sort(
+            nodes.begin(),
+            nodes.end(),
+            [](numa_node const& a, numa_node const& b) { return a.id < b.id; }
+            );
+
+    return nodes;
+#else
+    return default_topology();
+#endif
+}
+
+unsigned current_numa_node()
+{
+#if VSNRAY_OS_LINUX && defined(SYS_getcpu)
+    unsigned cpu = 0;
+    unsigned node = 0;
+
+    if (syscall(SYS_getcpu, &cpu, &node, nullptr) == 0)
+    {
+        return node;
+    }
+#endif
+
+    return 0;
+}
+
+bool run_on_numa_node(numa_node const& node)
+{
+#if VSNRAY_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+
+    for (auto cpu : node.cpus)
+    {
+        CPU_SET(cpu, &set);
+    }
+
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    static_cast<void>(node);
+    return false;
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Thread placement
+//
+
+thread_affinity make_thread_affinity(
+        unsigned                        num_threads,
+        thread_pinning                  pinning,
+        std::vector<numa_node> const&   nodes
+        )
+{
+    thread_affinity result;
+
+    if (pinning == PinNone || nodes.empty())
+    {
+        return result;
+    }
+
+    size_t num_cpus = 0;
+    for (auto const& n : nodes)
+    {
+        num_cpus += n.cpus.size();
+    }
+
+    if (num_cpus == 0)
+    {
+        return result;
+    }
+
+    for (unsigned i = 0; i < num_threads; ++i)
+    {
+        size_t node_index = 0;
+        size_t cpu_index = 0;
+
+        if (pinning == PinCompact)
+        {
+            // i-th CPU in node order
+            size_t k = i % num_cpus;
+
+            while (k >= nodes[node_index].cpus.size())
+            {
+                k -= nodes[node_index].cpus.size();
+                ++node_index;
+            }
+
+            cpu_index = k;
+        }
+        else // PinScatter
+        {
+            node_index = i % nodes.size();
+            cpu_index = (i / nodes.size()) % std::max(nodes[node_index].cpus.size(), size_t(1));
+        }
+
+        auto const& cpus = nodes[node_index].cpus;
+
+        result.cpus.push_back(cpus.empty() ? -1 : static_cast<int>(cpus[cpu_index]));
+        result.domains.push_back(static_cast<unsigned>(node_index));
+    }
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Memory placement
+//
+
+bool numa_bind(void const* addr, size_t len, numa_node const& node)
+{
+#if VSNRAY_OS_LINUX
+    return mbind_nodes(addr, len, MpolBind, std::vector<unsigned>(1, node.id));
+#else
+    static_cast<void>(addr);
+    static_cast<void>(len);
+    static_cast<void>(node);
+    return false;
+#endif
+}
+
+bool numa_interleave(void const* addr, size_t len, std::vector<numa_node> const& nodes)
+{
+#if VSNRAY_OS_LINUX
+    std::vector<unsigned> ids;
+
+    for (auto const& n : nodes)
+    {
+        ids.push_back(n.id);
+    }
+
+    return mbind_nodes(addr, len, MpolInterleave, ids);
+#else
+    static_cast<void>(addr);
+    static_cast<void>(len);
+    static_cast<void>(nodes);
+    return false;
+#endif
+}
+
+bool numa_distribute(void const* addr, size_t len, std::vector<numa_node> const& nodes)
+{
+    if (nodes.empty())
+    {
+        return false;
+    }
+
+    bool ok = true;
+
+    auto first = static_cast<char const*>(addr);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        size_t band_first = len * i / nodes.size();
+        size_t band_last  = len * (i + 1) / nodes.size();
+
+        if (band_last > band_first)
+        {
+            ok &= numa_bind(first + band_first, band_last - band_first, nodes[i]);
+        }
+    }
+
+    return ok;
+}
+
+} // visionaray
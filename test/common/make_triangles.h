@@ -0,0 +1,51 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEST_COMMON_MAKE_TRIANGLES_H
+#define VSNRAY_TEST_COMMON_MAKE_TRIANGLES_H 1
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Small random triangles in the unit cube
+//
+// Edge vectors are in [-size/2..size/2], prim_id is the triangle index
+//
+
+inline visionaray::aligned_vector<visionaray::basic_triangle<3, float>> make_triangles(
+        size_t      count,
+        float       size = 0.1f,
+        unsigned    seed = 0
+        )
+{
+    using namespace visionaray;
+
+    using triangle_t = basic_triangle<3, float>;
+
+    std::default_random_engine rng(seed);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v(dist(rng), dist(rng), dist(rng));
+        vec3 e1 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+        vec3 e2 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+
+        triangles[i] = triangle_t(v, e1, e2);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+#endif // VSNRAY_TEST_COMMON_MAKE_TRIANGLES_H
@@ -0,0 +1,152 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#pragma once
+
+#ifndef VSNRAY_TEST_COMMON_TEST_SCENE_H
+#define VSNRAY_TEST_COMMON_TEST_SCENE_H 1
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/kernels.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/point_light.h>
+
+
+//-------------------------------------------------------------------------------------------------
+// Triangle scene for kernel and scheduler tests
+//
+// Each quad gets its own geometry id and material (normals_per_face_binding).
+// Tests derive their scene from this, add geometry and lights in the
+// constructor and call build() at the end. Not copyable, the BVH refs point
+// into the scene.
+//
+
+template <typename Material>
+struct basic_test_scene
+{
+    using triangle_type = visionaray::basic_triangle<3, float>;
+    using bvh_type      = visionaray::index_bvh<triangle_type>;
+
+    visionaray::aligned_vector<triangle_type>                       triangles;
+    visionaray::aligned_vector<visionaray::vec3>                    normals;
+    visionaray::aligned_vector<Material>                            materials;
+    visionaray::aligned_vector<visionaray::point_light<float>>      lights;
+    bvh_type                                                        bvh;
+    visionaray::aligned_vector<typename bvh_type::bvh_ref>          refs;
+
+    visionaray::pinhole_camera                                      cam;
+
+    basic_test_scene() = default;
+    basic_test_scene(basic_test_scene const&) = delete;
+    basic_test_scene& operator=(basic_test_scene const&) = delete;
+
+    // Quad v1,v2,v3,v4 (counter-clockwise, seen from the front)
+    void add_quad(
+            visionaray::vec3 const& v1,
+            visionaray::vec3 const& v2,
+            visionaray::vec3 const& v3,
+            visionaray::vec3 const& v4,
+            Material const&         mat
+            )
+    {
+        triangle_type t1(v1, v2 - v1, v3 - v1);
+        triangle_type t2(v1, v3 - v1, v4 - v1);
+
+        int geom_id = static_cast<int>(materials.size());
+
+        t1.prim_id = static_cast<int>(triangles.size());
+        t2.prim_id = static_cast<int>(triangles.size() + 1);
+        t1.geom_id = t2.geom_id = geom_id;
+
+        triangles.push_back(t1);
+        triangles.push_back(t2);
+
+        visionaray::vec3 n = normalize(cross(v2 - v1, v3 - v1));
+        normals.push_back(n);
+        normals.push_back(n);
+
+        materials.push_back(mat);
+    }
+
+    // Triangle soup (e.g. from make_triangles()) w/ a single material
+    void add_triangles(visionaray::aligned_vector<triangle_type> const& tris, Material const& mat)
+    {
+        int geom_id = static_cast<int>(materials.size());
+
+        for (auto t : tris)
+        {
+            t.prim_id = static_cast<int>(triangles.size());
+            t.geom_id = geom_id;
+
+            triangles.push_back(t);
+            normals.push_back(normalize(cross(t.e1, t.e2)));
+        }
+
+        materials.push_back(mat);
+    }
+
+    void add_point_light(visionaray::vec3 const& pos)
+    {
+        visionaray::point_light<float> light;
+        light.set_cl(visionaray::vec3(1.0f));
+        light.set_kl(1.0f);
+        light.set_position(pos);
+        lights.push_back(light);
+    }
+
+    void build()
+    {
+        bvh = visionaray::build<bvh_type>(triangles.data(), triangles.size());
+        refs.assign(1, bvh.ref());
+    }
+
+    void look_at(int width, int height, float fovy_degrees, visionaray::vec3 const& eye, visionaray::vec3 const& center)
+    {
+        cam.set_viewport(0, 0, width, height);
+        cam.perspective(
+                fovy_degrees * visionaray::constants::degrees_to_radians<float>(),
+                width / static_cast<float>(height),
+                0.1f,
+                10.0f
+                );
+        cam.look_at(eye, center, visionaray::vec3(0.0f, 1.0f, 0.0f));
+    }
+
+    auto params(
+            unsigned                num_bounces,
+            visionaray::vec4 const& bg_color = visionaray::vec4(0.0f),
+            visionaray::vec4 const& ambient_color = visionaray::vec4(0.0f)
+            ) const
+        -> decltype(visionaray::make_kernel_params(
+                visionaray::normals_per_face_binding{},
+                refs.data(),
+                refs.data(),
+                normals.data(),
+                materials.data(),
+                lights.data(),
+                lights.data(),
+                num_bounces,
+                1E-3f,
+                bg_color,
+                ambient_color
+                ))
+    {
+        return visionaray::make_kernel_params(
+                visionaray::normals_per_face_binding{},
+                refs.data(),
+                refs.data() + refs.size(),
+                normals.data(),
+                materials.data(),
+                lights.data(),
+                lights.data() + lights.size(),
+                num_bounces,
+                1E-3f,
+                bg_color,
+                ambient_color
+                );
+    }
+};
+
+#endif // VSNRAY_TEST_COMMON_TEST_SCENE_H
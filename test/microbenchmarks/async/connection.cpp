@@ -0,0 +1,188 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <vector>
+
+#include <common/async/connection_manager.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const unsigned short Port = 31411;
+
+// Messages written per iteration, the client writes them back-to-back
+static const int NumMessages = 64;
+
+// A server and a client on localhost, the server counts the messages it received
+struct loopback
+{
+    connection_manager_pointer  server;
+    connection_manager_pointer  client;
+    connection_pointer          conn;
+
+    std::mutex                  mutex;
+    std::condition_variable     cond;
+    size_t                      num_received = 0;
+
+    loopback()
+        : server(make_connection_manager(Port))
+        , client(make_connection_manager())
+    {
+        server->accept([this](connection_pointer c, boost::system::error_code const& e)
+        {
+            if (e)
+            {
+                return false;
+            }
+
+            c->set_handler([this](connection::reason r, message_pointer /* msg */, boost::system::error_code const& e)
+            {
+                if (!e && r == connection::Read)
+                {
+                    std::unique_lock<std::mutex> l(mutex);
+                    ++num_received;
+                    cond.notify_all();
+                }
+            });
+
+            return true;
+        });
+
+        server->run_in_thread();
+        client->run_in_thread();
+
+        conn = client->connect("::1", Port);
+    }
+
+   ~loopback()
+    {
+        client->stop();
+        server->stop();
+        client->wait();
+        server->wait();
+    }
+
+    void wait_for(size_t count)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        cond.wait(l, [&]() { return num_received >= count; });
+    }
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Messages reference the sender's buffer (make_message_ref())
+//
+
+static void BM_WriteRef(benchmark::State& state)
+{
+    loopback lb;
+
+    if (!lb.conn)
+    {
+        state.SkipWithError("Cannot connect to localhost");
+        return;
+    }
+
+    std::vector<char> payload(static_cast<size_t>(state.range(0)), 'x');
+
+    size_t num_sent = 0;
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < NumMessages; ++i)
+        {
+            lb.conn->write(make_message_ref(1, payload.data(), payload.size()));
+        }
+
+        num_sent += NumMessages;
+        lb.wait_for(num_sent);
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumMessages);
+    state.SetBytesProcessed(state.iterations() * NumMessages * state.range(0));
+}
+
+BENCHMARK(BM_WriteRef)->Arg(64)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20)->UseRealTime();
+
+
+//-------------------------------------------------------------------------------------------------
+// Messages copy the sender's buffer
+//
+
+static void BM_WriteCopy(benchmark::State& state)
+{
+    loopback lb;
+
+    if (!lb.conn)
+    {
+        state.SkipWithError("Cannot connect to localhost");
+        return;
+    }
+
+    std::vector<char> payload(static_cast<size_t>(state.range(0)), 'x');
+
+    size_t num_sent = 0;
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < NumMessages; ++i)
+        {
+            lb.conn->write(1, payload);
+        }
+
+        num_sent += NumMessages;
+        lb.wait_for(num_sent);
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumMessages);
+    state.SetBytesProcessed(state.iterations() * NumMessages * state.range(0));
+}
+
+BENCHMARK(BM_WriteCopy)->Arg(64)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20)->UseRealTime();
+
+
+//-------------------------------------------------------------------------------------------------
+// Small messages w/ random vs. sequential IDs
+//
+
+static void BM_WriteIDScheme(benchmark::State& state)
+{
+    loopback lb;
+
+    if (!lb.conn)
+    {
+        state.SkipWithError("Cannot connect to localhost");
+        return;
+    }
+
+    lb.client->set_id_scheme(static_cast<connection_manager::id_scheme>(state.range(0)));
+
+    std::vector<char> payload(64, 'x');
+
+    size_t num_sent = 0;
+
+    for (auto _ : state)
+    {
+        for (int i = 0; i < NumMessages; ++i)
+        {
+            lb.conn->write(make_message_ref(1, payload.data(), payload.size()));
+        }
+
+        num_sent += NumMessages;
+        lb.wait_for(num_sent);
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumMessages);
+}
+
+BENCHMARK(BM_WriteIDScheme)->Arg(connection_manager::RandomUUID)->Arg(connection_manager::Sequential)->UseRealTime();
@@ -0,0 +1,146 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <common/async/frame_stream.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const int BPP = 4; // RGBA8
+
+// Smooth background w/ a few hard edges, similar to a rendered image
+static std::vector<uint8_t> make_frame(int width, int height, int offset = 0)
+{
+    std::vector<uint8_t> frame(size_t(width) * height * BPP);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            uint8_t* p = frame.data() + (size_t(y) * width + x) * BPP;
+
+            bool inside = ((x + offset) / 200 + y / 200) % 3 == 0;
+
+            p[0] = static_cast<uint8_t>(inside ? 200 : x * 255 / width);
+            p[1] = static_cast<uint8_t>(inside ? 60  : y * 255 / height);
+            p[2] = static_cast<uint8_t>(inside ? (x ^ y) & 0xF : 128);
+            p[3] = 255;
+        }
+    }
+
+    return frame;
+}
+
+static void set_counters(benchmark::State& state, size_t raw_size, size_t encoded_size)
+{
+    state.SetBytesProcessed(state.iterations() * raw_size);
+    state.counters["ratio"] = static_cast<double>(raw_size) / encoded_size;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// All tiles are encoded
+//
+
+static void BM_EncodeKeyFrame(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+
+    auto frame = make_frame(width, height);
+
+    frame_encoder enc;
+    size_t encoded_size = 0;
+
+    for (auto _ : state)
+    {
+        enc.reset();
+        auto msg = enc.encode(0, frame.data(), width, height, BPP);
+        encoded_size = msg->size();
+    }
+
+    set_counters(state, frame.size(), encoded_size);
+}
+
+BENCHMARK(BM_EncodeKeyFrame)->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
+
+
+//-------------------------------------------------------------------------------------------------
+// Two alternating frames that differ in a part of the image
+//
+
+static void BM_EncodeDeltaFrame(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+
+    std::vector<uint8_t> frames[2] = { make_frame(width, height), make_frame(width, height) };
+
+    // Change a quarter of the image
+    auto changed = make_frame(width, height, 100);
+    size_t row_size = size_t(width) * BPP;
+
+    for (int y = 0; y < height / 2; ++y)
+    {
+        std::copy(
+                changed.begin() + y * row_size,
+                changed.begin() + y * row_size + row_size / 2,
+                frames[1].begin() + y * row_size
+                );
+    }
+
+    frame_encoder enc;
+    enc.encode(0, frames[0].data(), width, height, BPP);
+
+    size_t encoded_size = 0;
+    int i = 1;
+
+    for (auto _ : state)
+    {
+        auto msg = enc.encode(0, frames[i].data(), width, height, BPP);
+        encoded_size = msg->size();
+        i = 1 - i;
+    }
+
+    set_counters(state, frames[0].size(), encoded_size);
+}
+
+BENCHMARK(BM_EncodeDeltaFrame)->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
+
+
+//-------------------------------------------------------------------------------------------------
+// Decode a key frame
+//
+
+static void BM_DecodeKeyFrame(benchmark::State& state)
+{
+    int width = static_cast<int>(state.range(0));
+    int height = static_cast<int>(state.range(1));
+
+    auto frame = make_frame(width, height);
+
+    frame_encoder enc;
+    auto msg = enc.encode(0, frame.data(), width, height, BPP);
+
+    frame_decoder dec;
+
+    for (auto _ : state)
+    {
+        bool ok = dec.decode(*msg);
+        benchmark::DoNotOptimize(ok);
+    }
+
+    set_counters(state, frame.size(), msg->size());
+}
+
+BENCHMARK(BM_DecodeKeyFrame)->Args({1920, 1080})->Args({3840, 2160})->Unit(benchmark::kMillisecond);
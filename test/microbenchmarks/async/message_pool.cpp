@@ -0,0 +1,54 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <common/async/message_pool.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Allocate a new message w/ data buffer for each request
+//
+
+static void BM_MakeMessage(benchmark::State& state)
+{
+    std::vector<char> payload(static_cast<size_t>(state.range(0)), 'x');
+
+    for (auto _ : state)
+    {
+        message_pointer msg = make_message(1, payload.begin(), payload.end());
+        benchmark::DoNotOptimize(msg->data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MakeMessage)->Arg(64)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
+
+//-------------------------------------------------------------------------------------------------
+// Recycle messages and their data buffers
+//
+
+static void BM_PoolAcquire(benchmark::State& state)
+{
+    std::vector<char> payload(static_cast<size_t>(state.range(0)), 'x');
+
+    auto pool = make_message_pool();
+
+    for (auto _ : state)
+    {
+        message_pointer msg = pool->acquire(1, payload.begin(), payload.end());
+        benchmark::DoNotOptimize(msg->data());
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_PoolAcquire)->Arg(64)->Arg(4 << 10)->Arg(64 << 10)->Arg(1 << 20);
+
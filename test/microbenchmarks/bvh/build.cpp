@@ -0,0 +1,124 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Random, small triangles in the unit cube
+static aligned_vector<triangle_t> make_triangles(size_t num_triangles)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(num_triangles);
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        vec3 v1(dist(rng), dist(rng), dist(rng));
+        vec3 v2 = v1 + vec3(dist(rng), dist(rng), dist(rng)) * 0.02f;
+        vec3 v3 = v1 + vec3(dist(rng), dist(rng), dist(rng)) * 0.02f;
+
+        triangles[i] = triangle_t(v1, v2 - v1, v3 - v1);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+static void sizes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(1 << 10);
+    b->Arg(1 << 14);
+    b->Arg(1 << 17);
+    b->Unit(benchmark::kMillisecond);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Binned SAH builder, with and without spatial splits
+//
+
+static void BM_BuildBinnedSAH(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size(), false);
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK(BM_BuildBinnedSAH)->Apply(sizes);
+
+static void BM_BuildSBVH(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size(), true);
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK(BM_BuildSBVH)->Apply(sizes);
+
+
+//-------------------------------------------------------------------------------------------------
+// LBVH builder
+//
+
+static void BM_BuildLBVH(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK(BM_BuildLBVH)->Apply(sizes);
+
+
+//-------------------------------------------------------------------------------------------------
+// Non-index BVH, includes reordering the primitives
+//
+
+static void BM_BuildBinnedSAHReorder(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto tree = build<bvh<triangle_t>>(triangles.data(), triangles.size(), false);
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK(BM_BuildBinnedSAHReorder)->Apply(sizes);
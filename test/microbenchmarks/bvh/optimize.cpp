@@ -0,0 +1,249 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/traverse.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Random triangles in the unit cube, many small and few large ones
+static aligned_vector<triangle_t> make_triangles(size_t num_triangles)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(num_triangles);
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        float size = 0.3f * std::pow(dist(rng), 8.0f);
+
+        vec3 v(dist(rng), dist(rng), dist(rng));
+        vec3 e1 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+        vec3 e2 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * size;
+
+        triangles[i] = triangle_t(v, e1, e2);
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+// Rays w/ random origins in the unit cube and random directions
+static aligned_vector<ray> make_rays(size_t num_rays)
+{
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<ray> rays(num_rays);
+
+    for (size_t i = 0; i < num_rays; ++i)
+    {
+        vec3 ori(dist(rng), dist(rng), dist(rng));
+        vec3 dir(dist(rng) - 0.5f, dist(rng) - 0.5f, dist(rng) - 0.5f);
+        rays[i] = ray(ori, normalize(dir));
+    }
+
+    return rays;
+}
+
+// Packet of consecutive rays
+template <typename S>
+static basic_ray<S> load_packet(ray const* rays)
+{
+    array<ray, simd::num_elements<S>::value> packet;
+
+    for (size_t i = 0; i < packet.size(); ++i)
+    {
+        packet[i] = rays[i];
+    }
+
+    return simd::pack(packet);
+}
+
+template <>
+basic_ray<float> load_packet<float>(ray const* rays)
+{
+    return rays[0];
+}
+
+static void sizes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(1 << 10);
+    b->Arg(1 << 14);
+    b->Arg(1 << 17);
+    b->Unit(benchmark::kMillisecond);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Treelet restructuring of LBVHs, one pass over the tree
+//
+
+static void BM_OptimizeTreelets(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+    thread_pool pool(1);
+
+    treelet_optimization_stats stats;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = tree;
+        state.ResumeTiming();
+
+        stats = optimize_treelets(copy, pool, 1);
+        benchmark::DoNotOptimize(copy.nodes().data());
+    }
+
+    state.counters["sah_before"] = stats.sah_cost_before;
+    state.counters["sah_after"] = stats.sah_cost_after;
+
+    state.SetItemsProcessed(state.iterations() * triangles.size());
+}
+
+BENCHMARK(BM_OptimizeTreelets)->Apply(sizes)->UseRealTime();
+
+
+//-------------------------------------------------------------------------------------------------
+// Traversal of LBVHs, arg: number of treelet restructuring passes
+//
+
+static void BM_TraverseLBVH(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17);
+    auto rays = make_rays(1 << 14);
+
+    auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+    thread_pool pool(1);
+
+    auto stats = optimize_treelets(tree, pool, static_cast<unsigned>(state.range(0)));
+
+    auto ref = tree.ref();
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = closest_hit(r, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.counters["sah"] = stats.sah_cost_after;
+
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK(BM_TraverseLBVH)->Arg(0)->Arg(1)->Arg(3);
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: traversal of binned SAH BVHs
+//
+
+static void BM_TraverseBinnedSAH(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17);
+    auto rays = make_rays(1 << 14);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size(), false);
+
+    auto ref = tree.ref();
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = closest_hit(r, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.counters["sah"] = sah_cost(tree);
+
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK(BM_TraverseBinnedSAH);
+
+
+//-------------------------------------------------------------------------------------------------
+// Node layout, arg: cluster size in bytes (0: build order)
+//
+
+static void BM_ReorderNodes(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)));
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size(), false);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = tree;
+        state.ResumeTiming();
+
+        reorder_nodes(copy);
+        benchmark::DoNotOptimize(copy.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * tree.num_nodes());
+}
+
+BENCHMARK(BM_ReorderNodes)->Apply(sizes);
+
+template <typename S>
+static void BM_TraverseLayout(benchmark::State& state)
+{
+    static const size_t N = simd::num_elements<S>::value;
+
+    // Nodes don't fit in the caches
+    auto triangles = make_triangles(1 << 20);
+    auto rays = make_rays(1 << 12);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size(), false);
+
+    if (state.range(0) > 0)
+    {
+        reorder_nodes(tree, static_cast<size_t>(state.range(0)));
+    }
+
+    auto ref = tree.ref();
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < rays.size(); i += N)
+        {
+            auto hr = closest_hit(load_packet<S>(rays.data() + i), &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK_TEMPLATE(BM_TraverseLayout, float)->Arg(0)->Arg(64)->Arg(4096);
+BENCHMARK_TEMPLATE(BM_TraverseLayout, simd::float4)->Arg(0)->Arg(64)->Arg(4096);
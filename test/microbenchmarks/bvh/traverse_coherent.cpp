@@ -0,0 +1,147 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Image w/ primary rays
+static const int Width  = 256;
+static const int Height = 256;
+
+// Primary ray packet at pixel (x,y), seen from a pinhole in front of the unit cube
+template <typename S>
+static basic_ray<S> make_packet(int x, int y)
+{
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    vec3 eye(0.5f, 0.5f, -1.0f);
+
+    array<ray, simd::num_elements<S>::value> packet;
+
+    for (int i = 0; i < pw * ph; ++i)
+    {
+        vec3 dst(
+                (x + i % pw + 0.5f) / static_cast<float>(Width),
+                (y + i / pw + 0.5f) / static_cast<float>(Height),
+                0.0f
+                );
+
+        packet[i] = ray(eye, normalize(dst - eye));
+    }
+
+    return simd::pack(packet);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: primary ray packets traverse the BVH one by one
+//
+
+template <typename S>
+static void BM_TraversePackets(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17, 0.02f);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    aligned_vector<basic_ray<S>> rays;
+
+    for (int y = 0; y < Height; y += ph)
+    {
+        for (int x = 0; x < Width; x += pw)
+        {
+            rays.push_back(make_packet<S>(x, y));
+        }
+    }
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = closest_hit(r, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_TraversePackets, simd::float4);
+BENCHMARK_TEMPLATE(BM_TraversePackets, simd::float8);
+
+
+//-------------------------------------------------------------------------------------------------
+// Coherent traversal w/ TileSize x TileSize pixel tiles
+//
+
+template <typename S, int TileSize>
+static void BM_TraverseCoherent(benchmark::State& state)
+{
+    static const size_t N = (TileSize / packet_size<S>::w) * (TileSize / packet_size<S>::h);
+
+    auto triangles = make_triangles(1 << 17, 0.02f);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    aligned_vector<array<basic_ray<S>, N>> tiles;
+
+    for (int y = 0; y < Height; y += TileSize)
+    {
+        for (int x = 0; x < Width; x += TileSize)
+        {
+            array<basic_ray<S>, N> tile;
+
+            for (size_t k = 0; k < N; ++k)
+            {
+                int px = x + static_cast<int>(k) % (TileSize / pw) * pw;
+                int py = y + static_cast<int>(k) / (TileSize / pw) * ph;
+                tile[k] = make_packet<S>(px, py);
+            }
+
+            tiles.push_back(tile);
+        }
+    }
+
+    for (auto _ : state)
+    {
+        for (auto const& t : tiles)
+        {
+            auto hrs = closest_hit_coherent(t, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hrs);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_TraverseCoherent, simd::float4, 8);
+BENCHMARK_TEMPLATE(BM_TraverseCoherent, simd::float4, 16);
+BENCHMARK_TEMPLATE(BM_TraverseCoherent, simd::float8, 8);
+BENCHMARK_TEMPLATE(BM_TraverseCoherent, simd::float8, 16);
@@ -0,0 +1,110 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <common/make_triangles.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static void sizes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(1 << 10);
+    b->Arg(1 << 14);
+    b->Arg(1 << 17);
+}
+
+// Number of primitives edited per iteration
+static const size_t NumEdits = 256;
+
+
+//-------------------------------------------------------------------------------------------------
+// Insert primitives into built trees, arg: number of primitives in the tree
+//
+
+static void BM_InsertPrimitive(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)), 0.01f);
+    auto more = make_triangles(NumEdits, 0.01f, 2);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = tree;
+        state.ResumeTiming();
+
+        for (auto const& t : more)
+        {
+            benchmark::DoNotOptimize(insert_primitive(copy, t));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * more.size());
+}
+
+BENCHMARK(BM_InsertPrimitive)->Apply(sizes);
+
+
+//-------------------------------------------------------------------------------------------------
+// Remove primitives from built trees, arg: number of primitives in the tree
+//
+
+static void BM_RemovePrimitive(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)), 0.01f);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+
+    size_t stride = triangles.size() / NumEdits;
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        auto copy = tree;
+        state.ResumeTiming();
+
+        for (size_t i = 0; i < triangles.size(); i += stride)
+        {
+            benchmark::DoNotOptimize(remove_primitive(copy, static_cast<unsigned>(i)));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumEdits);
+}
+
+BENCHMARK(BM_RemovePrimitive)->Apply(sizes);
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: rebuild w/ the edited primitives, arg: number of primitives in the tree
+//
+
+static void BM_Rebuild(benchmark::State& state)
+{
+    auto triangles = make_triangles(static_cast<size_t>(state.range(0)) + NumEdits, 0.01f);
+
+    for (auto _ : state)
+    {
+        auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+        benchmark::DoNotOptimize(tree.nodes().data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumEdits);
+}
+
+BENCHMARK(BM_Rebuild)->Apply(sizes)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,52 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/detail/algorithm.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// algo::reorder_n() with a random permutation
+//
+// reorder_n() consumes the indices (they are the identity on exit), so the
+// permutation is restored outside the timed region. The data type mimics a
+// triangle (as reordered by the BVH builders).
+//
+
+static void BM_ReorderN(benchmark::State& state)
+{
+    auto n = static_cast<size_t>(state.range(0));
+
+    std::vector<unsigned> permutation(n);
+    std::iota(permutation.begin(), permutation.end(), 0U);
+    std::shuffle(permutation.begin(), permutation.end(), std::default_random_engine(0));
+
+    std::vector<basic_triangle<3, float>> data(n);
+    std::vector<unsigned> indices(n);
+
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        std::copy(permutation.begin(), permutation.end(), indices.begin());
+        state.ResumeTiming();
+
+        algo::reorder_n(indices.begin(), data.begin(), n);
+
+        benchmark::DoNotOptimize(data.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * n);
+}
+
+BENCHMARK(BM_ReorderN)->RangeMultiplier(16)->Range(1 << 12, 1 << 20)->Unit(benchmark::kMicrosecond);
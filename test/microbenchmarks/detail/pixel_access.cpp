@@ -0,0 +1,78 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/pixel_format.h>
+#include <visionaray/detail/pixel_access.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Store a 1080p frame packet by packet
+//
+// The frame size is not a multiple of all packet sizes, so the border
+// packets take the partial path. Template arguments: SIMD type (ISA),
+// destination pixel format, destination pixel type.
+//
+
+static const int Width = 1920;
+static const int Height = 1080;
+
+template <typename FloatT, pixel_format DF, typename OutputColor>
+static void store_frame(OutputColor* buffer, vector<4, FloatT> const& color, pixel_format_constant<DF> df)
+{
+    for (int y = 0; y < Height; y += packet_size<FloatT>::h)
+    {
+        for (int x = 0; x < Width; x += packet_size<FloatT>::w)
+        {
+            detail::pixel_access::store(df, pixel_format_constant<PF_RGBA32F>{}, x, y, Width, Height, color, buffer);
+        }
+    }
+}
+
+template <typename FloatT>
+static void store_frame(float* buffer, vector<4, FloatT> const& color, pixel_format_constant<PF_DEPTH32F> df)
+{
+    for (int y = 0; y < Height; y += packet_size<FloatT>::h)
+    {
+        for (int x = 0; x < Width; x += packet_size<FloatT>::w)
+        {
+            detail::pixel_access::store(df, pixel_format_constant<PF_DEPTH32F>{}, x, y, Width, Height, color.x, buffer);
+        }
+    }
+}
+
+template <typename FloatT, pixel_format DF, typename OutputColor>
+static void BM_StoreFrame(benchmark::State& state)
+{
+    aligned_vector<OutputColor> buffer(Width * Height);
+
+    vector<4, FloatT> color(FloatT(0.25f), FloatT(0.5f), FloatT(0.75f), FloatT(1.0f));
+
+    for (auto _ : state)
+    {
+        store_frame(buffer.data(), color, pixel_format_constant<DF>{});
+        benchmark::ClobberMemory();
+    }
+
+    state.SetBytesProcessed(state.iterations() * buffer.size() * sizeof(OutputColor));
+}
+
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float4,  PF_RGBA8,    vector<4, unorm<8>>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float8,  PF_RGBA8,    vector<4, unorm<8>>)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float16, PF_RGBA8,    vector<4, unorm<8>>)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float4,  PF_RGBA32F,  vec4)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float8,  PF_RGBA32F,  vec4)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float16, PF_RGBA32F,  vec4)->Unit(benchmark::kMillisecond);
+
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float4,  PF_DEPTH32F, float)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float8,  PF_DEPTH32F, float)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_StoreFrame, simd::float16, PF_DEPTH32F, float)->Unit(benchmark::kMillisecond);
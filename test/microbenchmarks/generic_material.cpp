@@ -0,0 +1,191 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/material.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/shade_record.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const size_t NumPackets = 256;
+
+using material_type = generic_material<
+        matte<float>,
+        plastic<float>,
+        mirror<float>,
+        emissive<float>
+        >;
+
+static material_type make_material(int type, std::default_random_engine& rng)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    vec3 color(dist(rng), dist(rng), dist(rng));
+
+    if (type == 0)
+    {
+        matte<float> m;
+        m.ca() = from_rgb(vec3(0.0f));
+        m.ka() = 0.0f;
+        m.cd() = from_rgb(color);
+        m.kd() = 1.0f;
+        return m;
+    }
+    else if (type == 1)
+    {
+        plastic<float> p;
+        p.ca() = from_rgb(vec3(0.0f));
+        p.ka() = 0.0f;
+        p.cd() = from_rgb(color);
+        p.kd() = 1.0f;
+        p.cs() = from_rgb(vec3(1.0f));
+        p.ks() = 0.5f;
+        p.specular_exp() = 32.0f;
+        return p;
+    }
+    else if (type == 2)
+    {
+        mirror<float> m;
+        m.cr() = from_rgb(color);
+        m.kr() = 1.0f;
+        m.ior() = spectrum<float>(1.34f);
+        m.absorption() = spectrum<float>(0.0f);
+        return m;
+    }
+    else
+    {
+        emissive<float> e;
+        e.ce() = from_rgb(color);
+        e.ls() = 1.0f;
+        return e;
+    }
+}
+
+// Packets of N materials, each lane picks one of the first num_types material types
+template <size_t N>
+static std::vector<simd::generic_material<N, matte<float>, plastic<float>, mirror<float>, emissive<float>>>
+make_materials(int num_types)
+{
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<int> dist(0, num_types - 1);
+
+    std::vector<simd::generic_material<N, matte<float>, plastic<float>, mirror<float>, emissive<float>>> result;
+
+    for (size_t i = 0; i < NumPackets; ++i)
+    {
+        array<material_type, N> mats;
+
+        for (size_t j = 0; j < N; ++j)
+        {
+            mats[j] = make_material(dist(rng), rng);
+        }
+
+        result.push_back(simd::pack(mats));
+    }
+
+    return result;
+}
+
+template <typename T>
+static shade_record<T> make_shade_record()
+{
+    shade_record<T> sr;
+    sr.normal           = vector<3, T>(0.0f, 0.0f, 1.0f);
+    sr.geometric_normal = vector<3, T>(0.0f, 0.0f, 1.0f);
+    sr.view_dir         = normalize(vector<3, T>(0.3f, 0.2f, 1.0f));
+    sr.tex_color        = vector<3, T>(1.0f);
+    sr.light_dir        = normalize(vector<3, T>(-0.5f, 0.1f, 1.0f));
+    sr.light_intensity  = vector<3, T>(1.0f);
+    return sr;
+}
+
+template <typename T>
+static random_generator<T> make_generator()
+{
+    array<unsigned, simd::num_elements<T>::value> seed;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        seed[i] = static_cast<unsigned>(i);
+    }
+
+    return random_generator<T>(seed);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// simd::generic_material<N, Ts...>::shade(), arg: number of material types per packet
+//
+
+template <typename T>
+static void BM_GenericMaterialShade(benchmark::State& state)
+{
+    static const size_t N = simd::num_elements<T>::value;
+
+    auto mats = make_materials<N>(static_cast<int>(state.range(0)));
+    auto sr = make_shade_record<T>();
+
+    for (auto _ : state)
+    {
+        for (auto const& m : mats)
+        {
+            auto c = m.shade(sr);
+            benchmark::DoNotOptimize(c);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumPackets * N);
+}
+
+BENCHMARK_TEMPLATE(BM_GenericMaterialShade, simd::float4)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK_TEMPLATE(BM_GenericMaterialShade, simd::float8)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK_TEMPLATE(BM_GenericMaterialShade, simd::float16)->Arg(1)->Arg(2)->Arg(4);
+
+
+//-------------------------------------------------------------------------------------------------
+// simd::generic_material<N, Ts...>::sample(), arg: number of material types per packet
+//
+
+template <typename T>
+static void BM_GenericMaterialSample(benchmark::State& state)
+{
+    static const size_t N = simd::num_elements<T>::value;
+
+    auto mats = make_materials<N>(static_cast<int>(state.range(0)));
+    auto sr = make_shade_record<T>();
+    auto gen = make_generator<T>();
+
+    for (auto _ : state)
+    {
+        for (auto const& m : mats)
+        {
+            vector<3, T> refl_dir;
+            T pdf;
+            simd::int_type_t<T> inter;
+
+            auto c = m.sample(sr, refl_dir, pdf, inter, gen);
+            benchmark::DoNotOptimize(c);
+            benchmark::DoNotOptimize(refl_dir);
+            benchmark::DoNotOptimize(pdf);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumPackets * N);
+}
+
+BENCHMARK_TEMPLATE(BM_GenericMaterialSample, simd::float4)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK_TEMPLATE(BM_GenericMaterialSample, simd::float8)->Arg(1)->Arg(2)->Arg(4);
+BENCHMARK_TEMPLATE(BM_GenericMaterialSample, simd::float16)->Arg(1)->Arg(2)->Arg(4);
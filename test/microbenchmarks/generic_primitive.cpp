@@ -0,0 +1,212 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+#include <type_traits>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/generic_primitive.h>
+#include <visionaray/traverse.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Distinct primitive types, alternating spheres and triangles
+template <unsigned I>
+struct typed_primitive
+    : std::conditional<I % 2 == 0, basic_sphere<float>, basic_triangle<3, float>>::type
+{
+    using base_type = typename std::conditional<I % 2 == 0, basic_sphere<float>, basic_triangle<3, float>>::type;
+};
+
+template <unsigned I>
+void split_primitive(aabb& L, aabb& R, float plane, int axis, typed_primitive<I> const& prim)
+{
+    using base_type = typename typed_primitive<I>::base_type;
+
+    split_primitive(L, R, plane, axis, static_cast<base_type const&>(prim));
+}
+
+template <unsigned I>
+struct primitive_types;
+
+template <>
+struct primitive_types<2>
+{
+    using type = generic_primitive<typed_primitive<0>, typed_primitive<1>>;
+};
+
+template <>
+struct primitive_types<4>
+{
+    using type = generic_primitive<
+            typed_primitive<0>, typed_primitive<1>, typed_primitive<2>, typed_primitive<3>
+            >;
+};
+
+template <>
+struct primitive_types<8>
+{
+    using type = generic_primitive<
+            typed_primitive<0>, typed_primitive<1>, typed_primitive<2>, typed_primitive<3>,
+            typed_primitive<4>, typed_primitive<5>, typed_primitive<6>, typed_primitive<7>
+            >;
+};
+
+template <unsigned I, typename P>
+static void make_primitive(vec3 v, vec3 e1, vec3 /* e2 */, P& prim, basic_sphere<float> const* /* */)
+{
+    typed_primitive<I> s;
+    s.center = v;
+    s.radius = length(e1) * 0.5f;
+    s.geom_id = 0;
+    prim = s;
+}
+
+template <unsigned I, typename P>
+static void make_primitive(vec3 v, vec3 e1, vec3 e2, P& prim, basic_triangle<3, float> const* /* */)
+{
+    typed_primitive<I> t;
+    t.v1 = v;
+    t.e1 = e1;
+    t.e2 = e2;
+    t.geom_id = 0;
+    prim = t;
+}
+
+template <typename P>
+static void make_primitive(unsigned /* type */, vec3, vec3, vec3, P&, std::integral_constant<unsigned, 0>)
+{
+}
+
+template <typename P, unsigned I>
+static void make_primitive(unsigned type, vec3 v, vec3 e1, vec3 e2, P& prim, std::integral_constant<unsigned, I>)
+{
+    if (type == I - 1)
+    {
+        make_primitive<I - 1>(v, e1, e2, prim, static_cast<typed_primitive<I - 1> const*>(nullptr));
+    }
+    else
+    {
+        make_primitive(type, v, e1, e2, prim, std::integral_constant<unsigned, I - 1>{});
+    }
+}
+
+// Small primitives of random types in the unit cube
+template <unsigned NumTypes>
+static aligned_vector<typename primitive_types<NumTypes>::type> make_primitives(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    std::uniform_int_distribution<unsigned> type_dist(0, NumTypes - 1);
+
+    aligned_vector<typename primitive_types<NumTypes>::type> prims(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v(dist(rng), dist(rng), dist(rng));
+        vec3 e1 = vec3(dist(rng), dist(rng), dist(rng)) * 0.02f;
+        vec3 e2 = vec3(dist(rng), dist(rng), dist(rng)) * 0.02f;
+
+        make_primitive(type_dist(rng), v, e1, e2, prims[i], std::integral_constant<unsigned, NumTypes>{});
+    }
+
+    return prims;
+}
+
+// Rays from the -z side, through the unit cube
+static aligned_vector<ray> make_rays(size_t count)
+{
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<ray> rays(count);
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 ori(dist(rng), dist(rng), -1.0f);
+        vec3 dst(dist(rng), dist(rng), 1.0f);
+        rays[i] = ray(ori, normalize(dst - ori));
+    }
+
+    return rays;
+}
+
+static const size_t NumRays = 1 << 12;
+
+
+//-------------------------------------------------------------------------------------------------
+// intersect(ray, generic_primitive<Ts...>), dispatch cost w/ 2, 4 and 8 types
+//
+
+template <unsigned NumTypes>
+static void BM_GenericPrimitiveIntersect(benchmark::State& state)
+{
+    auto prims = make_primitives<NumTypes>(1 << 10);
+    auto rays = make_rays(4);
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            for (auto const& p : prims)
+            {
+                auto hr = intersect(r, p);
+                benchmark::DoNotOptimize(hr);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * rays.size() * prims.size());
+}
+
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveIntersect, 2);
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveIntersect, 4);
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveIntersect, 8);
+
+
+//-------------------------------------------------------------------------------------------------
+// BVH traversal w/ 2, 4 and 8 types, arg: leaves sorted by type (1) or not (0)
+//
+
+template <unsigned NumTypes>
+static void BM_GenericPrimitiveBVH(benchmark::State& state)
+{
+    using prim_t = typename primitive_types<NumTypes>::type;
+
+    auto prims = make_primitives<NumTypes>(1 << 16);
+    auto rays = make_rays(NumRays);
+
+    auto tree = build<index_bvh<prim_t>>(prims.data(), prims.size());
+
+    if (state.range(0))
+    {
+        sort_leaves_by_type(tree);
+    }
+
+    auto ref = tree.ref();
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = closest_hit(r, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveBVH, 2)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveBVH, 4)->Arg(0)->Arg(1);
+BENCHMARK_TEMPLATE(BM_GenericPrimitiveBVH, 8)->Arg(0)->Arg(1);
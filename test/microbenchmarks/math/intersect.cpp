@@ -0,0 +1,166 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+#include <type_traits>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const size_t NumRays = 1024;
+
+// Random value in [lo..hi), one random number per SIMD lane
+template <typename T, typename RNG>
+static T random_value(RNG& rng, float lo, float hi, std::false_type /* is simd */)
+{
+    std::uniform_real_distribution<float> dist(lo, hi);
+    return T(dist(rng));
+}
+
+template <typename T, typename RNG>
+static T random_value(RNG& rng, float lo, float hi, std::true_type /* is simd */)
+{
+    std::uniform_real_distribution<float> dist(lo, hi);
+
+    simd::aligned_array_t<T> arr;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        arr[i] = dist(rng);
+    }
+
+    return T(arr);
+}
+
+template <typename T, typename RNG>
+static T random_value(RNG& rng, float lo, float hi)
+{
+    return random_value<T>(rng, lo, hi, std::integral_constant<bool, simd::is_simd_vector<T>::value>{});
+}
+
+// Rays that start in front of the unit cube and point towards it (roughly
+// half of them hit the cube or the triangle, so that SIMD rays diverge)
+template <typename T>
+static aligned_vector<basic_ray<T>> make_rays()
+{
+    std::default_random_engine rng(0);
+
+    aligned_vector<basic_ray<T>> rays(NumRays);
+
+    for (auto& r : rays)
+    {
+        r.ori = vector<3, T>(
+                random_value<T>(rng, -0.5f, 1.5f),
+                random_value<T>(rng, -0.5f, 1.5f),
+                T(2.0f)
+                );
+        r.dir = normalize(vector<3, T>(
+                random_value<T>(rng, -0.2f, 0.2f),
+                random_value<T>(rng, -0.2f, 0.2f),
+                T(-1.0f)
+                ));
+    }
+
+    return rays;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / aabb
+//
+
+template <typename T>
+static void BM_IntersectAABB(benchmark::State& state)
+{
+    auto rays = make_rays<T>();
+    basic_aabb<float> box(vec3(0.0f), vec3(1.0f));
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = intersect(r, box);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumRays * simd::num_elements<T>::value);
+}
+
+BENCHMARK_TEMPLATE(BM_IntersectAABB, float);
+BENCHMARK_TEMPLATE(BM_IntersectAABB, simd::float4);
+BENCHMARK_TEMPLATE(BM_IntersectAABB, simd::float8);
+BENCHMARK_TEMPLATE(BM_IntersectAABB, simd::float16);
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / aabb with precomputed inverse ray direction (as used by BVH traversal)
+//
+
+template <typename T>
+static void BM_IntersectAABBInvDir(benchmark::State& state)
+{
+    auto rays = make_rays<T>();
+    basic_aabb<float> box(vec3(0.0f), vec3(1.0f));
+
+    aligned_vector<vector<3, T>> inv_dirs;
+
+    for (auto const& r : rays)
+    {
+        inv_dirs.push_back(T(1.0f) / r.dir);
+    }
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < NumRays; ++i)
+        {
+            auto hr = intersect(rays[i], box, inv_dirs[i]);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumRays * simd::num_elements<T>::value);
+}
+
+BENCHMARK_TEMPLATE(BM_IntersectAABBInvDir, float);
+BENCHMARK_TEMPLATE(BM_IntersectAABBInvDir, simd::float4);
+BENCHMARK_TEMPLATE(BM_IntersectAABBInvDir, simd::float8);
+BENCHMARK_TEMPLATE(BM_IntersectAABBInvDir, simd::float16);
+
+
+//-------------------------------------------------------------------------------------------------
+// ray / triangle
+//
+
+template <typename T>
+static void BM_IntersectTriangle(benchmark::State& state)
+{
+    auto rays = make_rays<T>();
+    basic_triangle<3, float> tri(vec3(0.0f), vec3(1.0f, 0.0f, 0.0f), vec3(0.0f, 1.0f, 0.0f));
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = intersect(r, tri);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumRays * simd::num_elements<T>::value);
+}
+
+BENCHMARK_TEMPLATE(BM_IntersectTriangle, float);
+BENCHMARK_TEMPLATE(BM_IntersectTriangle, simd::float4);
+BENCHMARK_TEMPLATE(BM_IntersectTriangle, simd::float8);
+BENCHMARK_TEMPLATE(BM_IntersectTriangle, simd::float16);
@@ -0,0 +1,107 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Benchmarks for simd::gather()
+//
+// Gathers from a table that fits into L2 cache with random indices, so that
+// the benchmarks measure the gather instructions (or their emulation) rather
+// than memory latency.
+//
+
+static const size_t TableSize = 1 << 14;
+static const size_t NumGathers = 1024;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+template <typename T>
+static aligned_vector<T> make_table()
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<T> table(TableSize);
+
+    for (auto& t : table)
+    {
+        t = T(dist(rng));
+    }
+
+    return table;
+}
+
+template <typename I>
+static aligned_vector<I> make_indices()
+{
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<int> dist(0, static_cast<int>(TableSize) - 1);
+
+    aligned_vector<I> indices(NumGathers);
+
+    for (auto& index : indices)
+    {
+        simd::aligned_array_t<I> arr;
+
+        for (int i = 0; i < simd::num_elements<I>::value; ++i)
+        {
+            arr[i] = dist(rng);
+        }
+
+        index = I(arr);
+    }
+
+    return indices;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Gather from float, unorm and vector arrays
+//
+
+template <typename T, typename I>
+static void BM_Gather(benchmark::State& state)
+{
+    auto table = make_table<T>();
+    auto indices = make_indices<I>();
+
+    for (auto _ : state)
+    {
+        for (auto const& index : indices)
+        {
+            auto res = gather(table.data(), index);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumGathers * simd::num_elements<I>::value);
+}
+
+BENCHMARK_TEMPLATE(BM_Gather, float, simd::int4);
+BENCHMARK_TEMPLATE(BM_Gather, float, simd::int8);
+BENCHMARK_TEMPLATE(BM_Gather, float, simd::int16);
+
+BENCHMARK_TEMPLATE(BM_Gather, int, simd::int4);
+BENCHMARK_TEMPLATE(BM_Gather, int, simd::int8);
+BENCHMARK_TEMPLATE(BM_Gather, int, simd::int16);
+
+BENCHMARK_TEMPLATE(BM_Gather, unorm<8>, simd::int4);
+BENCHMARK_TEMPLATE(BM_Gather, unorm<8>, simd::int8);
+BENCHMARK_TEMPLATE(BM_Gather, unorm<8>, simd::int16);
+
+BENCHMARK_TEMPLATE(BM_Gather, vec4, simd::int4);
+BENCHMARK_TEMPLATE(BM_Gather, vec4, simd::int8);
+BENCHMARK_TEMPLATE(BM_Gather, vec4, simd::int16);
@@ -0,0 +1,49 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <visionaray/morton.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// morton_encode3D() with 10-bit coordinates (as used by the LBVH builder)
+//
+
+static void BM_MortonEncode3D(benchmark::State& state)
+{
+    static const size_t N = 1024;
+
+    std::default_random_engine rng(0);
+    std::uniform_int_distribution<unsigned> dist(0, 1023);
+
+    std::vector<vec3ui> coords(N);
+
+    for (auto& c : coords)
+    {
+        c = vec3ui(dist(rng), dist(rng), dist(rng));
+    }
+
+    std::vector<unsigned> codes(N);
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            codes[i] = morton_encode3D(coords[i].x, coords[i].y, coords[i].z);
+        }
+
+        benchmark::DoNotOptimize(codes.data());
+        benchmark::ClobberMemory();
+    }
+
+    state.SetItemsProcessed(state.iterations() * N);
+}
+
+BENCHMARK(BM_MortonEncode3D);
@@ -0,0 +1,170 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/intersector.h>
+#include <visionaray/occluder_cache.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/traverse.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Grid of shadow rays on the z=0 plane
+static const int Width  = 256;
+static const int Height = 256;
+
+static const vec3 light(0.5f, 0.5f, 4.0f);
+
+// A few large occluders at z=2 over many small random triangles in the unit cube
+static aligned_vector<triangle_t> make_triangles(size_t num_triangles)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(num_triangles);
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        if (i < 16)
+        {
+            vec3 v(i % 4 * 0.25f, i / 4 * 0.25f, 2.0f);
+            triangles[i] = triangle_t(v, vec3(0.25f, 0.0f, 0.0f), vec3(0.0f, 0.25f, 0.0f));
+        }
+        else
+        {
+            vec3 v(dist(rng), dist(rng), dist(rng) + 0.1f);
+            vec3 e1 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * 0.02f;
+            vec3 e2 = (vec3(dist(rng), dist(rng), dist(rng)) - vec3(0.5f)) * 0.02f;
+
+            triangles[i] = triangle_t(v, e1, e2);
+        }
+
+        triangles[i].prim_id = static_cast<unsigned>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+static basic_ray<float> pack_rays(array<ray, 1> const& rays)
+{
+    return rays[0];
+}
+
+template <size_t N>
+static auto pack_rays(array<ray, N> const& rays)
+    -> decltype( simd::pack(rays) )
+{
+    return simd::pack(rays);
+}
+
+// Shadow ray packets on the grid, in scanline order
+template <typename S>
+static aligned_vector<basic_ray<S>> make_shadow_rays()
+{
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    aligned_vector<basic_ray<S>> rays;
+
+    for (int y = 0; y < Height; y += ph)
+    {
+        for (int x = 0; x < Width; x += pw)
+        {
+            array<ray, simd::num_elements<S>::value> packet;
+
+            for (int i = 0; i < pw * ph; ++i)
+            {
+                vec3 ori(
+                        (x + i % pw + 0.5f) / static_cast<float>(Width),
+                        (y + i / pw + 0.5f) / static_cast<float>(Height),
+                        0.0f
+                        );
+
+                packet[i] = ray(ori, normalize(light - ori));
+            }
+
+            rays.push_back(pack_rays(packet));
+        }
+    }
+
+    return rays;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: shadow rays traverse the BVH
+//
+
+template <typename S>
+static void BM_AnyHit(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    auto rays = make_shadow_rays<S>();
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = any_hit(r, &ref, &ref + 1, S(3.0f));
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_AnyHit, float);
+BENCHMARK_TEMPLATE(BM_AnyHit, simd::float4);
+
+
+//-------------------------------------------------------------------------------------------------
+// Shadow rays test the last occluder first
+//
+
+template <typename S>
+static void BM_OccluderCache(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    auto rays = make_shadow_rays<S>();
+
+    default_intersector isect;
+
+    for (auto _ : state)
+    {
+        occluder_cache<> cache;
+
+        for (auto const& r : rays)
+        {
+            auto hr = cache.any_hit(0, r, &ref, &ref + 1, S(3.0f), isect);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_OccluderCache, float);
+BENCHMARK_TEMPLATE(BM_OccluderCache, simd::float4);
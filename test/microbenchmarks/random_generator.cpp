@@ -0,0 +1,63 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/random_generator.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static random_generator<float> make_generator(float /* */)
+{
+    return random_generator<float>(0);
+}
+
+template <typename T>
+static random_generator<T> make_generator(T /* */)
+{
+    array<unsigned, simd::num_elements<T>::value> seed;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        seed[i] = static_cast<unsigned>(i);
+    }
+
+    return random_generator<T>(seed);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// random_generator<T>::next()
+//
+
+template <typename T>
+static void BM_RandomGenerator(benchmark::State& state)
+{
+    static const size_t N = 1024;
+
+    auto gen = make_generator(T());
+
+    for (auto _ : state)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            auto r = gen.next();
+            benchmark::DoNotOptimize(r);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * N * simd::num_elements<T>::value);
+}
+
+BENCHMARK_TEMPLATE(BM_RandomGenerator, float);
+BENCHMARK_TEMPLATE(BM_RandomGenerator, simd::float4);
+BENCHMARK_TEMPLATE(BM_RandomGenerator, simd::float8);
+BENCHMARK_TEMPLATE(BM_RandomGenerator, simd::float16);
@@ -0,0 +1,149 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/rasterizer.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static const int Width  = 512;
+static const int Height = 512;
+
+static pinhole_camera make_camera()
+{
+    pinhole_camera cam;
+    cam.set_viewport(0, 0, Width, Height);
+    cam.perspective(45.0f * constants::degrees_to_radians<float>(), 1.0f, 0.1f, 10.0f);
+    cam.look_at(vec3(0.5f, 0.5f, 2.5f), vec3(0.5f), vec3(0.0f, 1.0f, 0.0f));
+    return cam;
+}
+
+static basic_ray<float> pack_rays(array<ray, 1> const& rays)
+{
+    return rays[0];
+}
+
+template <size_t N>
+static auto pack_rays(array<ray, N> const& rays)
+    -> decltype( simd::pack(rays) )
+{
+    return simd::pack(rays);
+}
+
+// Primary ray packets, in scanline order
+template <typename S>
+static aligned_vector<basic_ray<S>> make_primary_rays(pinhole_camera cam)
+{
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    aligned_vector<basic_ray<S>> rays;
+
+    cam.begin_frame();
+
+    for (int y = 0; y < Height; y += ph)
+    {
+        for (int x = 0; x < Width; x += pw)
+        {
+            array<ray, simd::num_elements<S>::value> packet;
+
+            for (int i = 0; i < pw * ph; ++i)
+            {
+                packet[i] = cam.primary_ray(
+                        ray{},
+                        static_cast<float>(x + i % pw),
+                        static_cast<float>(y + i / pw),
+                        static_cast<float>(Width),
+                        static_cast<float>(Height)
+                        );
+            }
+
+            rays.push_back(pack_rays(packet));
+        }
+    }
+
+    return rays;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reference: primary rays traverse the BVH
+//
+
+template <typename S>
+static void BM_PrimaryRays(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17, 0.05f);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    auto rays = make_primary_rays<S>(make_camera());
+
+    for (auto _ : state)
+    {
+        for (auto const& r : rays)
+        {
+            auto hr = closest_hit(r, &ref, &ref + 1);
+            benchmark::DoNotOptimize(hr);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_PrimaryRays, float);
+BENCHMARK_TEMPLATE(BM_PrimaryRays, simd::float4);
+
+
+//-------------------------------------------------------------------------------------------------
+// Primary visibility is rasterized (one thread, w/ triangle setup and resolve)
+//
+
+template <typename S>
+static void BM_Rasterize(benchmark::State& state)
+{
+    auto triangles = make_triangles(1 << 17, 0.05f);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    auto cam = make_camera();
+
+    thread_pool pool(1);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+
+    for (auto _ : state)
+    {
+        rast.rasterize<S>(pool, cam, &ref, &ref + 1, vbuffer);
+        benchmark::DoNotOptimize(vbuffer.data());
+    }
+
+    state.SetItemsProcessed(state.iterations() * Width * Height);
+}
+
+BENCHMARK_TEMPLATE(BM_Rasterize, float)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Rasterize, simd::float4)->UseRealTime();
+BENCHMARK_TEMPLATE(BM_Rasterize, simd::float8)->UseRealTime();
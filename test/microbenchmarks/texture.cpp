@@ -0,0 +1,191 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/texture/texture.h>
+
+#include <benchmark/benchmark.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Benchmarks for tex2D() and tex3D() on the CPU
+//
+// The benchmark argument is the filter mode. Textures are small enough to
+// stay in cache, texture coordinates are random. Only texel / coordinate type
+// combinations that the CPU samplers support are instantiated (tex2D() has
+// no SIMD code path yet).
+//
+
+static const size_t NumLookups = 1024;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+template <typename T, typename RNG>
+static T random_coord(RNG& rng, std::false_type /* is simd */)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+    return T(dist(rng));
+}
+
+template <typename T, typename RNG>
+static T random_coord(RNG& rng, std::true_type /* is simd */)
+{
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    simd::aligned_array_t<T> arr;
+
+    for (int i = 0; i < simd::num_elements<T>::value; ++i)
+    {
+        arr[i] = dist(rng);
+    }
+
+    return T(arr);
+}
+
+template <size_t Dim, typename T>
+static aligned_vector<vector<Dim, T>> make_coords()
+{
+    std::default_random_engine rng(0);
+
+    aligned_vector<vector<Dim, T>> coords(NumLookups);
+
+    for (auto& c : coords)
+    {
+        for (size_t d = 0; d < Dim; ++d)
+        {
+            c[d] = random_coord<T>(rng, std::integral_constant<bool, simd::is_simd_vector<T>::value>{});
+        }
+    }
+
+    return coords;
+}
+
+template <typename Texel>
+static std::vector<Texel> make_texels(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    std::vector<Texel> texels(count);
+
+    for (auto& t : texels)
+    {
+        t = Texel(dist(rng));
+    }
+
+    return texels;
+}
+
+static const char* filter_mode_name(tex_filter_mode mode)
+{
+    switch (mode)
+    {
+    case Nearest:           return "Nearest";
+    case Linear:            return "Linear";
+    case BSpline:           return "BSpline";
+    case BSplineInterpol:   return "BSplineInterpol";
+    case CardinalSpline:    return "CardinalSpline";
+    }
+
+    return "";
+}
+
+static void filter_modes(benchmark::internal::Benchmark* b)
+{
+    b->Arg(Nearest);
+    b->Arg(Linear);
+    b->Arg(BSpline);
+    b->Arg(CardinalSpline);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// tex2D
+//
+
+template <typename Texel, typename T>
+static void BM_Tex2D(benchmark::State& state)
+{
+    auto mode = static_cast<tex_filter_mode>(state.range(0));
+
+    static const size_t W = 256;
+    static const size_t H = 256;
+
+    auto texels = make_texels<Texel>(W * H);
+
+    texture<Texel, 2> tex(W, H);
+    tex.reset(texels.data());
+    tex.set_address_mode(Wrap);
+    tex.set_filter_mode(mode);
+
+    auto coords = make_coords<2, T>();
+
+    for (auto _ : state)
+    {
+        for (auto const& c : coords)
+        {
+            auto res = tex2D(tex, c);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumLookups * simd::num_elements<T>::value);
+    state.SetLabel(filter_mode_name(mode));
+}
+
+BENCHMARK_TEMPLATE(BM_Tex2D, float, float)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex2D, unorm<8>, float)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex2D, vector<4, unorm<8>>, float)->Apply(filter_modes);
+
+
+//-------------------------------------------------------------------------------------------------
+// tex3D
+//
+
+template <typename Texel, typename T>
+static void BM_Tex3D(benchmark::State& state)
+{
+    auto mode = static_cast<tex_filter_mode>(state.range(0));
+
+    static const size_t W = 64;
+    static const size_t H = 64;
+    static const size_t D = 64;
+
+    auto texels = make_texels<Texel>(W * H * D);
+
+    texture<Texel, 3> tex(W, H, D);
+    tex.reset(texels.data());
+    tex.set_address_mode(Clamp);
+    tex.set_filter_mode(mode);
+
+    auto coords = make_coords<3, T>();
+
+    for (auto _ : state)
+    {
+        for (auto const& c : coords)
+        {
+            auto res = tex3D(tex, c);
+            benchmark::DoNotOptimize(res);
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * NumLookups * simd::num_elements<T>::value);
+    state.SetLabel(filter_mode_name(mode));
+}
+
+BENCHMARK_TEMPLATE(BM_Tex3D, float, float)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex3D, float, simd::float4)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex3D, float, simd::float8)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex3D, unorm<8>, float)->Apply(filter_modes);
+BENCHMARK_TEMPLATE(BM_Tex3D, unorm<8>, simd::float4)->Apply(filter_modes);
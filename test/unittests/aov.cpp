@@ -0,0 +1,187 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <visionaray/math/math.h>
+#include <visionaray/aov_buffer_rt.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const int Width  = 16;
+static const int Height = 16;
+
+namespace
+{
+
+// Two quads in the z=0 plane, left: x in [-1,0], right: x in [0,1], y in [-0.5,0.5],
+// each quad has its own geometry id / material
+struct test_scene : basic_test_scene<matte<float>>
+{
+    test_scene()
+    {
+        for (int q = 0; q < 2; ++q)
+        {
+            float x0 = q - 1.0f;
+
+            matte<float> m;
+            m.ca() = from_rgb(vec3(0.0f));
+            m.ka() = 0.0f;
+            m.cd() = from_rgb(q == 0 ? vec3(1.0f, 0.0f, 0.0f) : vec3(0.0f, 1.0f, 0.0f));
+            m.kd() = 0.5f;
+
+            add_quad(
+                    vec3(x0, -0.5f, 0.0f),
+                    vec3(x0 + 1.0f, -0.5f, 0.0f),
+                    vec3(x0 + 1.0f,  0.5f, 0.0f),
+                    vec3(x0,  0.5f, 0.0f),
+                    m
+                    );
+        }
+
+        add_point_light(vec3(0.0f, 0.0f, 2.0f));
+
+        build();
+
+        look_at(Width, Height, 90.0f, vec3(0.0f, 0.0f, 1.0f), vec3(0.0f));
+    }
+};
+
+} // namespace
+
+template <typename S>
+static void test_aovs(unsigned channels)
+{
+    test_scene scene;
+    auto kparams = scene.params(1);
+
+    simple_sched<basic_ray<S>> sched;
+
+
+    // Reference color w/o AOVs
+
+    simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED> ref_rt;
+    ref_rt.resize(Width, Height);
+
+    sched.frame(
+            simple::kernel<decltype(kparams)>({ kparams }),
+            make_sched_params(pixel_sampler::uniform_type{}, scene.cam, ref_rt)
+            );
+
+
+    // Color and AOVs in one pass
+
+    aov_buffer_rt<PF_RGBA32F> rt(channels);
+    rt.resize(Width, Height);
+
+    sched.frame(
+            simple::kernel<decltype(kparams), aov_result_record>({ kparams }),
+            make_sched_params(pixel_sampler::uniform_type{}, scene.cam, rt)
+            );
+
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            int i = y * Width + x;
+
+            for (int c = 0; c < 4; ++c)
+            {
+                ASSERT_FLOAT_EQ(rt.color()[i][c], ref_rt.color()[i][c]);
+            }
+
+            // Quads cover the middle rows
+            bool hit = y >= Height / 4 && y < Height * 3 / 4;
+            int quad = x < Width / 2 ? 0 : 1;
+
+            if (channels & AovDepth)
+            {
+                if (hit)
+                {
+                    EXPECT_LT(rt.depth()[i], 1.0f);
+                    EXPECT_GT(rt.depth()[i], 0.0f);
+                }
+                else
+                {
+                    EXPECT_FLOAT_EQ(rt.depth()[i], 1.0f);
+                }
+            }
+
+            if (channels & AovNormal)
+            {
+                EXPECT_FLOAT_EQ(rt.normal(0)[i], 0.0f);
+                EXPECT_FLOAT_EQ(rt.normal(1)[i], 0.0f);
+                EXPECT_FLOAT_EQ(rt.normal(2)[i], hit ? 1.0f : 0.0f);
+            }
+
+            if (channels & AovAlbedo)
+            {
+                EXPECT_FLOAT_EQ(rt.albedo(0)[i], hit && quad == 0 ? 0.5f : 0.0f);
+                EXPECT_FLOAT_EQ(rt.albedo(1)[i], hit && quad == 1 ? 0.5f : 0.0f);
+                EXPECT_FLOAT_EQ(rt.albedo(2)[i], 0.0f);
+            }
+
+            if (channels & AovPrimID)
+            {
+                if (hit)
+                {
+                    EXPECT_TRUE(rt.prim_id()[i] == quad * 2 || rt.prim_id()[i] == quad * 2 + 1);
+                }
+                else
+                {
+                    EXPECT_EQ(rt.prim_id()[i], -1);
+                }
+            }
+
+            if (channels & AovGeomID)
+            {
+                EXPECT_EQ(rt.geom_id()[i], hit ? quad : -1);
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Render color and AOVs in a single pass
+//
+
+TEST(AOV, SinglePass)
+{
+    test_aovs<float>(AovAll);
+    test_aovs<simd::float4>(AovAll);
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    test_aovs<simd::float8>(AovAll);
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Only the requested planes are allocated and written
+//
+
+TEST(AOV, Channels)
+{
+    aov_buffer_rt<PF_RGBA32F> rt(AovDepth | AovGeomID);
+    rt.resize(Width, Height);
+
+    EXPECT_NE(rt.depth(), nullptr);
+    EXPECT_EQ(rt.normal(0), nullptr);
+    EXPECT_EQ(rt.albedo(2), nullptr);
+    EXPECT_EQ(rt.prim_id(), nullptr);
+    EXPECT_NE(rt.geom_id(), nullptr);
+
+    test_aovs<float>(AovDepth | AovGeomID);
+    test_aovs<simd::float4>(AovNormal | AovAlbedo);
+}
@@ -0,0 +1,225 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <set>
+#include <vector>
+
+#include <boost/uuid/uuid.hpp>
+
+#include <common/async/connection_manager.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+namespace
+{
+
+// A server on localhost that records the IDs of the messages it received
+struct id_recorder
+{
+    connection_manager_pointer          server;
+
+    std::mutex                          mutex;
+    std::condition_variable             cond;
+    std::vector<boost::uuids::uuid>     ids;
+
+    explicit id_recorder(unsigned short port)
+        : server(make_connection_manager(port))
+    {
+        server->accept([this](connection_pointer c, boost::system::error_code const& e)
+        {
+            if (e)
+            {
+                return false;
+            }
+
+            c->set_handler([this](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+            {
+                if (!e && r == connection::Read)
+                {
+                    std::unique_lock<std::mutex> l(mutex);
+                    ids.push_back(msg->id());
+                    cond.notify_all();
+                }
+            });
+
+            return true;
+        });
+
+        server->run_in_thread();
+    }
+
+   ~id_recorder()
+    {
+        server->stop();
+        server->wait();
+    }
+
+    std::vector<boost::uuids::uuid> wait_for(size_t count)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        cond.wait(l, [&]() { return ids.size() >= count; });
+        return ids;
+    }
+};
+
+// Returns the sequence number stored in the last 8 bytes, big-endian
+uint64_t sequence_number(boost::uuids::uuid const& id)
+{
+    uint64_t n = 0;
+
+    for (int i = 8; i < 16; ++i)
+    {
+        n = (n << 8) | id.data[i];
+    }
+
+    return n;
+}
+
+} // namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// Sequential IDs are assigned in order, starting at 1 for each connection
+//
+
+TEST(ConnectionManager, SequentialIDs)
+{
+    static const size_t N = 100;
+
+    id_recorder rec1(31412);
+    id_recorder rec2(31413);
+
+    auto client = make_connection_manager();
+    client->set_id_scheme(connection_manager::Sequential);
+    client->run_in_thread();
+
+    auto conn1 = client->connect("::1", 31412);
+    auto conn2 = client->connect("::1", 31413);
+    ASSERT_TRUE(conn1 != nullptr);
+    ASSERT_TRUE(conn2 != nullptr);
+
+    std::vector<char> payload(64, 'x');
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        // The same message is written to both connections
+        auto msg = make_message(1, payload.begin(), payload.end());
+
+        conn1->write(msg);
+        conn2->write(msg);
+
+        // The sender's message is not modified
+        EXPECT_TRUE(msg->id().is_nil());
+    }
+
+    auto ids1 = rec1.wait_for(N);
+    auto ids2 = rec2.wait_for(N);
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        EXPECT_EQ(sequence_number(ids1[i]), i + 1);
+        EXPECT_EQ(sequence_number(ids2[i]), i + 1);
+    }
+
+    client->stop();
+    client->wait();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Random IDs are unique
+//
+
+TEST(ConnectionManager, RandomIDs)
+{
+    static const size_t N = 100;
+
+    id_recorder rec(31414);
+
+    auto client = make_connection_manager();
+    EXPECT_EQ(client->get_id_scheme(), connection_manager::RandomUUID);
+    client->run_in_thread();
+
+    auto conn = client->connect("::1", 31414);
+    ASSERT_TRUE(conn != nullptr);
+
+    std::vector<char> payload(64, 'x');
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        conn->write(1, payload);
+    }
+
+    auto ids = rec.wait_for(N);
+
+    std::set<boost::uuids::uuid> unique;
+
+    for (auto const& id : ids)
+    {
+        EXPECT_FALSE(id.is_nil());
+        unique.insert(id);
+    }
+
+    EXPECT_EQ(unique.size(), N);
+
+    client->stop();
+    client->wait();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Connection managers can be restarted after stop(), close_all() closes all connections
+//
+
+TEST(ConnectionManager, Restart)
+{
+    static const size_t NumRuns = 3;
+
+    id_recorder rec1(31415);
+    id_recorder rec2(31416);
+
+    auto client = make_connection_manager();
+    client->run_in_thread();
+
+    auto conn1 = client->connect("::1", 31415);
+    auto conn2 = client->connect("::1", 31416);
+    ASSERT_TRUE(conn1 != nullptr);
+    ASSERT_TRUE(conn2 != nullptr);
+
+    std::vector<char> payload(64, 'x');
+
+    for (size_t i = 0; i < NumRuns; ++i)
+    {
+        if (i > 0)
+        {
+            client->run_in_thread();
+        }
+
+        // The connections keep working after a restart
+        conn1->write(1, payload);
+        conn2->write(1, payload);
+
+        EXPECT_EQ(rec1.wait_for(i + 1).size(), i + 1);
+        EXPECT_EQ(rec2.wait_for(i + 1).size(), i + 1);
+
+        // Returns although there are pending reads
+        client->stop();
+        client->wait();
+    }
+
+    client->close_all();
+
+    EXPECT_TRUE(client->find("::1", 31415) == nullptr);
+    EXPECT_TRUE(client->find("::1", 31416) == nullptr);
+}
@@ -0,0 +1,264 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+#include <visionaray/detail/thread_pool.h>
+
+#include <common/async/frame_stream.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+namespace
+{
+
+// Smooth gradient w/ some noise, compresses but not entirely
+std::vector<uint8_t> make_frame(int width, int height, int bpp, unsigned seed = 0)
+{
+    std::vector<uint8_t> frame(size_t(width) * height * bpp);
+
+    for (int y = 0; y < height; ++y)
+    {
+        for (int x = 0; x < width; ++x)
+        {
+            for (int b = 0; b < bpp; ++b)
+            {
+                unsigned noise = ((x * 7919 + y * 104729 + b + seed) * 2654435761U) >> 29;
+                frame[(size_t(y) * width + x) * bpp + b] = static_cast<uint8_t>(x + y * b + noise);
+            }
+        }
+    }
+
+    return frame;
+}
+
+message_pointer copy_message(message const& msg, size_t size)
+{
+    return make_message(msg.type(), msg.begin(), msg.begin() + size);
+}
+
+} // namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// Key frames and delta frames decode bit-exact
+//
+
+TEST(FrameStream, RoundTrip)
+{
+    static const int W = 200;
+    static const int H = 150;
+    static const int BPP = 4;
+
+    thread_pool pool(2);
+
+    frame_encoder enc(32);
+    frame_decoder dec;
+
+    auto frame = make_frame(W, H, BPP);
+
+    auto msg = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 7U * 5U);
+
+    ASSERT_TRUE(dec.decode(*msg, &pool));
+    ASSERT_EQ(dec.width(), W);
+    ASSERT_EQ(dec.height(), H);
+    ASSERT_EQ(dec.bytes_per_pixel(), BPP);
+    EXPECT_EQ(std::memcmp(dec.data(), frame.data(), frame.size()), 0);
+
+    // Change a single pixel, only its tile is sent
+    frame[(size_t(100) * W + 50) * BPP] ^= 0xFF;
+
+    msg = enc.encode(1, frame.data(), W, H, BPP, &pool);
+    EXPECT_EQ(enc.num_tiles_sent(), 1U);
+
+    ASSERT_TRUE(dec.decode(*msg));
+    EXPECT_EQ(dec.frame_id(), 1U);
+    EXPECT_EQ(std::memcmp(dec.data(), frame.data(), frame.size()), 0);
+
+    // Unchanged frame
+    msg = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 0U);
+    ASSERT_TRUE(dec.decode(*msg));
+    EXPECT_EQ(std::memcmp(dec.data(), frame.data(), frame.size()), 0);
+
+    // New frame size, float pixels
+    auto frame2 = make_frame(W / 2, H / 3, 16, 1);
+
+    msg = enc.encode(1, frame2.data(), W / 2, H / 3, 16);
+    ASSERT_TRUE(dec.decode(*msg));
+    ASSERT_EQ(dec.width(), W / 2);
+    ASSERT_EQ(dec.bytes_per_pixel(), 16);
+    EXPECT_EQ(std::memcmp(dec.data(), frame2.data(), frame2.size()), 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Truncated or corrupt messages are rejected
+//
+
+TEST(FrameStream, Corrupt)
+{
+    static const int W = 64;
+    static const int H = 48;
+    static const int BPP = 4;
+
+    // frame_id, width, height, bytes_per_pixel, tile_size, num_tiles, flags
+    static const size_t HeaderSize = 7 * sizeof(uint32_t);
+
+    frame_encoder enc(16);
+
+    auto frame = make_frame(W, H, BPP);
+    auto msg = enc.encode(1, frame.data(), W, H, BPP);
+
+    // Truncated messages
+    for (size_t size = 0; size < msg->size(); ++size)
+    {
+        frame_decoder dec;
+        EXPECT_FALSE(dec.decode(*copy_message(*msg, size))) << size;
+    }
+
+    auto patch = [&](size_t offset, uint32_t value)
+    {
+        auto m = copy_message(*msg, msg->size());
+        std::memcpy(m->data() + offset, &value, sizeof(value));
+        return m;
+    };
+
+    frame_decoder dec;
+
+    // Header fields
+    EXPECT_FALSE(dec.decode(*patch(1 * sizeof(uint32_t), 0xFFFFFFFF)));     // width
+    EXPECT_FALSE(dec.decode(*patch(2 * sizeof(uint32_t), 0x80000000)));     // height
+    EXPECT_FALSE(dec.decode(*patch(3 * sizeof(uint32_t), 0)));              // bytes_per_pixel
+    EXPECT_FALSE(dec.decode(*patch(3 * sizeof(uint32_t), 1000)));           // bytes_per_pixel
+    EXPECT_FALSE(dec.decode(*patch(4 * sizeof(uint32_t), 0)));              // tile_size
+    EXPECT_FALSE(dec.decode(*patch(5 * sizeof(uint32_t), 0xFFFFFFFF)));     // num_tiles
+    EXPECT_FALSE(dec.decode(*patch(5 * sizeof(uint32_t), W / 16 * H / 16 + 1)));
+    EXPECT_FALSE(dec.decode(*patch(5 * sizeof(uint32_t), W / 16 * H / 16 - 1)));  // key frame w/o all tiles
+    EXPECT_FALSE(dec.decode(*patch(6 * sizeof(uint32_t), 0x2)));            // flags
+
+    // Each field is in range, but the frame has 16 GiB
+    {
+        auto m = copy_message(*msg, msg->size());
+        uint32_t size[] = { 16384, 16384, 64 };
+        std::memcpy(m->data() + sizeof(uint32_t), size, sizeof(size));
+        EXPECT_FALSE(dec.decode(*m));
+    }
+
+    // Nothing was allocated for the bogus frame sizes
+    EXPECT_EQ(dec.width(), 0);
+    EXPECT_EQ(dec.height(), 0);
+
+    // Tile headers: index, codec, size
+    EXPECT_FALSE(dec.decode(*patch(HeaderSize, 1000)));
+    EXPECT_FALSE(dec.decode(*patch(HeaderSize + sizeof(uint32_t), 7)));
+    EXPECT_FALSE(dec.decode(*patch(HeaderSize + 2 * sizeof(uint32_t), 0xFFFFFFFF)));
+
+    // Duplicate tiles
+    ASSERT_TRUE(dec.decode(*msg));
+
+    frame[0] ^= 0xFF;
+    auto delta = enc.encode(1, frame.data(), W, H, BPP);
+    ASSERT_EQ(enc.num_tiles_sent(), 1U);
+
+    std::vector<char> data(delta->begin(), delta->end());
+    data.insert(data.end(), delta->begin() + HeaderSize, delta->end());
+
+    uint32_t num_tiles = 2;
+    std::memcpy(data.data() + 5 * sizeof(uint32_t), &num_tiles, sizeof(num_tiles));
+
+    EXPECT_FALSE(dec.decode(*make_message(1, data.begin(), data.end())));
+
+    // Still decodes valid key frames
+    EXPECT_TRUE(dec.decode(*msg));
+    frame[0] ^= 0xFF;
+    EXPECT_EQ(std::memcmp(dec.data(), frame.data(), frame.size()), 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Delta frames are only decoded on top of a key frame
+//
+
+TEST(FrameStream, KeyFrames)
+{
+    static const int W = 64;
+    static const int H = 48;
+    static const int BPP = 4;
+    static const size_t NumTiles = 4U * 3U;
+
+    frame_encoder enc(16);
+    frame_decoder dec;
+
+    EXPECT_TRUE(dec.needs_key_frame());
+
+    auto frame = make_frame(W, H, BPP);
+    auto key = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), NumTiles);
+
+    frame[0] ^= 0xFF;
+    auto delta = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 1U);
+
+    // Delta w/o key frame
+    EXPECT_FALSE(dec.decode(*delta));
+    EXPECT_TRUE(dec.needs_key_frame());
+
+    ASSERT_TRUE(dec.decode(*key));
+    EXPECT_FALSE(dec.needs_key_frame());
+    ASSERT_TRUE(dec.decode(*delta));
+    EXPECT_EQ(std::memcmp(dec.data(), frame.data(), frame.size()), 0);
+
+    // Key frame on request, a new decoder can join
+    enc.request_key_frame();
+    key = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), NumTiles);
+
+    frame_decoder dec2;
+    ASSERT_TRUE(dec2.decode(*key));
+    EXPECT_EQ(std::memcmp(dec2.data(), frame.data(), frame.size()), 0);
+
+    // Key frame after reset
+    enc.reset();
+    key = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), NumTiles);
+    EXPECT_TRUE(frame_decoder().decode(*key));
+
+    // Key frame after resize, deltas for the old size are rejected
+    frame[0] ^= 0xFF;
+    delta = enc.encode(1, frame.data(), W, H, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 1U);
+
+    auto small = make_frame(W / 2, H / 2, BPP);
+    key = enc.encode(1, small.data(), W / 2, H / 2, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 4U);
+
+    ASSERT_TRUE(dec.decode(*key));
+    EXPECT_FALSE(dec.decode(*delta));
+
+    // After an error, deltas are rejected until the next key frame
+    small[0] ^= 0xFF;
+    delta = enc.encode(1, small.data(), W / 2, H / 2, BPP);
+    EXPECT_EQ(enc.num_tiles_sent(), 1U);
+
+    ASSERT_TRUE(dec.decode(*key));
+    EXPECT_FALSE(dec.decode(*copy_message(*delta, delta->size() - 1)));
+    EXPECT_TRUE(dec.needs_key_frame());
+    EXPECT_FALSE(dec.decode(*delta));
+
+    ASSERT_TRUE(dec.decode(*key));
+    ASSERT_TRUE(dec.decode(*delta));
+    EXPECT_EQ(std::memcmp(dec.data(), small.data(), small.size()), 0);
+}
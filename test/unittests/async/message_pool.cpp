@@ -0,0 +1,90 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <string>
+
+#include <common/async/message_pool.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Released messages are reused, w/ a reset header
+//
+
+TEST(MessagePool, Reuse)
+{
+    auto pool = make_message_pool();
+
+    auto msg = pool->acquire(1, 100);
+    EXPECT_EQ(msg->type(), 1U);
+    EXPECT_EQ(msg->size(), 100U);
+
+    message* ptr = msg.get();
+    msg.reset();
+
+    msg = pool->acquire(2);
+    EXPECT_EQ(msg.get(), ptr);
+    EXPECT_EQ(msg->type(), 2U);
+    EXPECT_EQ(msg->size(), 0U);
+    EXPECT_TRUE(msg->id().is_nil());
+
+    EXPECT_EQ(pool->num_allocated(), 1U);
+    EXPECT_EQ(pool->num_reused(), 1U);
+
+    std::string str("message");
+    msg = pool->acquire(3, str.begin(), str.end());
+    EXPECT_EQ(msg->size(), str.size());
+    EXPECT_EQ(std::string(msg->begin(), msg->end()), str);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Only max_pooled idle messages w/ buffers of up to max_capacity bytes are kept
+//
+
+TEST(MessagePool, Limits)
+{
+    auto pool = make_message_pool(2, 1024);
+
+    {
+        message_pointer msgs[3] = { pool->acquire(), pool->acquire(), pool->acquire() };
+    }
+
+    EXPECT_EQ(pool->num_allocated(), 3U);
+
+    {
+        message_pointer msgs[3] = { pool->acquire(), pool->acquire(), pool->acquire() };
+    }
+
+    EXPECT_EQ(pool->num_allocated(), 4U);
+    EXPECT_EQ(pool->num_reused(), 2U);
+
+    pool = make_message_pool(2, 1024);
+
+    pool->acquire(0, 4096);
+    pool->acquire(0, 512);
+    pool->acquire(0, 512);
+
+    EXPECT_EQ(pool->num_allocated(), 2U);
+    EXPECT_EQ(pool->num_reused(), 1U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Messages may outlive their pool
+//
+
+TEST(MessagePool, OutlivePool)
+{
+    auto pool = make_message_pool();
+    auto msg = pool->acquire(1, 100);
+
+    pool.reset();
+
+    EXPECT_EQ(msg->size(), 100U);
+    msg.reset();
+}
@@ -0,0 +1,250 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#include <common/async/connection_manager.h>
+#include <common/async/sort_first.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+namespace
+{
+
+// Regions are full-width strips that cover the viewport
+void check_regions(std::vector<recti> const& regions, int width, int height, int granularity)
+{
+    int y = 0;
+
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+        EXPECT_EQ(regions[i].x, 0);
+        EXPECT_EQ(regions[i].w, width);
+        EXPECT_EQ(regions[i].y, y);
+        EXPECT_GE(regions[i].h, granularity);
+
+        if (i < regions.size() - 1)
+        {
+            EXPECT_EQ(regions[i].h % granularity, 0);
+        }
+
+        y += regions[i].h;
+    }
+
+    EXPECT_EQ(y, height);
+}
+
+// Render times of workers w/ the given speeds (viewport per second)
+std::vector<double> simulate(std::vector<recti> const& regions, std::vector<double> const& speeds, int height)
+{
+    std::vector<double> times(regions.size());
+
+    for (size_t i = 0; i < regions.size(); ++i)
+    {
+        times[i] = regions[i].h / static_cast<double>(height) / speeds[i];
+    }
+
+    return times;
+}
+
+} // namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// The balancer converges to shares proportional to the worker speeds
+//
+
+TEST(SortFirst, Balancer)
+{
+    static const int W = 800;
+    static const int H = 600;
+
+    sort_first_balancer balancer(8);
+    balancer.reset(3);
+
+    std::vector<double> speeds = { 1.0, 1.0 / 2.0, 1.0 / 3.0 };
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        auto regions = balancer.regions(W, H);
+        check_regions(regions, W, H, 8);
+        balancer.update(regions, simulate(regions, speeds, H));
+    }
+
+    auto const& shares = balancer.shares();
+    EXPECT_NEAR(shares[0], 6.0 / 11.0, 0.02);
+    EXPECT_NEAR(shares[1], 3.0 / 11.0, 0.02);
+    EXPECT_NEAR(shares[2], 2.0 / 11.0, 0.02);
+
+    // Stable once converged
+    auto before = balancer.regions(W, H);
+    balancer.update(before, simulate(before, speeds, H));
+    auto after = balancer.regions(W, H);
+
+    for (size_t i = 0; i < before.size(); ++i)
+    {
+        EXPECT_LE(std::abs(before[i].h - after[i].h), 8);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Very slow workers still get one band and keep their measured speed
+//
+
+TEST(SortFirst, BalancerMinBand)
+{
+    static const int W = 100;
+    static const int H = 64;
+
+    sort_first_balancer balancer(16);
+    balancer.reset(4);
+
+    std::vector<double> speeds = { 1000.0, 1.0, 1.0, 1.0 };
+
+    for (int frame = 0; frame < 20; ++frame)
+    {
+        auto regions = balancer.regions(W, H);
+        check_regions(regions, W, H, 16);
+        balancer.update(regions, simulate(regions, speeds, H));
+    }
+
+    // Workers that rendered no rows (the viewport is too small) keep their
+    // last speed, so the shares don't change
+    balancer.reset(8);
+    auto regions = balancer.regions(W, H);
+
+    EXPECT_EQ(regions[3].h, 16);
+    EXPECT_EQ(regions[4].h, 0);
+    EXPECT_EQ(regions[7].h, 0);
+
+    balancer.update(regions, simulate(regions, std::vector<double>(8, 1.0), H));
+
+    auto const& shares = balancer.shares();
+
+    for (size_t i = 0; i < shares.size(); ++i)
+    {
+        EXPECT_GT(shares[i], 0.0);
+    }
+
+    EXPECT_DOUBLE_EQ(shares[4], shares[7]);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Master and worker on localhost, invalid requests are clamped to the viewport
+//
+
+TEST(SortFirst, Loopback)
+{
+    static const unsigned short Port = 31415;
+    static const int W = 64;
+    static const int H = 40;
+
+    std::vector<uint32_t> image(W * H);
+
+    for (size_t i = 0; i < image.size(); ++i)
+    {
+        image[i] = static_cast<uint32_t>(i);
+    }
+
+    std::mutex mutex;
+    std::vector<recti> rendered;
+
+    sort_first_worker worker(sizeof(uint32_t), [&](sort_first_request const& req) -> void const*
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        rendered.push_back(req.region);
+        return image.data();
+    });
+
+    auto server = make_connection_manager(Port);
+    server->accept([&](connection_pointer conn, boost::system::error_code const& e)
+    {
+        if (!e)
+        {
+            worker.serve(conn);
+        }
+
+        return !e;
+    });
+    server->run_in_thread();
+
+    auto client = make_connection_manager();
+    client->run_in_thread();
+
+    auto conn = client->connect("::1", Port);
+    ASSERT_TRUE(conn != nullptr);
+
+    {
+        sort_first_master master;
+        master.add_worker(conn);
+
+        std::vector<uint32_t> result(W * H);
+        ASSERT_TRUE(master.render_frame(mat4::identity(), mat4::identity(), 1, result.data(), W, H, sizeof(uint32_t)));
+        EXPECT_TRUE(result == image);
+    }
+
+    // Send requests w/ regions outside the viewport
+    std::condition_variable cond;
+    size_t num_replies = 0;
+
+    conn->set_handler([&](connection::reason r, message_pointer msg, boost::system::error_code const& e)
+    {
+        if (!e && r == connection::Read && msg->type() == SortFirstReply)
+        {
+            std::unique_lock<std::mutex> l(mutex);
+            ++num_replies;
+            cond.notify_all();
+        }
+    });
+
+    sort_first_request req;
+    std::memset(&req, 0, sizeof(req));
+    req.width = W;
+    req.height = H;
+
+    req.region = recti(0, 30, W, 1000);
+    conn->write(SortFirstRequest, reinterpret_cast<char const*>(&req), reinterpret_cast<char const*>(&req + 1));
+
+    req.region = recti(-5, -100, 1 << 20, 1 << 30);
+    conn->write(SortFirstRequest, reinterpret_cast<char const*>(&req), reinterpret_cast<char const*>(&req + 1));
+
+    req.width = 1 << 30;
+    req.region = recti(0, 0, 1 << 30, H);
+    conn->write(SortFirstRequest, reinterpret_cast<char const*>(&req), reinterpret_cast<char const*>(&req + 1));
+
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        cond.wait(l, [&]() { return num_replies == 3; });
+
+        // The last request wasn't rendered at all
+        ASSERT_EQ(rendered.size(), 3U);
+
+        EXPECT_EQ(rendered[1].y, 30);
+        EXPECT_EQ(rendered[1].h, 10);
+        EXPECT_EQ(rendered[2].x, 0);
+        EXPECT_EQ(rendered[2].y, 0);
+        EXPECT_EQ(rendered[2].w, W);
+        EXPECT_EQ(rendered[2].h, H);
+    }
+
+    client->stop();
+    server->stop();
+    client->wait();
+    server->wait();
+}
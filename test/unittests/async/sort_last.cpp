@@ -0,0 +1,129 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+
+#include <common/async/sort_last.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+using namespace visionaray::async;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+namespace
+{
+
+// Not a multiple of four, covers the SIMD loops and the remainder
+const size_t N = 11;
+
+struct partial_image
+{
+    aligned_vector<vec4>  color;
+    aligned_vector<float> depth;
+
+    explicit partial_image(unsigned seed)
+        : color(N)
+        , depth(N)
+    {
+        for (size_t i = 0; i < N; ++i)
+        {
+            float a = ((i + seed) % 5) / 4.0f;
+            color[i] = vec4(0.1f * seed * a, 0.2f * a, 0.05f * i * a, a);
+            depth[i] = static_cast<float>((i * (seed + 1)) % 5);
+        }
+    }
+};
+
+void expect_eq(vec4 const& a, vec4 const& b)
+{
+    EXPECT_FLOAT_EQ(a.x, b.x);
+    EXPECT_FLOAT_EQ(a.y, b.y);
+    EXPECT_FLOAT_EQ(a.z, b.z);
+    EXPECT_FLOAT_EQ(a.w, b.w);
+}
+
+} // namespace
+
+
+//-------------------------------------------------------------------------------------------------
+// Z-test keeps the nearer fragment, ties go to src only if requested
+//
+
+TEST(SortLast, CompositeDepth)
+{
+    partial_image src(1);
+
+    for (int ties = 0; ties < 2; ++ties)
+    {
+        partial_image dst(2);
+        partial_image ref(2);
+
+        composite_depth(dst.color.data(), dst.depth.data(), src.color.data(), src.depth.data(), N, ties != 0);
+
+        size_t num_ties = 0;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            bool tie = src.depth[i] == ref.depth[i];
+            bool src_wins = src.depth[i] < ref.depth[i] || (tie && ties != 0);
+
+            num_ties += tie ? 1 : 0;
+
+            EXPECT_FLOAT_EQ(dst.depth[i], std::min(src.depth[i], ref.depth[i]));
+            expect_eq(dst.color[i], src_wins ? src.color[i] : ref.color[i]);
+        }
+
+        // Make sure the test data has ties
+        EXPECT_GT(num_ties, 0U);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Alpha compositing w/ premultiplied colors, in the given order
+//
+
+TEST(SortLast, CompositeOver)
+{
+    partial_image src(1);
+
+    for (int src_in_front = 0; src_in_front < 2; ++src_in_front)
+    {
+        partial_image dst(2);
+        partial_image ref(2);
+
+        composite_over(dst.color.data(), dst.depth.data(), src.color.data(), src.depth.data(), N, src_in_front != 0);
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            vec4 front = src_in_front ? src.color[i] : ref.color[i];
+            vec4 back  = src_in_front ? ref.color[i] : src.color[i];
+
+            EXPECT_FLOAT_EQ(dst.depth[i], std::min(src.depth[i], ref.depth[i]));
+            expect_eq(dst.color[i], front + back * (1.0f - front.w));
+        }
+    }
+
+    // Opaque front hides the back, transparent front shows it
+    aligned_vector<vec4> front(N, vec4(0.5f, 0.0f, 0.0f, 1.0f));
+    aligned_vector<vec4> back(N, vec4(0.0f, 0.5f, 0.0f, 0.5f));
+    aligned_vector<float> depth(N, 1.0f);
+
+    composite_over(back.data(), depth.data(), front.data(), depth.data(), N, true);
+    expect_eq(back[N - 1], vec4(0.5f, 0.0f, 0.0f, 1.0f));
+
+    aligned_vector<vec4> clear(N, vec4(0.0f));
+    back.assign(N, vec4(0.0f, 0.5f, 0.0f, 0.5f));
+
+    composite_over(back.data(), depth.data(), clear.data(), depth.data(), N, true);
+    expect_eq(back[N - 1], vec4(0.0f, 0.5f, 0.0f, 0.5f));
+}
@@ -0,0 +1,197 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/async_bvh_builder.h>
+#include <visionaray/bvh.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using tree_t = index_bvh<triangle_t>;
+
+// Closest hits of random rays are the same as w/ a tree built from triangles
+template <typename Tree>
+static void expect_same_hits(Tree const& tree, aligned_vector<triangle_t> const& triangles)
+{
+    auto ref_tree = build<Tree>(triangles.data(), triangles.size());
+
+    auto ra = tree.ref();
+    auto rb = ref_tree.ref();
+
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(dist(rng), dist(rng), -1.0f);
+        vec3 dst(dist(rng), dist(rng), 2.0f);
+        ray r(ori, normalize(dst - ori));
+
+        auto hra = closest_hit(r, &ra, &ra + 1);
+        auto hrb = closest_hit(r, &rb, &rb + 1);
+
+        ASSERT_EQ(hra.hit, hrb.hit);
+
+        if (hra.hit)
+        {
+            EXPECT_FLOAT_EQ(hra.t, hrb.t);
+            EXPECT_EQ(hra.prim_id, hrb.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Builds are swapped in between frames
+//
+
+TEST(AsyncBVHBuilder, Build)
+{
+    auto triangles = make_triangles(5000);
+
+    async_bvh_builder<tree_t> builder;
+
+    EXPECT_FALSE(builder.swap());
+    EXPECT_EQ(builder.tree().num_nodes(), 0U);
+    EXPECT_FLOAT_EQ(builder.progress(), 1.0f);
+
+    builder.build(triangles.data(), triangles.size());
+
+    // The builder works on a copy
+    auto expected = triangles;
+    triangles.clear();
+
+    builder.wait();
+
+    EXPECT_FALSE(builder.busy());
+    EXPECT_FLOAT_EQ(builder.progress(), 1.0f);
+
+    // Not before swap()
+    EXPECT_EQ(builder.tree().num_nodes(), 0U);
+
+    EXPECT_TRUE(builder.swap());
+    EXPECT_FALSE(builder.swap());
+
+    EXPECT_EQ(builder.tree().num_primitives(), expected.size());
+    EXPECT_GE(builder.build_time(), 0.0);
+
+    expect_same_hits(builder.tree(), expected);
+}
+
+TEST(AsyncBVHBuilder, BuildSpatialSplits)
+{
+    auto triangles = make_triangles(2000);
+
+    async_bvh_builder<bvh<triangle_t>> builder;
+
+    builder.build(triangles.data(), triangles.size(), true);
+    builder.wait();
+
+    EXPECT_TRUE(builder.swap());
+
+    expect_same_hits(builder.tree(), triangles);
+}
+
+TEST(AsyncBVHBuilder, Supersede)
+{
+    auto triangles = make_triangles(5000);
+
+    async_bvh_builder<tree_t> builder;
+
+    // Only the newest requests are built
+    for (size_t n = 1000; n <= 5000; n += 1000)
+    {
+        builder.build(triangles.data(), n);
+    }
+
+    builder.wait();
+
+    EXPECT_TRUE(builder.swap());
+    EXPECT_EQ(builder.tree().num_primitives(), 5000U);
+
+    // The front tree is kept until the next swap
+    builder.build(triangles.data(), 10);
+
+    EXPECT_EQ(builder.tree().num_primitives(), 5000U);
+
+    builder.wait();
+    builder.swap();
+
+    EXPECT_EQ(builder.tree().num_primitives(), 10U);
+
+    // Empty scenes
+    builder.build(triangles.data(), 0);
+    builder.wait();
+    builder.swap();
+
+    EXPECT_EQ(builder.tree().num_nodes(), 0U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Refits of moved primitives
+//
+
+TEST(AsyncBVHBuilder, Refit)
+{
+    auto triangles = make_triangles(5000);
+
+    async_bvh_builder<tree_t> builder;
+
+    builder.build(triangles.data(), triangles.size());
+
+    // Move all triangles, refit before the build was swapped in
+    for (auto& t : triangles)
+    {
+        t.v1 += vec3(0.1f * t.v1.y, 0.0f, 0.0f);
+    }
+
+    builder.refit(triangles.data(), triangles.size());
+    builder.wait();
+
+    // Wrong number of primitives, dropped
+    builder.refit(triangles.data(), 10);
+    builder.wait();
+
+    EXPECT_TRUE(builder.swap());
+    EXPECT_FALSE(builder.swap());
+
+    auto const& tree = builder.tree();
+
+    EXPECT_EQ(tree.num_primitives(), triangles.size());
+
+    for (size_t i = 0; i < tree.num_nodes(); ++i)
+    {
+        auto const& n = tree.node(i);
+
+        if (is_inner(n))
+        {
+            EXPECT_TRUE(n.get_bounds().contains(tree.node(n.get_child(0)).get_bounds()));
+            EXPECT_TRUE(n.get_bounds().contains(tree.node(n.get_child(1)).get_bounds()));
+        }
+        else
+        {
+            for (unsigned j = n.get_indices().first; j != n.get_indices().last; ++j)
+            {
+                EXPECT_TRUE(n.get_bounds().contains(get_bounds(tree.primitive(j))));
+            }
+        }
+    }
+
+    expect_same_hits(tree, triangles);
+}
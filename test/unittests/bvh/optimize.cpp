@@ -0,0 +1,303 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <utility>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Every primitive is referenced by exactly one leaf, bounds of inner nodes contain their children,
+// leaves are at most 31 levels deep. Returns the depth of the deepest leaf
+template <typename Tree>
+static unsigned expect_valid(Tree const& tree)
+{
+    std::vector<int> refs(tree.num_primitives(), 0);
+    std::vector<std::pair<unsigned, unsigned>> stack(1, std::make_pair(0U, 0U));
+
+    size_t num_visited = 0;
+    unsigned max_depth = 0;
+
+    while (!stack.empty())
+    {
+        auto const& n = tree.node(stack.back().first);
+        unsigned depth = stack.back().second;
+        stack.pop_back();
+
+        ++num_visited;
+        max_depth = std::max(max_depth, depth);
+
+        if (is_inner(n))
+        {
+            for (unsigned i = 0; i < 2; ++i)
+            {
+                auto const& c = tree.node(n.get_child(i));
+
+                EXPECT_TRUE(n.get_bounds().contains(c.get_bounds()));
+
+                stack.push_back(std::make_pair(n.get_child(i), depth + 1));
+            }
+        }
+        else
+        {
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                ++refs[i];
+            }
+        }
+    }
+
+    EXPECT_EQ(num_visited, tree.num_nodes());
+
+    for (int r : refs)
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    EXPECT_LE(max_depth, 31U);
+
+    return max_depth;
+}
+
+// Closest hits of random rays are the same for both trees
+template <typename Tree>
+static void expect_same_hits(Tree const& a, Tree const& b)
+{
+    auto ra = a.ref();
+    auto rb = b.ref();
+
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(dist(rng), dist(rng), -1.0f);
+        vec3 dst(dist(rng), dist(rng), 2.0f);
+        ray r(ori, normalize(dst - ori));
+
+        auto hra = closest_hit(r, &ra, &ra + 1);
+        auto hrb = closest_hit(r, &rb, &rb + 1);
+
+        ASSERT_EQ(hra.hit, hrb.hit);
+
+        if (hra.hit)
+        {
+            EXPECT_FLOAT_EQ(hra.t, hrb.t);
+            EXPECT_EQ(hra.prim_id, hrb.prim_id);
+        }
+    }
+}
+
+template <typename Tree>
+static void test_optimize_treelets(size_t num_triangles)
+{
+    auto triangles = make_triangles(num_triangles);
+
+    auto tree = build<Tree>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+    auto ref_tree = tree;
+
+    thread_pool pool(2);
+
+    float before = sah_cost(tree);
+
+    auto stats = optimize_treelets(tree, pool, 3);
+
+    EXPECT_FLOAT_EQ(stats.sah_cost_before, before);
+    EXPECT_FLOAT_EQ(stats.sah_cost_after, sah_cost(tree));
+    EXPECT_LT(stats.sah_cost_after, stats.sah_cost_before);
+    EXPECT_EQ(stats.iterations, 3U);
+    EXPECT_EQ(tree.num_nodes(), ref_tree.num_nodes());
+
+    expect_valid(tree);
+
+    // Root is unchanged
+    EXPECT_EQ(tree.node(0).get_bounds().min, ref_tree.node(0).get_bounds().min);
+    EXPECT_EQ(tree.node(0).get_bounds().max, ref_tree.node(0).get_bounds().max);
+
+    expect_same_hits(tree, ref_tree);
+}
+
+template <typename Tree>
+static void test_reorder_nodes(size_t cluster_size)
+{
+    auto triangles = make_triangles(5000);
+
+    auto tree = build<Tree>(triangles.data(), triangles.size());
+    auto ref_tree = tree;
+
+    reorder_nodes(tree, cluster_size);
+
+    EXPECT_EQ(tree.num_nodes(), ref_tree.num_nodes());
+    EXPECT_NEAR(sah_cost(tree), sah_cost(ref_tree), 1.0e-4f * sah_cost(ref_tree));
+
+    expect_valid(tree);
+    expect_same_hits(tree, ref_tree);
+
+    // The root's children come first
+    EXPECT_EQ(tree.node(0).get_child(0), 1U);
+
+    // The first cluster is filled w/ the pairs whose parents have the largest
+    // surface area first
+    std::vector<float> parent_area(tree.num_nodes(), 0.0f);
+
+    for (size_t i = 0; i < tree.num_nodes(); ++i)
+    {
+        auto const& n = tree.node(i);
+
+        if (is_inner(n))
+        {
+            parent_area[n.get_child(0)] = surface_area(n.get_bounds());
+        }
+    }
+
+    size_t pairs_per_cluster = std::max(cluster_size / (2 * sizeof(bvh_node)), size_t(1));
+    size_t cluster_end = std::min(tree.num_nodes(), 2 * pairs_per_cluster + 1);
+
+    for (size_t i = 3; i < cluster_end; i += 2)
+    {
+        EXPECT_LE(parent_area[i], parent_area[i - 2]);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Treelet restructuring reduces the SAH cost of LBVHs, the trees are still valid
+//
+
+TEST(BVH, OptimizeTreeletsBvh)
+{
+    test_optimize_treelets<bvh<triangle_t>>(5000);
+}
+
+TEST(BVH, OptimizeTreeletsIndexBvh)
+{
+    test_optimize_treelets<index_bvh<triangle_t>>(5000);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Nested triangles, the SAH prefers a list. Leaves don't get deeper than the traversal
+// stack supports
+//
+
+TEST(BVH, OptimizeTreeletsMaxDepth)
+{
+    aligned_vector<triangle_t> triangles(200);
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        float size = std::pow(1.1f, static_cast<float>(i));
+
+        triangles[i] = triangle_t(vec3(-size, -size, 0.0f), vec3(2.0f * size, 0.0f, 0.0f), vec3(0.0f, 2.0f * size, 0.1f * size));
+        triangles[i].prim_id = static_cast<int>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+    thread_pool pool(2);
+
+    auto stats = optimize_treelets(tree, pool, 20);
+
+    EXPECT_LT(stats.sah_cost_after, stats.sah_cost_before);
+    EXPECT_EQ(expect_valid(tree), 31U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Time budget and degenerate trees
+//
+
+TEST(BVH, OptimizeTreeletsTimeBudget)
+{
+    auto triangles = make_triangles(5000);
+
+    auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+    thread_pool pool(1);
+
+    // Budget exceeded before the first level
+    auto stats = optimize_treelets(tree, pool, 100, 1.0e-12);
+
+    EXPECT_EQ(stats.iterations, 0U);
+    EXPECT_FLOAT_EQ(stats.sah_cost_after, stats.sah_cost_before);
+
+    expect_valid(tree);
+}
+
+TEST(BVH, OptimizeTreeletsSmallTrees)
+{
+    thread_pool pool(1);
+
+    for (size_t n = 1; n < 8; ++n)
+    {
+        auto triangles = make_triangles(n);
+
+        auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+        auto stats = optimize_treelets(tree, pool);
+
+        EXPECT_LE(stats.sah_cost_after, stats.sah_cost_before);
+
+        expect_valid(tree);
+    }
+
+    index_bvh<triangle_t> empty;
+    auto stats = optimize_treelets(empty, pool);
+
+    EXPECT_EQ(stats.iterations, 0U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Node reordering keeps the tree intact
+//
+
+TEST(BVH, ReorderNodesBvh)
+{
+    test_reorder_nodes<bvh<triangle_t>>(4096);
+}
+
+TEST(BVH, ReorderNodesIndexBvh)
+{
+    test_reorder_nodes<index_bvh<triangle_t>>(64);
+    test_reorder_nodes<index_bvh<triangle_t>>(4096);
+    test_reorder_nodes<index_bvh<triangle_t>>(1 << 20);
+}
+
+TEST(BVH, ReorderNodesAfterOptimizeTreelets)
+{
+    auto triangles = make_triangles(5000);
+
+    auto tree = build<index_bvh<triangle_t>>(detail::lbvh_builder{}, triangles.data(), triangles.size());
+
+    thread_pool pool(1);
+    optimize_treelets(tree, pool);
+
+    auto ref_tree = tree;
+
+    reorder_nodes(tree);
+
+    expect_valid(tree);
+    expect_same_hits(tree, ref_tree);
+}
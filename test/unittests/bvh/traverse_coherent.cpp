@@ -0,0 +1,157 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+static ray pack_rays(array<ray, 1> const& rays)
+{
+    return rays[0];
+}
+
+template <size_t N>
+static auto pack_rays(array<ray, N> const& rays)
+    -> decltype( simd::pack(rays) )
+{
+    return simd::pack(rays);
+}
+
+// Rays through a (4 x packet width) x (N/4 x packet height) pixel tile of
+// a w x h image on the z=0 plane, seen from eye
+template <typename S, size_t N>
+static array<basic_ray<S>, N> make_tile(vec3 eye, int x0, int y0, int w, int h)
+{
+    using R = basic_ray<S>;
+
+    int pw = packet_size<S>::w;
+    int ph = packet_size<S>::h;
+
+    array<R, N> rays;
+
+    for (size_t k = 0; k < N; ++k)
+    {
+        int px = x0 + static_cast<int>(k % 4) * pw;
+        int py = y0 + static_cast<int>(k / 4) * ph;
+
+        array<ray, simd::num_elements<S>::value> packet;
+
+        for (int i = 0; i < pw * ph; ++i)
+        {
+            vec3 dst(
+                    (px + i % pw + 0.5f) / static_cast<float>(w),
+                    (py + i / pw + 0.5f) / static_cast<float>(h),
+                    0.0f
+                    );
+
+            packet[i] = ray(eye, normalize(dst - eye));
+        }
+
+        rays[k] = pack_rays(packet);
+    }
+
+    return rays;
+}
+
+// Coherent hits are the same as the hits of single packets, for tiles across
+// the image, some have rays w/ mixed direction signs
+template <typename S, size_t N, typename Tree>
+static void expect_same_hits(Tree const& tree, vec3 eye)
+{
+    using R = basic_ray<S>;
+
+    auto refs = { tree.ref(), tree.ref() };
+
+    int tw = 4 * packet_size<S>::w;
+    int th = static_cast<int>(N / 4) * packet_size<S>::h;
+
+    for (int y = 0; y < 64; y += th)
+    {
+        for (int x = 0; x < 64; x += tw)
+        {
+            auto rays = make_tile<S, N>(eye, x, y, 64, 64);
+
+            auto closest = closest_hit_coherent(rays, refs.begin(), refs.end());
+
+            array<S, N> max_t;
+            max_t.fill(S(1.5));
+
+            auto any = any_hit_coherent(rays, refs.begin(), refs.end(), max_t);
+
+            for (size_t k = 0; k < N; ++k)
+            {
+                R r = rays[k];
+
+                auto expected = closest_hit(r, refs.begin(), refs.end());
+
+                ASSERT_TRUE( all(closest[k].hit == expected.hit) );
+                EXPECT_TRUE( all((closest[k].t == expected.t) | !expected.hit) );
+                EXPECT_TRUE( all((closest[k].prim_id == expected.prim_id) | !expected.hit) );
+
+                auto expected_any = any_hit(r, refs.begin(), refs.end(), S(1.5));
+
+                EXPECT_TRUE( all(any[k].hit == expected_any.hit) );
+            }
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Compare coherent traversal w/ packet traversal
+//
+
+TEST(BVH, TraverseCoherent)
+{
+    auto triangles = make_triangles(5000);
+
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+
+    // Eye outside and inside the scene bounds
+    expect_same_hits<float, 16>(tree, vec3(0.5f, 0.5f, -1.0f));
+    expect_same_hits<float, 16>(tree, vec3(0.3f, 0.6f, 0.5f));
+
+    expect_same_hits<simd::float4, 8>(tree, vec3(0.5f, 0.5f, -1.0f));
+    expect_same_hits<simd::float4, 8>(tree, vec3(0.3f, 0.6f, 0.5f));
+}
+
+TEST(BVH, TraverseCoherentSpatialSplits)
+{
+    auto triangles = make_triangles(2000, 0.1f, 2);
+
+    auto tree = build<bvh<triangle_t>>(triangles.data(), triangles.size(), true);
+
+    expect_same_hits<simd::float4, 16>(tree, vec3(0.5f, 0.5f, -1.0f));
+    expect_same_hits<simd::float4, 16>(tree, vec3(2.0f, -1.0f, 1.5f));
+}
+
+TEST(BVH, TraverseCoherentEmpty)
+{
+    index_bvh<triangle_t> tree;
+    auto ref = tree.ref();
+
+    auto rays = make_tile<float, 8>(vec3(0.5f, 0.5f, -1.0f), 0, 0, 64, 64);
+    auto hrs = closest_hit_coherent(rays, &ref, &ref + 1);
+
+    for (auto const& hr : hrs)
+    {
+        EXPECT_FALSE(hr.hit);
+    }
+}
@@ -0,0 +1,378 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <algorithm>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/detail/thread_pool.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using tree_t = index_bvh<triangle_t>;
+
+// Every used index is referenced by exactly one leaf, bounds of inner nodes
+// contain their children, free nodes are unreachable, leaves are at most 31
+// levels deep. Returns the number of references to each primitive slot
+static std::vector<int> expect_valid(tree_t const& tree)
+{
+    std::vector<int> prim_refs(tree.primitives().size(), 0);
+
+    if (tree.num_nodes() == 0)
+    {
+        return prim_refs;
+    }
+
+    std::vector<int> refs(tree.indices().size(), 0);
+    std::vector<std::pair<unsigned, unsigned>> stack(1, { 0U, 0U });
+
+    size_t num_visited = 0;
+
+    while (!stack.empty())
+    {
+        auto e = stack.back();
+        stack.pop_back();
+
+        auto const& n = tree.node(e.first);
+
+        ++num_visited;
+
+        EXPECT_TRUE(std::find(tree.free_nodes().begin(), tree.free_nodes().end(), e.first & ~1U)
+                == tree.free_nodes().end());
+
+        if (is_inner(n))
+        {
+            for (unsigned i = 0; i < 2; ++i)
+            {
+                auto const& c = tree.node(n.get_child(i));
+
+                EXPECT_TRUE(n.get_bounds().contains(c.get_bounds()));
+
+                stack.emplace_back(n.get_child(i), e.second + 1);
+            }
+        }
+        else
+        {
+            EXPECT_LE(e.second, 31U);
+
+            for (unsigned i = n.get_indices().first; i != n.get_indices().last; ++i)
+            {
+                ++refs[i];
+                ++prim_refs[tree.indices()[i]];
+            }
+        }
+    }
+
+    EXPECT_EQ(num_visited, tree.num_nodes() - 2 * tree.free_nodes().size());
+
+    for (size_t i = 0; i < refs.size(); ++i)
+    {
+        bool is_free = std::find(tree.free_indices().begin(), tree.free_indices().end(), i)
+                != tree.free_indices().end();
+
+        EXPECT_EQ(refs[i], is_free ? 0 : 1);
+    }
+
+    for (unsigned i : tree.free_primitives())
+    {
+        EXPECT_EQ(prim_refs[i], 0);
+    }
+
+    return prim_refs;
+}
+
+// Closest hits of random rays are the same as w/ a tree built from triangles
+static void expect_same_hits(tree_t const& tree, aligned_vector<triangle_t> const& triangles)
+{
+    auto ref_tree = build<tree_t>(triangles.data(), triangles.size());
+
+    auto ra = tree.ref();
+    auto rb = ref_tree.ref();
+
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 ori(dist(rng), dist(rng), -1.0f);
+        vec3 dst(dist(rng), dist(rng), 2.0f);
+        ray r(ori, normalize(dst - ori));
+
+        auto hra = closest_hit(r, &ra, &ra + 1);
+        auto hrb = closest_hit(r, &rb, &rb + 1);
+
+        ASSERT_EQ(hra.hit, hrb.hit);
+
+        if (hra.hit)
+        {
+            EXPECT_FLOAT_EQ(hra.t, hrb.t);
+            EXPECT_EQ(hra.prim_id, hrb.prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Insert primitives into empty and built trees
+//
+
+TEST(BVH, InsertPrimitiveEmpty)
+{
+    auto triangles = make_triangles(2000);
+
+    tree_t tree;
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        EXPECT_EQ(insert_primitive(tree, triangles[i]), static_cast<unsigned>(i));
+    }
+
+    EXPECT_EQ(tree.num_primitives(), triangles.size());
+    EXPECT_EQ(tree.num_nodes(), 2 * triangles.size() - 1);
+
+    for (int r : expect_valid(tree))
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    expect_same_hits(tree, triangles);
+}
+
+TEST(BVH, InsertPrimitiveBuilt)
+{
+    auto triangles = make_triangles(2000);
+    auto more = make_triangles(500, 0.1f, 2);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+
+    for (auto t : more)
+    {
+        t.prim_id += static_cast<int>(triangles.size());
+
+        insert_primitive(tree, t);
+        triangles.push_back(t);
+    }
+
+    EXPECT_EQ(tree.num_primitives(), triangles.size());
+
+    expect_valid(tree);
+    expect_same_hits(tree, triangles);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Remove primitives, free slots are reused
+//
+
+TEST(BVH, RemovePrimitive)
+{
+    auto triangles = make_triangles(2000);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+
+    aligned_vector<triangle_t> remaining;
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        if (i % 2 == 0)
+        {
+            EXPECT_EQ(remove_primitive(tree, static_cast<unsigned>(i)), 1U);
+        }
+        else
+        {
+            remaining.push_back(triangles[i]);
+        }
+    }
+
+    // Not in the tree (anymore)
+    EXPECT_EQ(remove_primitive(tree, 0), 0U);
+    EXPECT_EQ(remove_primitive(tree, 100000), 0U);
+
+    EXPECT_EQ(tree.free_primitives().size(), 1000U);
+
+    expect_valid(tree);
+    expect_same_hits(tree, remaining);
+
+    // Reinsert, no new primitive and index slots
+    for (size_t i = 0; i < triangles.size(); i += 2)
+    {
+        insert_primitive(tree, triangles[i]);
+    }
+
+    EXPECT_EQ(tree.primitives().size(), triangles.size());
+    EXPECT_EQ(tree.indices().size(), triangles.size());
+    EXPECT_TRUE(tree.free_primitives().empty());
+    EXPECT_TRUE(tree.free_indices().empty());
+
+    for (int r : expect_valid(tree))
+    {
+        EXPECT_EQ(r, 1);
+    }
+
+    expect_same_hits(tree, triangles);
+
+    // The reinserted primitives are leaves of their own, their nodes are reused
+    size_t num_nodes = tree.num_nodes();
+
+    for (size_t i = 0; i < triangles.size(); i += 2)
+    {
+        remove_primitive(tree, static_cast<unsigned>(i));
+    }
+
+    for (size_t i = 0; i < triangles.size(); i += 2)
+    {
+        insert_primitive(tree, triangles[i]);
+    }
+
+    EXPECT_EQ(tree.num_nodes(), num_nodes);
+
+    expect_valid(tree);
+    expect_same_hits(tree, triangles);
+}
+
+
+TEST(BVH, RemoveAllPrimitives)
+{
+    auto triangles = make_triangles(100);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        remove_primitive(tree, static_cast<unsigned>(i));
+        expect_valid(tree);
+    }
+
+    EXPECT_EQ(tree.num_nodes(), 0U);
+
+    insert_primitive(tree, triangles[0]);
+    expect_valid(tree);
+}
+
+TEST(BVH, RemovePrimitiveSpatialSplits)
+{
+    // Large triangles are referenced by several leaves
+    auto triangles = make_triangles(1000);
+
+    for (size_t i = 0; i < triangles.size(); i += 10)
+    {
+        triangles[i].e1 *= 10.0f;
+        triangles[i].e2 *= 10.0f;
+    }
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size(), true);
+
+    aligned_vector<triangle_t> remaining;
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        if (i % 10 == 0)
+        {
+            EXPECT_EQ(remove_primitive(tree, static_cast<unsigned>(i)), 1U);
+        }
+        else
+        {
+            remaining.push_back(triangles[i]);
+        }
+    }
+
+    auto prim_refs = expect_valid(tree);
+
+    for (size_t i = 0; i < triangles.size(); i += 10)
+    {
+        EXPECT_EQ(prim_refs[i], 0);
+    }
+
+    expect_same_hits(tree, remaining);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Depth stays bounded w/ degenerate insertion orders
+//
+
+TEST(BVH, InsertPrimitiveDepth)
+{
+    // Nested triangles, each one contains all previous ones
+    aligned_vector<triangle_t> triangles;
+
+    tree_t tree;
+
+    for (int i = 0; i < 200; ++i)
+    {
+        float s = std::pow(1.1f, static_cast<float>(i));
+
+        triangle_t t(vec3(-s, -s, 0.0f), vec3(2.0f * s, 0.0f, 0.0f), vec3(0.0f, 2.0f * s, 0.0f));
+        t.prim_id = i;
+        t.geom_id = 0;
+
+        insert_primitive(tree, t);
+        triangles.push_back(t);
+    }
+
+    expect_valid(tree);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Reoptimize degraded trees
+//
+
+TEST(BVH, ReoptimizeIfDegraded)
+{
+    auto triangles = make_triangles(2000);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+
+    thread_pool pool(1);
+
+    float reference_cost = 0.0f;
+
+    EXPECT_FALSE(reoptimize_if_degraded(tree, pool, reference_cost));
+    EXPECT_FLOAT_EQ(reference_cost, sah_cost(tree));
+
+    float built_cost = reference_cost;
+
+    // Insertion order along x degrades the tree
+    auto more = make_triangles(2000, 0.1f, 2);
+
+    std::sort(more.begin(), more.end(), [](triangle_t const& a, triangle_t const& b)
+    {
+        return a.v1.x < b.v1.x;
+    });
+
+    for (auto t : more)
+    {
+        t.prim_id += static_cast<int>(triangles.size());
+
+        insert_primitive(tree, t);
+        triangles.push_back(t);
+    }
+
+    float degraded_cost = sah_cost(tree);
+    ASSERT_GT(degraded_cost, built_cost * 1.1f);
+
+    EXPECT_TRUE(reoptimize_if_degraded(tree, pool, reference_cost));
+    EXPECT_LT(reference_cost, degraded_cost);
+    EXPECT_FLOAT_EQ(reference_cost, sah_cost(tree));
+
+    EXPECT_FALSE(reoptimize_if_degraded(tree, pool, reference_cost));
+
+    expect_valid(tree);
+    expect_same_hits(tree, triangles);
+}
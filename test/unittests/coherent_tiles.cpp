@@ -0,0 +1,139 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+
+#include <common/make_triangles.h>
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using render_target_t = simple_buffer_rt<PF_RGBA32F, PF_DEPTH32F>;
+
+// Not a multiple of the tile sizes
+static const int Width  = 52;
+static const int Height = 36;
+
+namespace
+{
+
+// Random triangles in the unit cube, lit by a point light
+struct test_scene : basic_test_scene<plastic<float>>
+{
+    test_scene()
+    {
+        plastic<float> mat;
+        mat.ca() = from_rgb(vec3(0.1f));
+        mat.ka() = 1.0f;
+        mat.cd() = from_rgb(vec3(0.8f, 0.6f, 0.4f));
+        mat.kd() = 1.0f;
+        mat.cs() = from_rgb(vec3(1.0f));
+        mat.ks() = 0.5f;
+        mat.specular_exp() = 32.0f;
+
+        add_triangles(make_triangles(2000, 0.2f), mat);
+
+        add_point_light(vec3(0.5f, 2.0f, 2.0f));
+
+        build();
+
+        look_at(Width, Height, 45.0f, vec3(0.5f, 0.5f, 2.2f), vec3(0.5f));
+    }
+};
+
+} // namespace
+
+struct image
+{
+    std::vector<vec4>  color;
+    std::vector<float> depth;
+};
+
+template <typename Sched, typename Kernel>
+static image render(test_scene& scene, Sched& sched, Kernel kernel)
+{
+    render_target_t rt;
+    rt.resize(Width, Height);
+
+    sched.frame(kernel, make_sched_params(pixel_sampler::uniform_type{}, scene.cam, rt));
+
+    image result;
+    result.color.assign(rt.color(), rt.color() + Width * Height);
+    result.depth.assign(rt.depth(), rt.depth() + Width * Height);
+    return result;
+}
+
+// Coherent tiles render the same image as single packets
+template <typename R, typename Kernel>
+static void test_coherent_tiles(test_scene& scene, Kernel kernel)
+{
+    tiled_sched<R> sched(2);
+
+    EXPECT_EQ(sched.coherent_tiles(), 0U);
+
+    auto expected = render(scene, sched, kernel);
+
+    for (unsigned size : { 8U, 16U })
+    {
+        sched.set_coherent_tiles(size);
+        EXPECT_EQ(sched.coherent_tiles(), size);
+
+        auto actual = render(scene, sched, kernel);
+
+        for (int i = 0; i < Width * Height; ++i)
+        {
+            for (int c = 0; c < 4; ++c)
+            {
+                EXPECT_FLOAT_EQ(actual.color[i][c], expected.color[i][c]);
+            }
+
+            EXPECT_FLOAT_EQ(actual.depth[i], expected.depth[i]);
+        }
+    }
+
+    // Not only background
+    int num_hits = 0;
+
+    for (float d : expected.depth)
+    {
+        num_hits += d < 1.0f;
+    }
+
+    EXPECT_GT(num_hits, Width * Height / 4);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test simple and whitted kernels w/ coherent tiles
+//
+
+TEST(CoherentTiles, Simple)
+{
+    test_scene scene;
+    auto kparams = scene.params(2, vec4(0.1f, 0.2f, 0.3f, 1.0f), vec4(0.5f));
+
+    test_coherent_tiles<basic_ray<float>>(scene, simple::kernel<decltype(kparams)>({ kparams }));
+    test_coherent_tiles<basic_ray<simd::float4>>(scene, simple::kernel<decltype(kparams)>({ kparams }));
+}
+
+TEST(CoherentTiles, Whitted)
+{
+    test_scene scene;
+    auto kparams = scene.params(2, vec4(0.1f, 0.2f, 0.3f, 1.0f), vec4(0.5f));
+
+    test_coherent_tiles<basic_ray<float>>(scene, whitted::kernel<decltype(kparams)>({ kparams }));
+    test_coherent_tiles<basic_ray<simd::float4>>(scene, whitted::kernel<decltype(kparams)>({ kparams }));
+}
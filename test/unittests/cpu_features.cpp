@@ -0,0 +1,51 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstring>
+
+#include <visionaray/math/simd/intrinsics.h>
+#include <visionaray/cpu_features.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Test that runtime detection is consistent
+//
+
+TEST(CPUFeatures, Consistency)
+{
+    simd_isa best = best_simd_isa();
+
+    EXPECT_TRUE(cpu_supports(ISA_Scalar));
+    EXPECT_TRUE(cpu_supports(best));
+
+    for (int i = ISA_Scalar; i <= ISA_AVX512F; ++i)
+    {
+        simd_isa isa = static_cast<simd_isa>(i);
+        EXPECT_EQ(cpu_supports(isa), isa <= best);
+        EXPECT_NE(std::strcmp(simd_isa_name(isa), "Unknown"), 0);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// The unittests run on this host, so the CPU supports what they were compiled for
+//
+
+TEST(CPUFeatures, CompiledISA)
+{
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    EXPECT_TRUE(cpu_supports(ISA_AVX512F));
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX2)
+    EXPECT_TRUE(cpu_supports(ISA_AVX2));
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    EXPECT_TRUE(cpu_supports(ISA_AVX));
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE4_1)
+    EXPECT_TRUE(cpu_supports(ISA_SSE4_1));
+#elif VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_SSE2)
+    EXPECT_TRUE(cpu_supports(ISA_SSE2));
+#endif
+}
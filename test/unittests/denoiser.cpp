@@ -0,0 +1,158 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <cstddef>
+#include <random>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aov_buffer_rt.h>
+#include <visionaray/denoiser.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const int Width  = 61; // not a multiple of the SIMD width
+static const int Height = 40;
+
+// Left half: red albedo, facing +z, right half: green albedo, facing +x
+// Color is albedo * irradiance, irradiance 1.0 +/- noise
+static void make_input(aov_buffer_rt<PF_RGBA32F>& rt, float noise)
+{
+    rt.resize(Width, Height);
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(-noise, noise);
+
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            int i = y * Width + x;
+            bool left = x < Width / 2;
+
+            vec3 albedo = left ? vec3(0.8f, 0.1f, 0.1f) : vec3(0.1f, 0.8f, 0.1f);
+            vec3 normal = left ? vec3(0.0f, 0.0f, 1.0f) : vec3(1.0f, 0.0f, 0.0f);
+
+            rt.color()[i] = vec4(albedo * (1.0f + dist(rng)), 1.0f);
+            rt.depth()[i] = 0.5f;
+
+            for (int c = 0; c < 3; ++c)
+            {
+                rt.normal(c)[i] = normal[c];
+                rt.albedo(c)[i] = albedo[c];
+            }
+        }
+    }
+}
+
+static float mean_squared_error(vec4 const* color, aov_buffer_rt<PF_RGBA32F> const& rt)
+{
+    float mse = 0.0f;
+
+    for (int i = 0; i < Width * Height; ++i)
+    {
+        vec3 albedo(rt.albedo(0)[i], rt.albedo(1)[i], rt.albedo(2)[i]);
+        vec3 diff = color[i].xyz() - albedo;
+        mse += dot(diff, diff);
+    }
+
+    return mse / (Width * Height);
+}
+
+template <typename FloatT>
+static std::vector<vec4> denoise(aov_buffer_rt<PF_RGBA32F> const& rt)
+{
+    thread_pool pool(2);
+
+    std::vector<vec4> result(Width * Height);
+
+    denoiser d;
+    d.denoise<FloatT>(pool, rt, result.data());
+
+    return result;
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Noise is removed, edges between surfaces and albedo are preserved
+//
+
+template <typename FloatT>
+static void test_denoise()
+{
+    aov_buffer_rt<PF_RGBA32F> rt;
+    make_input(rt, 0.5f);
+
+    auto result = denoise<FloatT>(rt);
+
+    float mse_in  = mean_squared_error(rt.color(), rt);
+    float mse_out = mean_squared_error(result.data(), rt);
+
+    EXPECT_LT(mse_out, mse_in * 0.1f);
+
+    // Pixels next to the edge are not mixed up with the other surface
+    for (int y = 0; y < Height; ++y)
+    {
+        vec4 l = result[y * Width + Width / 2 - 1];
+        vec4 r = result[y * Width + Width / 2];
+
+        EXPECT_LT(l.y, 0.2f);
+        EXPECT_LT(r.x, 0.2f);
+        EXPECT_FLOAT_EQ(l.w, 1.0f);
+    }
+}
+
+TEST(Denoiser, Denoise)
+{
+    test_denoise<float>();
+    test_denoise<simd::float4>();
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    test_denoise<simd::float8>();
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    test_denoise<simd::float16>();
+#endif
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Noise-free input is not changed, SIMD and scalar results match
+//
+
+TEST(Denoiser, Consistency)
+{
+    aov_buffer_rt<PF_RGBA32F> rt;
+
+    make_input(rt, 0.0f);
+
+    auto result = denoise<float>(rt);
+
+    for (int i = 0; i < Width * Height; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            EXPECT_NEAR(result[i][c], rt.color()[i][c], 1E-5f);
+        }
+    }
+
+    make_input(rt, 0.5f);
+
+    auto ref  = denoise<float>(rt);
+    auto simd = denoise<simd::float4>(rt);
+
+    for (int i = 0; i < Width * Height; ++i)
+    {
+        for (int c = 0; c < 4; ++c)
+        {
+            EXPECT_NEAR(simd[i][c], ref[i][c], 1E-4f);
+        }
+    }
+}
@@ -0,0 +1,187 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstring>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/pixel_format.h>
+#include <visionaray/detail/pixel_access.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helper functions
+//
+
+// Compare SIMD float to unorm conversion with the scalar conversion
+template <typename FloatT>
+static void test_float_to_unorm8()
+{
+    using float_array = simd::aligned_array_t<FloatT>;
+    using int_array = simd::aligned_array_t<simd::int_type_t<FloatT>>;
+
+    static const int N = simd::num_elements<FloatT>::value;
+
+    float_array in;
+    int_array out;
+
+    // Values close to the rounding boundaries i / 255
+    for (int i = 0; i <= 255; ++i)
+    {
+        float f = i / 255.0f;
+
+        for (int j = 0; j < N; ++j)
+        {
+            in[j] = f;
+            f = std::nextafter(f, j % 2 == 0 ? 0.0f : 2.0f);
+        }
+
+        store(out, detail::pixel_access::float_to_unorm8(FloatT(in)));
+
+        for (int j = 0; j < N; ++j)
+        {
+            EXPECT_EQ(out[j], static_cast<int>(detail::float_to_unorm<8>(in[j])));
+        }
+    }
+
+    // Out of range
+    for (float f : { -1.0f, -0.0f, 1.0f, 1.5f, 1E30f })
+    {
+        store(out, detail::pixel_access::float_to_unorm8(FloatT(f)));
+        EXPECT_EQ(out[0], static_cast<int>(detail::float_to_unorm<8>(f)));
+    }
+}
+
+// Store random packets to an image whose size is not a multiple of the packet
+// size, compare with storing pixel by pixel
+template <typename FloatT>
+static void test_store_packets()
+{
+    using float_array = simd::aligned_array_t<FloatT>;
+
+    static const int N = simd::num_elements<FloatT>::value;
+
+    const int w = packet_size<FloatT>::w;
+    const int h = packet_size<FloatT>::h;
+
+    const int width = 37;
+    const int height = 23;
+
+    aligned_vector<vector<4, unorm<8>>> rgba8(width * height);
+    aligned_vector<vector<4, unorm<8>>> rgba8_ref(width * height);
+    aligned_vector<vec4> rgba32f(width * height);
+    aligned_vector<vec4> rgba32f_ref(width * height);
+    aligned_vector<float> depth(width * height);
+    aligned_vector<float> depth_ref(width * height);
+
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(-0.5f, 1.5f);
+
+    for (int y = 0; y < height; y += h)
+    {
+        for (int x = 0; x < width; x += w)
+        {
+            float_array c[4];
+
+            for (int i = 0; i < 4; ++i)
+            {
+                for (int j = 0; j < N; ++j)
+                {
+                    c[i][j] = dist(rng);
+                }
+            }
+
+            vector<4, FloatT> color{ FloatT(c[0]), FloatT(c[1]), FloatT(c[2]), FloatT(c[3]) };
+
+            detail::pixel_access::store(
+                    pixel_format_constant<PF_RGBA8>{},
+                    pixel_format_constant<PF_RGBA32F>{},
+                    x,
+                    y,
+                    width,
+                    height,
+                    color,
+                    rgba8.data()
+                    );
+
+            detail::pixel_access::store(
+                    pixel_format_constant<PF_RGBA32F>{},
+                    pixel_format_constant<PF_RGBA32F>{},
+                    x,
+                    y,
+                    width,
+                    height,
+                    color,
+                    rgba32f.data()
+                    );
+
+            detail::pixel_access::store(
+                    pixel_format_constant<PF_DEPTH32F>{},
+                    pixel_format_constant<PF_DEPTH32F>{},
+                    x,
+                    y,
+                    width,
+                    height,
+                    color.x,
+                    depth.data()
+                    );
+
+            for (int j = 0; j < N; ++j)
+            {
+                int xx = x + j % w;
+                int yy = y + j / w;
+
+                if (xx >= width || yy >= height)
+                {
+                    continue;
+                }
+
+                vec4 v(c[0][j], c[1][j], c[2][j], c[3][j]);
+
+                convert(
+                        pixel_format_constant<PF_RGBA8>{},
+                        pixel_format_constant<PF_RGBA32F>{},
+                        rgba8_ref[yy * width + xx],
+                        v
+                        );
+
+                rgba32f_ref[yy * width + xx] = v;
+                depth_ref[yy * width + xx] = v.x;
+            }
+        }
+    }
+
+    EXPECT_EQ(std::memcmp(rgba8.data(), rgba8_ref.data(), rgba8.size() * sizeof(rgba8[0])), 0);
+    EXPECT_EQ(std::memcmp(rgba32f.data(), rgba32f_ref.data(), rgba32f.size() * sizeof(rgba32f[0])), 0);
+    EXPECT_EQ(std::memcmp(depth.data(), depth_ref.data(), depth.size() * sizeof(depth[0])), 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test SIMD float to unorm conversion
+//
+
+TEST(PixelAccess, FloatToUnorm8)
+{
+    test_float_to_unorm8<simd::float4>();
+    test_float_to_unorm8<simd::float8>();
+    test_float_to_unorm8<simd::float16>();
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Test storing full and partial SIMD packets
+//
+
+TEST(PixelAccess, StorePackets)
+{
+    test_store_packets<simd::float4>();
+    test_store_packets<simd::float8>();
+    test_store_packets<simd::float16>();
+}
@@ -3,8 +3,10 @@
 
 #include <vector>
 
-#include <visionaray/math/array.h>
+#include <visionaray/math/math.h>
 #include <visionaray/generic_material.h>
+#include <visionaray/random_generator.h>
+#include <visionaray/shade_record.h>
 
 #include <gtest/gtest.h>
 
@@ -120,3 +122,188 @@ TEST(GenericMaterial, SIMD)
     }
     EXPECT_FLOAT_EQ( m4.ls(), em.ls() );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test coherent SIMD dispatch against the scalar materials
+//
+
+template <typename T>
+static void test_coherent_dispatch()
+{
+    static const size_t N = simd::num_elements<T>::value;
+
+    // glass cannot be packed, those lanes are always evaluated per lane
+    using material_type = generic_material<
+        matte<float>,
+        mirror<float>,
+        emissive<float>,
+        glass<float>
+        >;
+
+    matte<float> ma;
+    ma.ca() = from_rgb(vec3(0.1f, 0.2f, 0.3f));
+    ma.ka() = 1.0f;
+    ma.cd() = from_rgb(vec3(1.0f, 0.5f, 0.0f));
+    ma.kd() = 0.8f;
+
+    mirror<float> mi;
+    mi.cr() = from_rgb(vec3(0.5f, 1.0f, 1.0f));
+    mi.kr() = 1.0f;
+    mi.ior() = spectrum<float>(1.34f);
+    mi.absorption() = spectrum<float>(0.0f);
+
+    emissive<float> em;
+    em.ce() = from_rgb(vec3(3.0f, 2.0f, 1.0f));
+    em.ls() = 5.0f;
+
+    glass<float> gl;
+    gl.ct() = from_rgb(vec3(1.0f));
+    gl.kt() = 1.0f;
+    gl.cr() = from_rgb(vec3(1.0f));
+    gl.kr() = 1.0f;
+    gl.ior() = spectrum<float>(1.5f);
+
+    material_type types[] = { ma, mi, em, gl };
+
+    // Lane i uses material layouts[l][i % 4], -1: empty (e.g. the ray missed)
+    int layouts[][4] = {
+        { 0, 0, 0, 0 },     // homogeneous, SIMD
+        { 1, 1, 1, 1 },     // homogeneous, SIMD
+        { 0, 0, 0, 1 },     // mostly coherent
+        { 0, 1, 0, 1 },     // two types, per lane
+        { 0, 1, 2, 3 },     // incoherent
+        { 3, 3, 3, 3 },     // no SIMD material
+        { 0, -1, 0, -1 },   // some rays missed, SIMD
+        { 3, -1, 2, -1 },
+        { -1, -1, -1, -1 }  // all rays missed
+        };
+
+    shade_record<float> sr;
+    sr.normal           = vec3(0.0f, 0.0f, 1.0f);
+    sr.geometric_normal = vec3(0.0f, 0.0f, 1.0f);
+    sr.tex_color        = vec3(1.0f);
+    sr.light_intensity  = vec3(1.0f);
+
+    array<shade_record<float>, N> srs;
+
+    for (size_t i = 0; i < N; ++i)
+    {
+        float f = static_cast<float>(i) / N;
+        srs[i] = sr;
+        srs[i].view_dir  = normalize(vec3(f, 0.5f - f, 1.0f));
+        srs[i].light_dir = normalize(vec3(-f, 0.2f, 1.0f));
+    }
+
+    shade_record<T> sr_simd;
+    array<vec3, N> vec;
+
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].normal;
+    sr_simd.normal = simd::pack(vec);
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].geometric_normal;
+    sr_simd.geometric_normal = simd::pack(vec);
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].view_dir;
+    sr_simd.view_dir = simd::pack(vec);
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].tex_color;
+    sr_simd.tex_color = simd::pack(vec);
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].light_dir;
+    sr_simd.light_dir = simd::pack(vec);
+    for (size_t i = 0; i < N; ++i) vec[i] = srs[i].light_intensity;
+    sr_simd.light_intensity = simd::pack(vec);
+
+    for (auto const& layout : layouts)
+    {
+        array<material_type, N> mats;
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            mats[i] = layout[i % 4] >= 0 ? types[layout[i % 4]] : material_type();
+        }
+
+        auto simd_material = simd::pack(mats);
+
+        auto ambient = simd::unpack(simd_material.ambient().samples());
+        auto albedo  = simd::unpack(simd_material.albedo().samples());
+        auto shaded  = simd::unpack(simd_material.shade(sr_simd).samples());
+
+        // Deterministic BRDFs only
+        array<unsigned, N> seed;
+        for (size_t i = 0; i < N; ++i) seed[i] = static_cast<unsigned>(i);
+        random_generator<T> gen(seed);
+
+        vector<3, T> refl_dir;
+        T pdf;
+        simd::int_type_t<T> inter;
+        auto sampled = simd::unpack(simd_material.sample(sr_simd, refl_dir, pdf, inter, gen).samples());
+        auto refl_dirs = simd::unpack(refl_dir);
+
+        simd::aligned_array_t<T> pdfs;
+        simd::store(pdfs, pdf);
+
+        simd::aligned_array_t<simd::int_type_t<T>> inters;
+        simd::store(inters, inter);
+
+        for (size_t i = 0; i < N; ++i)
+        {
+            if (layout[i % 4] < 0)
+            {
+                for (int c = 0; c < spectrum<float>::num_samples; ++c)
+                {
+                    EXPECT_EQ(ambient[i][c], 0.0f);
+                    EXPECT_EQ(albedo[i][c],  0.0f);
+                    EXPECT_EQ(shaded[i][c],  0.0f);
+                    EXPECT_EQ(sampled[i][c], 0.0f);
+                }
+
+                EXPECT_EQ(pdfs[i], 0.0f);
+                continue;
+            }
+
+            auto amb = mats[i].ambient();
+            auto alb = mats[i].albedo();
+            auto sha = mats[i].shade(srs[i]);
+
+            for (int c = 0; c < spectrum<float>::num_samples; ++c)
+            {
+                EXPECT_NEAR(ambient[i][c], amb[c], 1E-5f);
+                EXPECT_NEAR(albedo[i][c],  alb[c], 1E-5f);
+                EXPECT_NEAR(shaded[i][c],  sha[c], 1E-4f);
+            }
+
+            if (layout[i % 4] == 1 || layout[i % 4] == 2)
+            {
+                random_generator<float> g(0);
+                vec3 rd;
+                float p;
+                int in;
+                auto sam = mats[i].sample(srs[i], rd, p, in, g);
+
+                for (int c = 0; c < spectrum<float>::num_samples; ++c)
+                {
+                    EXPECT_NEAR(sampled[i][c], sam[c], 1E-4f);
+                }
+
+                EXPECT_FLOAT_EQ(pdfs[i], p);
+                EXPECT_EQ(inters[i], in);
+
+                if (layout[i % 4] == 1)
+                {
+                    EXPECT_NEAR(refl_dirs[i].x, rd.x, 1E-5f);
+                    EXPECT_NEAR(refl_dirs[i].y, rd.y, 1E-5f);
+                    EXPECT_NEAR(refl_dirs[i].z, rd.z, 1E-5f);
+                }
+            }
+        }
+    }
+}
+
+TEST(GenericMaterial, CoherentDispatch)
+{
+    test_coherent_dispatch<simd::float4>();
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX)
+    test_coherent_dispatch<simd::float8>();
+#endif
+#if VSNRAY_SIMD_ISA_GE(VSNRAY_SIMD_ISA_AVX512F)
+    test_coherent_dispatch<simd::float16>();
+#endif
+}
@@ -1,9 +1,14 @@
 // This file is distributed under the MIT license.
 // See the LICENSE file for details.
 
+#include <cstddef>
+#include <random>
+
 #include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
 #include <visionaray/bvh.h>
 #include <visionaray/generic_primitive.h>
+#include <visionaray/traverse.h>
 
 #include <gtest/gtest.h>
 
@@ -141,3 +146,127 @@ TEST(GenericPrimitive, SplitPrimitive)
     EXPECT_TRUE( Lt == Lp );
     EXPECT_TRUE( Rt == Rp );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Test sort_leaves_by_type() and BVH traversal w/ runs of primitives of the same type
+//
+
+using sphere_t = basic_sphere<float>;
+using triangle_t = basic_triangle<3, float>;
+using mixed_prim_t = generic_primitive<sphere_t, triangle_t>;
+
+// Small spheres and triangles in [-1..1]^3, in random order
+static aligned_vector<mixed_prim_t> make_mixed_primitives(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    aligned_vector<mixed_prim_t> result;
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        vec3 v(dist(rng), dist(rng), dist(rng));
+
+        if (dist(rng) < 0.0f)
+        {
+            sphere_t s(v, 0.05f);
+            s.prim_id = static_cast<int>(i);
+            s.geom_id = 0;
+            result.push_back(s);
+        }
+        else
+        {
+            vec3 e1(dist(rng) * 0.1f, dist(rng) * 0.1f, 0.0f);
+            vec3 e2(dist(rng) * 0.1f, dist(rng) * 0.1f, 0.01f);
+
+            triangle_t t(v, e1, e2);
+            t.prim_id = static_cast<int>(i);
+            t.geom_id = 1;
+            result.push_back(t);
+        }
+    }
+
+    return result;
+}
+
+template <typename BVH>
+static void test_leaf_runs(aligned_vector<mixed_prim_t> const& prims)
+{
+    auto unsorted = build<BVH>(prims.data(), prims.size());
+    auto sorted = unsorted;
+    sort_leaves_by_type(sorted);
+
+    // Leaves are sorted by type and contain the same primitives as before
+    for (auto const& node : sorted.nodes())
+    {
+        if (!is_leaf(node))
+        {
+            continue;
+        }
+
+        unsigned types_before = 0;
+        unsigned types_after = 0;
+        vec3 centers_before(0.0f);
+        vec3 centers_after(0.0f);
+
+        for (auto i = node.get_indices().first; i != node.get_indices().last; ++i)
+        {
+            types_before += unsorted.primitive(i).which();
+            types_after  += sorted.primitive(i).which();
+
+            centers_before += get_bounds(unsorted.primitive(i)).center();
+            centers_after  += get_bounds(sorted.primitive(i)).center();
+
+            if (i != node.get_indices().first)
+            {
+                EXPECT_LE( sorted.primitive(i - 1).which(), sorted.primitive(i).which() );
+            }
+        }
+
+        EXPECT_EQ( types_before, types_after );
+
+        for (int d = 0; d < 3; ++d)
+        {
+            EXPECT_NEAR( centers_before[d], centers_after[d], 1E-4f );
+        }
+    }
+
+    // Closest hits match brute force intersection
+    std::default_random_engine rng(1);
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    int num_hits = 0;
+
+    auto sorted_ref = sorted.ref();
+
+    for (int r = 0; r < 1000; ++r)
+    {
+        vec3 ori(dist(rng), dist(rng), -2.0f);
+        vec3 dir = normalize(vec3(dist(rng) * 0.2f, dist(rng) * 0.2f, 1.0f));
+
+        ray ry(ori, dir);
+
+        auto expected = closest_hit(ry, prims.begin(), prims.end());
+        auto actual = intersect(ry, sorted_ref);
+
+        EXPECT_EQ( actual.hit, expected.hit );
+
+        if (expected.hit)
+        {
+            EXPECT_FLOAT_EQ( actual.t, expected.t );
+            EXPECT_EQ( actual.prim_id, expected.prim_id );
+            ++num_hits;
+        }
+    }
+
+    EXPECT_GT( num_hits, 0 );
+}
+
+TEST(GenericPrimitive, SortLeavesByType)
+{
+    auto prims = make_mixed_primitives(2000);
+
+    test_leaf_runs<bvh<mixed_prim_t>>(prims);
+    test_leaf_runs<index_bvh<mixed_prim_t>>(prims);
+}
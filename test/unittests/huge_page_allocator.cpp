@@ -0,0 +1,117 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <cstdint>
+
+#include <visionaray/math/math.h>
+#include <visionaray/texture/texture.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Small and large allocations are aligned and keep their contents
+//
+
+TEST(HugePageAllocator, Vector)
+{
+    huge_page_vector<int, 32> small(100);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(small.data()) % 32, 0U);
+
+    size_t n = (detail::HugePageSize * 3) / sizeof(int) + 7;
+
+    huge_page_vector<int, 32> large(n);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(large.data()) % 32, 0U);
+
+    for (size_t i = 0; i < large.size(); ++i)
+    {
+        large[i] = static_cast<int>(i);
+    }
+
+    // Reallocates (huge pages -> huge pages)
+    large.resize(n * 2, -1);
+
+    for (size_t i = 0; i < n; ++i)
+    {
+        ASSERT_EQ(large[i], static_cast<int>(i));
+    }
+
+    EXPECT_EQ(large.back(), -1);
+
+    huge_page_vector<int, 32> copy(large);
+    EXPECT_TRUE(copy == large);
+
+    large.clear();
+    large.shrink_to_fit();
+    EXPECT_TRUE(large.empty());
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Huge page BVH yields the same result as the default BVH
+//
+
+TEST(HugePageAllocator, BVH)
+{
+    aligned_vector<basic_triangle<3, float>> triangles;
+
+    for (int i = 0; i < 1000; ++i)
+    {
+        vec3 v1(static_cast<float>(i), 0.0f, 0.0f);
+        triangles.emplace_back(v1, vec3(0.5f, 1.0f, 0.0f), vec3(1.0f, 0.0f, 0.0f));
+        triangles.back().prim_id = i;
+    }
+
+    auto bvh1 = build<index_bvh<basic_triangle<3, float>>>(triangles.data(), triangles.size());
+    auto bvh2 = build<huge_page_index_bvh<basic_triangle<3, float>>>(triangles.data(), triangles.size());
+
+    ASSERT_EQ(bvh1.num_nodes(), bvh2.num_nodes());
+    ASSERT_EQ(bvh1.num_primitives(), bvh2.num_primitives());
+
+    for (size_t i = 0; i < bvh1.num_primitives(); ++i)
+    {
+        EXPECT_EQ(bvh1.indices()[i], bvh2.indices()[i]);
+    }
+
+    // Same ref type, can be used with the same kernels
+    index_bvh<basic_triangle<3, float>>::bvh_ref ref = bvh2.ref();
+
+    ray r(vec3(10.25f, 0.25f, -1.0f), vec3(0.0f, 0.0f, 1.0f));
+    auto hr = intersect(r, ref);
+
+    EXPECT_TRUE(hr.hit);
+    EXPECT_EQ(hr.prim_id, 10);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Textures with huge page storage
+//
+
+TEST(HugePageAllocator, Texture)
+{
+    static const size_t W = 1024;
+    static const size_t H = 1024;
+
+    aligned_vector<float> texels(W * H);
+
+    for (size_t i = 0; i < texels.size(); ++i)
+    {
+        texels[i] = static_cast<float>(i % W) / W;
+    }
+
+    huge_page_texture<float, 2> tex(W, H);
+    tex.reset(texels.data());
+    tex.set_address_mode(Clamp);
+    tex.set_filter_mode(Nearest);
+
+    texture_ref<float, 2> ref(tex);
+
+    EXPECT_FLOAT_EQ(tex2D(ref, vec2(0.5f / W, 0.5f / H)), 0.0f);
+    EXPECT_FLOAT_EQ(tex2D(ref, vec2(100.5f / W, 7.5f / H)), 100.0f / W);
+}
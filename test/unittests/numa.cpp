@@ -0,0 +1,220 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+#include <visionaray/aligned_vector.h>
+#include <visionaray/numa.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+// Two fake nodes that share the CPUs of the machine, so that multi-domain
+// code paths are exercised on single node machines
+static std::vector<numa_node> make_fake_nodes()
+{
+    auto topology = numa_topology();
+
+    std::vector<numa_node> nodes(2);
+    nodes[0].id = topology[0].id;
+    nodes[1].id = topology[0].id;
+
+    for (size_t i = 0; i < topology[0].cpus.size(); ++i)
+    {
+        nodes[i % 2 == 0 || topology[0].cpus.size() == 1 ? 0 : 1].cpus.push_back(topology[0].cpus[i]);
+    }
+
+    if (nodes[1].cpus.empty())
+    {
+        nodes[1].cpus = nodes[0].cpus;
+    }
+
+    return nodes;
+}
+
+// Runs queue_length work items and checks that each is processed exactly once
+static void test_run(thread_pool& pool, long queue_length)
+{
+    std::vector<std::atomic<int>> counts(queue_length);
+
+    for (auto& c : counts)
+    {
+        c = 0;
+    }
+
+    pool.run([&](long i) { ++counts[i]; }, queue_length);
+
+    for (long i = 0; i < queue_length; ++i)
+    {
+        EXPECT_EQ(counts[i], 1);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Topology always contains at least one node with CPUs
+//
+
+TEST(NUMA, Topology)
+{
+    auto nodes = numa_topology();
+
+    ASSERT_FALSE(nodes.empty());
+
+    for (auto const& n : nodes)
+    {
+        EXPECT_FALSE(n.cpus.empty());
+    }
+
+    for (size_t i = 1; i < nodes.size(); ++i)
+    {
+        EXPECT_LT(nodes[i - 1].id, nodes[i].id);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Compact and scatter placement
+//
+
+TEST(NUMA, ThreadAffinity)
+{
+    numa_node n0;
+    n0.id = 0;
+    n0.cpus = { 0, 1 };
+
+    numa_node n1;
+    n1.id = 1;
+    n1.cpus = { 2, 3 };
+
+    std::vector<numa_node> nodes{ n0, n1 };
+
+    auto none = make_thread_affinity(4, PinNone, nodes);
+    EXPECT_TRUE(none.cpus.empty());
+    EXPECT_TRUE(none.domains.empty());
+
+    auto compact = make_thread_affinity(5, PinCompact, nodes);
+    EXPECT_EQ(compact.cpus,    std::vector<int>({ 0, 1, 2, 3, 0 }));
+    EXPECT_EQ(compact.domains, std::vector<unsigned>({ 0, 0, 1, 1, 0 }));
+
+    auto scatter = make_thread_affinity(5, PinScatter, nodes);
+    EXPECT_EQ(scatter.cpus,    std::vector<int>({ 0, 2, 1, 3, 0 }));
+    EXPECT_EQ(scatter.domains, std::vector<unsigned>({ 0, 1, 0, 1, 0 }));
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Thread pool processes each work item once, with and without domains
+//
+
+TEST(NUMA, ThreadPoolDomains)
+{
+    thread_pool pool(4);
+
+    test_run(pool, 1);
+    test_run(pool, 7);
+    test_run(pool, 1000);
+
+    pool.reset(4, make_thread_affinity(4, PinScatter, make_fake_nodes()));
+
+    test_run(pool, 1);
+    test_run(pool, 7);
+    test_run(pool, 1000);
+
+    // Domains without threads are processed by the other threads
+    thread_affinity affinity;
+    affinity.cpus = { -1, -1 };
+    affinity.domains = { 0, 2 };
+    pool.reset(2, affinity);
+
+    test_run(pool, 3);
+    test_run(pool, 1000);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Back-to-back runs of different lengths, threads that are still stealing from the
+// last run must not process items past the end of the next one
+//
+
+TEST(NUMA, ThreadPoolBackToBack)
+{
+    static const long MaxLength = 1000;
+
+    thread_pool pool(4, make_thread_affinity(4, PinNone, make_fake_nodes()));
+
+    std::vector<std::atomic<int>> counts(MaxLength);
+    std::atomic<int> out_of_range(0);
+
+    for (int i = 0; i < 2000; ++i)
+    {
+        long queue_length = i % 2 == 0 ? MaxLength : 1 + i % 7;
+
+        for (auto& c : counts)
+        {
+            c = 0;
+        }
+
+        pool.run([&](long item)
+        {
+            if (item < 0 || item >= queue_length)
+            {
+                ++out_of_range;
+                return;
+            }
+
+            ++counts[item];
+        },
+        queue_length);
+
+        for (long j = 0; j < queue_length; ++j)
+        {
+            ASSERT_EQ(counts[j], 1) << i;
+        }
+    }
+
+    EXPECT_EQ(out_of_range, 0);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Memory placement keeps the contents, one copy per node
+//
+
+TEST(NUMA, Memory)
+{
+    auto nodes = numa_topology();
+
+    aligned_vector<int> data(1 << 20);
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        data[i] = static_cast<int>(i);
+    }
+
+    // May fail if the kernel has no NUMA support, must not corrupt the data
+    numa_interleave(data.data(), data.size() * sizeof(int), nodes);
+    numa_distribute(data.data(), data.size() * sizeof(int), nodes);
+    numa_bind(data.data() + 1, 100, nodes[0]);
+
+    for (size_t i = 0; i < data.size(); ++i)
+    {
+        ASSERT_EQ(data[i], static_cast<int>(i));
+    }
+
+    numa_replicated<aligned_vector<int>> replicas(data, make_fake_nodes());
+
+    ASSERT_EQ(replicas.size(), 2U);
+    EXPECT_TRUE(replicas[0] == data);
+    EXPECT_TRUE(replicas[1] == data);
+    EXPECT_TRUE(replicas.local() == data);
+}
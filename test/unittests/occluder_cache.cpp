@@ -0,0 +1,266 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <random>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/intersector.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/occluder_cache.h>
+#include <visionaray/packet_traits.h>
+#include <visionaray/traverse.h>
+
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using tree_t = index_bvh<triangle_t>;
+
+// One large triangle (prim_id 0) between the z=0 plane and the light, and small
+// random triangles, most of them outside the shadow rays' frustum
+static aligned_vector<triangle_t> make_triangles(size_t count)
+{
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles(count);
+
+    triangles[0] = triangle_t(vec3(-0.5f, -0.5f, 0.5f), vec3(3.0f, 0.0f, 0.0f), vec3(0.0f, 3.0f, 0.0f));
+
+    for (size_t i = 1; i < count; ++i)
+    {
+        vec3 v(dist(rng) * 4.0f - 1.5f, dist(rng) * 4.0f - 1.5f, 0.1f + dist(rng));
+        vec3 e1 = vec3(dist(rng), dist(rng), dist(rng)) * 0.05f;
+        vec3 e2 = vec3(dist(rng), dist(rng), dist(rng)) * 0.05f;
+
+        triangles[i] = triangle_t(v, e1, e2);
+    }
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        triangles[i].prim_id = static_cast<int>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    return triangles;
+}
+
+static const vec3 light(0.5f, 0.5f, 2.0f);
+
+// Shadow ray from pixel (x,y) of a 32x32 grid on the z=0 plane to the light
+static basic_ray<float> make_shadow_ray(int x, int y, float)
+{
+    vec3 ori((x + 0.5f) / 32.0f, (y + 0.5f) / 32.0f, 0.0f);
+    return ray(ori, normalize(light - ori));
+}
+
+// 2x2 packet
+static basic_ray<simd::float4> make_shadow_ray(int x, int y, simd::float4)
+{
+    array<ray, 4> rays;
+
+    for (int i = 0; i < 4; ++i)
+    {
+        rays[i] = make_shadow_ray(x + i % 2, y + i / 2, 0.0f);
+    }
+
+    return simd::pack(rays);
+}
+
+// Shadow rays to the light are occluded iff any_hit() says so
+template <typename S, typename Primitives, typename Cache>
+static void expect_same_occlusion(Primitives begin, Primitives end, Cache& cache)
+{
+    default_intersector isect;
+
+    for (int y = 0; y < 32; y += packet_size<S>::h)
+    {
+        for (int x = 0; x < 32; x += packet_size<S>::w)
+        {
+            auto r = make_shadow_ray(x, y, S{});
+            S dist = length(vector<3, S>(light) - r.ori);
+
+            auto expected = any_hit(r, begin, end, dist);
+
+            // Light 0 and 1 share the position
+            auto hr0 = cache.any_hit(0, r, begin, end, dist, isect);
+            auto hr1 = cache.any_hit(1, r, begin, end, dist, isect);
+
+            ASSERT_TRUE( all(hr0.hit == expected.hit) );
+            ASSERT_TRUE( all(hr1.hit == expected.hit) );
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Cached occluders answer most queries, results are the same as w/o cache
+//
+
+TEST(OccluderCache, AnyHit)
+{
+    auto triangles = make_triangles(2000);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    occluder_cache<> cache;
+    expect_same_occlusion<float>(&ref, &ref + 1, cache);
+
+    // The large triangle occludes the center of the grid
+    EXPECT_GT(cache.num_hits(), cache.num_misses());
+
+    occluder_cache<> packet_cache;
+    expect_same_occlusion<simd::float4>(&ref, &ref + 1, packet_cache);
+
+    EXPECT_GT(packet_cache.num_hits(), 0U);
+
+    // Occluders are cached per BVH
+    tree_t trees[] = {
+        build<tree_t>(triangles.data() + 1, 1000),
+        build<tree_t>(triangles.data(), 1)
+        };
+
+    decltype(ref) refs[] = { trees[0].ref(), trees[1].ref() };
+
+    occluder_cache<> multi_cache;
+    expect_same_occlusion<float>(refs, refs + 2, multi_cache);
+
+    EXPECT_GT(multi_cache.num_hits(), multi_cache.num_misses());
+}
+
+TEST(OccluderCache, MaxLights)
+{
+    auto triangles = make_triangles(100);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    // Light 1 is not cached
+    occluder_cache<1> cache;
+    expect_same_occlusion<float>(&ref, &ref + 1, cache);
+
+    EXPECT_LT(cache.num_hits() + cache.num_misses(), 32U * 32U * 2U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Invalidate after the geometry changed
+//
+
+TEST(OccluderCache, Invalidate)
+{
+    auto triangles = make_triangles(2000);
+
+    auto tree = build<tree_t>(triangles.data(), triangles.size());
+
+    occluder_cache<> cache;
+
+    {
+        auto ref = tree.ref();
+        expect_same_occlusion<float>(&ref, &ref + 1, cache);
+    }
+
+    // Entries are kept between queries
+    unsigned num_misses = cache.num_misses();
+
+    {
+        auto ref = tree.ref();
+        auto r = make_shadow_ray(16, 16, 0.0f);
+        default_intersector isect;
+        EXPECT_TRUE(cache.any_hit(0, r, &ref, &ref + 1, length(light - r.ori), isect).hit);
+        EXPECT_EQ(cache.num_misses(), num_misses);
+    }
+
+    // Remove the large occluder, its index slot still refers to it
+    EXPECT_EQ(remove_primitive(tree, 0), 1U);
+
+    cache.invalidate();
+
+    {
+        auto ref = tree.ref();
+        expect_same_occlusion<float>(&ref, &ref + 1, cache);
+    }
+
+    num_misses = cache.num_misses();
+    cache.invalidate();
+
+    {
+        auto ref = tree.ref();
+        auto r = make_shadow_ray(16, 16, 0.0f);
+        default_intersector isect;
+        EXPECT_FALSE(cache.any_hit(0, r, &ref, &ref + 1, length(light - r.ori), isect).hit);
+        EXPECT_EQ(cache.num_misses(), num_misses + 1);
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// The whitted kernel reuses a cache passed to shade() across rays
+//
+
+TEST(OccluderCache, WhittedKernel)
+{
+    // Ground quad in the z=0 plane, occluder between the ground and the light
+    basic_test_scene<matte<float>> scene;
+
+    matte<float> m;
+    m.ca() = from_rgb(vec3(0.0f));
+    m.ka() = 0.0f;
+    m.cd() = from_rgb(vec3(0.8f));
+    m.kd() = 1.0f;
+
+    scene.add_quad(vec3(-1.0f, -1.0f, 0.0f), vec3(1.0f, -1.0f, 0.0f), vec3(1.0f, 1.0f, 0.0f), vec3(-1.0f, 1.0f, 0.0f), m);
+    scene.add_quad(vec3(-0.5f, -0.5f, 0.5f), vec3(0.5f, -0.5f, 0.5f), vec3(0.5f, 0.5f, 0.5f), vec3(-0.5f, 0.5f, 0.5f), m);
+    scene.add_point_light(vec3(0.0f, 0.0f, 2.0f));
+    scene.build();
+
+    auto kparams = scene.params(1);
+    whitted::kernel<decltype(kparams)> kernel{ kparams };
+
+    default_intersector isect;
+    occluder_cache<> cache;
+
+    unsigned num_shadowed = 0;
+
+    for (int y = 0; y < 32; ++y)
+    {
+        for (int x = 0; x < 32; ++x)
+        {
+            // Primary rays below the occluder, straight down to the ground
+            vec3 ori((x + 0.5f) / 16.0f - 1.0f, (y + 0.5f) / 16.0f - 1.0f, 0.25f);
+            ray r(ori, vec3(0.0f, 0.0f, -1.0f));
+
+            auto hr = closest_hit(r, kparams.prims.begin, kparams.prims.end, isect);
+            ASSERT_TRUE(hr.hit);
+
+            auto expected = kernel.shade(isect, r, hr);
+            auto actual = kernel.shade(isect, r, hr, cache);
+
+            for (int c = 0; c < 4; ++c)
+            {
+                EXPECT_FLOAT_EQ(actual.color[c], expected.color[c]);
+            }
+
+            // No ambient light
+            num_shadowed += expected.color.x == 0.0f;
+        }
+    }
+
+    // The occluder shadows the center of the ground quad, after the first shadow
+    // ray the cached occluder answers (almost) all queries there
+    EXPECT_GT(num_shadowed, 32U * 32U / 4U);
+    EXPECT_GT(cache.num_hits(), num_shadowed * 9U / 10U);
+}
@@ -0,0 +1,330 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cstddef>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aligned_vector.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/rasterizer.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+#include <visionaray/traverse.h>
+
+#include <common/make_triangles.h>
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+using render_target_t = simple_buffer_rt<PF_RGBA32F, PF_DEPTH32F>;
+
+// Not a multiple of the tile size
+static const int Width  = 100;
+static const int Height = 70;
+
+namespace
+{
+
+// Random triangles in the unit cube, lit by a point light
+struct test_scene : basic_test_scene<plastic<float>>
+{
+    explicit test_scene(vec3 const& eye = vec3(0.5f, 0.5f, 2.2f))
+    {
+        plastic<float> mat;
+        mat.ca() = from_rgb(vec3(0.1f));
+        mat.ka() = 1.0f;
+        mat.cd() = from_rgb(vec3(0.8f, 0.6f, 0.4f));
+        mat.kd() = 1.0f;
+        mat.cs() = from_rgb(vec3(1.0f));
+        mat.ks() = 0.5f;
+        mat.specular_exp() = 32.0f;
+
+        add_triangles(make_triangles(2000, 0.2f), mat);
+
+        add_point_light(vec3(0.5f, 2.0f, 2.0f));
+
+        build();
+
+        look_at(Width, Height, 45.0f, eye, vec3(0.5f, 0.5f, 0.0f));
+    }
+};
+
+} // namespace
+
+// Rasterized visibility is the same as the closest hit of the primary rays, up to
+// pixels on triangle edges
+template <typename Primitives>
+static void expect_same_visibility(
+        visibility_buffer const&    vbuffer,
+        pinhole_camera              cam,
+        Primitives                  begin,
+        Primitives                  end
+        )
+{
+    cam.begin_frame();
+
+    int num_hits = 0;
+    int num_different = 0;
+
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            auto r = cam.primary_ray(ray{}, float(x), float(y), float(Width), float(Height));
+            auto hr = closest_hit(r, begin, end);
+
+            auto const& vis = vbuffer(x, y);
+
+            num_hits += hr.hit;
+
+            if (vis.hit != hr.hit || (hr.hit && vis.prim_id != hr.prim_id))
+            {
+                ++num_different;
+                continue;
+            }
+
+            if (hr.hit)
+            {
+                EXPECT_EQ(vis.geom_id, hr.geom_id);
+                EXPECT_FLOAT_EQ(vis.t, hr.t);
+                EXPECT_FLOAT_EQ(vis.u, hr.u);
+                EXPECT_FLOAT_EQ(vis.v, hr.v);
+            }
+        }
+    }
+
+    EXPECT_GT(num_hits, Width * Height / 4);
+    EXPECT_LE(num_different, Width * Height / 200);
+}
+
+template <typename Kernel>
+static std::vector<vec4> render(
+        test_scene&                 scene,
+        tiled_sched<basic_ray<simd::float4>>& sched,
+        Kernel                      kernel,
+        visibility_buffer const*    vbuffer
+        )
+{
+    render_target_t rt;
+    rt.resize(Width, Height);
+
+    sched.set_visibility_buffer(vbuffer);
+    sched.frame(kernel, make_sched_params(pixel_sampler::uniform_type{}, scene.cam, rt));
+
+    return std::vector<vec4>(rt.color(), rt.color() + Width * Height);
+}
+
+// Kernels shade the same image from rasterized primary visibility, up to pixels
+// on triangle edges
+template <typename Kernel>
+static void test_kernel(test_scene& scene, Kernel kernel)
+{
+    tiled_sched<basic_ray<simd::float4>> sched(2);
+
+    EXPECT_EQ(sched.get_visibility_buffer(), nullptr);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+    rast.rasterize<simd::float4>(sched.backend().pool(), scene.cam, scene.refs.begin(), scene.refs.end(), vbuffer);
+
+    auto expected = render(scene, sched, kernel, nullptr);
+    auto actual = render(scene, sched, kernel, &vbuffer);
+
+    EXPECT_EQ(sched.get_visibility_buffer(), &vbuffer);
+
+    int num_different = 0;
+
+    for (int i = 0; i < Width * Height; ++i)
+    {
+        vec4 diff = actual[i] - expected[i];
+        num_different += dot(diff, diff) > 1E-6f;
+    }
+
+    EXPECT_LE(num_different, Width * Height / 200);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Rasterize triangle lists and BVHs
+//
+
+TEST(Rasterizer, Triangles)
+{
+    test_scene scene;
+    thread_pool pool(2);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+
+    rast.rasterize(pool, scene.cam, scene.triangles.begin(), scene.triangles.end(), vbuffer);
+    expect_same_visibility(vbuffer, scene.cam, scene.triangles.begin(), scene.triangles.end());
+
+    rast.rasterize<simd::float4>(pool, scene.cam, scene.triangles.begin(), scene.triangles.end(), vbuffer);
+    expect_same_visibility(vbuffer, scene.cam, scene.triangles.begin(), scene.triangles.end());
+
+    // Primitive list index is the position in the list
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            auto const& vis = vbuffer(x, y);
+
+            if (vis.hit)
+            {
+                EXPECT_EQ(vis.index, vis.prim_id);
+            }
+        }
+    }
+}
+
+TEST(Rasterizer, BVH)
+{
+    test_scene scene;
+    thread_pool pool(2);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+    rast.rasterize<simd::float8>(pool, scene.cam, scene.refs.begin(), scene.refs.end(), vbuffer);
+
+    expect_same_visibility(vbuffer, scene.cam, scene.refs.begin(), scene.refs.end());
+
+    // Primitive list index refers to the BVH's primitive
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            auto const& vis = vbuffer(x, y);
+
+            if (vis.hit)
+            {
+                EXPECT_EQ(static_cast<int>(scene.bvh.primitive(vis.index).prim_id), vis.prim_id);
+            }
+        }
+    }
+}
+
+// Eye inside the scene, triangles are clipped at the eye plane
+TEST(Rasterizer, Clipping)
+{
+    test_scene scene(vec3(0.5f, 0.5f, 0.5f));
+    thread_pool pool(2);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+    rast.rasterize<simd::float4>(pool, scene.cam, scene.refs.begin(), scene.refs.end(), vbuffer);
+
+    expect_same_visibility(vbuffer, scene.cam, scene.refs.begin(), scene.refs.end());
+}
+
+// Camera close to large triangles that cross the eye plane, their vertices
+// project far outside the viewport
+TEST(Rasterizer, LargeTriangles)
+{
+    aligned_vector<triangle_t> triangles;
+
+    // Ground plane and a wall next to the camera
+    vec3 quads[][3] = {
+        { vec3(-1000.0f, 0.0f, 1000.0f), vec3(2000.0f, 0.0f, 0.0f), vec3(0.0f, 0.0f, -2000.0f) },
+        { vec3(0.52f, -1000.0f, 1000.0f), vec3(0.0f, 2000.0f, 0.0f), vec3(0.0f, 0.0f, -2000.0f) }
+        };
+
+    for (auto const& q : quads)
+    {
+        triangles.push_back(triangle_t(q[0], q[1], q[2]));
+        triangles.push_back(triangle_t(q[0] + q[1] + q[2], -q[1], -q[2]));
+    }
+
+    for (size_t i = 0; i < triangles.size(); ++i)
+    {
+        triangles[i].prim_id = static_cast<int>(i);
+        triangles[i].geom_id = 0;
+    }
+
+    thread_pool pool(2);
+
+    visibility_buffer vbuffer;
+    vbuffer.resize(Width, Height);
+
+    rasterizer rast;
+
+    vec3 eyes[] = { vec3(0.5f, 0.01f, 0.0f), vec3(0.5f, 1.0f, 0.0f), vec3(0.51f, 0.001f, 3.0f) };
+
+    for (auto const& eye : eyes)
+    {
+        pinhole_camera cam;
+        cam.set_viewport(0, 0, Width, Height);
+        cam.perspective(60.0f * constants::degrees_to_radians<float>(), Width / static_cast<float>(Height), 0.1f, 10.0f);
+        cam.look_at(eye, eye + vec3(0.3f, -0.2f, -1.0f), vec3(0.0f, 1.0f, 0.0f));
+
+        rast.rasterize<simd::float4>(pool, cam, triangles.begin(), triangles.end(), vbuffer);
+        expect_same_visibility(vbuffer, cam, triangles.begin(), triangles.end());
+    }
+}
+
+// Results don't depend on the number of threads
+TEST(Rasterizer, Threads)
+{
+    test_scene scene;
+
+    visibility_buffer vbuffers[2];
+    unsigned num_threads[2] = { 1, 3 };
+
+    rasterizer rast;
+
+    for (int i = 0; i < 2; ++i)
+    {
+        thread_pool pool(num_threads[i]);
+
+        vbuffers[i].resize(Width, Height);
+        rast.rasterize<simd::float4>(pool, scene.cam, scene.refs.begin(), scene.refs.end(), vbuffers[i]);
+    }
+
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            EXPECT_EQ(vbuffers[0](x, y).hit, vbuffers[1](x, y).hit);
+            EXPECT_EQ(vbuffers[0](x, y).prim_id, vbuffers[1](x, y).prim_id);
+        }
+    }
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Simple and whitted kernels w/ rasterized primary visibility
+//
+
+TEST(Rasterizer, Simple)
+{
+    test_scene scene;
+    auto kparams = scene.params(2, vec4(0.1f, 0.2f, 0.3f, 1.0f), vec4(0.5f));
+
+    test_kernel(scene, simple::kernel<decltype(kparams)>({ kparams }));
+}
+
+TEST(Rasterizer, Whitted)
+{
+    test_scene scene;
+    auto kparams = scene.params(2, vec4(0.1f, 0.2f, 0.3f, 1.0f), vec4(0.5f));
+
+    test_kernel(scene, whitted::kernel<decltype(kparams)>({ kparams }));
+}
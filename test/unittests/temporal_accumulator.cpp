@@ -0,0 +1,225 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <random>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/aov_buffer_rt.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/pinhole_camera.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/temporal_accumulator.h>
+
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+static const int Width  = 64;
+static const int Height = 64;
+
+static pinhole_camera make_camera(vec3 const& eye)
+{
+    pinhole_camera cam;
+    cam.set_viewport(0, 0, Width, Height);
+    cam.perspective(90.0f * constants::degrees_to_radians<float>(), 1.0f, 0.1f, 10.0f);
+    cam.look_at(eye, eye - vec3(0.0f, 0.0f, 1.0f), vec3(0.0f, 1.0f, 0.0f));
+    return cam;
+}
+
+namespace
+{
+
+// Background quad in the z=0 plane, small occluder quad in front of it
+struct test_scene : basic_test_scene<matte<float>>
+{
+    static const float OccluderSize;
+    static const float OccluderZ;
+
+    void add_square(float size, float z)
+    {
+        matte<float> m;
+        m.ca() = from_rgb(vec3(0.0f));
+        m.ka() = 0.0f;
+        m.cd() = from_rgb(vec3(0.8f));
+        m.kd() = 1.0f;
+
+        add_quad(vec3(-size, -size, z), vec3(size, -size, z), vec3(size, size, z), vec3(-size, size, z), m);
+    }
+
+    test_scene()
+    {
+        add_square(2.0f, 0.0f);
+        add_square(OccluderSize, OccluderZ);
+
+        add_point_light(vec3(0.0f, 0.0f, 2.0f));
+
+        build();
+    }
+
+    void render(pinhole_camera const& cam, aov_buffer_rt<PF_RGBA32F>& rt) const
+    {
+        auto kparams = params(1);
+
+        simple_sched<ray> sched;
+
+        sched.frame(
+                simple::kernel<decltype(kparams), aov_result_record>({ kparams }),
+                make_sched_params(pixel_sampler::uniform_type{}, cam, rt)
+                );
+    }
+};
+
+} // namespace
+
+const float test_scene::OccluderSize = 0.25f;
+const float test_scene::OccluderZ = 0.5f;
+
+
+//-------------------------------------------------------------------------------------------------
+// Still camera: history is the mean of all samples
+//
+
+TEST(TemporalAccumulator, Still)
+{
+    thread_pool pool(2);
+
+    test_scene scene;
+    pinhole_camera cam = make_camera(vec3(0.0f, 0.0f, 1.5f));
+
+    aov_buffer_rt<PF_RGBA32F> rt(AovDepth | AovNormal | AovAlbedo);
+    rt.resize(Width, Height);
+
+    temporal_accumulator acc;
+
+    std::default_random_engine rng(0);
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    static const int NumFrames = 10;
+
+    std::vector<vec4> sum(Width * Height, vec4(0.0f));
+
+    for (int f = 0; f < NumFrames; ++f)
+    {
+        scene.render(cam, rt);
+
+        // Noisy samples
+        for (int i = 0; i < Width * Height; ++i)
+        {
+            rt.color()[i] = vec4(dist(rng), dist(rng), dist(rng), 1.0f);
+            sum[i] += rt.color()[i];
+        }
+
+        acc.accumulate(pool, rt, cam);
+    }
+
+    for (int i = 0; i < Width * Height; ++i)
+    {
+        EXPECT_FLOAT_EQ(acc.history_length()[i], static_cast<float>(NumFrames));
+
+        for (int c = 0; c < 4; ++c)
+        {
+            EXPECT_NEAR(rt.color()[i][c], sum[i][c] / NumFrames, 1E-5f);
+        }
+    }
+
+    // History is discarded after reset
+    acc.reset();
+    scene.render(cam, rt);
+    acc.accumulate(pool, rt, cam);
+
+    EXPECT_FLOAT_EQ(acc.history_length()[0], 1.0f);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Moving camera: history is reprojected, but not for surfaces that were occluded
+//
+
+TEST(TemporalAccumulator, Reprojection)
+{
+    thread_pool pool(2);
+
+    test_scene scene;
+
+    vec3 eye1(0.0f, 0.0f, 1.5f);
+    vec3 eye2(0.5f, 0.0f, 1.5f);
+
+    pinhole_camera cam1 = make_camera(eye1);
+    pinhole_camera cam2 = make_camera(eye2);
+
+    aov_buffer_rt<PF_RGBA32F> rt(AovDepth | AovNormal | AovAlbedo | AovGeomID);
+    rt.resize(Width, Height);
+
+    temporal_accumulator acc;
+
+    scene.render(cam1, rt);
+    acc.accumulate(pool, rt, cam1);
+
+    scene.render(cam2, rt);
+    std::vector<vec4> current(rt.color(), rt.color() + Width * Height);
+    acc.accumulate(pool, rt, cam2);
+
+    cam2.begin_frame();
+
+    int num_reprojected = 0;
+    int num_disoccluded = 0;
+
+    for (int y = 0; y < Height; ++y)
+    {
+        for (int x = 0; x < Width; ++x)
+        {
+            int i = y * Width + x;
+
+            if (rt.geom_id()[i] != 0)
+            {
+                continue;
+            }
+
+            // Point on the background quad, and where the line to the first eye
+            // crosses the occluder plane
+            auto r = cam2.primary_ray(ray{}, static_cast<float>(x), static_cast<float>(y), float(Width), float(Height));
+            vec3 p = r.ori + r.dir * (-r.ori.z / r.dir.z);
+
+            float t = (test_scene::OccluderZ - p.z) / (eye1.z - p.z);
+            vec3 q = p + (eye1 - p) * t;
+
+            // Stay away from the silhouettes and the borders of the first image
+            float margin = 0.05f;
+            float extent = test_scene::OccluderSize;
+
+            bool occluded = std::abs(q.x) < extent - margin && std::abs(q.y) < extent - margin;
+            bool visible  = std::abs(q.x) > extent + margin || std::abs(q.y) > extent + margin;
+            bool inside   = std::abs(p.x - eye1.x) < 1.4f && std::abs(p.y - eye1.y) < 1.4f;
+
+            if (occluded)
+            {
+                EXPECT_FLOAT_EQ(acc.history_length()[i], 1.0f);
+                ++num_disoccluded;
+            }
+            else if (visible && inside)
+            {
+                EXPECT_FLOAT_EQ(acc.history_length()[i], 2.0f);
+                ++num_reprojected;
+            }
+
+            // Diffuse surfaces, the reprojected color matches the current one
+            if (acc.history_length()[i] > 1.0f)
+            {
+                EXPECT_NEAR(rt.color()[i].x, current[i].x, 0.05f);
+            }
+        }
+    }
+
+    EXPECT_GT(num_disoccluded, 0);
+    EXPECT_GT(num_reprojected, Width * Height / 2);
+}
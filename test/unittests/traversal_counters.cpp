@@ -0,0 +1,238 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <random>
+#include <thread>
+#include <vector>
+
+#include <visionaray/aligned_vector.h>
+#include <visionaray/bvh.h>
+#include <visionaray/kernels.h>
+#include <visionaray/traversal_counters.h>
+#include <visionaray/traverse.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using triangle_t = basic_triangle<3, float>;
+
+// Random triangles in the unit cube
+static aligned_vector<triangle_t> make_random_triangles(size_t num_triangles)
+{
+    std::default_random_engine rng;
+    std::uniform_real_distribution<float> dist(0.0f, 1.0f);
+
+    aligned_vector<triangle_t> triangles;
+
+    for (size_t i = 0; i < num_triangles; ++i)
+    {
+        vec3 v1(dist(rng), dist(rng), dist(rng));
+        vec3 v2 = v1 + vec3(dist(rng), dist(rng), dist(rng)) * 0.1f;
+        vec3 v3 = v1 + vec3(dist(rng), dist(rng), dist(rng)) * 0.1f;
+
+        triangle_t t(v1, v2 - v1, v3 - v1);
+        t.prim_id = static_cast<unsigned>(i);
+        t.geom_id = 0;
+        triangles.push_back(t);
+    }
+
+    return triangles;
+}
+
+// Rays on a grid in front of the unit cube, looking down -z
+static std::vector<basic_ray<float>> make_rays(int n)
+{
+    std::vector<basic_ray<float>> rays;
+
+    for (int y = 0; y < n; ++y)
+    {
+        for (int x = 0; x < n; ++x)
+        {
+            vec3 ori((x + 0.5f) / n, (y + 0.5f) / n, 2.0f);
+            rays.emplace_back(ori, vec3(0.0f, 0.0f, -1.0f));
+        }
+    }
+
+    return rays;
+}
+
+template <typename Primitives>
+struct heatmap_params
+{
+    struct
+    {
+        Primitives begin;
+        Primitives end;
+    } prims;
+};
+
+
+//-------------------------------------------------------------------------------------------------
+// Counting does not change the traversal result
+//
+
+TEST(TraversalCounters, SameResult)
+{
+    auto triangles = make_random_triangles(500);
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    traversal_counters total;
+
+    for (auto const& ray : make_rays(32))
+    {
+        default_intersector isect;
+        auto hr = closest_hit(ray, &ref, &ref + 1, isect);
+
+        counting_intersector counting;
+        auto hr_counting = closest_hit(ray, &ref, &ref + 1, counting);
+
+        EXPECT_EQ(hr.hit, hr_counting.hit);
+
+        if (hr.hit)
+        {
+            EXPECT_FLOAT_EQ(hr.t, hr_counting.t);
+            EXPECT_EQ(hr.prim_id, hr_counting.prim_id);
+            EXPECT_GT(counting.counters.prims, 0U);
+        }
+
+        auto const& c = counting.counters;
+
+        // The root node is always visited, each inner node tests its two children
+        EXPECT_GE(c.nodes, 1U);
+        EXPECT_EQ(c.boxes % 2, 0U);
+        EXPECT_LE(c.boxes, 2 * c.nodes);
+        EXPECT_LE(c.prims, triangles.size());
+        EXPECT_LE(c.max_stack_depth, 32U);
+
+        total += c;
+    }
+
+    // At least some rays pushed nodes to the stack
+    EXPECT_GT(total.max_stack_depth, 0U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Linear traversal tests each primitive, unless it can exit early
+//
+
+TEST(TraversalCounters, Linear)
+{
+    auto triangles = make_random_triangles(100);
+
+    // Aim at the centroid of the first triangle
+    auto const& t = triangles[0];
+    vec3 centroid = t.v1 + (t.e1 + t.e2) / 3.0f;
+    basic_ray<float> ray(vec3(centroid.xy(), 2.0f), vec3(0.0f, 0.0f, -1.0f));
+
+    counting_intersector closest;
+    auto hr = closest_hit(ray, triangles.begin(), triangles.end(), closest);
+
+    EXPECT_TRUE(hr.hit);
+    EXPECT_EQ(closest.counters.prims, triangles.size());
+    EXPECT_EQ(closest.counters.nodes, 0U);
+    EXPECT_EQ(closest.counters.boxes, 0U);
+
+    counting_intersector any;
+    any_hit(ray, triangles.begin(), triangles.end(), any);
+
+    EXPECT_GE(any.counters.prims, 1U);
+    EXPECT_LE(any.counters.prims, closest.counters.prims);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Aggregate counters from several threads
+//
+
+TEST(TraversalCounters, Statistics)
+{
+    traversal_statistics stats;
+
+    static const unsigned NumThreads = 8;
+    static const unsigned NumAdds = 1000;
+
+    std::vector<std::thread> threads;
+
+    for (unsigned i = 0; i < NumThreads; ++i)
+    {
+        threads.emplace_back([&stats, i]()
+        {
+            traversal_counters c;
+            c.rays = 1;
+            c.nodes = 2;
+            c.boxes = 3;
+            c.prims = 4;
+            c.max_stack_depth = i;
+
+            for (unsigned j = 0; j < NumAdds; ++j)
+            {
+                stats.add(c);
+            }
+        });
+    }
+
+    for (auto& t : threads)
+    {
+        t.join();
+    }
+
+    auto c = stats.accumulate();
+    EXPECT_EQ(c.rays,  NumThreads * NumAdds * 1U);
+    EXPECT_EQ(c.nodes, NumThreads * NumAdds * 2U);
+    EXPECT_EQ(c.boxes, NumThreads * NumAdds * 3U);
+    EXPECT_EQ(c.prims, NumThreads * NumAdds * 4U);
+    EXPECT_EQ(c.max_stack_depth, NumThreads - 1);
+
+    stats.reset();
+    c = stats.accumulate();
+    EXPECT_EQ(c.rays, 0U);
+    EXPECT_EQ(c.nodes, 0U);
+    EXPECT_EQ(c.max_stack_depth, 0U);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// Heatmap kernel reports one traversal per call
+//
+
+TEST(TraversalCounters, HeatmapKernel)
+{
+    auto triangles = make_random_triangles(500);
+    auto tree = build<index_bvh<triangle_t>>(triangles.data(), triangles.size());
+    auto ref = tree.ref();
+
+    using params_type = heatmap_params<index_bvh<triangle_t>::bvh_ref const*>;
+    params_type params;
+    params.prims.begin = &ref;
+    params.prims.end = &ref + 1;
+
+    traversal_statistics stats;
+
+    heatmap::kernel<params_type> kernel{ params, heatmap::Nodes, 64.0f, &stats };
+
+    auto rays = make_rays(16);
+
+    for (auto const& ray : rays)
+    {
+        auto result = kernel(ray);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            EXPECT_GE(result.color[i], 0.0f);
+            EXPECT_LE(result.color[i], 1.0f);
+        }
+        EXPECT_FLOAT_EQ(result.color.w, 1.0f);
+    }
+
+    auto c = stats.accumulate();
+    EXPECT_EQ(c.rays, rays.size());
+    EXPECT_GE(c.nodes, rays.size());
+}
@@ -3,6 +3,7 @@
 
 #include <sstream>
 #include <string>
+#include <type_traits>
 
 #include <visionaray/math/math.h>
 #include <visionaray/variant.h>
@@ -111,3 +112,72 @@ TEST(VariantTest, General)
 
     EXPECT_STREQ( str1.c_str(), str2.c_str() );
 }
+
+
+//-------------------------------------------------------------------------------------------------
+// Variants with more types than one switch statement of apply_visitor() covers
+//
+
+template <int I>
+struct indexed
+{
+    int value;
+};
+
+struct index_visitor
+{
+    using return_type = int;
+
+    template <int I>
+    int operator()(indexed<I> const& x) const
+    {
+        return I * 100 + x.value;
+    }
+};
+
+template <typename Variant>
+static void test_index(std::integral_constant<int, -1>)
+{
+}
+
+template <typename Variant, int I>
+static void test_index(std::integral_constant<int, I>)
+{
+    Variant var = indexed<I>{ I + 1 };
+
+    EXPECT_EQ( var.which(), static_cast<unsigned>(I + 1) );
+    EXPECT_EQ( var.template get<I + 1>().value, I + 1 );
+    EXPECT_EQ( apply_visitor( index_visitor(), var ), I * 100 + I + 1 );
+
+    test_index<Variant>(std::integral_constant<int, I - 1>{});
+}
+
+TEST(VariantTest, ManyTypes)
+{
+    using variant_t = variant<
+            indexed< 0>, indexed< 1>, indexed< 2>, indexed< 3>, indexed< 4>,
+            indexed< 5>, indexed< 6>, indexed< 7>, indexed< 8>, indexed< 9>,
+            indexed<10>, indexed<11>, indexed<12>, indexed<13>, indexed<14>,
+            indexed<15>, indexed<16>, indexed<17>, indexed<18>, indexed<19>
+            >;
+
+    test_index<variant_t>(std::integral_constant<int, 19>{});
+}
+
+TEST(VariantTest, Empty)
+{
+    // Default constructed variants have no active type, visitors return a
+    // default constructed value
+    variant<int, float, double> var;
+    EXPECT_EQ( var.which(), 0U );
+    EXPECT_FALSE( apply_visitor( is_double_visitor(), var ) );
+
+    variant<
+        indexed< 0>, indexed< 1>, indexed< 2>, indexed< 3>, indexed< 4>,
+        indexed< 5>, indexed< 6>, indexed< 7>, indexed< 8>, indexed< 9>,
+        indexed<10>, indexed<11>, indexed<12>, indexed<13>, indexed<14>,
+        indexed<15>, indexed<16>, indexed<17>, indexed<18>, indexed<19>
+        > many;
+    EXPECT_EQ( many.which(), 0U );
+    EXPECT_EQ( apply_visitor( index_visitor(), many ), 0 );
+}
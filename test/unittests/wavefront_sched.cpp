@@ -0,0 +1,179 @@
+// This file is distributed under the MIT license.
+// See the LICENSE file for details.
+
+#include <cmath>
+#include <vector>
+
+#include <visionaray/math/math.h>
+#include <visionaray/generic_material.h>
+#include <visionaray/kernels.h>
+#include <visionaray/material.h>
+#include <visionaray/scheduler.h>
+#include <visionaray/simple_buffer_rt.h>
+#include <visionaray/detail/wavefront_sched.h>
+
+#include <common/test_scene.h>
+
+#include <gtest/gtest.h>
+
+using namespace visionaray;
+
+
+//-------------------------------------------------------------------------------------------------
+// Helpers
+//
+
+using material_t = generic_material<matte<float>, mirror<float>, emissive<float>>;
+using render_target_t = simple_buffer_rt<PF_RGBA32F, PF_UNSPECIFIED>;
+
+static const int Width  = 32;
+static const int Height = 32;
+static const int NumFrames = 64;
+
+namespace
+{
+
+// Box w/o front wall, light source at the ceiling and a mirror at the back
+struct test_scene : basic_test_scene<material_t>
+{
+    static material_t make_matte(vec3 color)
+    {
+        matte<float> m;
+        m.ca() = from_rgb(vec3(0.0f));
+        m.ka() = 0.0f;
+        m.cd() = from_rgb(color);
+        m.kd() = 1.0f;
+        return m;
+    }
+
+    test_scene()
+    {
+        material_t white = make_matte(vec3(0.8f));
+        material_t red   = make_matte(vec3(0.8f, 0.1f, 0.1f));
+
+        mirror<float> mi;
+        mi.cr() = from_rgb(vec3(0.9f));
+        mi.kr() = 1.0f;
+        mi.ior() = spectrum<float>(1.34f);
+        mi.absorption() = spectrum<float>(0.0f);
+
+        emissive<float> e;
+        e.ce() = from_rgb(vec3(1.0f));
+        e.ls() = 4.0f;
+
+        // Floor, ceiling, left, right, back
+        add_quad(vec3(-1, -1,  1), vec3( 1, -1,  1), vec3( 1, -1, -1), vec3(-1, -1, -1), white);
+        add_quad(vec3(-1,  1, -1), vec3( 1,  1, -1), vec3( 1,  1,  1), vec3(-1,  1,  1), white);
+        add_quad(vec3(-1, -1, -1), vec3(-1,  1, -1), vec3(-1,  1,  1), vec3(-1, -1,  1), red);
+        add_quad(vec3( 1, -1,  1), vec3( 1,  1,  1), vec3( 1,  1, -1), vec3( 1, -1, -1), white);
+        add_quad(vec3(-0.5f, -1, -1), vec3(-0.5f, 0, -1), vec3(0.5f, 0, -1), vec3(0.5f, -1, -1), mi);
+        add_quad(vec3(-1, -1, -1.01f), vec3(1, -1, -1.01f), vec3(1, 1, -1.01f), vec3(-1, 1, -1.01f), white);
+
+        // Light
+        add_quad(vec3(-0.3f, 0.99f, -0.3f), vec3(0.3f, 0.99f, -0.3f), vec3(0.3f, 0.99f, 0.3f), vec3(-0.3f, 0.99f, 0.3f), e);
+
+        build();
+
+        look_at(Width, Height, 60.0f, vec3(0.0f, 0.0f, 3.0f), vec3(0.0f));
+    }
+};
+
+} // namespace
+
+// Average of NumFrames frames
+template <typename Sched, typename Kernel>
+static std::vector<vec4> render(test_scene& scene, Sched& sched, Kernel kernel)
+{
+    render_target_t rt;
+    rt.resize(Width, Height);
+
+    for (int f = 1; f <= NumFrames; ++f)
+    {
+        sched.frame(
+                kernel,
+                make_sched_params(pixel_sampler::jittered_blend_type{}, scene.cam, rt),
+                static_cast<unsigned>(f)
+                );
+    }
+
+    return std::vector<vec4>(rt.color(), rt.color() + Width * Height);
+}
+
+// Compare block averages of two images, the images are noisy
+static void expect_similar(std::vector<vec4> const& a, std::vector<vec4> const& b)
+{
+    static const int Block = 8;
+
+    for (int by = 0; by < Height; by += Block)
+    {
+        for (int bx = 0; bx < Width; bx += Block)
+        {
+            vec4 sum_a(0.0f);
+            vec4 sum_b(0.0f);
+
+            for (int y = by; y < by + Block; ++y)
+            {
+                for (int x = bx; x < bx + Block; ++x)
+                {
+                    sum_a += a[y * Width + x];
+                    sum_b += b[y * Width + x];
+                }
+            }
+
+            for (int c = 0; c < 4; ++c)
+            {
+                float ma = sum_a[c] / (Block * Block);
+                float mb = sum_b[c] / (Block * Block);
+
+                EXPECT_NEAR(ma, mb, 0.05f + 0.1f * std::abs(mb));
+            }
+        }
+    }
+}
+
+template <typename R>
+static void test_wavefront(size_t batch_size)
+{
+    test_scene scene;
+    auto kparams = scene.params(4, vec4(0.1f, 0.2f, 0.3f, 1.0f), vec4(0.5f));
+
+    tiled_sched<R> ref_sched(2);
+    auto expected = render(scene, ref_sched, pathtracing::kernel<decltype(kparams)>({ kparams }));
+
+    wavefront_sched<R> sched(2);
+    sched.set_batch_size(batch_size);
+    auto actual = render(scene, sched, pathtracing::wavefront_kernel<decltype(kparams)>({ kparams }));
+
+    expect_similar(actual, expected);
+
+    // Not black
+    float sum = 0.0f;
+
+    for (auto const& c : actual)
+    {
+        sum += c.x + c.y + c.z;
+    }
+
+    EXPECT_GT(sum, 0.1f * Width * Height);
+}
+
+
+//-------------------------------------------------------------------------------------------------
+// The wavefront path tracer converges to the same image as pathtracing::kernel
+//
+
+TEST(WavefrontSched, Pathtracing)
+{
+    test_wavefront<basic_ray<float>>(Width * Height);
+}
+
+TEST(WavefrontSched, PathtracingSIMD)
+{
+    test_wavefront<basic_ray<simd::float4>>(Width * Height);
+}
+
+TEST(WavefrontSched, PathtracingBatches)
+{
+    // Batches that are not a multiple of the packet and chunk sizes
+    test_wavefront<basic_ray<simd::float4>>(333);
+}